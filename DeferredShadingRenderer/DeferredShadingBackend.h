@@ -7,6 +7,7 @@
 #include "RendererCommon/RendererBackend.h"
 #include "RendererCommon/serial/RenderQueues.h"
 #include "Util/serial/Array.h"
+#include "Util/serial/SparseCellArray.h"
 
 //TODO: for debug
 #include "Util/Geometry/MeshEdgeList.h"
@@ -31,6 +32,12 @@ namespace illDeferredShadingRenderer {
 
 class DeferredShadingBackend : public illRendererCommon::RendererBackend {
 public:
+    /**
+    For each viewport id, the last query frame of each cell in the scene grid, coded with codeFrame and encodeVisible.
+    Cells that were never queried read as 0, so only the parts of the grid that have been queried take up memory.
+    */
+    typedef std::unordered_map<size_t, SparseCellArray<uint64_t>> CellQueryFrames;
+
     static inline uint64_t codeFrame(uint64_t frame) {
         return /*0x00FFFFFFFFFFFFFF*/0x7FFFFFFFFFFFFFFF & frame;
     }
@@ -95,7 +102,7 @@ public:
     @param failureDuration If a query failed, adds this number to the frame counter to make the query result last for that many frames.
     @param randomAddMax Adds a random number between 0 and this number to every query frame duration to help reduce query starvation
     */
-    virtual void retreiveCellQueries(std::unordered_map<size_t, Array<uint64_t>>& lastViewedFrames, uint64_t lastFrameCounter, 
+    virtual void retreiveCellQueries(CellQueryFrames& lastViewedFrames, uint64_t lastFrameCounter, 
         uint64_t successDuration, uint64_t failureDuration, uint64_t randomAddMax = 0) = 0;
     
     /**
@@ -154,7 +161,7 @@ public:
     */
     virtual void render(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport,
         const GridVolume3D<>* debugGridVolume = NULL,
-        const std::unordered_map<size_t, Array<uint64_t>>* debugLastViewedFrames = NULL, uint64_t debugFrameCounter = 0,
+        const CellQueryFrames* debugLastViewedFrames = NULL, uint64_t debugFrameCounter = 0,
         int debugTraversals = -1) = 0;     //TODO: take out these debug things
     
     //different debug modes
@@ -1,11 +1,25 @@
+#include <cassert>
 #include "DeferredShadingRenderer/serial/DeferredShadingScene.h"
 #include "DeferredShadingRenderer/DeferredShadingBackend.h"
 #include "Util/Geometry/Iterators/MultiConvexMeshIterator.h"
+#include "Util/parallel/ThreadPool.h"
 #include "Graphics/serial/Camera/Camera.h"
+#include "RendererCommon/serial/StaticMeshNode.h"
 
 namespace illDeferredShadingRenderer {
 
+DeferredShadingScene::~DeferredShadingScene() {
+    for(size_t worker = 0; worker < m_parallelWorkers.size(); worker++) {
+        delete m_parallelWorkers[worker];
+    }
+}
+
 void DeferredShadingScene::setupFrame() {
+    applyMoves();
+    finishResourceLoads();
+
+    //the frame arenas were already reset when the render queues were cleared at the end of last frame
+
     uint64_t visibilityDuration = m_queryVisibilityDuration;
     uint64_t invisibilityDuration = m_queryInvisibilityDuration;
 
@@ -28,31 +42,226 @@ void DeferredShadingScene::render(const illGraphics::Camera& camera, size_t view
     m_renderQueues.m_depthPassObjects = 75;
     static_cast<DeferredShadingBackend *>(m_rendererBackend)->setupViewport(camera);
 
-    //get the frustum iterator
-    MeshEdgeList<> meshEdgeList = camera.getViewFrustum().getMeshEdgeList();
-    MultiConvexMeshIterator<> frustumIterator;
+    //get the frustum iterator, reusing the storage from last frame
+    camera.getViewFrustum().getMeshEdgeList(m_frustumMeshEdgeList);
+    m_frustumIterator.reset();
     
-    getGridVolume().orderedMeshIteratorForMesh(frustumIterator, &meshEdgeList,
+    getGridVolume().orderedMeshIteratorForMesh(m_frustumIterator, &m_frustumMeshEdgeList,
         camera.getViewFrustum().m_nearTipPoint,
         camera.getViewFrustum().m_direction);
-    
-    bool needsQuerySetup = true;
 
     m_debugNumTraversedCells = 0;
     m_debugNumEmptyCells = 0;
     m_debugNumCulledCells = 0;
     m_debugNumRenderedNodes = 0;
     m_debugNumUnqueried = 0;
-    
-    size_t numQueries = 0;
-    size_t numQueriesNeeded = 0;
-    
+    m_debugNumFrustumCulledNodes = 0;
+
+    m_frustumCullPlanes.set(camera.getViewFrustum());
+
+    CellQueryState queryState;
+    queryState.m_numQueries = 0;
+    queryState.m_numQueriesNeeded = 0;
+    queryState.m_needsQuerySetup = true;
+    queryState.m_recordedOverflow = false;
+
+    if(m_occlusionMode == OcclusionMode::SOFTWARE) {
+        m_softwareOcclusionBuffer.clear(camera.getModelViewProjection());
+    }
+
+    //the parallel path merges the sorted queues, the maps can't be merged in order
+    if(m_threadPool && m_renderQueues.m_useSortedQueues && m_occlusionMode == OcclusionMode::HARDWARE_QUERIES) {
+        traverseParallel(camera, viewport, queryState);
+    }
+    else {
+        traverseSerial(camera, viewport, queryState);
+    }
+
+    if(queryState.m_numQueries < m_maxQueries || !m_performCull) {
+        m_numFramesOverflowed = 0;
+    }
+
+    //LOG_DEBUG("Num Queries needed %u.  Countdown %u.  Num performed %u", numQueriesNeeded, m_resetRequeryDurationCountdown, numQueries);
+
+    m_debugNumOverflowedQueries = m_numFramesOverflowed;
+    m_debugRequeryDuration = m_queryVisibilityDuration;
+    m_debugNumQueries = queryState.m_numQueries;
+
+    m_renderQueues.sort();
+
+    static_cast<DeferredShadingBackend *>(m_rendererBackend)->render(m_renderQueues, camera, viewport,
+        &m_grid, &m_queryFrames, m_frameCounter, m_debugMaxCellTraversals);
+
+    ++m_renderAccessCounter;
+
+    m_renderQueues.clear();
+    m_renderQueues.m_depthPassObjects = 0;
+
+    //the payloads merged in from the workers were moved out, but the workers' queues still need emptying, which also resets their arenas
+    for(size_t worker = 0; worker < m_parallelWorkers.size(); worker++) {
+        m_parallelWorkers[worker]->m_renderQueues.clear();
+    }
+}
+
+bool DeferredShadingScene::queryCell(const illGraphics::Camera& camera, size_t viewport,
+        const glm::uvec3& cellPosition, unsigned int cellArrayIndex, CellQueryState& queryState, void *& cellQuery) {
+    ++queryState.m_numQueriesNeeded;
+
+    //do an occlusion query for the cell
+    cellQuery = NULL;
+
+    if(m_occlusionMode == OcclusionMode::SOFTWARE) {
+        if(!m_performCull) {
+            return true;
+        }
+
+        glm::vec3 cellMin = vec3cast<unsigned int, glm::mediump_float>(cellPosition) * getGridVolume().getCellDimensions();
+        return m_softwareOcclusionBuffer.testBox(cellMin, cellMin + getGridVolume().getCellDimensions());
+    }
+
+    bool visible;
+    uint64_t lastQueryFrame;
+    getCellQueryFrame(viewport, cellPosition, visible, lastQueryFrame);
+
+    //time to query
+    if(m_performCull) {
+        if(lastQueryFrame <= m_frameCounter) {
+            if(queryState.m_numQueries >= m_maxQueries) {  //check if queries overflowed
+                if(!queryState.m_recordedOverflow) {
+                    ++m_numFramesOverflowed;
+                    queryState.m_recordedOverflow = true;
+                }
+            }
+
+            if(queryState.m_numQueries >= m_maxQueries && !visible) {  //if queries overflowed, force visible cells to requery to avoid blinking
+                ++m_debugNumUnqueried;
+            }
+            else {
+                ++queryState.m_numQueries;
+
+                if(queryState.m_needsQuerySetup) {
+                    static_cast<DeferredShadingBackend *>(m_rendererBackend)->setupQuery();
+                    queryState.m_needsQuerySetup = false;
+                }
+
+                cellQuery = static_cast<DeferredShadingBackend *>(m_rendererBackend)->occlusionQueryCell(
+                    camera, vec3cast<unsigned int, glm::mediump_float>(cellPosition) * getGridVolume().getCellDimensions()
+                        + getGridVolume().getCellDimensions() * 0.5f,
+                    getGridVolume().getCellDimensions(), cellArrayIndex, viewport,
+                    m_debugNumTraversedCells == m_debugMaxCellTraversals);
+            }
+        }
+        else {
+            ++m_debugNumUnqueried;
+        }
+    }
+
+    //if cell was visible last frames and has objects in it
+    return isCellRendered(visible, lastQueryFrame);
+}
+
+void DeferredShadingScene::depthPassCell(const illGraphics::Camera& camera, size_t viewport, CellQueryState& queryState, void * cellQuery) {
+    static_cast<DeferredShadingBackend *>(m_rendererBackend)->endQuery();
+    queryState.m_needsQuerySetup = true;
+
+    //the occluders in this cell hide whatever's behind them from the cells coming after
+    if(m_occlusionMode == OcclusionMode::SOFTWARE && m_performCull) {
+        rasterizeSoftwareOccluders();
+    }
+
+    //draw objects for the depth pass
+    m_renderQueues.sortDepthPass();
+    static_cast<DeferredShadingBackend *>(m_rendererBackend)->depthPass(m_renderQueues, camera, cellQuery, viewport);
+}
+
+void DeferredShadingScene::addNode(const illGraphics::Camera& camera, size_t viewport, illRendererCommon::GraphicsNode * node) {
+    if(node->addedToRenderQueue(m_renderAccessCounter)) {
+        return;
+    }
+
+    //TODO: take this out after done with thesis
+    node->setOcclusionCull(m_debugPerObjectCull);
+
+    if(m_occlusionMode == OcclusionMode::SOFTWARE) {
+        if(node->getOcclusionCull() && m_performCull) {
+            Box<> bounds = node->getWorldBoundingVolume();
+
+            if(!m_softwareOcclusionBuffer.testBox(bounds.m_min, bounds.m_max)) {
+                return;
+            }
+        }
+
+        node->render(m_renderQueues);
+        ++m_debugNumRenderedNodes;
+    }
+    else if(node->getOcclusionCull() && node->getLastNonvisibleFrame(viewport) == m_frameCounter - 1) {
+        static_cast<DeferredShadingBackend *>(m_rendererBackend)->occlusionQueryNode(camera, node, viewport);
+    }
+    else {
+        node->render(m_renderQueues);
+        ++m_debugNumRenderedNodes;
+    }
+}
+
+void DeferredShadingScene::frustumCullCellNodes(const NodeContainer& cell) {
+    if(!m_frustumCullNodes) {
+        return;
+    }
+
+    size_t numWords = (cell.size() + 31) / 32;
+
+    if(m_cellNodeVisibility.size() < numWords) {
+        m_cellNodeVisibility.resize(numWords);
+    }
+
+    size_t numVisible = frustumCullBoxBatch(m_frustumCullPlanes, cell.getAttachment(), m_cellNodeVisibility.data());
+    m_debugNumFrustumCulledNodes += (int) (cell.size() - numVisible);
+}
+
+void DeferredShadingScene::rasterizeSoftwareOccluders() {
+    const illRendererCommon::StaticMeshNode * lastNode = NULL;
+
+    auto rasterizeNode = [&] (const illRendererCommon::StaticMeshNode * node) {
+        //a node adds an entry per primitive group, one after the other
+        if(node == lastNode) {
+            return;
+        }
+
+        lastNode = node;
+
+        //the bounding volume covers more than the mesh, only a box known to be inside the mesh is safe to cull with
+        if(!node->m_hasOccluderBounds) {
+            return;
+        }
+
+        Box<> bounds = node->m_occluderBounds + node->getPosition();
+        m_softwareOcclusionBuffer.rasterizeBox(bounds.m_min, bounds.m_max);
+    };
+
+    //the payloads are still in the order they were added
+    const auto& sortedPayloads = m_renderQueues.m_sortedDepthPassSolidStaticMeshes.m_payloads;
+
+    for(size_t entry = 0; entry < sortedPayloads.size(); entry++) {
+        rasterizeNode(sortedPayloads[entry].m_info.m_node);
+    }
+
+    for(auto shaderIter = m_renderQueues.m_depthPassSolidStaticMeshes.begin(); shaderIter != m_renderQueues.m_depthPassSolidStaticMeshes.end(); shaderIter++) {
+        for(auto materialIter = shaderIter->second.begin(); materialIter != shaderIter->second.end(); materialIter++) {
+            for(auto meshIter = materialIter->second.begin(); meshIter != materialIter->second.end(); meshIter++) {
+                for(auto infoIter = meshIter->second.begin(); infoIter != meshIter->second.end(); infoIter++) {
+                    rasterizeNode(infoIter->m_node);
+                }
+            }
+        }
+    }
+}
+
+void DeferredShadingScene::traverseSerial(const illGraphics::Camera& camera, size_t viewport, CellQueryState& queryState) {
     //std::set<unsigned int> debugCellSet;
-    
-    bool recordedOverflow = false;
 
-    while(!frustumIterator.atEnd() && (m_debugMaxCellTraversals == -1 || m_debugNumTraversedCells < m_debugMaxCellTraversals)) {
-        unsigned int currentCell = getGridVolume().indexForCell(frustumIterator.getCurrentPosition());
+    while(!m_frustumIterator.atEnd() && (m_debugMaxCellTraversals == -1 || m_debugNumTraversedCells < m_debugMaxCellTraversals)) {
+        glm::uvec3 cellPosition = m_frustumIterator.getCurrentPosition();
+        unsigned int currentCell = getGridVolume().indexForCell(cellPosition);
 
         /*if(debugCellSet.find(currentCell) != debugCellSet.end()) {
             LOG_ERROR("Cell %u traversed multiple times", currentCell);
@@ -65,142 +274,284 @@ void DeferredShadingScene::render(const illGraphics::Camera& camera, size_t view
         //check if cell is empty
         if(getSceneNodeCell(currentCell).empty() && getStaticNodeCell(currentCell).size() == 0) {
             ++m_debugNumEmptyCells;
-            frustumIterator.forward();
+            m_frustumIterator.forward();
             continue;
         }
 
-        ++numQueriesNeeded;
-
-        //do an occlusion query for the cell
-        void * cellQuery = NULL;
-        
-        bool visible = DeferredShadingBackend::decodeVisible(m_queryFrames.at(viewport)[currentCell]);
-        uint64_t lastQueryFrame = DeferredShadingBackend::codeFrame(m_queryFrames.at(viewport)[currentCell]);
-                
-        //time to query
-        if(m_performCull) {
-            if(lastQueryFrame <= m_frameCounter) {
-                if(numQueries >= m_maxQueries) {  //check if queries overflowed
-                    if(!recordedOverflow) {
-                        ++m_numFramesOverflowed;
-                        recordedOverflow = true;
-                    }
-                }
+        void * cellQuery;
+        bool render = queryCell(camera, viewport, cellPosition, currentCell, queryState, cellQuery);
 
-                if(numQueries >= m_maxQueries && !visible) {  //if queries overflowed, force visible cells to requery to avoid blinking
-                    ++m_debugNumUnqueried;
-                }
-                else {
-                    ++numQueries;
+        m_frustumIterator.forward();
 
-                    if(needsQuerySetup) {
-                        static_cast<DeferredShadingBackend *>(m_rendererBackend)->setupQuery();
-                        needsQuerySetup = false;
-                    }
+        if(render) {
+            //add all nodes in the cell to the render queues
+            {
+                auto& currCell = getSceneNodeCell(currentCell);
+                frustumCullCellNodes(currCell);
 
-                    cellQuery = static_cast<DeferredShadingBackend *>(m_rendererBackend)->occlusionQueryCell(
-                        camera, vec3cast<unsigned int, glm::mediump_float>(frustumIterator.getCurrentPosition()) * getGridVolume().getCellDimensions() 
-                            + getGridVolume().getCellDimensions() * 0.5f, 
-                        getGridVolume().getCellDimensions(), currentCell, viewport, 
-                        m_debugNumTraversedCells == m_debugMaxCellTraversals);
+                for(size_t nodeInd = 0; nodeInd < currCell.size(); nodeInd++) {
+                    if(isCellNodeVisible(nodeInd)) {
+                        addNode(camera, viewport, currCell[nodeInd]);
+                    }
                 }
             }
-            else {
-                ++m_debugNumUnqueried;
+
+            {
+                auto& currCell = getStaticNodeCell(currentCell);
+
+                for(size_t arrayInd = 0; arrayInd < currCell.size(); arrayInd++) {
+                    addNode(camera, viewport, currCell[arrayInd]);
+                }
             }
+
+            depthPassCell(camera, viewport, queryState, cellQuery);
+        }
+        else {
+            ++m_debugNumCulledCells;
         }
-        
-        frustumIterator.forward();
+    }
+}
 
-        //if cell was visible last frames and has objects in it
-        if((visible && lastQueryFrame >= m_frameCounter) || !m_performCull) {
-            //add all nodes in the cell to the render queues
-            {
-                auto& currCell = getSceneNodeCell(currentCell);
+void DeferredShadingScene::addParallelNodeJob(illRendererCommon::GraphicsNode * node, size_t viewport) {
+    if(node->addedToRenderQueue(m_renderAccessCounter)) {
+        return;
+    }
 
-                for(auto cellIter = currCell.begin(); cellIter != currCell.end(); cellIter++) {
-                    auto node = *cellIter;
+    //TODO: take this out after done with thesis
+    node->setOcclusionCull(m_debugPerObjectCull);
 
-                    if(node->addedToRenderQueue(m_renderAccessCounter)) {
-                        continue;
-                    }
+    NodeJob job;
+    job.m_node = node;
 
-                    //TODO: take this out after done with thesis                    
-                    node->setOcclusionCull(m_debugPerObjectCull);
+    if(node->getOcclusionCull() && node->getLastNonvisibleFrame(viewport) == m_frameCounter - 1) {
+        job.m_action = NodeJob::Action::QUERY;
+    }
+    else if(node->getType() == illRendererCommon::GraphicsNode::Type::LIGHT) {
+        //lights write into the light queue maps, and they're cheap anyway
+        job.m_action = NodeJob::Action::RENDER_SERIAL;
+    }
+    else {
+        job.m_action = NodeJob::Action::RENDER_PARALLEL;
+        m_parallelNodes.push_back(node);
+    }
 
-                    if(node->getOcclusionCull() && node->getLastNonvisibleFrame(viewport) == m_frameCounter - 1) {
-                        static_cast<DeferredShadingBackend *>(m_rendererBackend)->occlusionQueryNode(camera, node, viewport);
-                    }
-                    else {
-                        node->render(m_renderQueues);
-                        ++m_debugNumRenderedNodes;
-                    }
-                }
+    m_nodeJobs.push_back(job);
+}
+
+void DeferredShadingScene::mergeParallelNode(illRendererCommon::RenderQueues& source, const ParallelNodeOutput& begin, const ParallelNodeOutput& end) {
+    using illRendererCommon::StaticMeshNode;
+
+    //the workers queue every occluder since they can't know how many objects came before them,
+    //so the depth pass limit is applied here in the same order the serial path would have applied it
+    for(size_t entry = begin.m_depthPassEnd; entry < end.m_depthPassEnd; entry++) {
+        auto& payload = source.m_sortedDepthPassSolidStaticMeshes.m_payloads[entry];
+
+        if(m_renderQueues.m_depthPassObjects >= m_renderQueues.m_depthPassLimit
+                && payload.m_info.m_node->m_occluderType == StaticMeshNode::OccluderType::LIMITED) {
+            continue;
+        }
+
+        m_renderQueues.m_sortedDepthPassSolidStaticMeshes.add(source.m_sortedDepthPassSolidStaticMeshes.m_keys[entry].m_key, std::move(payload));
+        ++m_renderQueues.m_depthPassObjects;
+    }
+
+    for(size_t entry = begin.m_solidEnd; entry < end.m_solidEnd; entry++) {
+        auto& payload = source.m_sortedSolidStaticMeshes.m_payloads[entry];
+        m_renderQueues.m_sortedSolidStaticMeshes.add(source.m_sortedSolidStaticMeshes.m_keys[entry].m_key, std::move(payload));
+    }
+
+    for(size_t entry = begin.m_unsolidEnd; entry < end.m_unsolidEnd; entry++) {
+        auto& payload = source.m_sortedUnsolidStaticMeshes.m_payloads[entry];
+        m_renderQueues.m_sortedUnsolidStaticMeshes.add(source.m_sortedUnsolidStaticMeshes.m_keys[entry].m_key, std::move(payload));
+    }
+}
+
+void DeferredShadingScene::traverseParallel(const illGraphics::Camera& camera, size_t viewport, CellQueryState& queryState) {
+    size_t numIterators = m_frustumIterator.m_numIterators;
+
+    if(m_traversedCells.size() < numIterators) {
+        m_traversedCells.resize(numIterators);
+    }
+
+    //walk each of the fanned out sub iterators on its own thread
+    //going through them in order afterwards gives exactly the cells the serial traversal would have given
+    m_threadPool->parallelFor(numIterators, [&] (size_t iterInd) {
+        std::vector<TraversedCell>& cells = m_traversedCells[iterInd];
+        cells.clear();
+
+        ConvexMeshIterator<>& iter = m_frustumIterator.m_iterators[iterInd];
+
+        //the multi iterator visits the current position of an empty iterator once, unless it's the last one
+        bool visitAtEnd = iterInd + 1 < numIterators;
+
+        if(iter.atEnd() && !visitAtEnd) {
+            return;
+        }
+
+        do {
+            TraversedCell cell;
+            cell.m_position = iter.getCurrentPosition();
+            cell.m_cellArrayIndex = getGridVolume().indexForCell(cell.m_position);
+            cell.m_empty = getSceneNodeCell(cell.m_cellArrayIndex).empty() && getStaticNodeCell(cell.m_cellArrayIndex).size() == 0;
+
+            cells.push_back(cell);
+
+            if(iter.atEnd()) {
+                break;
             }
 
-            {
-                auto& currCell = getStaticNodeCell(currentCell);
+            iter.forward();
+        } while(!iter.atEnd());
+    });
 
-                for(size_t arrayInd = 0; arrayInd < currCell.size(); arrayInd++) {
-                    auto node = currCell[arrayInd];
+    m_frustumIterator.m_currentIter = numIterators;
 
-                    if(node->addedToRenderQueue(m_renderAccessCounter)) {
-                        continue;
-                    }
+    //figure out which nodes get rendered in which cells in traversal order, this is what keeps the nodes in the same order as the serial path
+    m_nodeJobs.clear();
+    m_parallelNodes.clear();
+    m_cellJobs.clear();
 
-                    //TODO: take this out after done with thesis                    
-                    node->setOcclusionCull(m_debugPerObjectCull);
+    int numTraversed = 0;
 
-                    if(node->getOcclusionCull() && node->getLastNonvisibleFrame(viewport) == m_frameCounter - 1) {
-                        static_cast<DeferredShadingBackend *>(m_rendererBackend)->occlusionQueryNode(camera, node, viewport);
+    for(size_t iterInd = 0; iterInd < numIterators; iterInd++) {
+        const std::vector<TraversedCell>& cells = m_traversedCells[iterInd];
+
+        for(size_t cellInd = 0; cellInd < cells.size() && (m_debugMaxCellTraversals == -1 || numTraversed < m_debugMaxCellTraversals); cellInd++) {
+            ++numTraversed;
+
+            const TraversedCell& cell = cells[cellInd];
+
+            CellJob cellJob;
+            cellJob.m_cell = &cell;
+            cellJob.m_nodeJobsBegin = m_nodeJobs.size();
+
+            if(!cell.m_empty) {
+                bool visible;
+                uint64_t lastQueryFrame;
+                getCellQueryFrame(viewport, cell.m_position, visible, lastQueryFrame);
+
+                if(isCellRendered(visible, lastQueryFrame)) {
+                    auto& currCell = getSceneNodeCell(cell.m_cellArrayIndex);
+                    frustumCullCellNodes(currCell);
+
+                    for(size_t nodeInd = 0; nodeInd < currCell.size(); nodeInd++) {
+                        if(isCellNodeVisible(nodeInd)) {
+                            addParallelNodeJob(currCell[nodeInd], viewport);
+                        }
                     }
-                    else {
-                        node->render(m_renderQueues);
-                        ++m_debugNumRenderedNodes;
+
+                    auto& currStaticCell = getStaticNodeCell(cell.m_cellArrayIndex);
+
+                    for(size_t arrayInd = 0; arrayInd < currStaticCell.size(); arrayInd++) {
+                        addParallelNodeJob(currStaticCell[arrayInd], viewport);
                     }
                 }
             }
 
-            static_cast<DeferredShadingBackend *>(m_rendererBackend)->endQuery();
-            needsQuerySetup = true;
-
-            //draw objects for the depth pass
-            static_cast<DeferredShadingBackend *>(m_rendererBackend)->depthPass(m_renderQueues, camera, cellQuery, viewport);
-        }
-        else {
-            ++m_debugNumCulledCells;
+            cellJob.m_nodeJobsEnd = m_nodeJobs.size();
+            m_cellJobs.push_back(cellJob);
         }
     }
 
-    if(numQueries < m_maxQueries || !m_performCull) {        
-        m_numFramesOverflowed = 0;
+    //render the nodes into per worker queues, each worker gets a contiguous run of nodes so its queues are in traversal order
+    size_t numWorkers = m_threadPool->getConcurrency();
+
+    while(m_parallelWorkers.size() < numWorkers) {
+        m_parallelWorkers.push_back(new ParallelWorker());
     }
 
-    //LOG_DEBUG("Num Queries needed %u.  Countdown %u.  Num performed %u", numQueriesNeeded, m_resetRequeryDurationCountdown, numQueries);
+    m_parallelOutputs.resize(m_parallelNodes.size());
 
-    m_debugNumOverflowedQueries = m_numFramesOverflowed;
-    m_debugRequeryDuration = m_queryVisibilityDuration;    
-    m_debugNumQueries = numQueries;
+    m_threadPool->parallelFor(numWorkers, [&] (size_t worker) {
+        illRendererCommon::RenderQueues& queues = m_parallelWorkers[worker]->m_renderQueues;
 
-    static_cast<DeferredShadingBackend *>(m_rendererBackend)->render(m_renderQueues, camera, viewport, 
-        &m_grid, &m_queryFrames, m_frameCounter, m_debugMaxCellTraversals);
+        queues.m_useSortedQueues = true;
+        queues.m_getSolidAffectingLights = m_renderQueues.m_getSolidAffectingLights;
+        queues.m_queueLights = m_renderQueues.m_queueLights;
+        queues.m_depthPassLimit = (size_t) -1;
+        queues.m_depthPassObjects = 0;
 
-    ++m_renderAccessCounter;
+        size_t end = parallelChunkBegin(worker + 1, numWorkers);
 
-    m_renderQueues.m_depthPassSolidStaticMeshes.clear();
-    m_renderQueues.m_lights.clear();
-    m_renderQueues.m_solidStaticMeshes.clear();
-    m_renderQueues.m_depthPassObjects = 0;
+        for(size_t nodeInd = parallelChunkBegin(worker, numWorkers); nodeInd < end; nodeInd++) {
+            m_parallelNodes[nodeInd]->render(queues);
+
+            ParallelNodeOutput& output = m_parallelOutputs[nodeInd];
+            output.m_depthPassEnd = queues.m_sortedDepthPassSolidStaticMeshes.size();
+            output.m_solidEnd = queues.m_sortedSolidStaticMeshes.size();
+            output.m_unsolidEnd = queues.m_sortedUnsolidStaticMeshes.size();
+        }
+    });
+
+    //now go through the cells again in order doing the queries and depth passes on this thread and merging in the worker results
+    ParallelNodeOutput zeroOutput;
+    zeroOutput.m_depthPassEnd = 0;
+    zeroOutput.m_solidEnd = 0;
+    zeroOutput.m_unsolidEnd = 0;
+
+    size_t parallelNode = 0;
+    size_t worker = 0;
+
+    for(size_t cellJobInd = 0; cellJobInd < m_cellJobs.size(); cellJobInd++) {
+        const CellJob& cellJob = m_cellJobs[cellJobInd];
+        const TraversedCell& cell = *cellJob.m_cell;
+
+        ++m_debugNumTraversedCells;
+
+        if(cell.m_empty) {
+            ++m_debugNumEmptyCells;
+            continue;
+        }
+
+        void * cellQuery;
+
+        if(queryCell(camera, viewport, cell.m_position, cell.m_cellArrayIndex, queryState, cellQuery)) {
+            for(size_t jobInd = cellJob.m_nodeJobsBegin; jobInd < cellJob.m_nodeJobsEnd; jobInd++) {
+                const NodeJob& job = m_nodeJobs[jobInd];
+
+                switch(job.m_action) {
+                case NodeJob::Action::QUERY:
+                    static_cast<DeferredShadingBackend *>(m_rendererBackend)->occlusionQueryNode(camera, job.m_node, viewport);
+                    break;
+
+                case NodeJob::Action::RENDER_SERIAL:
+                    job.m_node->render(m_renderQueues);
+                    ++m_debugNumRenderedNodes;
+                    break;
+
+                case NodeJob::Action::RENDER_PARALLEL: {
+                        while(parallelNode >= parallelChunkBegin(worker + 1, numWorkers)) {
+                            ++worker;
+                        }
+
+                        const ParallelNodeOutput& begin = parallelNode == parallelChunkBegin(worker, numWorkers)
+                            ? zeroOutput
+                            : m_parallelOutputs[parallelNode - 1];
+
+                        mergeParallelNode(m_parallelWorkers[worker]->m_renderQueues, begin, m_parallelOutputs[parallelNode]);
+
+                        ++parallelNode;
+                        ++m_debugNumRenderedNodes;
+                    }
+                    break;
+                }
+            }
+
+            depthPassCell(camera, viewport, queryState, cellQuery);
+        }
+        else {
+            ++m_debugNumCulledCells;
+        }
+    }
+
+    assert(parallelNode == m_parallelNodes.size());
 }
 
 size_t DeferredShadingScene::registerViewport() {
     size_t res = m_returnViewportId++;
-    Array<uint64_t>& framesArray = m_queryFrames[res];
-
-    size_t numCells = getGridVolume().getCellNumber().x * getGridVolume().getCellNumber().y * getGridVolume().getCellNumber().z;
 
-    framesArray.resize(numCells);
-    memset(&framesArray[0], 0, sizeof(uint64_t) * numCells);
+    //cells read as 0 until they're first queried, so nothing is allocated per cell here
+    m_queryFrames[res].setCellNumber(getGridVolume().getCellNumber());
 
     return res;
 }
@@ -209,4 +560,4 @@ void DeferredShadingScene::freeViewport(size_t viewport) {
     m_queryFrames.erase(viewport);
 }
 
-}
\ No newline at end of file
+}
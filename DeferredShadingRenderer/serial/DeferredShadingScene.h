@@ -2,12 +2,19 @@
 #define ILL_DEFERRED_SHADING_SCENE_H_
 
 #include <unordered_map>
+#include <vector>
 #include "Util/serial/Array.h"
 #include "Util/Geometry/GridVolume3D.h"
+#include "Util/Geometry/Iterators/MultiConvexMeshIterator.h"
+#include "Util/Geometry/frustumCull.h"
 #include "RendererCommon/serial/GraphicsScene.h"
+#include "RendererCommon/serial/RenderQueues.h"
+#include "RendererCommon/serial/SoftwareOcclusionBuffer.h"
 
 #include "DeferredShadingRenderer/DeferredShadingBackend.h"
 
+class ThreadPool;
+
 namespace illDeferredShadingRenderer {
 
 class DeferredShadingScene : public illRendererCommon::GraphicsScene {
@@ -29,15 +36,18 @@ public:
         m_numFramesOverflowed(0),
         m_performCull(true),
         m_debugPerObjectCull(false),
+        m_threadPool(NULL),
+        m_occlusionMode(OcclusionMode::HARDWARE_QUERIES),
+        m_frustumCullNodes(true),
         
         m_debugMaxCellTraversals(-1)
     {
         m_renderQueues.m_queueLights = true;
         m_renderQueues.m_getSolidAffectingLights = false;
+        m_renderQueues.m_useSortedQueues = true;
     }
     
-    virtual ~DeferredShadingScene() {
-    }
+    virtual ~DeferredShadingScene();
 
     virtual void setupFrame();
 
@@ -64,6 +74,43 @@ public:
     bool m_performCull;
     bool m_debugPerObjectCull;
 
+    /**
+    If set, the frustum traversal and filling of the render queues is split up across the threads in the pool.
+    Only used with the sorted render queues, otherwise rendering stays on the calling thread.
+    The queues that come out are exactly the same as the single threaded ones, and all backend calls still happen on the calling thread.
+    The scene doesn't own the pool.
+    */
+    ThreadPool * m_threadPool;
+
+    enum class OcclusionMode {
+        HARDWARE_QUERIES,   ///<occlusion queries on the GPU, the results come back a few frames later
+        SOFTWARE            ///<cells get tested against the occluders in front of them on the CPU in the same frame, opt in, see m_occlusionMode
+    };
+
+    /**
+    How cells, and nodes if per object culling is on, get occlusion culled.  Only matters if m_performCull is on.
+
+    In SOFTWARE mode the depth pass occluders of each visible cell get rasterized into m_softwareOcclusionBuffer
+    as the frustum is traversed front to back, and every cell is tested against the buffer before its nodes are added.
+    This doesn't use the thread pool since each cell depends on the occluders of the cells before it.
+
+    SOFTWARE mode is opt in.  Only static meshes with StaticMeshNode::m_occluderBounds set occlude anything, and the culling is only
+    correct if those boxes are really inside the meshes.  A box that sticks out of its mesh culls visible things behind it.
+    */
+    OcclusionMode m_occlusionMode;
+
+    /**
+    The buffer used in SOFTWARE occlusion mode, set its resolution to trade accuracy for speed.
+    */
+    illRendererCommon::SoftwareOcclusionBuffer m_softwareOcclusionBuffer;
+
+    /**
+    If set, the moveable nodes in each visible cell are tested against the camera frustum all at once before being added,
+    using the bounds the scene keeps next to them in the cell.  Cells on the edge of the frustum usually have a lot
+    of nodes sticking out of it that would otherwise get rendered or occlusion queried for nothing.
+    */
+    bool m_frustumCullNodes;
+
     int m_debugNumTraversedCells;
     int m_debugNumQueries;
     int m_debugNumUnqueried;
@@ -72,6 +119,7 @@ public:
     int m_debugRequeryDuration;
     int m_debugNumRenderedNodes;
     int m_debugNumOverflowedQueries;
+    int m_debugNumFrustumCulledNodes;       //counted once for every visible cell a culled node is in
 
     int m_debugMaxCellTraversals;
 
@@ -86,8 +134,164 @@ protected:
     uint64_t m_queryInvisibilityDurationGrowth;
     size_t m_numFramesOverflowed;
 
+    /**
+    The frustum mesh edge list and iterator are kept around between frames so clipping and iterating the frustum
+    reuses their memory instead of allocating every frame.
+    */
+    MeshEdgeList<> m_frustumMeshEdgeList;
+    MultiConvexMeshIterator<> m_frustumIterator;
+
     size_t m_returnViewportId;  //the next viewport id that will be returned
-    std::unordered_map<size_t, Array<uint64_t>> m_queryFrames;
+    DeferredShadingBackend::CellQueryFrames m_queryFrames;
+
+private:
+    /**
+    The occlusion query bookkeeping for one render call.
+    */
+    struct CellQueryState {
+        size_t m_numQueries;
+        size_t m_numQueriesNeeded;
+        bool m_needsQuerySetup;
+        bool m_recordedOverflow;
+    };
+
+    /**
+    A cell the frustum iterator went through, recorded by the parallel traversal.
+    */
+    struct TraversedCell {
+        glm::uvec3 m_position;
+        unsigned int m_cellArrayIndex;
+        bool m_empty;
+    };
+
+    /**
+    What to do with a node found in a visible cell.  Figured out up front in traversal order by the parallel path.
+    */
+    struct NodeJob {
+        enum class Action {
+            QUERY,              ///<do an occlusion query for the node on the calling thread
+            RENDER_SERIAL,      ///<render the node into the main queues on the calling thread
+            RENDER_PARALLEL     ///<render the node into a worker's queues and merge the results in afterwards
+        };
+
+        illRendererCommon::GraphicsNode * m_node;
+        Action m_action;
+    };
+
+    /**
+    The range of node jobs that belong to a traversed cell.
+    */
+    struct CellJob {
+        const TraversedCell * m_cell;
+        size_t m_nodeJobsBegin;
+        size_t m_nodeJobsEnd;
+    };
+
+    /**
+    How far into each of a worker's sorted queues the worker got after rendering a node.
+    The previous node's output in the same worker gives where the node's entries start.
+    */
+    struct ParallelNodeOutput {
+        size_t m_depthPassEnd;
+        size_t m_solidEnd;
+        size_t m_unsolidEnd;
+    };
+
+    /**
+    Per worker render queues along with the arena they allocate from.
+    */
+    struct ParallelWorker {
+        inline ParallelWorker() {
+            m_renderQueues.m_frameArena = &m_frameArena;
+        }
+
+        FrameArena m_frameArena;
+        illRendererCommon::RenderQueues m_renderQueues;
+    };
+
+    inline void getCellQueryFrame(size_t viewport, const glm::uvec3& cellPosition, bool& visible, uint64_t& lastQueryFrame) const {
+        const SparseCellArray<uint64_t>& queryFrames = m_queryFrames.at(viewport);
+        visible = DeferredShadingBackend::decodeVisible(queryFrames.get(cellPosition));
+        lastQueryFrame = DeferredShadingBackend::codeFrame(queryFrames.get(cellPosition));
+    }
+
+    /**
+    Whether a cell was visible in the last frames, meaning its nodes get rendered.
+    */
+    inline bool isCellRendered(bool visible, uint64_t lastQueryFrame) const {
+        return (visible && lastQueryFrame >= m_frameCounter) || !m_performCull;
+    }
+
+    /**
+    Where a worker's contiguous run of the parallel rendered nodes starts.
+    */
+    inline size_t parallelChunkBegin(size_t worker, size_t numWorkers) const {
+        return m_parallelNodes.size() * worker / numWorkers;
+    }
+
+    /**
+    Tests the moveable nodes of a visible cell against the frustum, see m_frustumCullNodes.
+    Afterwards isCellNodeVisible says which of them are in it.
+    */
+    void frustumCullCellNodes(const NodeContainer& cell);
+
+    inline bool isCellNodeVisible(size_t nodeInd) const {
+        return !m_frustumCullNodes || (m_cellNodeVisibility[nodeInd >> 5] >> (nodeInd & 31) & 1) != 0;
+    }
+
+    /**
+    Adds a node found in a visible cell to the render queues, or does an occlusion query for it instead.
+    Nodes already added from another cell are skipped.
+    */
+    void addNode(const illGraphics::Camera& camera, size_t viewport, illRendererCommon::GraphicsNode * node);
+
+    /**
+    Rasterizes the occluder bounds of the static meshes in the depth pass queues into the software occlusion buffer.
+    Nodes without occluder bounds are skipped.
+    */
+    void rasterizeSoftwareOccluders();
+
+    /**
+    Does the occlusion query for a non empty cell if it's time to, and returns whether the cell's nodes should be rendered.
+    In SOFTWARE occlusion mode this tests the cell against the software occlusion buffer instead.
+    */
+    bool queryCell(const illGraphics::Camera& camera, size_t viewport,
+        const glm::uvec3& cellPosition, unsigned int cellArrayIndex, CellQueryState& queryState, void *& cellQuery);
+
+    /**
+    Ends the cell's query and draws whatever the cell added to the depth pass.
+    */
+    void depthPassCell(const illGraphics::Camera& camera, size_t viewport, CellQueryState& queryState, void * cellQuery);
+
+    void traverseSerial(const illGraphics::Camera& camera, size_t viewport, CellQueryState& queryState);
+
+    /**
+    Same as traverseSerial but the frustum traversal and the nodes' render calls run in the thread pool.
+
+    Each of the frustum iterator's sub iterators is walked on its own thread, then the visible cells' nodes
+    are split into contiguous runs, one per thread, and rendered into per worker queues.
+    Finally the cells are gone through again in traversal order on the calling thread to do the queries and depth passes
+    while merging the workers' queue entries in, so the queues end up in the same order as the serial path.
+    */
+    void traverseParallel(const illGraphics::Camera& camera, size_t viewport, CellQueryState& queryState);
+
+    void addParallelNodeJob(illRendererCommon::GraphicsNode * node, size_t viewport);
+
+    /**
+    Moves a node's entries from a worker's queues into the main queues, applying the depth pass limit.
+    */
+    void mergeParallelNode(illRendererCommon::RenderQueues& source, const ParallelNodeOutput& begin, const ParallelNodeOutput& end);
+
+    FrustumCullPlanes m_frustumCullPlanes;
+    std::vector<uint32_t> m_cellNodeVisibility;
+
+    //storage for the parallel path, kept around between frames to avoid reallocating
+    std::vector<std::vector<TraversedCell>> m_traversedCells;
+    std::vector<NodeJob> m_nodeJobs;
+    std::vector<CellJob> m_cellJobs;
+    std::vector<illRendererCommon::GraphicsNode *> m_parallelNodes;
+    std::vector<ParallelNodeOutput> m_parallelOutputs;
+    std::vector<ParallelWorker *> m_parallelWorkers;
 };
 
 }
@@ -36,6 +36,10 @@ inline GLenum getPrimitiveType(MeshData<>::PrimitiveGroup::Type type) {
     }
 }
 
+inline GLenum getIndexType(const MeshData<>& mesh) {
+    return mesh.getIndexSize() == sizeof(uint32_t) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
 namespace illDeferredShadingRenderer {
 
 void DeferredShadingBackendGl3_3::initialize(const glm::uvec2 screenResolution, illGraphics::ShaderProgramManager * shaderProgramManager) {
@@ -144,102 +148,102 @@ void DeferredShadingBackendGl3_3::initialize(const glm::uvec2 screenResolution,
     m_internalShaderProgramLoader = new illGraphics::ShaderProgramLoader(m_graphicsBackend, NULL);
 
     {
-        RefCountPtr<illGraphics::Shader> lightVertexShader(new illGraphics::Shader());
+        IntrusivePtr<illGraphics::Shader> lightVertexShader(new illGraphics::Shader());
         lightVertexShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.vert", GL_VERTEX_SHADER, "");
 
         //point light
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define POINT_LIGHT\n#define SPECULAR");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredPointLightProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //point light no specular
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define POINT_LIGHT");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredPointLightNoSpecProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //spot light
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define SPOT_LIGHT\n#define SPECULAR");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredSpotLightProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //spot light no specular 
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define SPOT_LIGHT");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredSpotLightNoSpecProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //point volume light
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define POINT_LIGHT\n#define VOLUME_LIGHT\n#define SPECULAR");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredDirectionVolumeLightProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //point volume light no specular
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define POINT_LIGHT\n#define VOLUME_LIGHT");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredDirectionVolumeLightNoSpecProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //direction volume light
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define DIRECTIONAL_LIGHT\n#define VOLUME_LIGHT\n#define SPECULAR");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredDirectionVolumeLightProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
 
         //direction volume light no specular
         {
-            std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+            std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
             shaders.push_back(lightVertexShader);
 
             illGraphics::Shader * fragShader = new illGraphics::Shader();
             fragShader->loadInternal(m_graphicsBackend, "shaders/deferredPhongLighting.frag", GL_FRAGMENT_SHADER, "#define DIRECTIONAL_LIGHT\n#define VOLUME_LIGHT");
 
-            shaders.push_back(RefCountPtr<illGraphics::Shader>(fragShader));
+            shaders.push_back(IntrusivePtr<illGraphics::Shader>(fragShader));
             m_deferredDirectionVolumeLightNoSpecProgram.loadInternal(m_internalShaderProgramLoader, shaders);
         }
     }
@@ -322,7 +326,7 @@ void DeferredShadingBackendGl3_3::setupViewport(const illGraphics::Camera& camer
     setupGbuffer();
 }
 
-void DeferredShadingBackendGl3_3::retreiveCellQueries(std::unordered_map<size_t, Array<uint64_t>>& lastViewedFrames, uint64_t lastFrameCounter, 
+void DeferredShadingBackendGl3_3::retreiveCellQueries(CellQueryFrames& lastViewedFrames, uint64_t lastFrameCounter, 
         uint64_t successDuration, uint64_t failureDuration, uint64_t randomAddMax) {    
     for(auto iter = m_cellQueries.begin(); iter != m_cellQueries.end(); iter++) {
         CellQuery& cellQuery = *iter;
@@ -331,7 +335,7 @@ void DeferredShadingBackendGl3_3::retreiveCellQueries(std::unordered_map<size_t,
             GLint result;
             glGetQueryObjectiv(cellQuery.m_query, GL_QUERY_RESULT, &result);
             
-            lastViewedFrames.at(cellQuery.m_viewport)[cellQuery.m_cellArrayIndex] = 
+            lastViewedFrames.at(cellQuery.m_viewport).getMutable(cellQuery.m_cellArrayIndex) = 
                 codeFrame(lastFrameCounter + (result != 0 ? successDuration : failureDuration) + (std::rand() % (randomAddMax + 1))) 
                 | encodeVisible(result != 0);
         }
@@ -476,7 +480,7 @@ void renderQueryBox(const illGraphics::Camera& camera, const illGraphics::Mesh&
     }
 #endif
 
-    glDrawRangeElements(GL_TRIANGLES, 0, boxMesh.getMeshFrontentData()->getNumInd(), boxMesh.getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+    glDrawRangeElements(GL_TRIANGLES, 0, boxMesh.getMeshFrontentData()->getNumInd(), boxMesh.getMeshFrontentData()->getNumInd(), getIndexType(*boxMesh.getMeshFrontentData()), (char *)NULL);
     glEndQuery(/*GL_SAMPLES_PASSED*/GL_ANY_SAMPLES_PASSED/*_CONSERVATIVE*/);
 }
 
@@ -602,7 +606,7 @@ void DeferredShadingBackendGl3_3::depthPass(illRendererCommon::RenderQueues& ren
 
                         glUniformMatrix4fv(getProgramUniformLocation(prog, "modelViewProjection"), 1, false, glm::value_ptr(m_occlusionCamera->getModelViewProjection() * node.m_node->getTransform()));
 
-                        glDrawRangeElements(GL_TRIANGLES, 0, mesh->getMeshFrontentData()->getNumInd(), mesh->getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+                        glDrawRangeElements(GL_TRIANGLES, 0, mesh->getMeshFrontentData()->getNumInd(), mesh->getMeshFrontentData()->getNumInd(), getIndexType(*mesh->getMeshFrontentData()), (char *)NULL);
 
                         glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y + camera.getViewportDimensions().y / 2,
                             camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
@@ -699,7 +703,7 @@ void DeferredShadingBackendGl3_3::depthPass(illRendererCommon::RenderQueues& ren
                         GLuint numInd = primitiveGroup.m_numIndices;
                         GLuint endInd = startInd + numInd;
                         
-                        glDrawRangeElements(getPrimitiveType(primitiveGroup.m_type), startInd, endInd, numInd, GL_UNSIGNED_SHORT, (char *)NULL + startInd * sizeof(uint16_t));
+                        glDrawRangeElements(getPrimitiveType(primitiveGroup.m_type), startInd, endInd, numInd, getIndexType(*mesh->getMeshFrontentData()), (char *)NULL + startInd * mesh->getMeshFrontentData()->getIndexSize());
                     }
                                         
                     if(node.m_node->getOcclusionCull()) {                        
@@ -714,6 +718,8 @@ void DeferredShadingBackendGl3_3::depthPass(illRendererCommon::RenderQueues& ren
         glDisableVertexAttribArray(posAttrib);
     }
 
+    depthPassSorted(renderQueues, camera, viewport);
+
     if(cellOcclusionQuery && m_performCull) {
         glEndConditionalRender();
     }
@@ -721,13 +727,109 @@ void DeferredShadingBackendGl3_3::depthPass(illRendererCommon::RenderQueues& ren
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    renderQueues.m_depthPassSolidStaticMeshes.clear();
+    renderQueues.clearDepthPass();
 
     if(m_debugOcclusion) {
         glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y, camera.getViewportDimensions().x, camera.getViewportDimensions().y);
     }
 }
 
+void DeferredShadingBackendGl3_3::depthPassSorted(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport) {
+    auto& queue = renderQueues.m_sortedDepthPassSolidStaticMeshes;
+
+    const illGraphics::ShaderProgram * currentProgram = NULL;
+    const illGraphics::Mesh * currentMesh = NULL;
+
+    GLuint prog = 0;
+    GLint posAttrib = -1;
+
+    for(size_t entry = 0; entry < queue.size(); entry++) {
+        const auto& payload = queue[entry];
+        const illGraphics::Mesh * mesh = payload.m_mesh;
+        const auto& node = payload.m_info;
+
+        if(payload.m_program != currentProgram) {
+            if(currentProgram) {
+                glDisableVertexAttribArray(posAttrib);
+            }
+
+            currentProgram = payload.m_program;
+            currentMesh = NULL;
+
+            prog = getProgram(*currentProgram);
+            glUseProgram(prog);
+
+            posAttrib = getProgramAttribLocation(prog, "positionIn");
+            glEnableVertexAttribArray(posAttrib);
+        }
+
+        //TODO: material specific states
+        //TODO: skinning attrib
+
+        if(mesh != currentMesh) {
+            currentMesh = mesh;
+
+            //bind VBO
+            {
+                GLuint buffer = *((GLuint *) mesh->getMeshBackendData() + 0);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            }
+
+            //bind IBO
+            {
+                GLuint buffer = *((GLuint *) mesh->getMeshBackendData() + 1);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+            }
+
+            //setup positions
+            glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, (GLsizei) mesh->getMeshFrontentData()->getVertexSize(), (char *)NULL + mesh->getMeshFrontentData()->getPositionOffset());
+        }
+
+        //DRAW!!!!
+        if(m_debugOcclusion) {
+            glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y,
+                camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
+
+            glUniformMatrix4fv(getProgramUniformLocation(prog, "modelViewProjection"), 1, false, glm::value_ptr(m_occlusionCamera->getModelViewProjection() * node.m_node->getTransform()));
+
+            glDrawRangeElements(GL_TRIANGLES, 0, mesh->getMeshFrontentData()->getNumInd(), mesh->getMeshFrontentData()->getNumInd(), getIndexType(*mesh->getMeshFrontentData()), (char *)NULL);
+
+            glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y + camera.getViewportDimensions().y / 2,
+                camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
+        }
+
+        glUniformMatrix4fv(getProgramUniformLocation(prog, "modelViewProjection"), 1, false, glm::value_ptr(camera.getModelViewProjection() * node.m_node->getTransform()));
+
+        if(node.m_node->getOcclusionCull()) {
+            m_nodeQueries.emplace_back();
+
+            glGenQueries(1, &m_nodeQueries.back().m_query);
+            m_nodeQueries.back().m_node = node.m_node;
+            m_nodeQueries.back().m_viewport = viewport;
+
+            glBeginQuery(/*GL_SAMPLES_PASSED*/GL_ANY_SAMPLES_PASSED, m_nodeQueries.back().m_query);
+        }
+
+        {
+            auto& primitiveGroup = mesh->getMeshFrontentData()->getPrimitiveGroup(node.m_primitiveGroup);
+
+            GLuint startInd = primitiveGroup.m_beginIndex;
+            GLuint numInd = primitiveGroup.m_numIndices;
+            GLuint endInd = startInd + numInd;
+            
+            glDrawRangeElements(getPrimitiveType(primitiveGroup.m_type), startInd, endInd, numInd, getIndexType(*mesh->getMeshFrontentData()), (char *)NULL + startInd * mesh->getMeshFrontentData()->getIndexSize());
+        }
+
+        if(node.m_node->getOcclusionCull()) {
+            glEndQuery(/*GL_SAMPLES_PASSED*/GL_ANY_SAMPLES_PASSED);
+        }
+    }
+
+    if(currentProgram) {
+        glDisableVertexAttribArray(posAttrib);
+    }
+}
+
 void renderDebugTexture(GLuint texture) {
     //debug
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -904,7 +1006,7 @@ void DeferredShadingBackendGl3_3::renderGbuffer(illRendererCommon::RenderQueues&
                             1, false, glm::value_ptr(glm::mat3(m_occlusionCamera->getModelView() * meshInfo.m_meshInfo.m_node->getTransform())));
 
                         glDrawRangeElements(GL_TRIANGLES, 0, 
-                            mesh->getMeshFrontentData()->getNumInd(), mesh->getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+                            mesh->getMeshFrontentData()->getNumInd(), mesh->getMeshFrontentData()->getNumInd(), getIndexType(*mesh->getMeshFrontentData()), (char *)NULL);
                         
                         glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y + camera.getViewportDimensions().y / 2,
                             camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
@@ -998,7 +1100,7 @@ void DeferredShadingBackendGl3_3::renderGbuffer(illRendererCommon::RenderQueues&
 
                         //LOG_DEBUG("Primitive Group %u", meshInfo.m_meshInfo.m_primitiveGroup);
 
-                        glDrawRangeElements(getPrimitiveType(primitiveGroup.m_type), startInd, endInd, numInd, GL_UNSIGNED_SHORT, (char *)NULL + startInd * sizeof(uint16_t));
+                        glDrawRangeElements(getPrimitiveType(primitiveGroup.m_type), startInd, endInd, numInd, getIndexType(*mesh->getMeshFrontentData()), (char *)NULL + startInd * mesh->getMeshFrontentData()->getIndexSize());
                     }
                 }
             }
@@ -1019,6 +1121,8 @@ void DeferredShadingBackendGl3_3::renderGbuffer(illRendererCommon::RenderQueues&
         glDisableVertexAttribArray(normAttrib);
     }
 
+    renderGbufferSorted(renderQueues, camera);
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
@@ -1027,6 +1131,204 @@ void DeferredShadingBackendGl3_3::renderGbuffer(illRendererCommon::RenderQueues&
     }
 }
 
+void DeferredShadingBackendGl3_3::renderGbufferSorted(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera) {
+    auto& queue = renderQueues.m_sortedSolidStaticMeshes;
+
+    const illGraphics::ShaderProgram * currentProgram = NULL;
+    const illGraphics::Material * currentMaterial = NULL;
+    const illGraphics::Mesh * currentMesh = NULL;
+
+    GLuint prog = 0;
+    GLint posAttrib = -1;
+    GLint normAttrib = -1;
+
+    //-2 means unneeded, -1 means needed and will be initialized afterwards
+    GLint texCoordAttrib = -2;
+    GLint tangentsAttrib = -2;
+    GLint bitangentsAttrib = -2;     //bitangents implicitly needed along with tangents
+
+    for(size_t entry = 0; entry < queue.size(); entry++) {
+        const auto& payload = queue[entry];
+        const illGraphics::Material * material = payload.m_material;
+        const illGraphics::Mesh * mesh = payload.m_mesh;
+        const auto& meshInfo = payload.m_info;
+
+        //material attributes depend on the program, so a new program also means redoing the material
+        if(payload.m_program != currentProgram || material != currentMaterial) {
+            if(texCoordAttrib >= 0) {
+                glDisableVertexAttribArray(texCoordAttrib);
+            }
+
+            if(tangentsAttrib >= 0) {
+                glDisableVertexAttribArray(tangentsAttrib);
+                glDisableVertexAttribArray(bitangentsAttrib);
+            }
+
+            texCoordAttrib = -2;
+            tangentsAttrib = -2;
+
+            //TODO: disable skinning attrib
+
+            if(payload.m_program != currentProgram) {
+                if(currentProgram) {
+                    glDisableVertexAttribArray(posAttrib);
+                    glDisableVertexAttribArray(normAttrib);
+                }
+
+                currentProgram = payload.m_program;
+
+                prog = getProgram(*currentProgram);
+                glUseProgram(prog);
+
+                posAttrib = getProgramAttribLocation(prog, "positionIn");
+                glEnableVertexAttribArray(posAttrib);
+
+                //TODO: forward rendering on fullbright solid objects
+                normAttrib = getProgramAttribLocation(prog, "normalIn");
+                glEnableVertexAttribArray(normAttrib);
+            }
+
+            currentMaterial = material;
+            currentMesh = NULL;
+
+            //pass material colors
+            glUniform3fv(getProgramUniformLocation(prog, "diffuseColor"), 1, glm::value_ptr(material->getLoadArgs().m_diffuseBlend));
+            glUniform4fv(getProgramUniformLocation(prog, "specularColor"), 1, glm::value_ptr(material->getLoadArgs().m_specularBlend));
+
+            //textures
+            if(material->getLoadArgs().m_diffuseTextureIndex >= 0) {
+                texCoordAttrib = -1;
+
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, getTexture(*material->getDiffuseTexture()));
+                glUniform1i(getProgramUniformLocation(prog, "diffuseMap"), 0);
+            }
+
+            if(material->getLoadArgs().m_specularTextureIndex >= 0) {
+                texCoordAttrib = -1;
+
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, getTexture(*material->getSpecularTexture()));
+                glUniform1i(getProgramUniformLocation(prog, "specularMap"), 1);
+            }
+
+            if(material->getLoadArgs().m_normalTextureIndex >= 0) {
+                texCoordAttrib = -1;
+                tangentsAttrib = -1;
+
+                glActiveTexture(GL_TEXTURE2);
+                glBindTexture(GL_TEXTURE_2D, getTexture(*material->getNormalTexture()));
+                glUniform1i(getProgramUniformLocation(prog, "normalMap"), 2);
+            }
+
+            if(texCoordAttrib == -1) {
+                texCoordAttrib = getProgramAttribLocation(prog, "texCoordIn");
+                glEnableVertexAttribArray(texCoordAttrib);
+            }
+
+            if(tangentsAttrib == -1) {
+                tangentsAttrib = getProgramAttribLocation(prog, "tangentIn");
+                glEnableVertexAttribArray(tangentsAttrib);
+
+                bitangentsAttrib = getProgramAttribLocation(prog, "bitangentIn");
+                glEnableVertexAttribArray(bitangentsAttrib);
+            }
+
+            //TODO: skinning attrib
+        }
+
+        if(mesh != currentMesh) {
+            currentMesh = mesh;
+
+            //bind VBO
+            {
+                GLuint buffer = *((GLuint *) mesh->getMeshBackendData() + 0);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            }
+
+            //bind IBO
+            {
+                GLuint buffer = *((GLuint *) mesh->getMeshBackendData() + 1);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+            }
+
+            //setup positions
+            glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 
+                (GLsizei) mesh->getMeshFrontentData()->getVertexSize(), (char *)NULL + mesh->getMeshFrontentData()->getPositionOffset());
+
+            //setup tex coords
+            if(texCoordAttrib >= 0) {
+                glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 
+                    (GLsizei) mesh->getMeshFrontentData()->getVertexSize(), (char *)NULL + mesh->getMeshFrontentData()->getTexCoordOffset());
+            }
+
+            //setup normals
+            glVertexAttribPointer(normAttrib, 3, GL_FLOAT, GL_FALSE, 
+                (GLsizei) mesh->getMeshFrontentData()->getVertexSize(), (char *)NULL + mesh->getMeshFrontentData()->getNormalOffset());
+            
+            //setup tangents
+            if(tangentsAttrib >= 0) {
+                glVertexAttribPointer(tangentsAttrib, 3, GL_FLOAT, GL_FALSE, 
+                    (GLsizei) mesh->getMeshFrontentData()->getVertexSize(), (char *)NULL + mesh->getMeshFrontentData()->getTangentOffset());
+
+                //setup bitangents
+                glVertexAttribPointer(bitangentsAttrib, 3, GL_FLOAT, GL_FALSE, 
+                    (GLsizei) mesh->getMeshFrontentData()->getVertexSize(), (char *)NULL + mesh->getMeshFrontentData()->getBitangentOffset());
+            }
+
+            //TODO: skinning
+        }
+
+        //DRAW!!!!
+        if(m_debugOcclusion) {
+            glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y,
+                camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
+
+            glUniformMatrix4fv(getProgramUniformLocation(prog, "modelViewProjection"), 
+                1, false, glm::value_ptr(m_occlusionCamera->getModelViewProjection() * meshInfo.m_meshInfo.m_node->getTransform()));
+
+            glUniformMatrix3fv(getProgramUniformLocation(prog, "normalMat"), 
+                1, false, glm::value_ptr(glm::mat3(m_occlusionCamera->getModelView() * meshInfo.m_meshInfo.m_node->getTransform())));
+
+            glDrawRangeElements(GL_TRIANGLES, 0, 
+                mesh->getMeshFrontentData()->getNumInd(), mesh->getMeshFrontentData()->getNumInd(), getIndexType(*mesh->getMeshFrontentData()), (char *)NULL);
+            
+            glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y + camera.getViewportDimensions().y / 2,
+                camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
+        }
+
+        glUniformMatrix4fv(getProgramUniformLocation(prog, "modelViewProjection"), 
+            1, false, glm::value_ptr(camera.getModelViewProjection() * meshInfo.m_meshInfo.m_node->getTransform()));
+
+        glUniformMatrix3fv(getProgramUniformLocation(prog, "normalMat"), 
+            1, false, glm::value_ptr(glm::mat3(camera.getModelView() * meshInfo.m_meshInfo.m_node->getTransform())));
+
+        {
+            auto& primitiveGroup = mesh->getMeshFrontentData()->getPrimitiveGroup(meshInfo.m_meshInfo.m_primitiveGroup);
+
+            GLuint startInd = primitiveGroup.m_beginIndex;
+            GLuint numInd = primitiveGroup.m_numIndices;
+            GLuint endInd = startInd + numInd;
+
+            glDrawRangeElements(getPrimitiveType(primitiveGroup.m_type), startInd, endInd, numInd, getIndexType(*mesh->getMeshFrontentData()), (char *)NULL + startInd * mesh->getMeshFrontentData()->getIndexSize());
+        }
+    }
+
+    if(texCoordAttrib >= 0) {
+        glDisableVertexAttribArray(texCoordAttrib);
+    }
+
+    if(tangentsAttrib >= 0) {
+        glDisableVertexAttribArray(tangentsAttrib);
+        glDisableVertexAttribArray(bitangentsAttrib);
+    }
+
+    if(currentProgram) {
+        glDisableVertexAttribArray(posAttrib);
+        glDisableVertexAttribArray(normAttrib);
+    }
+}
+
 void DeferredShadingBackendGl3_3::renderAmbientPass(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera) {
     /*glUseProgram(m_ambientPassProgram->getShaderProgram());
    
@@ -1387,7 +1689,7 @@ void DeferredShadingBackendGl3_3::renderLights(illRendererCommon::RenderQueues&
 
                         glUniform1i(getProgramUniformLocation(prog, "noLighting"), 1);
   
-                        glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+                        glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), getIndexType(*m_box.getMeshFrontentData()), (char *)NULL);
                     }
 
                     /*
@@ -1448,7 +1750,7 @@ void DeferredShadingBackendGl3_3::renderLights(illRendererCommon::RenderQueues&
 
                     glUniform1i(getProgramUniformLocation(prog, "noLighting"), 0);
 
-                    glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+                    glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), getIndexType(*m_box.getMeshFrontentData()), (char *)NULL);
                     
                     glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y + camera.getViewportDimensions().y / 2,
                         camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
@@ -1641,7 +1943,7 @@ void DeferredShadingBackendGl3_3::renderLights(illRendererCommon::RenderQueues&
                         assert(val[0] == GL_FALSE && val[1] == GL_FALSE && val[2] == GL_FALSE && val[3] == GL_FALSE);
                     }
 #endif
-                    glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+                    glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), getIndexType(*m_box.getMeshFrontentData()), (char *)NULL);
 
                     glEndQuery(/*GL_SAMPLES_PASSED*/GL_ANY_SAMPLES_PASSED);
                 }
@@ -1769,7 +2071,7 @@ void DeferredShadingBackendGl3_3::renderLights(illRendererCommon::RenderQueues&
                     assert(val[0] == GL_TRUE && val[1] == GL_TRUE && val[2] == GL_TRUE && val[3] == GL_TRUE);
                 }
 #endif
-                glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), GL_UNSIGNED_SHORT, (char *)NULL);
+                glDrawRangeElements(GL_TRIANGLES, 0, m_box.getMeshFrontentData()->getNumInd(), m_box.getMeshFrontentData()->getNumInd(), getIndexType(*m_box.getMeshFrontentData()), (char *)NULL);
 
                 glEndConditionalRender();
 
@@ -2230,6 +2532,46 @@ void DeferredShadingBackendGl3_3::renderDebugBounds(illRendererCommon::RenderQue
         }
     }
 
+    for(size_t entry = 0; entry < renderQueues.m_sortedSolidStaticMeshes.size(); entry++) {
+        const auto& meshInfo = renderQueues.m_sortedSolidStaticMeshes[entry].m_info;
+
+        if(m_debugOcclusion) {
+            glMatrixMode(GL_PROJECTION);
+            glLoadIdentity();
+
+            glMultMatrixf(glm::value_ptr(m_occlusionCamera->getProjection()));
+
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+
+            glMultMatrixf(glm::value_ptr(m_occlusionCamera->getModelView()));
+
+            glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y,
+                camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
+            
+            glEnable(GL_DEPTH_TEST);
+
+            renderNodeBounds(meshInfo.m_meshInfo.m_node);
+
+            glDisable(GL_DEPTH_TEST);
+            
+            glMatrixMode(GL_PROJECTION);
+            glLoadIdentity();
+
+            glMultMatrixf(glm::value_ptr(camera.getProjection()));
+
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+
+            glMultMatrixf(glm::value_ptr(camera.getModelView()));
+
+            glViewport(camera.getViewportCorner().x, camera.getViewportCorner().y + camera.getViewportDimensions().y / 2,
+                camera.getViewportDimensions().x, camera.getViewportDimensions().y / 2);
+        }
+
+        renderNodeBounds(meshInfo.m_meshInfo.m_node);
+    }
+
     for(auto lightTypeIter = renderQueues.m_lights.begin(); lightTypeIter != renderQueues.m_lights.end(); lightTypeIter++) {        
         auto& lights = lightTypeIter->second;
 
@@ -2281,7 +2623,7 @@ void DeferredShadingBackendGl3_3::renderDebugBounds(illRendererCommon::RenderQue
 
 void DeferredShadingBackendGl3_3::render(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport,
         const GridVolume3D<>* debugGridVolume,
-        const std::unordered_map<size_t, Array<uint64_t>>* debugLastViewedFrames, uint64_t debugFrameCounter,
+        const CellQueryFrames* debugLastViewedFrames, uint64_t debugFrameCounter,
         int debugTraversals) {
     //enable depth mask
     glDepthMask(GL_TRUE);
@@ -2394,7 +2736,7 @@ void DeferredShadingBackendGl3_3::render(illRendererCommon::RenderQueues& render
                 camera.getViewFrustum().m_direction);
             
             //renderSceneDebug(*debugGridVolume);
-            for(size_t iter = 0; iter < frustumIterator.m_meshEdgeListCopies.size(); iter++) {
+            for(size_t iter = 0; iter < frustumIterator.m_numIterators; iter++) {
                 renderMeshEdgeListDebugAlgorithmToWorld(frustumIterator.m_meshEdgeListCopies[iter], frustumIterator.m_iterators[iter]);
             }
 
@@ -2409,8 +2751,8 @@ void DeferredShadingBackendGl3_3::render(illRendererCommon::RenderQueues& render
 
                 ++traversedCells;
 
-                bool visible = DeferredShadingBackend::decodeVisible(debugLastViewedFrames->at(viewport)[currentCell]);
-                uint64_t lastQueryFrame = DeferredShadingBackend::codeFrame(debugLastViewedFrames->at(viewport)[currentCell]);
+                bool visible = DeferredShadingBackend::decodeVisible(debugLastViewedFrames->at(viewport).get(currentCell));
+                uint64_t lastQueryFrame = DeferredShadingBackend::codeFrame(debugLastViewedFrames->at(viewport).get(currentCell));
 
                 Box<> cellBox(debugGridVolume->getCellDimensions() * 0.01f, debugGridVolume->getCellDimensions() - debugGridVolume->getCellDimensions() * 0.01f);
                 cellBox += vec3cast<unsigned int, glm::mediump_float>(frustumIterator.getCurrentPosition()) * debugGridVolume->getCellDimensions();
@@ -2520,7 +2862,7 @@ void DeferredShadingBackendGl3_3::render(illRendererCommon::RenderQueues& render
                 camera.getViewFrustum().m_direction);
             
             //renderSceneDebug(*debugGridVolume);
-            for(size_t iter = 0; iter < frustumIterator.m_meshEdgeListCopies.size(); iter++) {
+            for(size_t iter = 0; iter < frustumIterator.m_numIterators; iter++) {
                 renderMeshEdgeListDebugAlgorithmToWorld(frustumIterator.m_meshEdgeListCopies[iter], frustumIterator.m_iterators[iter]);
             }
 
@@ -2535,8 +2877,8 @@ void DeferredShadingBackendGl3_3::render(illRendererCommon::RenderQueues& render
 
                 ++traversedCells;
 
-                bool visible = DeferredShadingBackend::decodeVisible(debugLastViewedFrames->at(viewport)[currentCell]);
-                uint64_t lastQueryFrame = DeferredShadingBackend::codeFrame(debugLastViewedFrames->at(viewport)[currentCell]);
+                bool visible = DeferredShadingBackend::decodeVisible(debugLastViewedFrames->at(viewport).get(currentCell));
+                uint64_t lastQueryFrame = DeferredShadingBackend::codeFrame(debugLastViewedFrames->at(viewport).get(currentCell));
 
                 Box<> cellBox(debugGridVolume->getCellDimensions() * 0.01f, debugGridVolume->getCellDimensions() - debugGridVolume->getCellDimensions() * 0.01f);
                 cellBox += vec3cast<unsigned int, glm::mediump_float>(frustumIterator.getCurrentPosition()) * debugGridVolume->getCellDimensions();
@@ -28,7 +28,7 @@ public:
 
     virtual void setupFrame();
     virtual void setupViewport(const illGraphics::Camera& camera);
-    virtual void retreiveCellQueries(std::unordered_map<size_t, Array<uint64_t>>& lastViewedFrames, uint64_t lastFrameCounter, 
+    virtual void retreiveCellQueries(CellQueryFrames& lastViewedFrames, uint64_t lastFrameCounter, 
         uint64_t successDuration, uint64_t failureDuration, uint64_t randomAddMax = 0);
     virtual void retreiveNodeQueries(uint64_t lastFrameCounter);
 
@@ -41,7 +41,7 @@ public:
 
     virtual void render(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport,
         const GridVolume3D<>* debugGridVolume = NULL,
-        const std::unordered_map<size_t, Array<uint64_t>>* debugLastViewedFrames = NULL, uint64_t debugFrameCounter = 0,
+        const CellQueryFrames* debugLastViewedFrames = NULL, uint64_t debugFrameCounter = 0,
         int debugTraversals = -1);
 
 private:
@@ -60,6 +60,13 @@ private:
 
     void setupGbuffer();
 
+    /**
+    The depth pass and gbuffer pass for the sorted render queues.
+    Since the entries come in sorted by shader, material, then mesh, these only change GL state when the next entry differs from the last.
+    */
+    void depthPassSorted(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport);
+    void renderGbufferSorted(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera);
+
     void renderGbuffer(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera);
     void renderAmbientPass(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera);
     void renderEmissivePass(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera);
@@ -98,7 +105,7 @@ private:
     illGraphics::ShaderProgram m_deferredPointVolumeLightNoSpecProgram;
     illGraphics::ShaderProgram m_deferredDirectionVolumeLightProgram;
     illGraphics::ShaderProgram m_deferredDirectionVolumeLightNoSpecProgram;
-    RefCountPtr<illGraphics::ShaderProgram> m_volumeRenderProgram;
+    IntrusivePtr<illGraphics::ShaderProgram> m_volumeRenderProgram;
 
     //TODO: have these be some kind of utility meshes?
     //I might use geometry shaders later, maybe...
@@ -0,0 +1,160 @@
+#include <cstdlib>
+
+#include "DeferredShadingBackendNull.h"
+#include "RendererCommon/serial/GraphicsNode.h"
+
+namespace illDeferredShadingRenderer {
+
+void DeferredShadingBackendNull::initialize(const glm::uvec2 screenResolution, illGraphics::ShaderProgramManager * shaderProgramManager) {
+    m_state = State::INITIALIZED;
+}
+
+void DeferredShadingBackendNull::uninitialize() {
+    m_cellQueries.clear();
+    m_nodeQueries.clear();
+
+    m_state = State::UNINITIALIZED;
+}
+
+void DeferredShadingBackendNull::setupFrame() {
+    ++m_stats.m_frames;
+}
+
+void DeferredShadingBackendNull::setupViewport(const illGraphics::Camera& camera) {
+    ++m_stats.m_viewports;
+}
+
+void DeferredShadingBackendNull::retreiveCellQueries(CellQueryFrames& lastViewedFrames, uint64_t lastFrameCounter,
+        uint64_t successDuration, uint64_t failureDuration, uint64_t randomAddMax) {
+    for(auto iter = m_cellQueries.begin(); iter != m_cellQueries.end(); iter++) {
+        CellQuery& cellQuery = *iter;
+
+        //same as what the GL backend writes
+        lastViewedFrames.at(cellQuery.m_viewport).getMutable(cellQuery.m_cellArrayIndex) =
+            codeFrame(lastFrameCounter + (cellQuery.m_visible ? successDuration : failureDuration) + (std::rand() % (randomAddMax + 1)))
+            | encodeVisible(cellQuery.m_visible);
+    }
+
+    m_cellQueries.clear();
+}
+
+void DeferredShadingBackendNull::retreiveNodeQueries(uint64_t lastFrameCounter) {
+    for(auto iter = m_nodeQueries.begin(); iter != m_nodeQueries.end(); iter++) {
+        NodeQuery& nodeQuery = *iter;
+
+        if(!nodeQuery.m_visible) {
+            nodeQuery.m_node->setLastNonvisibleFrame(nodeQuery.m_viewport, lastFrameCounter);
+        }
+    }
+
+    m_nodeQueries.clear();
+}
+
+void DeferredShadingBackendNull::setupQuery() {
+    ++m_stats.m_querySetups;
+}
+
+void DeferredShadingBackendNull::endQuery() {
+}
+
+void * DeferredShadingBackendNull::occlusionQueryCell(const illGraphics::Camera& camera, const glm::vec3& cellCenter, const glm::vec3& cellSize,
+        unsigned int cellArrayIndex, size_t viewport, bool debugDraw) {
+    if(!m_performCull) {
+        return NULL;
+    }
+
+    CellQuery cellQuery;
+    cellQuery.m_viewport = viewport;
+    cellQuery.m_cellArrayIndex = cellArrayIndex;
+    cellQuery.m_visible = !m_cellVisibility || m_cellVisibility(camera, cellArrayIndex, viewport);
+
+    m_cellQueries.push_back(cellQuery);
+
+    ++m_stats.m_cellQueries;
+
+    if(!cellQuery.m_visible) {
+        ++m_stats.m_cellsOccluded;
+    }
+
+    //the query's position in the list plus one so it's never NULL, the list can reallocate so no pointing into it
+    return (void *) (uintptr_t) m_cellQueries.size();
+}
+
+void * DeferredShadingBackendNull::occlusionQueryNode(const illGraphics::Camera& camera, illRendererCommon::GraphicsNode * node, size_t viewport) {
+    if(!m_performCull) {
+        return NULL;
+    }
+
+    NodeQuery nodeQuery;
+    nodeQuery.m_viewport = viewport;
+    nodeQuery.m_node = node;
+    nodeQuery.m_visible = !m_nodeVisibility || m_nodeVisibility(camera, node, viewport);
+
+    m_nodeQueries.push_back(nodeQuery);
+
+    ++m_stats.m_nodeQueries;
+
+    if(!nodeQuery.m_visible) {
+        ++m_stats.m_nodesOccluded;
+    }
+
+    return NULL;
+}
+
+void DeferredShadingBackendNull::depthPass(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, void * cellOcclusionQuery, size_t viewport) {
+    ++m_stats.m_depthPasses;
+
+    size_t numObjects = renderQueues.m_sortedDepthPassSolidStaticMeshes.size();
+
+    for(auto shaderIter = renderQueues.m_depthPassSolidStaticMeshes.begin(); shaderIter != renderQueues.m_depthPassSolidStaticMeshes.end(); shaderIter++) {
+        for(auto materialIter = shaderIter->second.begin(); materialIter != shaderIter->second.end(); materialIter++) {
+            for(auto meshIter = materialIter->second.begin(); meshIter != materialIter->second.end(); meshIter++) {
+                numObjects += meshIter->second.size();
+            }
+        }
+    }
+
+    //the GL backend draws these with a conditional render on the cell's query
+    if(cellOcclusionQuery && m_performCull && !m_cellQueries[(uintptr_t) cellOcclusionQuery - 1].m_visible) {
+        m_stats.m_depthPassObjectsSkipped += numObjects;
+    }
+    else {
+        m_stats.m_depthPassObjects += numObjects;
+    }
+
+    renderQueues.clearDepthPass();
+}
+
+void DeferredShadingBackendNull::render(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport,
+        const GridVolume3D<>* debugGridVolume,
+        const CellQueryFrames* debugLastViewedFrames, uint64_t debugFrameCounter,
+        int debugTraversals) {
+    ++m_stats.m_renders;
+
+    m_stats.m_solidObjects += renderQueues.m_sortedSolidStaticMeshes.size();
+    m_stats.m_unsolidObjects += renderQueues.m_sortedUnsolidStaticMeshes.size();
+
+    for(auto shaderIter = renderQueues.m_solidStaticMeshes.begin(); shaderIter != renderQueues.m_solidStaticMeshes.end(); shaderIter++) {
+        for(auto materialIter = shaderIter->second.begin(); materialIter != shaderIter->second.end(); materialIter++) {
+            for(auto meshIter = materialIter->second.begin(); meshIter != materialIter->second.end(); meshIter++) {
+                m_stats.m_solidObjects += meshIter->second.size();
+            }
+        }
+    }
+
+    for(auto shaderIter = renderQueues.m_unsolidStaticMeshes.begin(); shaderIter != renderQueues.m_unsolidStaticMeshes.end(); shaderIter++) {
+        for(auto materialIter = shaderIter->second.begin(); materialIter != shaderIter->second.end(); materialIter++) {
+            for(auto meshIter = materialIter->second.begin(); meshIter != materialIter->second.end(); meshIter++) {
+                m_stats.m_unsolidObjects += meshIter->second.size();
+            }
+        }
+    }
+
+    for(auto lightTypeIter = renderQueues.m_lights.begin(); lightTypeIter != renderQueues.m_lights.end(); lightTypeIter++) {
+        for(auto lightIter = lightTypeIter->second.begin(); lightIter != lightTypeIter->second.end(); lightIter++) {
+            m_stats.m_lightInstances += lightIter->second.size();
+        }
+    }
+}
+
+}
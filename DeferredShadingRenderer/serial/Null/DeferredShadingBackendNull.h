@@ -0,0 +1,120 @@
+#ifndef ILL_DEFERRED_SHADING_BACKEND_NULL_H_
+#define ILL_DEFERRED_SHADING_BACKEND_NULL_H_
+
+#include <functional>
+#include <vector>
+
+#include "DeferredShadingRenderer/DeferredShadingBackend.h"
+
+namespace illDeferredShadingRenderer {
+
+/**
+A backend that doesn't draw anything or need a graphics context.
+
+It goes through the same motions as a real backend would as far as the scene can tell.
+Occlusion queries issued during a frame get their results handed back in the next frame's
+retreiveCellQueries and retreiveNodeQueries, with the results coming from the visibility functions.
+Everything it gets asked to do is counted up in the stats.
+
+This lets the CPU side of the scene traversal, culling, and render queue building be tested and benchmarked
+on machines without a GPU.
+*/
+class DeferredShadingBackendNull : public DeferredShadingBackend {
+public:
+    /**
+    Decides whether a queried cell is visible.
+    */
+    typedef std::function<bool (const illGraphics::Camera& camera, unsigned int cellArrayIndex, size_t viewport)> CellVisibility;
+
+    /**
+    Decides whether a queried node is visible.
+    */
+    typedef std::function<bool (const illGraphics::Camera& camera, const illRendererCommon::GraphicsNode * node, size_t viewport)> NodeVisibility;
+
+    /**
+    Running counts of what the backend was asked to do.
+    */
+    struct Stats {
+        size_t m_frames;
+        size_t m_viewports;
+        size_t m_querySetups;
+        size_t m_cellQueries;
+        size_t m_cellsOccluded;             ///<cell queries that came back not visible
+        size_t m_nodeQueries;
+        size_t m_nodesOccluded;             ///<node queries that came back not visible
+        size_t m_depthPasses;
+        size_t m_depthPassObjects;          ///<depth pass entries that would have been drawn
+        size_t m_depthPassObjectsSkipped;   ///<depth pass entries that the conditional render would have skipped since the cell query failed
+        size_t m_solidObjects;
+        size_t m_unsolidObjects;
+        size_t m_lightInstances;
+        size_t m_renders;
+    };
+
+    DeferredShadingBackendNull()
+        : DeferredShadingBackend(NULL)
+    {
+        resetStats();
+    }
+
+    virtual void initialize(const glm::uvec2 screenResolution, illGraphics::ShaderProgramManager * shaderProgramManager);
+    virtual void uninitialize();
+
+    virtual void setupFrame();
+    virtual void setupViewport(const illGraphics::Camera& camera);
+    virtual void retreiveCellQueries(CellQueryFrames& lastViewedFrames, uint64_t lastFrameCounter,
+        uint64_t successDuration, uint64_t failureDuration, uint64_t randomAddMax = 0);
+    virtual void retreiveNodeQueries(uint64_t lastFrameCounter);
+
+    virtual void setupQuery();
+    virtual void endQuery();
+    virtual void * occlusionQueryCell(const illGraphics::Camera& camera, const glm::vec3& cellCenter, const glm::vec3& cellSize,
+        unsigned int cellArrayIndex, size_t viewport, bool debugDraw = false);
+    virtual void * occlusionQueryNode(const illGraphics::Camera& camera, illRendererCommon::GraphicsNode * node, size_t viewport);
+    virtual void depthPass(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, void * cellOcclusionQuery, size_t viewport);
+
+    virtual void render(illRendererCommon::RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport,
+        const GridVolume3D<>* debugGridVolume = NULL,
+        const CellQueryFrames* debugLastViewedFrames = NULL, uint64_t debugFrameCounter = 0,
+        int debugTraversals = -1);
+
+    inline const Stats& getStats() const {
+        return m_stats;
+    }
+
+    inline void resetStats() {
+        m_stats = Stats();
+    }
+
+    /**
+    Where cell query results come from.  If not set, every cell is visible.
+    */
+    CellVisibility m_cellVisibility;
+
+    /**
+    Where node query results come from.  If not set, every node is visible.
+    */
+    NodeVisibility m_nodeVisibility;
+
+private:
+    struct CellQuery {
+        size_t m_viewport;
+        unsigned int m_cellArrayIndex;
+        bool m_visible;
+    };
+
+    struct NodeQuery {
+        size_t m_viewport;
+        const illRendererCommon::GraphicsNode * m_node;
+        bool m_visible;
+    };
+
+    std::vector<CellQuery> m_cellQueries;
+    std::vector<NodeQuery> m_nodeQueries;
+
+    Stats m_stats;
+};
+
+}
+
+#endif
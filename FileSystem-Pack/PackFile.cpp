@@ -0,0 +1,55 @@
+#include <cassert>
+#include <cstring>
+
+#include "PackFile.h"
+#include "Logging/logging.h"
+
+namespace illPack {
+void PackFile::close() {
+    delete[] m_ownedData;
+    m_ownedData = NULL;
+    m_data = NULL;
+    m_state = File::State::ST_CLOSED;
+}
+
+size_t PackFile::getSize() {
+    return m_size;
+}
+
+size_t PackFile::tell() {
+    return m_position;
+}
+
+void PackFile::seek(size_t offset) {
+    if(offset > m_size) {
+        LOG_FATAL_ERROR("Failed to seek into file %s with offset %u, the file is only %u bytes.", getFileName(), (unsigned int) offset, (unsigned int) m_size);
+    }
+
+    m_position = offset;
+}
+
+void PackFile::seekAhead(size_t offset) {
+    seek(m_position + offset);
+}
+
+bool PackFile::eof() {
+    return m_position >= m_size;
+}
+
+void PackFile::read(void* destination, size_t size) {
+    assert(destination);
+	assert(getState() == File::State::ST_READ);
+
+    if(m_size - m_position < size) {
+        LOG_FATAL_ERROR("Failed to read %u bytes from file %s, only %u left.", (unsigned int) size, getFileName(), (unsigned int) (m_size - m_position));
+    }
+
+    memcpy(destination, m_data + m_position, size);
+    m_position += size;
+}
+
+void PackFile::write(const void* /*source*/, size_t /*size*/) {
+    LOG_FATAL_ERROR("Can't write to file %s in a pack.", getFileName());
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef ILL_PACK_FILE_H__
+#define ILL_PACK_FILE_H__
+
+#include <stdint.h>
+#include "FileSystem/File.h"
+
+namespace illPack {
+class PackFileSystem;
+
+/**
+A file in a mounted pack.  It's just a slice of memory so reading is a memcpy and seeking is setting an offset.
+
+Uncompressed files point straight into the mapped pack, so nothing is copied until something reads.
+Compressed files get decompressed into a buffer the file owns when opened.
+
+Pack files are read only.
+*/
+class PackFile : public illFileSystem::File {
+public:
+    virtual ~PackFile() {
+        delete[] m_ownedData;
+    }
+
+    virtual void close();
+
+    virtual size_t getSize();
+
+    virtual size_t tell();
+
+    virtual void seek(size_t offset);
+    virtual void seekAhead(size_t offset);
+    virtual bool eof();
+
+    virtual void read(void* destination, size_t size);
+	virtual void write(const void* source, size_t size);
+
+    /**
+    The whole file contents for loaders that can use them in place instead of reading them out.
+    This is only valid while the file is open and the pack stays mounted.
+    */
+    inline const uint8_t * getData() const {
+        return m_data;
+    }
+
+private:
+    PackFile(const uint8_t * data, size_t size, uint8_t * ownedData, const char * fileName)
+        : File(File::State::ST_READ, fileName),
+        m_data(data),
+        m_size(size),
+        m_position(0),
+        m_ownedData(ownedData)
+    {}
+
+    const uint8_t * m_data;
+    size_t m_size;
+    size_t m_position;
+
+    uint8_t * m_ownedData;          ///<The decompressed data if the file is compressed in the pack, NULL otherwise
+
+friend PackFileSystem;
+};
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "PackFileSystem.h"
+#include "PackFile.h"
+
+#include "Logging/logging.h"
+#include "Util/endian.h"
+
+#ifdef ILL_PACK_LZ4
+#include <lz4.h>
+#endif
+
+namespace illPack {
+
+inline uint16_t packRead16(const uint8_t * source) {
+    uint16_t value;
+    memcpy(&value, source, sizeof(uint16_t));
+    return little16(value);
+}
+
+inline uint32_t packRead32(const uint8_t * source) {
+    uint32_t value;
+    memcpy(&value, source, sizeof(uint32_t));
+    return little32(value);
+}
+
+inline uint64_t packRead64(const uint8_t * source) {
+    uint64_t value;
+    memcpy(&value, source, sizeof(uint64_t));
+    return little64(value);
+}
+
+PackFileSystem::~PackFileSystem() {
+    for(size_t pack = 0; pack < m_packs.size(); pack++) {
+        unmapPack(*m_packs[pack]);
+        delete m_packs[pack];
+    }
+}
+
+bool PackFileSystem::mapPack(Pack& pack) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(pack.m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    //the mapping keeps the file open on its own
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+
+    if(mapping == NULL) {
+        return false;
+    }
+
+    void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if(data == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    pack.m_data = (const uint8_t *) data;
+    pack.m_size = (size_t) size.QuadPart;
+    pack.m_mapping = mapping;
+#else
+    int file = open(pack.m_path.c_str(), O_RDONLY);
+
+    if(file == -1) {
+        return false;
+    }
+
+    struct stat st;
+
+    if(fstat(file, &st) != 0 || st.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    //the mapping keeps the file open on its own
+    void * data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+
+    if(data == MAP_FAILED) {
+        return false;
+    }
+
+    pack.m_data = (const uint8_t *) data;
+    pack.m_size = (size_t) st.st_size;
+    pack.m_mapping = NULL;
+#endif
+
+    return true;
+}
+
+void PackFileSystem::unmapPack(Pack& pack) {
+#ifdef _WIN32
+    UnmapViewOfFile(pack.m_data);
+    CloseHandle((HANDLE) pack.m_mapping);
+#else
+    munmap((void *) pack.m_data, pack.m_size);
+#endif
+}
+
+void PackFileSystem::addPath(const char * path) {
+    Pack * pack = new Pack();
+    pack->m_path = path;
+
+    if(!mapPack(*pack)) {
+        LOG_FATAL_ERROR("Failed to map pack %s.", path);
+    }
+
+    //header
+    if(pack->m_size < PACK_HEADER_SIZE) {
+        LOG_FATAL_ERROR("Pack %s is too small to be a pack.", path);
+    }
+
+    {
+        uint64_t magic;
+        memcpy(&magic, pack->m_data, sizeof(uint64_t));
+
+        if(big64(magic) != PACK_MAGIC) {
+            LOG_FATAL_ERROR("Not a valid ILLPACK1 file %s.", path);
+        }
+    }
+
+    uint32_t numEntries = packRead32(pack->m_data + 8);
+    uint64_t directoryOffset = packRead64(pack->m_data + 16);
+    uint64_t namesOffset = packRead64(pack->m_data + 24);
+    uint32_t namesSize = packRead32(pack->m_data + 32);
+
+    if(directoryOffset > pack->m_size || (uint64_t) numEntries * PACK_ENTRY_SIZE > pack->m_size - directoryOffset
+            || namesOffset > pack->m_size || namesSize > pack->m_size - namesOffset) {
+        LOG_FATAL_ERROR("Pack %s is truncated or corrupt.", path);
+    }
+
+    pack->m_names = (const char *) pack->m_data + namesOffset;
+
+    //directory, copied out once so lookups don't have to deal with byte order
+    pack->m_entries.resize(numEntries);
+
+    for(uint32_t entry = 0; entry < numEntries; entry++) {
+        const uint8_t * source = pack->m_data + directoryOffset + entry * PACK_ENTRY_SIZE;
+        PackEntry& packEntry = pack->m_entries[entry];
+
+        packEntry.m_hash = packRead64(source);
+        packEntry.m_offset = packRead64(source + 8);
+        packEntry.m_size = packRead32(source + 16);
+        packEntry.m_storedSize = packRead32(source + 20);
+        packEntry.m_nameOffset = packRead32(source + 24);
+        packEntry.m_nameLength = packRead16(source + 28);
+        packEntry.m_compression = (PackCompression) source[30];
+
+        if(packEntry.m_offset > pack->m_size || packEntry.m_storedSize > pack->m_size - packEntry.m_offset
+                || (uint64_t) packEntry.m_nameOffset + packEntry.m_nameLength > namesSize
+                || (packEntry.m_compression == PackCompression::NONE && packEntry.m_size != packEntry.m_storedSize)
+                || packEntry.m_compression > PackCompression::LZ4) {
+            LOG_FATAL_ERROR("Pack %s has a corrupt directory entry %u.", path, entry);
+        }
+    }
+
+    m_packs.push_back(pack);
+}
+
+const PackEntry * PackFileSystem::findEntry(const char * path, const Pack *& pack) const {
+    size_t length = strlen(path);
+    uint64_t hash = packPathHash(path, length);
+
+    for(size_t packInd = 0; packInd < m_packs.size(); packInd++) {
+        const Pack * currentPack = m_packs[packInd];
+
+        std::vector<PackEntry>::const_iterator entry = std::lower_bound(currentPack->m_entries.begin(), currentPack->m_entries.end(), hash,
+            [] (const PackEntry& entry, uint64_t hash) {
+                return entry.m_hash < hash;
+            });
+
+        //usually there's just one entry with the hash, but compare the names to be sure
+        for(; entry != currentPack->m_entries.end() && entry->m_hash == hash; ++entry) {
+            if(packPathCompare(currentPack->m_names + entry->m_nameOffset, entry->m_nameLength, path, length) == 0) {
+                pack = currentPack;
+                return &*entry;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+bool PackFileSystem::fileExists(const char * path) const {
+    const Pack * pack;
+    return findEntry(path, pack) != NULL;
+}
+
+illFileSystem::File * PackFileSystem::openRead(const char * path) const {
+    const Pack * pack;
+    const PackEntry * entry = findEntry(path, pack);
+
+    if(!entry) {
+        LOG_FATAL_ERROR("Failed to open file %s for reading, it's not in any of the mounted packs.", path);
+    }
+
+    const uint8_t * storedData = pack->m_data + entry->m_offset;
+
+    switch(entry->m_compression) {
+    case PackCompression::NONE:
+        return new PackFile(storedData, entry->m_size, NULL, path);
+
+    case PackCompression::LZ4: {
+#ifdef ILL_PACK_LZ4
+        uint8_t * data = new uint8_t[entry->m_size > 0 ? entry->m_size : 1];
+
+        if(LZ4_decompress_safe((const char *) storedData, (char *) data, (int) entry->m_storedSize, (int) entry->m_size) != (int) entry->m_size) {
+            LOG_FATAL_ERROR("Failed to decompress file %s from pack %s.", path, pack->m_path.c_str());
+        }
+
+        return new PackFile(data, entry->m_size, data, path);
+#else
+        LOG_FATAL_ERROR("File %s in pack %s is compressed with LZ4 but the engine was built without ILL_PACK_LZ4.", path, pack->m_path.c_str());
+        return NULL;
+#endif
+    }
+    }
+
+    return NULL;
+}
+
+illFileSystem::File * PackFileSystem::openWrite(const char * path) const {
+    LOG_FATAL_ERROR("Failed to open file %s for writing, packs are read only.", path);
+    return NULL;
+}
+
+illFileSystem::File * PackFileSystem::openAppend(const char * path) const {
+    LOG_FATAL_ERROR("Failed to open file %s for appending, packs are read only.", path);
+    return NULL;
+}
+}
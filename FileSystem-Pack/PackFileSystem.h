@@ -0,0 +1,88 @@
+#ifndef ILL_PACK_FILE_SYSTEM_H__
+#define ILL_PACK_FILE_SYSTEM_H__
+
+#include <string>
+#include <vector>
+
+#include "FileSystem/FileSystem.h"
+#include "FileSystem-Pack/PackFormat.h"
+
+namespace illPack {
+
+/**
+Reads files out of ILLPACK1 packs.  Each path added with addPath() is a pack that gets memory mapped whole when it's added,
+so opening a file is a binary search of the pack directory and reading it is a memcpy out of the mapping.
+There's no system call per file like with stdio or PhysFS, which matters when loading thousands of small files.
+
+Packs are searched in the order they were added and the first one with the file wins, same as PhysFS.
+Packs are read only, so openWrite() and openAppend() are errors.
+
+Add all the packs before anything starts loading.  After that it's safe to open files from several threads at once.
+
+Use PackWriter.h or the illPack tool to make packs.  The layout is:
+- 8 bytes magic string ILLPACK1
+- 32 bit number of entries
+- 32 bit data alignment
+- 64 bit offset of the directory
+- 64 bit offset of the names block
+- 32 bit size of the names block
+- 32 bit reserved, 0
+- The file data, each file starts on a multiple of the data alignment
+- The directory, sorted by path hash then by path, each entry is
+  64 bit packPathHash of the path, 64 bit data offset, 32 bit size, 32 bit stored size,
+  32 bit offset of the path in the names block, 16 bit path length, 1 byte PackCompression, 1 byte padding
+- The names block, all paths one after the other without terminators
+
+Everything after the magic string is little endian.
+
+Entries compressed with LZ4 can only be read if the engine is built with ILL_PACK_LZ4 defined and linked against liblz4.
+*/
+class PackFileSystem : public illFileSystem::FileSystem {
+public:
+    PackFileSystem() {}
+	~PackFileSystem();
+
+    /**
+    Mounts a pack.
+    */
+	virtual void addPath(const char * path);
+
+	virtual bool fileExists(const char * path) const;
+
+    virtual illFileSystem::File * openRead(const char * path) const;
+	virtual illFileSystem::File * openWrite(const char * path) const;
+    virtual illFileSystem::File * openAppend(const char * path) const;
+
+    inline size_t getNumPacks() const {
+        return m_packs.size();
+    }
+
+private:
+    struct Pack {
+        std::string m_path;
+
+        const uint8_t * m_data;
+        size_t m_size;
+
+        std::vector<PackEntry> m_entries;
+        const char * m_names;
+
+        void * m_mapping;               ///<Platform specific handle to the mapping
+    };
+
+    /**
+    Finds a file in the mounted packs.
+
+    @param pack Gets set to the pack the file is in.
+    @return The directory entry, or NULL if none of the packs have the file.
+    */
+    const PackEntry * findEntry(const char * path, const Pack *& pack) const;
+
+    static bool mapPack(Pack& pack);
+    static void unmapPack(Pack& pack);
+
+    std::vector<Pack *> m_packs;
+};
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef ILL_PACK_FORMAT_H__
+#define ILL_PACK_FORMAT_H__
+
+#include <stdint.h>
+
+namespace illPack {
+
+const uint64_t PACK_MAGIC = 0x494C4C5041434B31;	//ILLPACK1 in big endian 64 bit
+
+/**
+ILLPACK1 header size in bytes.
+*/
+const uint32_t PACK_HEADER_SIZE = 40;
+
+/**
+ILLPACK1 size in bytes of each directory entry.
+*/
+const uint32_t PACK_ENTRY_SIZE = 32;
+
+/**
+The default alignment of the file data in a pack.  Aligned data can be handed straight to loaders that read blocks
+of floats or indices out of memory, like ILLMESH2.
+*/
+const uint32_t PACK_DEFAULT_ALIGNMENT = 16;
+
+enum class PackCompression : uint8_t {
+    NONE,
+    LZ4
+};
+
+/**
+A file in a pack, as it is in the directory.
+*/
+struct PackEntry {
+    uint64_t m_hash;                ///<packPathHash of the path
+    uint64_t m_offset;              ///<Where the stored data starts in the pack
+    uint32_t m_size;                ///<Size of the file once decompressed
+    uint32_t m_storedSize;          ///<Size of the data in the pack, same as m_size when not compressed
+    uint32_t m_nameOffset;          ///<Where the path starts in the names block
+    uint16_t m_nameLength;
+    PackCompression m_compression;
+};
+
+/**
+64 bit FNV-1a hash of a path in a pack.  Back slashes hash the same as forward slashes so paths written on Windows still match.
+*/
+inline uint64_t packPathHash(const char * path, size_t length) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for(size_t character = 0; character < length; character++) {
+        hash ^= (uint8_t) (path[character] == '\\' ? '/' : path[character]);
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/**
+Compares two paths in a pack the same way they're sorted in the directory after the hash.
+*/
+inline int packPathCompare(const char * path1, size_t length1, const char * path2, size_t length2) {
+    size_t length = length1 < length2 ? length1 : length2;
+
+    for(size_t character = 0; character < length; character++) {
+        char character1 = path1[character] == '\\' ? '/' : path1[character];
+        char character2 = path2[character] == '\\' ? '/' : path2[character];
+
+        if(character1 != character2) {
+            return (uint8_t) character1 < (uint8_t) character2 ? -1 : 1;
+        }
+    }
+
+    return length1 < length2 ? -1 : (length1 > length2 ? 1 : 0);
+}
+
+}
+
+#endif
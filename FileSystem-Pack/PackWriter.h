@@ -0,0 +1,215 @@
+#ifndef ILL_PACK_WRITER_H__
+#define ILL_PACK_WRITER_H__
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Logging/logging.h"
+#include "FileSystem/File.h"
+#include "FileSystem-Pack/PackFormat.h"
+
+#ifdef ILL_PACK_LZ4
+#include <lz4.h>
+#endif
+
+namespace illPack {
+
+/**
+Writes an ILLPACK1 pack described in PackFileSystem.h.
+
+Add the files one at a time, their data goes into the pack right away, then call finish() to write the directory.
+The output file needs to support seeking since the header is written last.
+
+With compression turned on each file is compressed with LZ4 and kept compressed only if that saves at least an eighth of it.
+Compressed files can't be used in place from the mapped pack so leave compression off for files that get loaded
+straight out of memory, like meshes.  Compression needs ILL_PACK_LZ4, without it everything is stored uncompressed.
+*/
+class PackWriter {
+public:
+    /**
+    @param file The file to write the pack to.  The writer doesn't own it.
+    @param alignment What the file data starts on a multiple of, must be a power of 2.
+    */
+    PackWriter(illFileSystem::File * file, uint32_t alignment = PACK_DEFAULT_ALIGNMENT, bool compress = false)
+        : m_file(file),
+        m_alignment(alignment),
+        m_compress(compress),
+        m_finished(false),
+        m_packSize(0)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+        //the header gets filled in by finish()
+        padTo(PACK_HEADER_SIZE);
+    }
+
+    ~PackWriter() {
+        assert(m_finished);
+    }
+
+    /**
+    Adds a file to the pack.
+
+    @param path The path the file is opened with later.
+    */
+    void addFile(const char * path, const void * data, size_t size) {
+        assert(!m_finished);
+
+        size_t pathLength = strlen(path);
+
+        if(pathLength > 0xFFFF) {
+            LOG_FATAL_ERROR("Path %s is too long to go in pack %s.", path, m_file->getFileName());
+        }
+
+        if(size > 0xFFFFFFFF) {
+            LOG_FATAL_ERROR("File %s is too big to go in pack %s.", path, m_file->getFileName());
+        }
+
+        PackEntry entry;
+        entry.m_hash = packPathHash(path, pathLength);
+        entry.m_size = (uint32_t) size;
+        entry.m_storedSize = (uint32_t) size;
+        entry.m_nameOffset = (uint32_t) m_names.size();
+        entry.m_nameLength = (uint16_t) pathLength;
+        entry.m_compression = PackCompression::NONE;
+
+        //paths are stored with forward slashes
+        for(size_t character = 0; character < pathLength; character++) {
+            m_names.push_back(path[character] == '\\' ? '/' : path[character]);
+        }
+
+#ifdef ILL_PACK_LZ4
+        std::vector<char> compressed;
+
+        if(m_compress && size > 0) {
+            compressed.resize(LZ4_compressBound((int) size));
+            int compressedSize = LZ4_compress_default((const char *) data, &compressed[0], (int) size, (int) compressed.size());
+
+            if(compressedSize > 0 && (size_t) compressedSize <= size - size / 8) {
+                entry.m_storedSize = (uint32_t) compressedSize;
+                entry.m_compression = PackCompression::LZ4;
+                data = &compressed[0];
+            }
+        }
+#endif
+
+        entry.m_offset = alignOffset(m_file->tell());
+        padTo(entry.m_offset);
+
+        if(entry.m_storedSize > 0) {
+            m_file->write(data, entry.m_storedSize);
+        }
+
+        m_entries.push_back(entry);
+    }
+
+    /**
+    Writes the directory and the header.  Nothing can be added after this.
+    */
+    void finish() {
+        assert(!m_finished);
+
+        const std::string& names = m_names;
+
+        std::sort(m_entries.begin(), m_entries.end(), [&names] (const PackEntry& entry1, const PackEntry& entry2) {
+            if(entry1.m_hash != entry2.m_hash) {
+                return entry1.m_hash < entry2.m_hash;
+            }
+
+            return packPathCompare(names.data() + entry1.m_nameOffset, entry1.m_nameLength,
+                names.data() + entry2.m_nameOffset, entry2.m_nameLength) < 0;
+        });
+
+        for(size_t entry = 1; entry < m_entries.size(); entry++) {
+            if(m_entries[entry].m_hash == m_entries[entry - 1].m_hash
+                    && packPathCompare(names.data() + m_entries[entry].m_nameOffset, m_entries[entry].m_nameLength,
+                        names.data() + m_entries[entry - 1].m_nameOffset, m_entries[entry - 1].m_nameLength) == 0) {
+                LOG_FATAL_ERROR("File %s was added to pack %s twice.",
+                    names.substr(m_entries[entry].m_nameOffset, m_entries[entry].m_nameLength).c_str(), m_file->getFileName());
+            }
+        }
+
+        //directory
+        uint64_t directoryOffset = (m_file->tell() + 7) & ~(uint64_t) 7;
+        padTo(directoryOffset);
+
+        for(size_t entry = 0; entry < m_entries.size(); entry++) {
+            const PackEntry& packEntry = m_entries[entry];
+
+            m_file->writeL64(packEntry.m_hash);
+            m_file->writeL64(packEntry.m_offset);
+            m_file->writeL32(packEntry.m_size);
+            m_file->writeL32(packEntry.m_storedSize);
+            m_file->writeL32(packEntry.m_nameOffset);
+            m_file->writeL16(packEntry.m_nameLength);
+            m_file->write8((uint8_t) packEntry.m_compression);
+            m_file->write8(0);
+        }
+
+        //names
+        uint64_t namesOffset = m_file->tell();
+
+        if(!m_names.empty()) {
+            m_file->write(m_names.data(), m_names.size());
+        }
+
+        m_packSize = m_file->tell();
+
+        //header
+        m_file->seek(0);
+        m_file->writeB64(PACK_MAGIC);
+        m_file->writeL32((uint32_t) m_entries.size());
+        m_file->writeL32(m_alignment);
+        m_file->writeL64(directoryOffset);
+        m_file->writeL64(namesOffset);
+        m_file->writeL32((uint32_t) m_names.size());
+        m_file->writeL32(0);
+
+        m_finished = true;
+    }
+
+    inline size_t getNumFiles() const {
+        return m_entries.size();
+    }
+
+    /**
+    The size of the whole pack once it's finished.
+    */
+    inline uint64_t getPackSize() const {
+        return m_packSize;
+    }
+
+private:
+    inline uint64_t alignOffset(uint64_t offset) const {
+        return (offset + m_alignment - 1) & ~(uint64_t) (m_alignment - 1);
+    }
+
+    /**
+    Writes zeroes until the file is at the offset.
+    */
+    inline void padTo(uint64_t offset) {
+        static const uint8_t ZEROES[64] = {};
+
+        for(uint64_t position = m_file->tell(); position < offset; ) {
+            size_t size = (size_t) std::min<uint64_t>(offset - position, sizeof(ZEROES));
+            m_file->write(ZEROES, size);
+            position += size;
+        }
+    }
+
+    illFileSystem::File * m_file;
+    uint32_t m_alignment;
+    bool m_compress;
+    bool m_finished;
+    uint64_t m_packSize;
+
+    std::vector<PackEntry> m_entries;
+    std::string m_names;
+};
+
+}
+
+#endif
@@ -6,15 +6,45 @@
 #include "Logging/logging.h"
 
 namespace illStdio {
+void StdioFileSystem::addPath(const char * path) {
+    std::string searchPath(path);
+
+    if(!searchPath.empty() && searchPath[searchPath.size() - 1] != '/' && searchPath[searchPath.size() - 1] != '\\') {
+        searchPath.push_back('/');
+    }
+
+    m_paths.push_back(searchPath);
+}
+
+bool StdioFileSystem::findPath(const char * path, std::string& fullPath) const {
+    struct stat st;
+
+    if(m_paths.empty()) {
+        fullPath = path;
+        return stat(path, &st) == 0;
+    }
+
+    for(size_t searchPath = 0; searchPath < m_paths.size(); searchPath++) {
+        fullPath = m_paths[searchPath] + path;
+
+        if(stat(fullPath.c_str(), &st) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool StdioFileSystem::fileExists(const char * path) const {
-	struct stat st;
-	return stat(path, &st) == 0;
+    std::string fullPath;
+	return findPath(path, fullPath);
 }
 
 illFileSystem::File * StdioFileSystem::openRead(const char * path) const {
     FILE* file;
+    std::string fullPath;
 
-    if((file = fopen(path, "rb")) == NULL) {
+    if(!findPath(path, fullPath) || (file = fopen(fullPath.c_str(), "rb")) == NULL) {
         LOG_FATAL_ERROR("Failed to open file %s for reading.", path);
     }
 
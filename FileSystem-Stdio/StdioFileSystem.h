@@ -1,20 +1,44 @@
 #ifndef ILL_STDIO_FILE_SYSTEM_H__
 #define ILL_STDIO_FILE_SYSTEM_H__
 
+#include <string>
+#include <vector>
+
 #include "FileSystem/FileSystem.h"
 
 namespace illStdio {
+/**
+Reads and writes loose files with stdio.
+
+Files are read from the search paths in the order they were added, and the first one with the file wins.
+Without any search paths, paths are relative to the working directory.  Writing and appending always use the path as given.
+*/
 class StdioFileSystem : public illFileSystem::FileSystem {
 public:
 	~StdioFileSystem() {}
 	
-	virtual void addPath(const char * path) {}
+	virtual void addPath(const char * path);
 
 	virtual bool fileExists(const char * path) const;
 
     virtual illFileSystem::File * openRead(const char * path) const;
 	virtual illFileSystem::File * openWrite(const char * path) const;
     virtual illFileSystem::File * openAppend(const char * path) const;
+
+    /**
+    The search paths, each ending with a slash.
+    */
+    inline const std::vector<std::string>& getPaths() const {
+        return m_paths;
+    }
+
+private:
+    /**
+    Finds which search path has a file.  Returns false if none of them do.
+    */
+    bool findPath(const char * path, std::string& fullPath) const;
+
+    std::vector<std::string> m_paths;
 };
 }
 
@@ -0,0 +1,154 @@
+#include "StdioFileWatcher.h"
+#include "StdioFileSystem.h"
+
+#include "Logging/logging.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace illStdio {
+
+#ifdef __linux__
+
+//files saved in place show up as IN_CLOSE_WRITE, and editors that save to a temporary file and rename it over the original as IN_MOVED_TO
+const uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+StdioFileWatcher::StdioFileWatcher(const StdioFileSystem& fileSystem) {
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if(m_inotify < 0) {
+        LOG_ERROR("Failed to start watching for file changes. Error %s", strerror(errno));
+        return;
+    }
+
+    if(fileSystem.getPaths().empty()) {
+        watchDirectory("", "");
+    }
+    else {
+        for(size_t path = 0; path < fileSystem.getPaths().size(); path++) {
+            watchDirectory(fileSystem.getPaths()[path], "");
+        }
+    }
+}
+
+StdioFileWatcher::~StdioFileWatcher() {
+    if(m_inotify >= 0) {
+        close(m_inotify);
+    }
+}
+
+void StdioFileWatcher::watchDirectory(const std::string& directory, const std::string& relativePath) {
+    const char * directoryPath = directory.empty() ? "." : directory.c_str();
+
+    int watch = inotify_add_watch(m_inotify, directoryPath, WATCH_EVENTS);
+
+    if(watch < 0) {
+        LOG_ERROR("Failed to watch directory %s for changes. Error %s", directoryPath, strerror(errno));
+        return;
+    }
+
+    //the same directory can be reached twice through links or overlapping search paths, inotify gives back the same watch
+    if(m_watchedDirectories.find(watch) != m_watchedDirectories.end()) {
+        return;
+    }
+
+    WatchedDirectory& watchedDirectory = m_watchedDirectories[watch];
+    watchedDirectory.m_directory = directory;
+    watchedDirectory.m_relativePath = relativePath;
+
+    DIR * dir = opendir(directoryPath);
+
+    if(!dir) {
+        return;
+    }
+
+    while(dirent * entry = readdir(dir)) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+
+        std::string childDirectory = directory + entry->d_name;
+        bool isDirectory = entry->d_type == DT_DIR;
+
+        if(entry->d_type == DT_UNKNOWN) {
+            DIR * childDir = opendir(childDirectory.c_str());
+            isDirectory = childDir != NULL;
+
+            if(childDir) {
+                closedir(childDir);
+            }
+        }
+
+        if(isDirectory) {
+            watchDirectory(childDirectory + "/", relativePath + entry->d_name + "/");
+        }
+    }
+
+    closedir(dir);
+}
+
+void StdioFileWatcher::pollChanges(std::vector<std::string>& changedPaths) {
+    if(m_inotify < 0) {
+        return;
+    }
+
+    //aligned like the kernel wants for the events
+    char buffer[4096] __attribute__ ((aligned(__alignof__(inotify_event))));
+
+    while(true) {
+        ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+
+        //EAGAIN once there's nothing left to read
+        if(length <= 0) {
+            return;
+        }
+
+        for(ssize_t offset = 0; offset < length;) {
+            const inotify_event * event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW) {
+                LOG_ERROR("Too many file changes at once, some of them were missed.");
+                continue;
+            }
+
+            auto watchIter = m_watchedDirectories.find(event->wd);
+
+            if(watchIter == m_watchedDirectories.end() || event->len == 0) {
+                continue;
+            }
+
+            if(event->mask & IN_ISDIR) {
+                //copy these since watching can rehash the map
+                WatchedDirectory parent = watchIter->second;
+                watchDirectory(parent.m_directory + event->name + "/", parent.m_relativePath + event->name + "/");
+            }
+            else if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                changedPaths.push_back(watchIter->second.m_relativePath + event->name);
+            }
+        }
+    }
+}
+
+#else
+
+StdioFileWatcher::StdioFileWatcher(const StdioFileSystem& fileSystem)
+    : m_inotify(-1)
+{
+    LOG_ERROR("Watching for file changes isn't supported on this platform.");
+}
+
+StdioFileWatcher::~StdioFileWatcher() {}
+
+void StdioFileWatcher::watchDirectory(const std::string& directory, const std::string& relativePath) {}
+
+void StdioFileWatcher::pollChanges(std::vector<std::string>& changedPaths) {}
+
+#endif
+
+}
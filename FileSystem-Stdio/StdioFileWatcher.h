@@ -0,0 +1,55 @@
+#ifndef ILL_STDIO_FILE_WATCHER_H__
+#define ILL_STDIO_FILE_WATCHER_H__
+
+#include <string>
+#include <unordered_map>
+
+#include "FileSystem/FileWatcher.h"
+
+namespace illStdio {
+
+class StdioFileSystem;
+
+/**
+Watches the search paths of a StdioFileSystem, or the working directory if it has none, and all directories inside them.
+Directories created later get watched too.
+
+Uses inotify so it only works on Linux for now.  On other platforms it logs an error and never reports anything.
+Add the search paths to the file system before creating this.
+*/
+class StdioFileWatcher : public illFileSystem::FileWatcher {
+public:
+    StdioFileWatcher(const StdioFileSystem& fileSystem);
+    virtual ~StdioFileWatcher();
+
+    virtual void pollChanges(std::vector<std::string>& changedPaths);
+
+    /**
+    How many directories are being watched.
+    */
+    inline size_t getNumWatchedDirectories() const {
+        return m_watchedDirectories.size();
+    }
+
+private:
+    struct WatchedDirectory {
+        std::string m_directory;            ///<Where the directory is relative to the working directory
+        std::string m_relativePath;         ///<What paths of files in it start with when opening them with the file system
+    };
+
+    /**
+    Watches a directory and everything in it.
+
+    @param directory The directory to watch, ending with a slash, or empty for the working directory.
+    @param relativePath What the paths of files in the directory start with when passed to the file system, ending with a slash or empty.
+    */
+    void watchDirectory(const std::string& directory, const std::string& relativePath);
+
+    int m_inotify;
+
+    std::unordered_map<int, WatchedDirectory> m_watchedDirectories;     ///<By inotify watch descriptor
+};
+
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef ILL_BUFFERED_FILE_READER_H__
+#define ILL_BUFFERED_FILE_READER_H__
+
+#include <cassert>
+#include <cstring>
+
+#include "Logging/logging.h"
+#include "FileSystem/File.h"
+#include "FileSystem/FileSystem.h"
+
+namespace illFileSystem {
+
+/**
+Reads a file through a big buffer so loaders that read one value at a time don't do a virtual call and
+a trip into stdio or PhysFS for every value.
+
+It's a File itself so it can be passed to anything that takes a File.  The typed read helpers
+like readL16 and readLF are redefined here without going through the virtual read, so code that holds
+a BufferedFileReader pointer gets them inlined down to a copy out of the buffer.  Code holding it as a
+plain File pointer still works and is still buffered, it just pays for the virtual call.
+
+Reads bigger than the buffer go straight to the file without being copied through the buffer.
+With a buffer size of 0 nothing is buffered and every read goes to the file.
+
+The reader owns the file it wraps and deletes it when deleted.  It's read only.
+*/
+class BufferedFileReader : public File {
+public:
+    BufferedFileReader(File * file, size_t bufferSize = DEFAULT_READ_BUFFER_SIZE)
+        : File(State::ST_READ, file->getFileName()),
+        m_file(file),
+        m_fileSize(file->getSize()),
+        m_buffer(bufferSize > 0 ? new uint8_t[bufferSize] : NULL),
+        m_bufferSize(bufferSize),
+        m_bufferOffset(file->tell()),
+        m_bufferPosition(0),
+        m_bufferEnd(0)
+    {
+        assert(file->getState() == State::ST_READ);
+    }
+
+    virtual ~BufferedFileReader() {
+        delete m_file;
+        delete[] m_buffer;
+    }
+
+    /**
+    Closes the wrapped file.
+    */
+    virtual void close() {
+        delete m_file;
+        m_file = NULL;
+        m_state = State::ST_CLOSED;
+    }
+
+    virtual size_t getSize() {
+        return m_fileSize;
+    }
+
+    virtual size_t tell() {
+        return m_bufferOffset + m_bufferPosition;
+    }
+
+    /**
+    Seeking somewhere that's already in the buffer just moves around inside the buffer.
+    */
+    virtual void seek(size_t offset) {
+        if(offset >= m_bufferOffset && offset <= m_bufferOffset + m_bufferEnd) {
+            m_bufferPosition = offset - m_bufferOffset;
+        }
+        else {
+            m_file->seek(offset);
+
+            m_bufferOffset = offset;
+            m_bufferPosition = 0;
+            m_bufferEnd = 0;
+        }
+    }
+
+    virtual void seekAhead(size_t offset) {
+        seek(tell() + offset);
+    }
+
+    virtual bool eof() {
+        return tell() >= m_fileSize;
+    }
+
+    virtual void read(void* destination, size_t size) {
+        readBuffered(destination, size);
+    }
+
+    virtual void write(const void* /*source*/, size_t /*size*/) {
+        LOG_FATAL_ERROR("Can't write to file %s opened with a buffered reader.", getFileName());
+    }
+
+    inline size_t getBufferSize() const {
+        return m_bufferSize;
+    }
+
+    //the same helpers as in File but without the virtual call
+
+    inline uint16_t readStringBufferLength() {
+		uint16_t strlength;
+		readB16(strlength);
+
+		return strlength + 1;
+	}
+
+	inline void readString(char * destination, uint16_t stringBufferLength) {
+		--stringBufferLength;
+
+		readBuffered(destination, stringBufferLength);
+		destination[stringBufferLength] = '\0';
+	}
+
+    inline void read8(uint8_t& destination) {
+        readBuffered(&destination, sizeof(uint8_t));
+    }
+
+    inline void readL16(uint16_t& destination) {
+        readBuffered(&destination, sizeof(uint16_t));
+		destination = little16(destination);
+    }
+
+    inline void readB16(uint16_t& destination) {
+        readBuffered(&destination, sizeof(uint16_t));
+		destination = big16(destination);
+    }
+
+    inline void readL32(uint32_t& destination) {
+        readBuffered(&destination, sizeof(uint32_t));
+		destination = little32(destination);
+    }
+
+    inline void readB32(uint32_t& destination) {
+        readBuffered(&destination, sizeof(uint32_t));
+		destination = big32(destination);
+    }
+
+    inline void readL64(uint64_t& destination) {
+        readBuffered(&destination, sizeof(uint64_t));
+		destination = little64(destination);
+    }
+
+    inline void readB64(uint64_t& destination) {
+        readBuffered(&destination, sizeof(uint64_t));
+		destination = big64(destination);
+    }
+
+    inline void readLF(float& destination) {
+        readBuffered(&destination, sizeof(float));
+		destination = littleF(destination);
+    }
+
+    inline void readBF(float& destination) {
+        readBuffered(&destination, sizeof(float));
+		destination = bigF(destination);
+    }
+
+    inline void readLD(double& destination) {
+        readBuffered(&destination, sizeof(double));
+		destination = littleD(destination);
+    }
+
+    inline void readBD(double& destination) {
+        readBuffered(&destination, sizeof(double));
+		destination = bigD(destination);
+    }
+
+private:
+    /**
+    The fast path, the size is usually a constant so the copy turns into a load and store.
+    */
+    inline void readBuffered(void * destination, size_t size) {
+        if(m_bufferEnd - m_bufferPosition >= size) {
+            memcpy(destination, m_buffer + m_bufferPosition, size);
+            m_bufferPosition += size;
+        }
+        else {
+            readRefill(destination, size);
+        }
+    }
+
+    /**
+    Copies out whatever is left in the buffer, then either reads the rest straight from the file or refills the buffer.
+    */
+    void readRefill(void * destination, size_t size) {
+        assert(m_file);
+
+        size_t available = m_bufferEnd - m_bufferPosition;
+
+        if(available > 0) {
+            memcpy(destination, m_buffer + m_bufferPosition, available);
+
+            destination = (uint8_t *) destination + available;
+            size -= available;
+        }
+
+        //the underlying file is always at the end of the buffer
+        m_bufferOffset += m_bufferEnd;
+        m_bufferPosition = 0;
+        m_bufferEnd = 0;
+
+        if(size >= m_bufferSize) {
+            m_file->read(destination, size);
+            m_bufferOffset += size;
+            return;
+        }
+
+        size_t remaining = m_fileSize > m_bufferOffset ? m_fileSize - m_bufferOffset : 0;
+        m_bufferEnd = remaining < m_bufferSize ? remaining : m_bufferSize;
+
+        if(m_bufferEnd < size) {
+            LOG_FATAL_ERROR("Failed to read %u bytes from file %s, only %u left.", (unsigned int) size, getFileName(), (unsigned int) m_bufferEnd);
+        }
+
+        m_file->read(m_buffer, m_bufferEnd);
+
+        memcpy(destination, m_buffer, size);
+        m_bufferPosition = size;
+    }
+
+    File * m_file;
+    size_t m_fileSize;
+
+    uint8_t * m_buffer;
+    size_t m_bufferSize;
+
+    size_t m_bufferOffset;         ///<Offset in the file where the buffer starts
+    size_t m_bufferPosition;       ///<Current read position inside the buffer
+    size_t m_bufferEnd;            ///<How much of the buffer is filled
+};
+
+/**
+Opens a file for reading through a BufferedFileReader with the file system's read buffer size.
+*/
+inline BufferedFileReader * openBufferedRead(const char * path) {
+    return new BufferedFileReader(fileSystem->openRead(path), fileSystem->getReadBufferSize());
+}
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define ILL_FILE_H__
 
 #include <stdint.h>
+#include <cstring>
 #include <string>
 
 #include "Util/endian.h"
@@ -1,10 +1,15 @@
 #ifndef ILL_FILE_SYSTEM_H__
 #define ILL_FILE_SYSTEM_H__
 
+#include <cstddef>
+
 namespace illFileSystem {
 
 class File;
 
+///The default buffer size for BufferedFileReader.  Big enough that most resource files are read in one or two go's.
+const size_t DEFAULT_READ_BUFFER_SIZE = 64 * 1024;
+
 /**
 File system for reading archived resources and read/writing to files elsewhere.
 
@@ -12,6 +17,10 @@ This is still a work in progress and currently is a wrapper around reading files
 */
 class FileSystem {
 public:
+    FileSystem()
+        : m_readBufferSize(DEFAULT_READ_BUFFER_SIZE)
+    {}
+
     virtual ~FileSystem() {}
 
     /**
@@ -38,6 +47,21 @@ public:
     Opens an file for appending to an existing file relative to one of the search paths added.
     */
     virtual File * openAppend(const char * path) const = 0;
+
+    /**
+    The buffer size loaders that opt into buffered reading with openBufferedRead() get.
+    Set it to 0 to turn off the buffering.
+    */
+    inline size_t getReadBufferSize() const {
+        return m_readBufferSize;
+    }
+
+    inline void setReadBufferSize(size_t readBufferSize) {
+        m_readBufferSize = readBufferSize;
+    }
+
+private:
+    size_t m_readBufferSize;
 };
 
 //a public global variable, problem?
@@ -0,0 +1,25 @@
+#ifndef ILL_FILE_WATCHER_H__
+#define ILL_FILE_WATCHER_H__
+
+#include <string>
+#include <vector>
+
+namespace illFileSystem {
+
+/**
+Watches a file system's files for changes, for hot reloading resources while the game runs.
+*/
+class FileWatcher {
+public:
+    virtual ~FileWatcher() {}
+
+    /**
+    Adds the paths of files that changed since the last call, the same way they'd be passed to FileSystem::openRead().
+    Never blocks.  A file saved a few times since the last call might show up more than once.
+    */
+    virtual void pollChanges(std::vector<std::string>& changedPaths) = 0;
+};
+
+}
+
+#endif
@@ -25,17 +25,17 @@ void GlBackend::initialize() {
 
     //load the temporary font shader
     /*{
-        std::vector<RefCountPtr<illGraphics::Shader> > shaders;
+        std::vector<IntrusivePtr<illGraphics::Shader> > shaders;
 
         illGraphics::Shader * shader = new illGraphics::Shader();
         shader->loadInternal(this, "shaders/tempFont.vert", GL_VERTEX_SHADER, "");
 
-        shaders.push_back(RefCountPtr<illGraphics::Shader>(shader));
+        shaders.push_back(IntrusivePtr<illGraphics::Shader>(shader));
 
         shader = new illGraphics::Shader();
         shader->loadInternal(this, "shaders/tempFont.frag", GL_FRAGMENT_SHADER, "");
 
-        shaders.push_back(RefCountPtr<illGraphics::Shader>(shader));
+        shaders.push_back(IntrusivePtr<illGraphics::Shader>(shader));
 
         m_debugShaderLoader = new illGraphics::ShaderProgramLoader(this, NULL);
         m_fontShader.loadInternal(m_debugShaderLoader, shaders);
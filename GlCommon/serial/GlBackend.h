@@ -24,15 +24,17 @@ public:
     //Resource loading functions
     virtual void loadTexture(void ** textureData, const illGraphics::TextureLoadArgs& loadArgs);
     virtual void unloadTexture(void ** textureData);
+    virtual size_t getTextureMemoryUsage(const void * textureData);
     
     virtual void loadMesh(void** meshBackendData, const MeshData<>& meshFrontendData);
     virtual void unloadMesh(void** meshBackendData);
 
     virtual void loadShader(void ** shaderData, uint64_t featureMask);
+    virtual const char * getShaderPath(uint64_t featureMask) const;
     virtual void loadShaderInternal(void ** shaderData, const char * path, unsigned int shaderType, const char * defines);
     virtual void unloadShader(void ** shaderData);
 
-    virtual void loadShaderProgram(void ** programData, const std::vector<RefCountPtr<illGraphics::Shader> >& shaderList);
+    virtual void loadShaderProgram(void ** programData, const std::vector<IntrusivePtr<illGraphics::Shader> >& shaderList);
     virtual void unloadShaderProgram(void ** programData);
 
     ////////////////////
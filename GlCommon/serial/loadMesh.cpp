@@ -14,7 +14,7 @@ void GlBackend::loadMesh(void** meshBackendData, const MeshData<>& meshFrontendD
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *((GLuint *)(*meshBackendData) + 1));
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshFrontendData.getNumInd() * sizeof(uint16_t), meshFrontendData.getIndices(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshFrontendData.getNumInd() * meshFrontendData.getIndexSize(), meshFrontendData.getIndexData(), GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
@@ -13,27 +13,36 @@
 
 namespace GlCommon {
 
+const char * GlBackend::getShaderPath(uint64_t featureMask) const {
+    if(featureMask & illGraphics::Shader::SHADER_DEFERRED_FRAG) {
+        return "shaders/deferredG.frag";
+    }
+
+    if(featureMask & illGraphics::Shader::SHADER_FORWARD_FRAG) {
+        return "shaders/forward.frag";
+    }
+
+    if(featureMask & illGraphics::Shader::SHADER_3D_VERT) {
+        return "shaders/main.vert";
+    }
+
+    return NULL;
+}
+
 void GlBackend::loadShader(void ** shaderData, uint64_t featureMask) {
     /////////////////////////////////////
     //determine shader type and path
 
-    std::string path;
+    const char * path = getShaderPath(featureMask);
     unsigned int shaderType;
     std::string defines;
 
     if(featureMask & illGraphics::Shader::SHADER_3D_VERT) {
         shaderType = GL_VERTEX_SHADER;
-        path = "shaders/main.vert";
-    }
-
-    if(featureMask & illGraphics::Shader::SHADER_FORWARD_FRAG) {
-        shaderType = GL_FRAGMENT_SHADER;
-        path = "shaders/forward.frag";
     }
 
-    if(featureMask & illGraphics::Shader::SHADER_DEFERRED_FRAG) {
+    if(featureMask & (illGraphics::Shader::SHADER_FORWARD_FRAG | illGraphics::Shader::SHADER_DEFERRED_FRAG)) {
         shaderType = GL_FRAGMENT_SHADER;
-        path = "shaders/deferredG.frag";
     }
 
     ///////////////////////////////////////
@@ -70,7 +79,7 @@ void GlBackend::loadShader(void ** shaderData, uint64_t featureMask) {
         defines += "#define NORMAL_MAP\n";
     }
 
-    loadShaderInternal(shaderData, path.c_str(), shaderType, defines.c_str());
+    loadShaderInternal(shaderData, path, shaderType, defines.c_str());
 }
 
 void GlBackend::loadShaderInternal(void ** shaderData, const char * path, unsigned int shaderType, const char * defines) {    
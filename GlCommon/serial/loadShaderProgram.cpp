@@ -10,7 +10,7 @@
 
 namespace GlCommon {
 
-void GlBackend::loadShaderProgram(void ** programData, const std::vector<RefCountPtr<illGraphics::Shader> >& shaderList) {
+void GlBackend::loadShaderProgram(void ** programData, const std::vector<IntrusivePtr<illGraphics::Shader> >& shaderList) {
     //////////////////////////////////
     //declare stuff
     GLint status; //status of shader
@@ -19,7 +19,7 @@ void GlBackend::loadShaderProgram(void ** programData, const std::vector<RefCoun
     //create the shader program
     GLuint program = glCreateProgram(); 
 
-    for(std::vector<RefCountPtr<illGraphics::Shader> >::const_iterator iter = shaderList.begin(); iter != shaderList.end(); iter++) {
+    for(std::vector<IntrusivePtr<illGraphics::Shader> >::const_iterator iter = shaderList.begin(); iter != shaderList.end(); iter++) {
         glAttachShader(program, *(GLuint*) ((*iter)->getShaderData()));
     }
 
@@ -128,6 +128,19 @@ void GlBackend::unloadTexture(void ** textureData) {
     *textureData = NULL;
 }
 
+size_t GlBackend::getTextureMemoryUsage(const void * textureData) {
+    GLint width;
+    GLint height;
+
+    glBindTexture(GL_TEXTURE_2D, *(const GLuint *) textureData);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    //textures are always converted to RGBA bytes, and the mipmap chain adds another third
+    return (size_t) width * height * 4 * 4 / 3;
+}
+
 void initFont(void ** fontData, void ** charData, unsigned int charCount) {
 }
 
@@ -5,7 +5,7 @@
 #include <stdint.h>
 #include <vector>
 
-#include "Util/serial/RefCountPtr.h"
+#include "Util/serial/IntrusivePtr.h"
 #include "Util/Geometry/MeshData.h"
 
 namespace illGraphics {
@@ -28,15 +28,29 @@ public:
 
     virtual void loadTexture(void ** textureData, const TextureLoadArgs& loadArgs) = 0;
     virtual void unloadTexture(void ** textureData) = 0;
+
+    /**
+    Roughly how much GPU memory a loaded texture is using, mipmaps included.
+    */
+    virtual size_t getTextureMemoryUsage(const void * textureData) = 0;
     
     virtual void loadMesh(void** meshBackendData, const MeshData<>& meshFrontendData) = 0;
     virtual void unloadMesh(void** meshBackendData) = 0;
 
     virtual void loadShader(void ** shaderData, uint64_t featureMask) = 0;
+
+    /**
+    The file loadShader() reads for a shader, so hot reloading knows which shaders to reload when a file changes.
+    Returns NULL by default for backends whose shaders don't come from files.
+    */
+    virtual const char * getShaderPath(uint64_t featureMask) const {
+        return NULL;
+    }
+
     virtual void loadShaderInternal(void ** shaderData, const char * path, unsigned int shaderType, const char * defines) = 0;
     virtual void unloadShader(void **) = 0;
 
-    virtual void loadShaderProgram(void **, const std::vector<RefCountPtr<Shader> >& shaderList) = 0;
+    virtual void loadShaderProgram(void **, const std::vector<IntrusivePtr<Shader> >& shaderList) = 0;
     virtual void unloadShaderProgram(void **) = 0;    
 };
 
@@ -2,6 +2,7 @@
 #include "Graphics/GraphicsBackend.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/File.h"
+#include "FileSystem/BufferedFileReader.h"
 
 #include "Logging/logging.h"
 
@@ -201,7 +202,7 @@ void BitmapFont::reload(GraphicsBackend * backend) {
 
     m_state = RES_LOADING;
 
-    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(m_loadArgs.m_path.c_str());
+    illFileSystem::BufferedFileReader * openFile = illFileSystem::openBufferedRead(m_loadArgs.m_path.c_str());
 
     /////////////////////////////
     //read header
@@ -256,7 +257,7 @@ void BitmapFont::reload(GraphicsBackend * backend) {
     m_state = RES_LOADED;
 }
 
-void BitmapFont::readInfo(illFileSystem::File * file, size_t size) {
+void BitmapFont::readInfo(illFileSystem::BufferedFileReader * file, size_t size) {
     //skip to the stuff I need
     file->seekAhead(7);
 
@@ -286,7 +287,7 @@ void BitmapFont::readInfo(illFileSystem::File * file, size_t size) {
     file->seekAhead(size - (7 + 6));
 }
 
-void BitmapFont::readCommon(illFileSystem::File * file, unsigned int& textureWidth, unsigned int& textureHeight) {
+void BitmapFont::readCommon(illFileSystem::BufferedFileReader * file, unsigned int& textureWidth, unsigned int& textureHeight) {
     //read line height
     {
         uint16_t lineHeight;
@@ -326,7 +327,7 @@ void BitmapFont::readCommon(illFileSystem::File * file, unsigned int& textureWid
     file->seekAhead(5);
 }
 
-void BitmapFont::readPages(illFileSystem::File * file, size_t size) {
+void BitmapFont::readPages(illFileSystem::BufferedFileReader * file, size_t size) {
     //string length is the same for all file names in this block
     size_t pathSize = size / m_pageTextures.size();
     char * pathBuffer = new char[pathSize];
@@ -348,7 +349,7 @@ void BitmapFont::readPages(illFileSystem::File * file, size_t size) {
     delete[] pathBuffer;
 }
 
-void BitmapFont::readChars(illFileSystem::File * file, size_t size, unsigned int textureWidth, unsigned int textureHeight) {
+void BitmapFont::readChars(illFileSystem::BufferedFileReader * file, size_t size, unsigned int textureWidth, unsigned int textureHeight) {
     memset(m_charData, 0, sizeof(CharData) * NUM_CHARS);
 
     glm::mediump_float texW = 1.0f / textureWidth;
@@ -360,7 +361,16 @@ void BitmapFont::readChars(illFileSystem::File * file, size_t size, unsigned int
     m_mesh.unload();
     m_mesh.setFrontentDataInternal(new MeshData<>(numChars << 2, numChars << 2, 1, MF_POSITION | MF_TEX_COORD));
     
-    uint16_t * indeces = m_mesh.getMeshFrontentData()->getIndices();
+    //a font with a lot of characters can end up with 32 bit indices
+    uint16_t * indeces = NULL;
+    uint32_t * indeces32 = NULL;
+
+    if(m_mesh.getMeshFrontentData()->getIndexSize() == sizeof(uint32_t)) {
+        indeces32 = m_mesh.getMeshFrontentData()->getIndices32();
+    }
+    else {
+        indeces = m_mesh.getMeshFrontentData()->getIndices();
+    }
 
     {
         auto primGroup = m_mesh.getMeshFrontentData()->getPrimitiveGroup(0);
@@ -423,12 +433,20 @@ void BitmapFont::readChars(illFileSystem::File * file, size_t size, unsigned int
             //set the character index buffer data
             size_t currVert = currChar << 2;
 
-            m_charData[character].m_meshIndex = (uint16_t) currVert;
+            m_charData[character].m_meshIndex = (uint32_t) currVert;
 
-            indeces[currVert] = (uint16_t) currVert;                                                                               //vtx 0
-            indeces[currVert + 1] = (uint16_t) currVert + 1;                                                                       //vtx 1
-            indeces[currVert + 2] = (uint16_t) currVert + 2;                                                                       //vtx 2
-            indeces[currVert + 3] = (uint16_t) currVert + 3;                                                                       //vtx 3
+            if(indeces32) {
+                indeces32[currVert] = (uint32_t) currVert;                                                                         //vtx 0
+                indeces32[currVert + 1] = (uint32_t) currVert + 1;                                                                 //vtx 1
+                indeces32[currVert + 2] = (uint32_t) currVert + 2;                                                                 //vtx 2
+                indeces32[currVert + 3] = (uint32_t) currVert + 3;                                                                 //vtx 3
+            }
+            else {
+                indeces[currVert] = (uint16_t) currVert;                                                                           //vtx 0
+                indeces[currVert + 1] = (uint16_t) currVert + 1;                                                                   //vtx 1
+                indeces[currVert + 2] = (uint16_t) currVert + 2;                                                                   //vtx 2
+                indeces[currVert + 3] = (uint16_t) currVert + 3;                                                                   //vtx 3
+            }
 
             //set the character vertex buffer data
             //positions
@@ -471,7 +489,7 @@ void BitmapFont::readChars(illFileSystem::File * file, size_t size, unsigned int
     m_mesh.frontendBackendTransferInternal(m_loader);
 }
 
-void BitmapFont::readKerningPairs(illFileSystem::File * file, size_t size) {
+void BitmapFont::readKerningPairs(illFileSystem::BufferedFileReader * file, size_t size) {
     unsigned int numPairs = (unsigned int) size / 10;
 
     for(unsigned int pair = 0; pair < numPairs; pair++) {
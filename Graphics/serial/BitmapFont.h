@@ -8,7 +8,7 @@
 #include "Graphics/serial/Model/Mesh.h"
 
 namespace illFileSystem {
-    class File;
+    class BufferedFileReader;
 }
 
 namespace illGraphics {
@@ -32,7 +32,7 @@ This will most likely get redesigned later so there's some common font rendering
 class BitmapFont : public ResourceBase<BitmapFontLoadArgs, GraphicsBackend> {
 public:
     struct CharData {
-        uint16_t m_meshIndex;               ///<the index of the first vertex in the mesh that contains geometry data for this character
+        uint32_t m_meshIndex;               ///<the index of the first vertex in the mesh that contains geometry data for this character
         glm::mediump_float m_advance;       ///<how much to advance the write location when this character is written
         uint8_t m_texturePage;              ///<which texture is this character in
     };
@@ -157,11 +157,11 @@ public:
     }
     
 private:
-    void readInfo(illFileSystem::File * file, size_t size);
-    void readCommon(illFileSystem::File * file, unsigned int& textureWidth, unsigned int& textureHeight);
-    void readPages(illFileSystem::File * file, size_t size);
-    void readChars(illFileSystem::File * file, size_t size, unsigned int textureWidth, unsigned int textureHeight);
-    void readKerningPairs(illFileSystem::File * file, size_t size);
+    void readInfo(illFileSystem::BufferedFileReader * file, size_t size);
+    void readCommon(illFileSystem::BufferedFileReader * file, unsigned int& textureWidth, unsigned int& textureHeight);
+    void readPages(illFileSystem::BufferedFileReader * file, size_t size);
+    void readChars(illFileSystem::BufferedFileReader * file, size_t size, unsigned int textureWidth, unsigned int textureHeight);
+    void readKerningPairs(illFileSystem::BufferedFileReader * file, size_t size);
     
     glm::mediump_float m_paddingUp;
     glm::mediump_float m_paddingDown;
@@ -105,13 +105,13 @@ public:
     }
 	
 private:
-	RefCountPtr<Texture> m_diffuseTexture;
-	RefCountPtr<Texture> m_specularTexture;
-	RefCountPtr<Texture> m_emissiveTexture;
-	RefCountPtr<Texture> m_normalTexture;
+	IntrusivePtr<Texture> m_diffuseTexture;
+	IntrusivePtr<Texture> m_specularTexture;
+	IntrusivePtr<Texture> m_emissiveTexture;
+	IntrusivePtr<Texture> m_normalTexture;
 
-    RefCountPtr<ShaderProgram> m_depthPassProgram;
-	RefCountPtr<ShaderProgram> m_shaderProgram;
+    IntrusivePtr<ShaderProgram> m_depthPassProgram;
+	IntrusivePtr<ShaderProgram> m_shaderProgram;
 };
 
 typedef uint32_t MaterialId;
@@ -19,6 +19,9 @@ void ShaderProgram::unload() {
 
     m_loader->m_backend->unloadShaderProgram(&m_shaderProgramData);
 
+    //reload() adds the shaders again
+    m_shaders.clear();
+
     m_state = RES_UNLOADED;
 }
 
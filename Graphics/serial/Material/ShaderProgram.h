@@ -54,7 +54,7 @@ public:
     void unload();
     void reload(ShaderProgramLoader * loader);
 
-    inline void loadInternal(ShaderProgramLoader * loader, const std::vector<RefCountPtr<Shader> >& shaderList) {
+    inline void loadInternal(ShaderProgramLoader * loader, const std::vector<IntrusivePtr<Shader> >& shaderList) {
         unload();
 
         m_loader = loader;
@@ -69,11 +69,18 @@ public:
     inline void * getShaderProgram() const { 
         return m_shaderProgramData; 
     }
+
+    /**
+    The shaders linked into the program.
+    */
+    inline const std::vector<IntrusivePtr<Shader> >& getShaders() const {
+        return m_shaders;
+    }
         
 private:
     void build();
 
-    std::vector<RefCountPtr<Shader> > m_shaders;
+    std::vector<IntrusivePtr<Shader> > m_shaders;
     void * m_shaderProgramData;
 };
 
@@ -15,6 +15,7 @@ void Texture::unload() {
     }
 
     m_loader->unloadTexture(&m_textureData);
+    m_gpuMemoryUsage = 0;
 
     m_state = RES_UNLOADED;
 }
@@ -27,6 +28,7 @@ void Texture::reload(GraphicsBackend * backend) {
     m_state = RES_LOADING;
 
     m_loader->loadTexture(&m_textureData, m_loadArgs);
+    m_gpuMemoryUsage = m_loader->getTextureMemoryUsage(m_textureData);
 
     m_state = RES_LOADED;
 }
@@ -29,7 +29,8 @@ class Texture : public ResourceBase<TextureLoadArgs, GraphicsBackend> {
 public:
     Texture()
         : ResourceBase(),
-        m_textureData(NULL)
+        m_textureData(NULL),
+        m_gpuMemoryUsage(0)
     {}
 
     virtual ~Texture() {
@@ -43,8 +44,16 @@ public:
         return m_textureData; 
     }
 
+    /**
+    Asked from the backend once when the texture loads.
+    */
+    virtual size_t getGpuMemoryUsage() const {
+        return m_gpuMemoryUsage;
+    }
+
 private:
     void* m_textureData;
+    size_t m_gpuMemoryUsage;
 };
 
 typedef uint32_t TextureId;
@@ -1,6 +1,7 @@
 #include "Logging/logging.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/File.h"
+#include "FileSystem/BufferedFileReader.h"
 
 #include "Graphics/serial/Model/AnimSet.h"
 #include "Util/serial/Array.h"
@@ -30,7 +31,7 @@ void AnimSet::reload(GraphicsBackend * backend) {
 
     m_state = RES_LOADING;
 	
-    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(m_loadArgs.m_path.c_str());
+    illFileSystem::BufferedFileReader * openFile = illFileSystem::openBufferedRead(m_loadArgs.m_path.c_str());
 	
     //read magic string
     {
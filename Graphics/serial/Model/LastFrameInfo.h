@@ -3,15 +3,17 @@
 
 namespace illGraphics {
 
+/**
+Which keys a bone was at in a SkeletonAnimation last time, so the next lookup can start looking there.
+It's only a hint, any values work.
+*/
 struct LastFrameInfo {
     LastFrameInfo()
-        : m_lastTime(0.0f),
-        m_lastPositionKey(0),
+        : m_lastPositionKey(0),
         m_lastRotationKey(0),
         m_lastScalingKey(0)
     {}
 
-    float m_lastTime;
     size_t m_lastPositionKey;
     size_t m_lastRotationKey;
     size_t m_lastScalingKey;
@@ -18,6 +18,8 @@ void Mesh::unload() {
     }
 
     delete m_meshFrontendData;
+    m_meshFrontendData = NULL;
+    m_gpuMemoryUsage = 0;
 
     m_state = RES_UNLOADED;
 }
@@ -33,6 +35,8 @@ void Mesh::setFrontentDataInternal(MeshData<> * mesh) {
 void Mesh::frontendBackendTransferInternal(GraphicsBackend * loader, bool freeFrontendData) {
     m_loader = loader;
     m_loader->loadMesh(&m_meshBackendData, *m_meshFrontendData);
+    m_gpuMemoryUsage = (size_t) m_meshFrontendData->getNumVert() * m_meshFrontendData->getVertexSize()
+        + (size_t) m_meshFrontendData->getNumInd() * m_meshFrontendData->getIndexSize();
 
     if(freeFrontendData) {
         m_meshFrontendData->free();
@@ -41,14 +45,41 @@ void Mesh::frontendBackendTransferInternal(GraphicsBackend * loader, bool freeFr
     m_state = RES_LOADED;
 }
 
+size_t Mesh::getCpuMemoryUsage() const {
+    size_t memoryUsage = sizeof(Mesh);
+
+    if(m_meshFrontendData) {
+        memoryUsage += sizeof(MeshData<>) + m_meshFrontendData->getNumPrimitiveGroups() * sizeof(MeshData<>::PrimitiveGroup);
+
+        if(m_meshFrontendData->getData()) {
+            memoryUsage += (size_t) m_meshFrontendData->getNumVert() * m_meshFrontendData->getVertexSize();
+        }
+
+        if(m_meshFrontendData->getIndexData()) {
+            memoryUsage += (size_t) m_meshFrontendData->getNumInd() * m_meshFrontendData->getIndexSize();
+        }
+    }
+
+    return memoryUsage;
+}
+
 void Mesh::reload(GraphicsBackend * backend) {
     unload();
 
+    reloadCpu();
+    reloadFinish(backend);
+}
+
+void Mesh::reloadCpu() {
     IllmeshLoader meshLoader(m_loadArgs.m_path.c_str());
 
-    setFrontentDataInternal(new MeshData<>(meshLoader.m_numInd, meshLoader.m_numVert, meshLoader.m_numGroups, meshLoader.m_features));
+    //not going through setFrontentDataInternal since the mesh is marked as loading when this runs in the background
+    m_meshFrontendData = new MeshData<>(meshLoader.m_numInd, meshLoader.m_numVert, meshLoader.m_numGroups, meshLoader.m_features, true, meshLoader.m_indexSize);
     
     meshLoader.buildMesh(*getMeshFrontentData());
+}
+
+void Mesh::reloadFinish(GraphicsBackend * backend) {
     frontendBackendTransferInternal(backend, true);
 }
 }
@@ -24,7 +24,8 @@ class Mesh : public ResourceBase<MeshLoadArgs, GraphicsBackend> {
 public:
     Mesh()
         : m_meshFrontendData(NULL),
-        m_meshBackendData(NULL)
+        m_meshBackendData(NULL),
+        m_gpuMemoryUsage(0)
     {}
 
     ~Mesh() {
@@ -34,6 +35,28 @@ public:
     virtual void unload();
     virtual void reload(GraphicsBackend * backend);
 
+    /**
+    Reads the mesh file into the frontend data.
+    */
+    virtual void reloadCpu();
+
+    /**
+    Uploads the frontend data read in reloadCpu() to the backend.
+    */
+    virtual void reloadFinish(GraphicsBackend * backend);
+
+    /**
+    The frontend data if it's still allocated, which it usually isn't after uploading to the backend.
+    */
+    virtual size_t getCpuMemoryUsage() const;
+
+    /**
+    The vertex and index buffers uploaded to the backend.
+    */
+    virtual size_t getGpuMemoryUsage() const {
+        return m_gpuMemoryUsage;
+    }
+
     void setFrontentDataInternal(MeshData<> * mesh);
     void frontendBackendTransferInternal(GraphicsBackend * loader, bool freeFrontendData = true);
 
@@ -48,6 +71,7 @@ public:
 private:
     MeshData<> * m_meshFrontendData;
     void * m_meshBackendData;
+    size_t m_gpuMemoryUsage;
 };
 
 typedef uint32_t MeshId;
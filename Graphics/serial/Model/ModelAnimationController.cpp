@@ -1,10 +1,10 @@
+#include <cmath>
 #include <glm/gtx/quaternion.hpp>
-#include <glm/gtx/transform.hpp>
-#include <new>
 
 #include "ModelAnimationController.h"
 #include "Skeleton.h"
 #include "SkeletonAnimation.h"
+#include "Util/Geometry/transformBatchMath.h"
 
 namespace illGraphics {
 
@@ -54,71 +54,243 @@ float ModelAnimationController::updateInternal(float seconds) {
 	return 0.0f;
 }
 
-void ModelAnimationController::computeAnimPose(glm::mat4 * skelMats) {
-    updateSkeleton(skelMats, m_skeleton->getRootBoneNode(), glm::mat4());
+void ModelAnimationController::updateLayers(float seconds) {
+    for(size_t layerIndex = 0; layerIndex < m_layers.size(); layerIndex++) {
+        Layer& layer = m_layers[layerIndex];
+
+        if(!layer.m_synchronize) {
+            for(size_t animation = 0; animation < layer.m_animations.size(); animation++) {
+                layer.m_animations[animation].m_animTime += seconds;
+            }
+
+            continue;
+        }
+
+        //the cycle length is the average of the durations by weight
+        float totalWeight = 0.0f;
+        float totalDuration = 0.0f;
+
+        for(size_t animation = 0; animation < layer.m_animations.size(); animation++) {
+            const Layer::BlendAnimation& blendAnimation = layer.m_animations[animation];
+
+            if(blendAnimation.m_animation && blendAnimation.m_weight > 0.0f) {
+                totalWeight += blendAnimation.m_weight;
+                totalDuration += blendAnimation.m_weight * blendAnimation.m_animation->getDuration();
+            }
+        }
+
+        if(totalDuration > 0.0f) {
+            layer.m_phase = std::fmod(layer.m_phase + seconds * totalWeight / totalDuration, 1.0f);
+        }
+
+        for(size_t animation = 0; animation < layer.m_animations.size(); animation++) {
+            Layer::BlendAnimation& blendAnimation = layer.m_animations[animation];
+
+            if(blendAnimation.m_animation) {
+                blendAnimation.m_animTime = layer.m_phase * blendAnimation.m_animation->getDuration();
+            }
+        }
+    }
+}
+
+void ModelAnimationController::Layer::maskBoneSubtree(const Skeleton * skeleton, uint16_t rootBone, float weight) {
+    const Array<Skeleton::OrderedBone>& boneOrder = skeleton->getBoneOrder();
+
+    if(m_boneMask.size() < skeleton->getNumBones()) {
+        m_boneMask.resize(skeleton->getNumBones(), 0.0f);
+    }
+
+    //parents come before their children in the bone order so one pass finds everything under the root
+    std::vector<bool> inSubtree(boneOrder.size(), false);
+
+    for(size_t ordered = 0; ordered < boneOrder.size(); ordered++) {
+        inSubtree[ordered] = boneOrder[ordered].m_boneIndex == rootBone
+            || (boneOrder[ordered].m_parent != Skeleton::NO_PARENT && inSubtree[boneOrder[ordered].m_parent]);
+
+        if(inSubtree[ordered]) {
+            m_boneMask[boneOrder[ordered].m_boneIndex] = weight;
+        }
+    }
+
+    m_maskChanged = true;
 }
 
-void ModelAnimationController::updateSkeleton(glm::mat4 * skelMats, const illGraphics::Skeleton::BoneHeirarchy * currNode, glm::mat4 currXform) {	
-	Transform<> transform[2];
-    
-    //TODO: there's currently a bug related to using relative transforms in animations, for now it's using absolute transforms but decomposing the bind pose xform
-    //should fix soon, the decomposing isn't very good for performance
-
-	//for the primary animation
-	if(m_animations[m_currentAnimation].m_animation) {
-		/*transform[0] = m_animations[m_currentAnimation].m_animation->getTransform(currNode->m_boneIndex,
-			m_animations[m_currentAnimation].m_animTime,
-			m_animations[m_currentAnimation].m_lastFrameInfo[currNode->m_boneIndex]);*/
-
-        if(!m_animations[m_currentAnimation].m_animation->getTransform(currNode->m_boneIndex,
-			m_animations[m_currentAnimation].m_animTime,
-            transform[0],
-			m_animations[m_currentAnimation].m_lastFrameInfo[currNode->m_boneIndex])) {
-
-            transform[0].set(m_skeleton->getBone(currNode->m_boneIndex).m_relativeTransform);
-        }
-	}
-	else {
-		//new(&transform[0]) Transform<>();
-
-        transform[0].set(m_skeleton->getBone(currNode->m_boneIndex).m_relativeTransform);
-	}
-
-	//for the secondary animation, see if the bone is in the animation
-	if(m_transitionWeight > 0.0f) {
-		if(m_animations[!m_currentAnimation].m_animation) {
-			/*transform[1] = m_animations[!m_currentAnimation].m_animation->getTransform(currNode->m_boneIndex,
-				m_animations[!m_currentAnimation].m_animTime,
-				m_animations[!m_currentAnimation].m_lastFrameInfo[currNode->m_boneIndex]);*/
-
-            if(!m_animations[!m_currentAnimation].m_animation->getTransform(currNode->m_boneIndex,
-			    m_animations[!m_currentAnimation].m_animTime,
-                transform[1],
-			    m_animations[!m_currentAnimation].m_lastFrameInfo[currNode->m_boneIndex])) {
-
-                transform[1].set(m_skeleton->getBone(currNode->m_boneIndex).m_relativeTransform);
+/**
+Gets a bone's transform relative to its parent in an animation, or the bind pose if the animation doesn't have the bone.
+*/
+inline void getAnimationBoneTransform(const Skeleton * skeleton, ModelAnimationController::Animation& animation, uint16_t boneIndex, Transform<>& dest) {
+    if(!animation.m_animation
+            || !animation.m_animation->getTransform(boneIndex, animation.m_animTime, dest, animation.m_lastFrameInfo[boneIndex])) {
+        dest = skeleton->getBone(boneIndex).m_relativeBindTransform;
+    }
+}
+
+void ModelAnimationController::computeAnimPose(glm::mat4 * skelMats) {
+    const Array<Skeleton::OrderedBone>& boneOrder = m_skeleton->getBoneOrder();
+
+    if(boneOrder.size() == 0) {
+        return;
+    }
+
+    if(m_modelMatrices.size() != boneOrder.size()) {
+        m_modelMatrices.resize(boneOrder.size());
+    }
+
+    Animation& primaryAnimation = m_animations[m_currentAnimation];
+    Animation& secondaryAnimation = m_animations[!m_currentAnimation];
+    bool blending = m_transitionWeight > 0.0f;
+
+    primaryAnimation.m_lastFrameInfo.resize(m_skeleton->getNumBones());
+    m_localTransforms.resize(boneOrder.size());
+
+    if(blending) {
+        secondaryAnimation.m_lastFrameInfo.resize(m_skeleton->getNumBones());
+        m_transitionTransforms.resize(boneOrder.size());
+    }
+
+    //get the layers ready, the scratch space only ever grows so this stops allocating after the first few frames
+    size_t numLayerAnimations = 0;
+
+    for(size_t layerIndex = 0; layerIndex < m_layers.size(); layerIndex++) {
+        Layer& layer = m_layers[layerIndex];
+
+        numLayerAnimations += layer.m_animations.size();
+
+        if(layer.m_weight <= 0.0f) {
+            continue;
+        }
+
+        for(size_t animation = 0; animation < layer.m_animations.size(); animation++) {
+            layer.m_animations[animation].m_lastFrameInfo.resize(m_skeleton->getNumBones());
+        }
+
+        if(layer.hasBoneMask() && (layer.m_maskChanged || layer.m_orderedMask.size() != m_localTransforms.paddedSize())) {
+            layer.m_orderedMask.assign(m_localTransforms.paddedSize(), 0.0f);
+
+            for(size_t ordered = 0; ordered < boneOrder.size(); ordered++) {
+                uint16_t boneIndex = boneOrder[ordered].m_boneIndex;
+
+                if(boneIndex < layer.m_boneMask.size()) {
+                    layer.m_orderedMask[ordered] = layer.m_boneMask[boneIndex];
+                }
             }
-		}
-		else {
-			//new(&transform[1]) Transform<>();
-
-            transform[1].set(m_skeleton->getBone(currNode->m_boneIndex).m_relativeTransform);
-		}
-
-		//now blend them
-		transform[0] = transform[0].interpolate(transform[1], m_transitionWeight);
-	}
-	
-	currXform = currXform * /*m_skeleton->getBone(currNode->m_boneIndex).m_relativeTransform **/ transform[0].getMatrix();
-
-    skelMats[currNode->m_boneIndex] = currXform * m_skeleton->getBone(currNode->m_boneIndex).m_offsetTransform
-        * glm::rotate(-90.0f, glm::vec3(1.0f, 0.0, 0.0f));     //TODO: for now hardcoded to rotate this -90 degrees around x since all md5s seem to be flipped
-                                                                //figure out how to export models in the right orientation
-                                                                //THIS!  is why there's the horrible hack code below and why it took me days to get this working, 1 tiny mistake and it all explodes
-    
-	for(std::vector<illGraphics::Skeleton::BoneHeirarchy *>::const_iterator iter = currNode->m_children.begin(); iter != currNode->m_children.end(); iter++) {
-        updateSkeleton(skelMats, *iter, currXform);
+
+            layer.m_maskChanged = false;
+        }
+    }
+
+    if(m_layerTransforms.size() < numLayerAnimations) {
+        m_layerTransforms.resize(numLayerAnimations);
+    }
+
+    for(size_t layerAnimation = 0; layerAnimation < numLayerAnimations; layerAnimation++) {
+        m_layerTransforms[layerAnimation].resize(boneOrder.size());
+    }
+
+    //local transforms of the base animations and every layer animation in one go through the bones
+    for(size_t ordered = 0; ordered < boneOrder.size(); ordered++) {
+        uint16_t boneIndex = boneOrder[ordered].m_boneIndex;
+        Transform<> transform;
+
+        getAnimationBoneTransform(m_skeleton, primaryAnimation, boneIndex, transform);
+        m_localTransforms.set(ordered, transform);
+
+        if(blending) {
+            getAnimationBoneTransform(m_skeleton, secondaryAnimation, boneIndex, transform);
+            m_transitionTransforms.set(ordered, transform);
+        }
+
+        size_t layerAnimation = 0;
+
+        for(size_t layerIndex = 0; layerIndex < m_layers.size(); layerIndex++) {
+            Layer& layer = m_layers[layerIndex];
+
+            //bones the layer doesn't affect keep whatever was in the batch, the masked blend ignores them
+            if(layer.m_weight <= 0.0f || (layer.hasBoneMask() && layer.m_orderedMask[ordered] == 0.0f)) {
+                layerAnimation += layer.m_animations.size();
+                continue;
+            }
+
+            for(size_t animation = 0; animation < layer.m_animations.size(); animation++, layerAnimation++) {
+                if(layer.m_animations[animation].m_weight > 0.0f) {
+                    getAnimationBoneTransform(m_skeleton, layer.m_animations[animation], boneIndex, transform);
+                    m_layerTransforms[layerAnimation].set(ordered, transform);
+                }
+            }
+        }
+    }
+
+    if(blending) {
+        blendTransformBatch(m_localTransforms, m_transitionTransforms, m_transitionWeight, m_localTransforms);
+    }
+
+    //combine the layers onto the base pose
+    size_t firstLayerAnimation = 0;
+
+    for(size_t layerIndex = 0; layerIndex < m_layers.size(); layerIndex++) {
+        const Layer& layer = m_layers[layerIndex];
+
+        size_t layerAnimation = firstLayerAnimation;
+        firstLayerAnimation += layer.m_animations.size();
+
+        if(layer.m_weight <= 0.0f) {
+            continue;
+        }
+
+        //blending each animation in by its share of the total weight so far comes out to the weighted average of all of them,
+        //the first animation's batch ends up with the layer's pose
+        TransformBatch * layerPose = NULL;
+        float totalWeight = 0.0f;
+
+        for(size_t animation = 0; animation < layer.m_animations.size(); animation++, layerAnimation++) {
+            float weight = layer.m_animations[animation].m_weight;
+
+            if(weight <= 0.0f) {
+                continue;
+            }
+
+            totalWeight += weight;
+
+            if(layerPose) {
+                blendTransformBatch(*layerPose, m_layerTransforms[layerAnimation], weight / totalWeight, *layerPose);
+            }
+            else {
+                layerPose = &m_layerTransforms[layerAnimation];
+            }
+        }
+
+        if(!layerPose) {
+            continue;
+        }
+
+        const float * mask = layer.hasBoneMask() ? &layer.m_orderedMask[0] : NULL;
+
+        if(layer.m_mode == LayerMode::ADDITIVE) {
+            addTransformBatch(m_localTransforms, *layerPose, m_skeleton->getBindPose(), layer.m_weight, mask, m_localTransforms);
+        }
+        else if(mask) {
+            blendTransformBatchMasked(m_localTransforms, *layerPose, layer.m_weight, mask, m_localTransforms);
+        }
+        else {
+            blendTransformBatch(m_localTransforms, *layerPose, layer.m_weight, m_localTransforms);
+        }
+    }
+
+    //model space, parents are always done before their children so the local matrices can be replaced in place
+    transformBatchMatrices(m_localTransforms, &m_modelMatrices[0]);
+
+    for(size_t ordered = 0; ordered < boneOrder.size(); ordered++) {
+        if(boneOrder[ordered].m_parent != Skeleton::NO_PARENT) {
+            multiplyMatrix(m_modelMatrices[boneOrder[ordered].m_parent], m_modelMatrices[ordered], m_modelMatrices[ordered]);
+        }
+    }
+
+    //skinning matrices, by bone index
+    for(size_t ordered = 0; ordered < boneOrder.size(); ordered++) {
+        uint16_t boneIndex = boneOrder[ordered].m_boneIndex;
+
+        multiplyMatrix(m_modelMatrices[ordered], m_skeleton->getBone(boneIndex).m_skinningTransform, skelMats[boneIndex]);
     }
 }
 
-}
\ No newline at end of file
+}
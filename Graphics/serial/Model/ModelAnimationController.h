@@ -2,11 +2,13 @@
 #define ILL_MODEL_ANIMATION_CONTROLLER_H__
 
 #include <cassert>
-#include <unordered_map>
 #include <queue>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include "Util/serial/RefCountPtr.h"
+#include "Util/serial/Array.h"
+#include "Util/Geometry/TransformBatch.h"
 #include "Graphics/serial/Model/LastFrameInfo.h"
 #include "Graphics/serial/Model/Skeleton.h"
 
@@ -14,7 +16,7 @@ namespace illGraphics {
 
 class SkeletonAnimation;
 
-//TODO: put this together right, at the moment it's just quickly thrown together and doesn't even support blending
+//TODO: put this together right, the transition queue is still just quickly thrown together
 //This is in no way how it'll be in the end
 class ModelAnimationController {
 public:
@@ -34,6 +36,8 @@ public:
 		while(remainSeconds > 0.0f) {
 			remainSeconds = updateInternal(remainSeconds);
 		}
+
+        updateLayers(seconds);
 	}
 
 	/**
@@ -43,9 +47,57 @@ public:
 	The buffer must be allocated to hold as many 4x4 matrices as there are bones in the skeleton.
 	This is the data you usually want to pass to the skinning shader or for computing
 	hitboxes or whatever...
+
+	Goes through the skeleton's bone order in three passes, the local transforms of all bones,
+	then their model space matrices, then the skinning matrices, so there's no recursion and everything is in contiguous arrays.
+	The local transforms are kept as a TransformBatch so blending and building their matrices use the SIMD code in transformBatchMath.h.
+
+	The first pass samples the base animations and every animation in every layer for each bone at once,
+	skipping bones a layer's mask leaves out, then the layers are combined onto the base pose a whole batch at a time.
+	Nothing is allocated once the scratch space has grown to fit the skeleton and layers.
 	*/
     void computeAnimPose(glm::mat4 * skelMats);
 
+    /**
+    How an animation layer combines with the pose from the base animations and the layers before it.
+    */
+    enum class LayerMode {
+        OVERRIDE,                       ///<blends from the pose so far toward the layer's pose by the layer's weight
+        ADDITIVE                        ///<adds the layer's difference from the skeleton's bind pose onto the pose so far, scaled by the layer's weight
+    };
+
+    struct Layer;
+
+    /**
+    Adds an animation layer on top of the base animations from the transition queue and the layers already added.
+    Layers are applied in the order they're added.
+
+    @return The index of the new layer for getLayer().
+    */
+    inline size_t addLayer(LayerMode mode, float weight = 1.0f) {
+        m_layers.emplace_back(mode, weight);
+        return m_layers.size() - 1;
+    }
+
+    /**
+    Gets a layer to change its weight, animations, and mask.
+    The reference is only good until the next addLayer() or clearLayers().
+    */
+    inline Layer& getLayer(size_t layer) {
+        return m_layers[layer];
+    }
+
+    inline size_t getNumLayers() const {
+        return m_layers.size();
+    }
+
+    /**
+    Removes all the layers, leaving only the base animations.
+    */
+    inline void clearLayers() {
+        m_layers.clear();
+    }
+
     /**
     Queues up an animation transition to happen after an already queued up transition.
     This is mostly for convenience given the current setup, and will change completely once animation trees are in.
@@ -89,6 +141,11 @@ public:
 	*/
 	inline void setSkeleton(Skeleton * skeleton) {
 		m_skeleton = skeleton;
+
+        //the masks are stored in the skeleton's bone order
+        for(size_t layer = 0; layer < m_layers.size(); layer++) {
+            m_layers[layer].m_maskChanged = true;
+        }
 	}
 
 	inline const Skeleton * getSkeleton() const {
@@ -104,6 +161,11 @@ public:
 	*/
 	float updateInternal(float seconds);
 
+    /**
+    Advances the time in the animations of all the layers.
+    */
+    void updateLayers(float seconds);
+
     /**
     Info about an individual animation, these are the things that are blended together
     */
@@ -119,8 +181,8 @@ public:
         ///The time in the animation
         float m_animTime;
 
-        ///The map of skeleton bone index to frame info
-        std::unordered_map<size_t, LastFrameInfo> m_lastFrameInfo;
+        ///Frame info by skeleton bone index, sized to the skeleton when posing
+        std::vector<LastFrameInfo> m_lastFrameInfo;
 	};
 
     struct Transition {
@@ -144,13 +206,108 @@ public:
         float m_beginTime;
     };
 
-	void updateSkeleton(glm::mat4 * skelMats, const illGraphics::Skeleton::BoneHeirarchy * currNode, glm::mat4 currXform);
+    /**
+    An animation layer applied on top of the base animations.
+
+    The layer's pose is a blend of any number of animations by their weights, like a locomotion blend space
+    with walking, jogging, and running all playing with weights picked from how fast the character is going.
+    That pose then overrides or adds onto the pose from below by the layer's weight, optionally on only some of the bones,
+    like an upper body aiming layer on top of running legs.
+    */
+    struct Layer {
+        /**
+        An animation in a layer and how much it counts compared to the others in the layer.
+        */
+        struct BlendAnimation : public Animation {
+            BlendAnimation()
+                : Animation(),
+                m_weight(0.0f)
+            {}
+
+            float m_weight;
+        };
+
+        Layer(LayerMode mode, float weight)
+            : m_mode(mode),
+            m_weight(weight),
+            m_synchronize(false),
+            m_phase(0.0f),
+            m_maskChanged(true)
+        {}
+
+        /**
+        Adds an animation to the blend.  The animations' weights don't have to add up to anything,
+        each one counts for its weight divided by the total of all of them.
+
+        @return The index of the animation in m_animations.
+        */
+        inline size_t addAnimation(SkeletonAnimation * animation, float weight, float beginTime = 0.0f) {
+            m_animations.emplace_back();
+            m_animations.back().m_animation = animation;
+            m_animations.back().m_animTime = beginTime;
+            m_animations.back().m_weight = weight;
+
+            return m_animations.size() - 1;
+        }
+
+        /**
+        Sets how much the layer affects each bone, usually from 0 to 1, indexed by bone index.
+        Bones past the end aren't affected at all.
+        */
+        inline void setBoneMask(const float * boneWeights, size_t numBones) {
+            m_boneMask.assign(boneWeights, boneWeights + numBones);
+            m_maskChanged = true;
+        }
+
+        /**
+        Sets the mask weight of a bone and everything under it in the skeleton, like the spine for an upper body layer.
+        If there's no mask yet, every other bone starts off unaffected.
+        */
+        void maskBoneSubtree(const Skeleton * skeleton, uint16_t rootBone, float weight = 1.0f);
+
+        /**
+        Removes the mask so the layer affects every bone fully again.
+        */
+        inline void clearBoneMask() {
+            m_boneMask.clear();
+            m_maskChanged = true;
+        }
+
+        inline bool hasBoneMask() const {
+            return !m_boneMask.empty();
+        }
+
+        LayerMode m_mode;
+
+        ///How much the layer counts, 0 skips it entirely
+        float m_weight;
+
+        std::vector<BlendAnimation> m_animations;
+
+        /**
+        If set the animations are all kept at the same fraction of the way through, going at the average speed of the blend,
+        so cycles of different lengths like walking and running line up.
+        */
+        bool m_synchronize;
+
+        ///How far through the animations a synchronized layer is, from 0 to 1
+        float m_phase;
+
+    //TODO: temporarily public like the rest
+    //private:
+        ///Weights by bone index, empty for every bone at full weight
+        std::vector<float> m_boneMask;
+
+        ///m_boneMask in the skeleton's bone order padded for the batch code, redone in computeAnimPose() when the mask changes
+        std::vector<float> m_orderedMask;
+        bool m_maskChanged;
+    };
 
     Skeleton * m_skeleton;    
     
     /**
-    Right now there's support for simple blending between two animations.
-    Eventually this will support animation trees and all that crazyness.
+    The base animations, blending between two during a transition.
+    Anything more goes on top of these in m_layers.
     */
     Animation m_animations[2];
 
@@ -159,6 +316,14 @@ public:
     glm::mediump_float m_transitionDelta;
 
     std::queue<Transition> m_transitionQueue;
+
+    std::vector<Layer> m_layers;
+
+    ///Scratch space for computeAnimPose() in the skeleton's bone order, kept around to not reallocate every frame
+    TransformBatch m_localTransforms;
+    TransformBatch m_transitionTransforms;
+    std::vector<TransformBatch> m_layerTransforms;      ///<One for each animation in each layer, in order
+    Array<glm::mat4> m_modelMatrices;
 };
 
 }
@@ -0,0 +1,45 @@
+#include "ModelAnimationSystem.h"
+#include "Util/parallel/ThreadPool.h"
+
+namespace illGraphics {
+
+ModelAnimationController * ModelAnimationSystem::addController(Skeleton * skeleton) {
+    m_controllers.emplace_back();
+
+    ModelAnimationController * controller = &m_controllers.back();
+    controller->setSkeleton(skeleton);
+
+    m_paletteOffsets.push_back(m_palette.size());
+    m_palette.resize(m_palette.size() + skeleton->getNumBones());
+
+    return controller;
+}
+
+void ModelAnimationSystem::clear() {
+    m_controllers.clear();
+    m_paletteOffsets.clear();
+    m_palette.clear();
+}
+
+void ModelAnimationSystem::update(float seconds) {
+    auto updateController = [this, seconds] (size_t index) {
+        ModelAnimationController& controller = m_controllers[index];
+
+        controller.update(seconds);
+
+        if(controller.getSkeleton()->getNumBones() > 0) {
+            controller.computeAnimPose(&m_palette[m_paletteOffsets[index]]);
+        }
+    };
+
+    if(m_threadPool) {
+        m_threadPool->parallelFor(m_controllers.size(), updateController);
+    }
+    else {
+        for(size_t index = 0; index < m_controllers.size(); index++) {
+            updateController(index);
+        }
+    }
+}
+
+}
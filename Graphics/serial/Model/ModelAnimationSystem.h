@@ -0,0 +1,102 @@
+#ifndef ILL_MODEL_ANIMATION_SYSTEM_H__
+#define ILL_MODEL_ANIMATION_SYSTEM_H__
+
+#include <deque>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include "Graphics/serial/Model/ModelAnimationController.h"
+
+class ThreadPool;
+
+namespace illGraphics {
+
+/**
+Owns the animation controllers for a whole crowd of characters and updates and poses all of them each frame,
+spread out across a ThreadPool.
+
+The skinning matrices for every controller go into one contiguous palette buffer, each controller getting the range
+starting at getPaletteOffset() with one matrix per bone of its skeleton, so the whole thing can be uploaded to the GPU in one go.
+
+Every controller only touches its own state and its own range of the palette, so the results are exactly the same
+no matter how many threads there are or which thread ends up doing which controller.
+
+Controllers are never moved once added so pointers to them stay valid until clear().
+*/
+class ModelAnimationSystem {
+public:
+    /**
+    @param threadPool The threads to update the controllers on, or NULL to do everything on the calling thread.
+    */
+    ModelAnimationSystem(ThreadPool * threadPool = NULL)
+        : m_threadPool(threadPool)
+    {}
+
+    /**
+    Adds a controller for a skeleton and makes room for its matrices in the palette.
+    The skeleton must stay loaded for as long as the controller is around.
+
+    @return The new controller, which is also at index getNumControllers() - 1.
+    */
+    ModelAnimationController * addController(Skeleton * skeleton);
+
+    /**
+    Removes all the controllers.
+    */
+    void clear();
+
+    inline size_t getNumControllers() const {
+        return m_controllers.size();
+    }
+
+    inline ModelAnimationController& getController(size_t index) {
+        return m_controllers[index];
+    }
+
+    inline const ModelAnimationController& getController(size_t index) const {
+        return m_controllers[index];
+    }
+
+    /**
+    Advances the time in every controller and writes their poses into the palette.
+    Returns once all of them are done.
+    */
+    void update(float seconds);
+
+    /**
+    The skinning matrices for all controllers from the last update().
+    */
+    inline const glm::mat4 * getPalette() const {
+        return m_palette.empty() ? NULL : &m_palette[0];
+    }
+
+    /**
+    How many matrices are in the palette in total.
+    */
+    inline size_t getPaletteSize() const {
+        return m_palette.size();
+    }
+
+    /**
+    Where in the palette a controller's matrices start.
+    */
+    inline size_t getPaletteOffset(size_t index) const {
+        return m_paletteOffsets[index];
+    }
+
+    /**
+    The threads to update the controllers on, or NULL to do everything on the calling thread.
+    */
+    ThreadPool * m_threadPool;
+
+private:
+    ///A deque so adding controllers doesn't move the existing ones, they aren't copyable
+    std::deque<ModelAnimationController> m_controllers;
+
+    std::vector<size_t> m_paletteOffsets;
+    std::vector<glm::mat4> m_palette;
+};
+
+}
+
+#endif
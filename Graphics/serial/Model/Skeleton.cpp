@@ -1,10 +1,14 @@
 #include <map>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
 
 #include "Graphics/serial/Model/Skeleton.h"
 
 #include "Logging/logging.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/File.h"
+#include "FileSystem/BufferedFileReader.h"
 
 const uint64_t SKEL_MAGIC = 0x494C4C534B454C30;		//ILLSKEL0 in big endian 64 bit
 
@@ -32,7 +36,7 @@ void Skeleton::reload(GraphicsBackend * backend) {
 
     m_state = RES_LOADING;
 	
-    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(m_loadArgs.m_path.c_str());
+    illFileSystem::BufferedFileReader * openFile = illFileSystem::openBufferedRead(m_loadArgs.m_path.c_str());
 	
 	//read magic string
     {
@@ -66,8 +70,16 @@ void Skeleton::reload(GraphicsBackend * backend) {
 				openFile->readLF(m_bones[bone].m_offsetTransform[matCol][matRow]);
             }            
         }
+
+        m_bones[bone].m_relativeBindTransform.set(m_bones[bone].m_relativeTransform);
+
+        //TODO: for now hardcoded to rotate this -90 degrees around x since all md5s seem to be flipped
+        //figure out how to export models in the right orientation
+        m_bones[bone].m_skinningTransform = m_bones[bone].m_offsetTransform * glm::rotate(-90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
     }
 
+    std::vector<uint16_t> parents(m_bones.size());
+
     //read the heirarchy
     {
         std::map<unsigned int, BoneHeirarchy *> boneToNode;
@@ -78,6 +90,7 @@ void Skeleton::reload(GraphicsBackend * backend) {
             //lookup parent node
             uint16_t parentInd;
 			openFile->readL16(parentInd);
+            parents[bone] = parentInd;
 
             //look up the parent node
             BoneHeirarchy * parentNode;
@@ -136,6 +149,52 @@ void Skeleton::reload(GraphicsBackend * backend) {
 		
 	delete openFile;
 
+    //the order to pose the bones in, breadth first from the roots
+    {
+        std::vector<std::vector<uint16_t> > children(m_bones.size());
+
+        for(uint16_t bone = 0; bone < m_bones.size(); bone++) {
+            if(parents[bone] != bone && parents[bone] < m_bones.size()) {
+                children[parents[bone]].push_back(bone);
+            }
+        }
+
+        m_boneOrder.resize(m_bones.size());
+        size_t numOrdered = 0;
+
+        for(uint16_t bone = 0; bone < m_bones.size(); bone++) {
+            if(parents[bone] == bone) {
+                m_boneOrder[numOrdered].m_boneIndex = bone;
+                m_boneOrder[numOrdered].m_parent = NO_PARENT;
+                ++numOrdered;
+            }
+        }
+
+        for(size_t ordered = 0; ordered < numOrdered; ordered++) {
+            const std::vector<uint16_t>& boneChildren = children[m_boneOrder[ordered].m_boneIndex];
+
+            for(size_t child = 0; child < boneChildren.size(); child++) {
+                m_boneOrder[numOrdered].m_boneIndex = boneChildren[child];
+                m_boneOrder[numOrdered].m_parent = (uint16_t) ordered;
+                ++numOrdered;
+            }
+        }
+
+        //bones with a bad parent index or in a loop
+        if(numOrdered != m_bones.size()) {
+            LOG_ERROR("Skeleton %s has %u bones that aren't connected to a root bone.  They won't be posed.",
+                m_loadArgs.m_path.c_str(), (unsigned int) (m_bones.size() - numOrdered));
+
+            m_boneOrder.resize(numOrdered);
+        }
+    }
+
+    m_bindPose.resize(m_boneOrder.size());
+
+    for(size_t ordered = 0; ordered < m_boneOrder.size(); ordered++) {
+        m_bindPose.set(ordered, m_bones[m_boneOrder[ordered].m_boneIndex].m_relativeBindTransform);
+    }
+
     m_state = RES_LOADED;
 }
 
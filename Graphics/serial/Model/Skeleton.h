@@ -8,6 +8,8 @@
 #include "Util/serial/ResourceBase.h"
 #include "Util/serial/ResourceManager.h"
 #include "Util/serial/Array.h"
+#include "Util/Geometry/Transform.h"
+#include "Util/Geometry/TransformBatch.h"
 #include "Logging/logging.h"
 
 namespace illGraphics {
@@ -27,8 +29,21 @@ public:
 	struct Bone {
         glm::mat4 m_relativeTransform;  //the transform relative to the parent in the bind pose
         glm::mat4 m_offsetTransform;    //the inverse of the full transform in the bind pose
+
+        Transform<> m_relativeBindTransform;    //m_relativeTransform decomposed, for bones that aren't animated
+        glm::mat4 m_skinningTransform;          //m_offsetTransform with the model orientation fix, what skinning matrices end with
+    };
+
+    /**
+    A bone in the order bones need to be posed in, see getBoneOrder().
+    */
+    struct OrderedBone {
+        uint16_t m_boneIndex;
+        uint16_t m_parent;              ///<Where the parent is in the bone order, always earlier, or NO_PARENT for a root
     };
 
+    static const uint16_t NO_PARENT = 0xFFFF;
+
     struct BoneHeirarchy {
         unsigned int m_boneIndex;
 
@@ -67,8 +82,25 @@ public:
         return m_heirarchy;
     }
 
+    /**
+    All the bones ordered so parents come before their children, with the parents as indices into this same array.
+    Posing a skeleton is one loop over this where every bone's parent is already done.
+    */
+    inline const Array<OrderedBone>& getBoneOrder() const {
+        return m_boneOrder;
+    }
+
+    /**
+    Every bone's m_relativeBindTransform in the bone order, what additive animation layers are relative to.
+    */
+    inline const TransformBatch& getBindPose() const {
+        return m_bindPose;
+    }
+
 private:
 	Array<Bone> m_bones;	
+    Array<OrderedBone> m_boneOrder;
+    TransformBatch m_bindPose;
     BoneHeirarchy * m_heirarchy;
 };
 
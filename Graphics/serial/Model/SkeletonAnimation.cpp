@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 
@@ -6,113 +11,701 @@
 #include "Logging/logging.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/File.h"
+#include "FileSystem/BufferedFileReader.h"
 #include "Util/Geometry/Transform.h"
+#include "Util/Geometry/quantization.h"
 
 const uint64_t ANIM_MAGIC = 0x494C4C414E494D30;		//ILLANIM0 in big endian 64 bit
+const uint64_t ANIM1_MAGIC = 0x494C4C414E494D31;	//ILLANIM1 in big endian 64 bit
+
+const uint32_t ANIM1_HEADER_SIZE = 32;
+const uint32_t ANIM1_BONE_SIZE = 72;
+const uint32_t ANIM1_BLOCK_ALIGNMENT = 16;
+
+/**
+The encoder won't drop more than this many keys in a row, so encoding stays linear in the number of keys.
+*/
+const unsigned int ANIM_MAX_DROPPED_KEYS = 64;
+
+/**
+How far the key lookup walks from where it was last time before switching to a binary search.
+*/
+const unsigned int ANIM_CURSOR_MAX_STEPS = 4;
+
+/**
+Sample rates past this in a file are treated as corrupt, so a bad file can't make the loader expect billions of keys.
+*/
+const float ANIM_MAX_SAMPLE_RATE = 10000.0f;
 
 namespace illGraphics {
 
-Transform<> SkeletonAnimation::AnimData::getTransform(glm::mediump_float time, glm::mediump_float duration, LastFrameInfo& lastFrameInfo) const {
-    time = fmod(time, duration);
-    
-    if(time < lastFrameInfo.m_lastTime) {
-        lastFrameInfo.m_lastPositionKey = 0;
-        lastFrameInfo.m_lastRotationKey = 0;
-        lastFrameInfo.m_lastScalingKey = 0;
-    }
+namespace {
 
-    lastFrameInfo.m_lastTime = time;
+inline uint32_t anim1AlignOffset(size_t offset) {
+    return (uint32_t) ((offset + ANIM1_BLOCK_ALIGNMENT - 1) & ~(size_t) (ANIM1_BLOCK_ALIGNMENT - 1));
+}
+
+/**
+Finds the last key at or before a time, or key 0 if the time is before all of them.
+
+Checks the few keys around the cursor first, since playing forward or backward at normal speed only moves a key or two a frame,
+and binary searches the rest of the keys in the direction the time went otherwise, so seeking around a long animation doesn't go through every key.
+
+@param getTime Gives the time of a key given its index.
+@param cursor Where the key was last time.  It's only a hint, anything works.
+*/
+template <typename GetTime>
+inline size_t findKey(const GetTime& getTime, size_t numKeys, glm::mediump_float time, size_t cursor) {
+    //the first key after the time is somewhere in [low, high]
+    size_t low = 0;
+    size_t high = numKeys;
+
+    if(cursor < numKeys) {
+        if(getTime(cursor) <= time) {
+            for(unsigned int step = 0; step < ANIM_CURSOR_MAX_STEPS; step++) {
+                if(cursor + 1 >= numKeys || time < getTime(cursor + 1)) {
+                    return cursor;
+                }
 
-    //find the right keys
-    while(lastFrameInfo.m_lastPositionKey < m_positionKeys.size() - 1) {
-        if(time < m_positionKeys[lastFrameInfo.m_lastPositionKey + 1].m_time) {
-            break;
+                cursor++;
+            }
+
+            low = cursor + 1;
         }
-        lastFrameInfo.m_lastPositionKey++;
-    }
+        else {
+            for(unsigned int step = 0; step < ANIM_CURSOR_MAX_STEPS; step++) {
+                if(cursor == 0) {
+                    return 0;
+                }
+
+                cursor--;
 
-    while(lastFrameInfo.m_lastRotationKey < m_rotationKeys.size() - 1) {
-        if(time < m_rotationKeys[lastFrameInfo.m_lastRotationKey + 1].m_time) {
-            break;
+                if(getTime(cursor) <= time) {
+                    return cursor;
+                }
+            }
+
+            high = cursor;
         }
-        lastFrameInfo.m_lastRotationKey++;
     }
 
-    while(lastFrameInfo.m_lastScalingKey < m_scalingKeys.size() - 1) {
-        if(time < m_scalingKeys[lastFrameInfo.m_lastScalingKey + 1].m_time) {
-            break;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if(time < getTime(middle)) {
+            high = middle;
+        }
+        else {
+            low = middle + 1;
         }
-        lastFrameInfo.m_lastScalingKey++;
     }
-    
-    //LOG_DEBUG("Time: %f Pos: %u Rot: %u Scale: %u", time, lastKey[0], lastKey[1], lastKey[2]);
 
-    //interpolate between keys
-	Transform<> res;
+    return low == 0 ? 0 : low - 1;
+}
 
-    //position
-    {
-        size_t key1 = lastFrameInfo.m_lastPositionKey;
-        size_t key2 = (lastFrameInfo.m_lastPositionKey + 1) % m_positionKeys.size();
+/**
+Finds the keys on either side of a time.
+
+@param sampleRate If the animation is uniformly sampled the keys per second, and the key is found straight from the time.
+    0 to search for it with findKey.
+@param cursor The key at or before the time, gets updated.  It's used as a hint for where to start looking.
+@param key2 Gets set to the key after the time, which is key 0 when looping around past the last key.
+@return How far between the two keys the time is, 0 if it's right on the first one.
+*/
+inline glm::mediump_float findKeys(const float * times, uint32_t numKeys, glm::mediump_float time, glm::mediump_float duration, glm::mediump_float sampleRate,
+        size_t& cursor, size_t& key2) {
+    if(sampleRate > 0.0f) {
+        glm::mediump_float position = time * sampleRate;
+        cursor = position > 0.0f ? glm::min((size_t) position, (size_t) numKeys - 1) : 0;
+    }
+    else {
+        cursor = findKey([times] (size_t key) { return times[key]; }, numKeys, time, cursor);
+    }
+
+    key2 = (cursor + 1) % numKeys;
+
+    glm::mediump_float interp = times[key2] - times[cursor];
+
+    if(interp < 0.0f) {
+        interp += duration;
+    }
+
+    if(interp == 0.0f) {
+        return 0.0f;
+    }
+
+    return (time - times[cursor]) / interp;
+}
 
-        glm::mediump_float interp = m_positionKeys[key2].m_time - m_positionKeys[key1].m_time;
+/**
+Wraps a time into the animation so it loops, including going backwards past the start.
+*/
+inline glm::mediump_float loopAnimationTime(glm::mediump_float time, glm::mediump_float duration) {
+    time = fmod(time, duration);
+
+    if(time < 0.0f) {
+        time += duration;
+    }
+
+    return time;
+}
+
+/**
+Uniformly sampled channels either don't change and have one key, or have a key for every sample.
+*/
+inline bool uniformTrackKeys(uint32_t numKeys, uint32_t numSamples) {
+    return numKeys == 1 || numKeys == numSamples;
+}
+
+inline glm::vec3 decodeVectorKey(const illGraphics::SkeletonAnimation::VectorTrack& track, const uint16_t * values) {
+    return glm::vec3(dequantizeRange16(values[0], track.m_rangeMin.x, track.m_rangeScale.x),
+        dequantizeRange16(values[1], track.m_rangeMin.y, track.m_rangeScale.y),
+        dequantizeRange16(values[2], track.m_rangeMin.z, track.m_rangeScale.z));
+}
 
-        if(interp < 0.0f) {
-            interp += duration;
+inline double vectorError(const glm::vec3& vector1, const glm::vec3& vector2) {
+    double x = (double) vector1.x - vector2.x;
+    double y = (double) vector1.y - vector2.y;
+    double z = (double) vector1.z - vector2.z;
+
+    return sqrt(x * x + y * y + z * z);
+}
+
+/**
+The angle in radians between two rotations.
+*/
+inline double rotationError(const glm::quat& rotation1, const glm::quat& rotation2) {
+    double dot = 0.0;
+    double length1 = 0.0;
+    double length2 = 0.0;
+
+    for(int component = 0; component < 4; component++) {
+        dot += (double) rotation1[component] * rotation2[component];
+        length1 += (double) rotation1[component] * rotation1[component];
+        length2 += (double) rotation2[component] * rotation2[component];
+    }
+
+    dot = fabs(dot) / sqrt(length1 * length2);
+
+    return dot >= 1.0 ? 0.0 : 2.0 * acos(dot);
+}
+
+/**
+Decides which keys of a channel to keep.  The first and last keys are always kept so looping and the time before the first key
+work the same.  The rest are dropped if interpolating the decoded neighbors that are kept gets within the error bound of the original.
+
+@param decoded The keys as they'll come out after quantizing.
+@param interpolate Interpolates between two decoded values.
+@param error Measures the error between a decoded value and an original.
+*/
+template <typename T, typename Interpolate, typename Error>
+void reduceKeys(const Array<illGraphics::SkeletonAnimation::AnimData::Key<T>>& keys, const std::vector<T>& decoded, float errorBound,
+        Interpolate interpolate, Error error, std::vector<uint32_t>& kept) {
+    size_t numKeys = keys.size();
+    kept.clear();
+    kept.push_back(0);
+
+    size_t anchor = 0;
+
+    for(size_t end = 2; end < numKeys; end++) {
+        bool fits = end - anchor <= ANIM_MAX_DROPPED_KEYS + 1;
+        glm::mediump_float span = keys[end].m_time - keys[anchor].m_time;
+
+        if(span <= 0.0f) {
+            fits = false;
         }
 
-        if(interp == 0.0f) {
-			res.m_position = m_positionKeys[key1].m_data;
+        for(size_t key = anchor + 1; fits && key < end; key++) {
+            glm::mediump_float interp = (keys[key].m_time - keys[anchor].m_time) / span;
+
+            if(error(interpolate(decoded[anchor], decoded[end], interp), keys[key].m_data) > errorBound) {
+                fits = false;
+            }
         }
-        else {
-            interp = (time - m_positionKeys[key1].m_time) / interp;
-            res.m_position = m_positionKeys[key1].m_data + (m_positionKeys[key2].m_data - m_positionKeys[key1].m_data) * interp;
+
+        if(!fits) {
+            kept.push_back((uint32_t) (end - 1));
+            anchor = end - 1;
         }
     }
 
-    //rotation
-    {
-        size_t key1 = lastFrameInfo.m_lastRotationKey;
-        size_t key2 = (lastFrameInfo.m_lastRotationKey + 1) % m_rotationKeys.size();
+    if(numKeys > 1) {
+        kept.push_back((uint32_t) (numKeys - 1));
+    }
+}
+
+void keepAllKeys(size_t numKeys, std::vector<uint32_t>& kept) {
+    kept.resize(numKeys);
+
+    for(size_t key = 0; key < numKeys; key++) {
+        kept[key] = (uint32_t) key;
+    }
+}
+
+void encodeVectorTrack(const Array<illGraphics::SkeletonAnimation::AnimData::Key<glm::vec3>>& keys, float errorBound, bool dropKeys, const glm::vec3& defaultValue,
+        illGraphics::SkeletonAnimation::VectorTrack& track, std::vector<float>& times, std::vector<uint16_t>& values) {
+    track.m_firstKey = (uint32_t) times.size();
+
+    //no keys at all is treated as being at the default value the whole time
+    if(keys.size() == 0) {
+        track.m_numKeys = 1;
+        track.m_rangeMin = defaultValue;
+        track.m_rangeScale = glm::vec3(0.0f);
+
+        times.push_back(0.0f);
+        values.insert(values.end(), 3, 0);
+        return;
+    }
+
+    //constant channels get one key with an empty range so it comes out exact
+    bool constant = true;
+
+    for(size_t key = 1; constant && key < keys.size(); key++) {
+        constant = vectorError(keys[key].m_data, keys[0].m_data) <= errorBound;
+    }
 
-        glm::mediump_float interp = m_rotationKeys[key2].m_time - m_rotationKeys[key1].m_time;
+    if(constant) {
+        track.m_numKeys = 1;
+        track.m_rangeMin = keys[0].m_data;
+        track.m_rangeScale = glm::vec3(0.0f);
 
-        if(interp < 0.0f) {
-            interp += duration;
+        times.push_back(keys[0].m_time);
+        values.insert(values.end(), 3, 0);
+        return;
+    }
+
+    glm::vec3 rangeMax = keys[0].m_data;
+    track.m_rangeMin = keys[0].m_data;
+
+    for(size_t key = 1; key < keys.size(); key++) {
+        for(int component = 0; component < 3; component++) {
+            track.m_rangeMin[component] = std::min(track.m_rangeMin[component], keys[key].m_data[component]);
+            rangeMax[component] = std::max(rangeMax[component], keys[key].m_data[component]);
         }
+    }
 
-        if(interp == 0.0f) {
-			res.m_rotation = m_rotationKeys[key1].m_data;
+    glm::vec3 rangeExtent = rangeMax - track.m_rangeMin;
+    track.m_rangeScale = rangeExtent / 65535.0f;
+
+    std::vector<uint16_t> quantized(keys.size() * 3);
+    std::vector<glm::vec3> decoded(keys.size());
+
+    for(size_t key = 0; key < keys.size(); key++) {
+        for(int component = 0; component < 3; component++) {
+            quantized[key * 3 + component] = quantizeRange16(keys[key].m_data[component], track.m_rangeMin[component], rangeExtent[component]);
         }
-        else {
-            interp = (time - m_rotationKeys[key1].m_time) / interp;
-            res.m_rotation = glm::shortMix(m_rotationKeys[key1].m_data, m_rotationKeys[key2].m_data, interp);
+
+        decoded[key] = decodeVectorKey(track, &quantized[key * 3]);
+    }
+
+    std::vector<uint32_t> kept;
+
+    if(dropKeys) {
+        reduceKeys(keys, decoded, errorBound,
+            [] (const glm::vec3& value1, const glm::vec3& value2, glm::mediump_float interp) {
+                return value1 + (value2 - value1) * interp;
+            },
+            vectorError, kept);
+    }
+    else {
+        keepAllKeys(keys.size(), kept);
+    }
+
+    track.m_numKeys = (uint32_t) kept.size();
+
+    for(size_t key = 0; key < kept.size(); key++) {
+        times.push_back(keys[kept[key]].m_time);
+        values.insert(values.end(), quantized.begin() + kept[key] * 3, quantized.begin() + kept[key] * 3 + 3);
+    }
+}
+
+void encodeRotationTrack(const Array<illGraphics::SkeletonAnimation::AnimData::Key<glm::quat>>& keys, float errorBound, bool dropKeys,
+        illGraphics::SkeletonAnimation::RotationTrack& track, std::vector<float>& times, std::vector<uint16_t>& values) {
+    track.m_firstKey = (uint32_t) times.size();
+
+    uint16_t packed[3];
+
+    if(keys.size() == 0) {
+        track.m_numKeys = 1;
+
+        packQuatSmallestThree(glm::quat(), packed);
+        times.push_back(0.0f);
+        values.insert(values.end(), packed, packed + 3);
+        return;
+    }
+
+    std::vector<uint16_t> quantized(keys.size() * 3);
+    std::vector<glm::quat> decoded(keys.size());
+
+    for(size_t key = 0; key < keys.size(); key++) {
+        packQuatSmallestThree(keys[key].m_data, &quantized[key * 3]);
+        decoded[key] = unpackQuatSmallestThree(&quantized[key * 3]);
+    }
+
+    bool constant = true;
+
+    for(size_t key = 1; constant && key < keys.size(); key++) {
+        constant = rotationError(keys[key].m_data, decoded[0]) <= errorBound;
+    }
+
+    std::vector<uint32_t> kept;
+
+    if(constant) {
+        kept.push_back(0);
+    }
+    else if(!dropKeys) {
+        keepAllKeys(keys.size(), kept);
+    }
+    else {
+        reduceKeys(keys, decoded, errorBound,
+            [] (const glm::quat& value1, const glm::quat& value2, glm::mediump_float interp) {
+                return glm::shortMix(value1, value2, interp);
+            },
+            rotationError, kept);
+    }
+
+    track.m_numKeys = (uint32_t) kept.size();
+
+    for(size_t key = 0; key < kept.size(); key++) {
+        times.push_back(keys[kept[key]].m_time);
+        values.insert(values.end(), quantized.begin() + kept[key] * 3, quantized.begin() + kept[key] * 3 + 3);
+    }
+}
+
+template <typename T>
+void copyToArray(const std::vector<T>& source, Array<T>& destination) {
+    destination.resize(source.size());
+
+    if(!source.empty()) {
+        memcpy(&destination[0], &source[0], source.size() * sizeof(T));
+    }
+}
+
+void writeAnim1Padding(illFileSystem::File * file, size_t offset) {
+    for(size_t position = file->tell(); position < offset; position++) {
+        file->write8(0);
+    }
+}
+
+void writeAnim1VectorTrack(illFileSystem::File * file, const illGraphics::SkeletonAnimation::VectorTrack& track) {
+    file->writeL32(track.m_firstKey);
+    file->writeL32(track.m_numKeys);
+
+    for(int component = 0; component < 3; component++) {
+        file->writeLF(track.m_rangeMin[component]);
+    }
+
+    for(int component = 0; component < 3; component++) {
+        file->writeLF(track.m_rangeScale[component]);
+    }
+}
+
+void readAnim1VectorTrack(illFileSystem::BufferedFileReader * file, illGraphics::SkeletonAnimation::VectorTrack& track) {
+    file->readL32(track.m_firstKey);
+    file->readL32(track.m_numKeys);
+
+    for(int component = 0; component < 3; component++) {
+        file->readLF(track.m_rangeMin[component]);
+    }
+
+    for(int component = 0; component < 3; component++) {
+        file->readLF(track.m_rangeScale[component]);
+    }
+}
+
+/**
+Writes the times and values blocks of a channel.
+*/
+void writeAnim1Channel(illFileSystem::File * file, const illGraphics::SkeletonAnimation::KeyChannel& channel) {
+    writeAnim1Padding(file, anim1AlignOffset(file->tell()));
+
+    for(size_t key = 0; key < channel.m_times.size(); key++) {
+        file->writeLF(channel.m_times[key]);
+    }
+
+    writeAnim1Padding(file, anim1AlignOffset(file->tell()));
+
+    for(size_t value = 0; value < channel.m_values.size(); value++) {
+        file->writeL16(channel.m_values[value]);
+    }
+}
+
+/**
+Reads the times and values blocks of a channel in one go each.
+
+@return False if the blocks would go past the end of the file, without resizing the channel to the bogus count.
+*/
+bool readAnim1Channel(illFileSystem::BufferedFileReader * file, uint32_t numKeys, illGraphics::SkeletonAnimation::KeyChannel& channel) {
+    //64 bit so a huge count can't wrap around
+    uint64_t timesEnd = (uint64_t) anim1AlignOffset(file->tell()) + (uint64_t) numKeys * sizeof(float);
+    uint64_t valuesEnd = ((timesEnd + ANIM1_BLOCK_ALIGNMENT - 1) & ~(uint64_t) (ANIM1_BLOCK_ALIGNMENT - 1)) + (uint64_t) numKeys * 3 * sizeof(uint16_t);
+
+    if(numKeys > 0 && valuesEnd > file->getSize()) {
+        return false;
+    }
+
+    channel.m_times.resize(numKeys);
+    channel.m_values.resize((size_t) numKeys * 3);
+
+    if(numKeys == 0) {
+        return true;
+    }
+
+    file->seek(anim1AlignOffset(file->tell()));
+    file->read(&channel.m_times[0], numKeys * sizeof(float));
+
+    file->seek(anim1AlignOffset(file->tell()));
+    file->read(&channel.m_values[0], (size_t) numKeys * 3 * sizeof(uint16_t));
+
+#if ILL_BYTEORDER == ILL_BIG_ENDIAN
+    for(uint32_t key = 0; key < numKeys; key++) {
+        channel.m_times[key] = littleF(channel.m_times[key]);
+    }
+
+    for(size_t value = 0; value < channel.m_values.size(); value++) {
+        channel.m_values[value] = little16(channel.m_values[value]);
+    }
+#endif
+
+    return true;
+}
+
+}
+
+namespace {
+
+/**
+Interpolates between the uncompressed keys of a channel.
+*/
+template <typename T, typename Interpolate>
+T interpolateAnimDataKeys(const Array<SkeletonAnimation::AnimData::Key<T>>& keys, glm::mediump_float time, glm::mediump_float duration,
+        size_t& cursor, Interpolate interpolate) {
+    cursor = findKey([&keys] (size_t key) { return keys[key].m_time; }, keys.size(), time, cursor);
+
+    size_t key2 = (cursor + 1) % keys.size();
+
+    glm::mediump_float interp = keys[key2].m_time - keys[cursor].m_time;
+
+    if(interp < 0.0f) {
+        interp += duration;
+    }
+
+    if(interp == 0.0f) {
+        return keys[cursor].m_data;
+    }
+
+    return interpolate(keys[cursor].m_data, keys[key2].m_data, (time - keys[cursor].m_time) / interp);
+}
+
+/**
+Samples a channel's keys at a fixed rate.  Channels with one key or none are left that way, the encoder treats them as constant.
+*/
+template <typename T, typename Interpolate>
+void resampleAnimDataKeys(const Array<SkeletonAnimation::AnimData::Key<T>>& keys, glm::mediump_float duration, glm::mediump_float sampleRate, uint32_t numSamples,
+        Interpolate interpolate, Array<SkeletonAnimation::AnimData::Key<T>>& dest) {
+    if(keys.size() <= 1) {
+        dest.resize(keys.size());
+
+        for(size_t key = 0; key < keys.size(); key++) {
+            dest[key] = keys[key];
         }
+
+        return;
     }
 
-    //scaling
+    dest.resize(numSamples);
+    size_t cursor = 0;
+
+    for(uint32_t sample = 0; sample < numSamples; sample++) {
+        dest[sample].m_time = (glm::mediump_float) sample / sampleRate;
+        dest[sample].m_data = interpolateAnimDataKeys(keys, dest[sample].m_time, duration, cursor, interpolate);
+    }
+}
+
+glm::vec3 lerpAnimDataKeys(const glm::vec3& value1, const glm::vec3& value2, glm::mediump_float interp) {
+    return value1 + (value2 - value1) * interp;
+}
+
+glm::quat slerpAnimDataKeys(const glm::quat& value1, const glm::quat& value2, glm::mediump_float interp) {
+    return glm::shortMix(value1, value2, interp);
+}
+
+/**
+How many keys a uniformly sampled channel has, the ones at multiples of 1 / sampleRate before the end of the animation.
+*/
+inline uint32_t uniformSampleCount(glm::mediump_float duration, glm::mediump_float sampleRate) {
+    return glm::max((uint32_t) std::ceil(duration * sampleRate), (uint32_t) 1);
+}
+
+}
+
+Transform<> SkeletonAnimation::AnimData::getTransform(glm::mediump_float time, glm::mediump_float duration, LastFrameInfo& lastFrameInfo) const {
+    time = loopAnimationTime(time, duration);
+
+    Transform<> res;
+
+    res.m_position = interpolateAnimDataKeys(m_positionKeys, time, duration, lastFrameInfo.m_lastPositionKey, lerpAnimDataKeys);
+    res.m_rotation = interpolateAnimDataKeys(m_rotationKeys, time, duration, lastFrameInfo.m_lastRotationKey, slerpAnimDataKeys);
+    res.m_scale = interpolateAnimDataKeys(m_scalingKeys, time, duration, lastFrameInfo.m_lastScalingKey, lerpAnimDataKeys);
+
+    return res;
+}
+
+Transform<> SkeletonAnimation::getBoneTransform(const BoneTracks& boneTracks, glm::mediump_float time, LastFrameInfo& lastFrameInfo) const {
+    time = loopAnimationTime(time, m_duration);
+
+    Transform<> res;
+
+    //position
     {
-        size_t key1 = lastFrameInfo.m_lastScalingKey;
-        size_t key2 = (lastFrameInfo.m_lastScalingKey + 1) % m_scalingKeys.size();
+        const VectorTrack& track = boneTracks.m_position;
+        const uint16_t * values = &m_positionKeys.m_values[(size_t) track.m_firstKey * 3];
+        size_t key2;
 
-        glm::mediump_float interp = m_scalingKeys[key2].m_time - m_scalingKeys[key1].m_time;
+        glm::mediump_float interp = findKeys(&m_positionKeys.m_times[track.m_firstKey], track.m_numKeys, time, m_duration, m_sampleRate, lastFrameInfo.m_lastPositionKey, key2);
+        res.m_position = decodeVectorKey(track, values + lastFrameInfo.m_lastPositionKey * 3);
 
-        if(interp < 0.0f) {
-            interp += duration;
+        if(interp != 0.0f) {
+            res.m_position += (decodeVectorKey(track, values + key2 * 3) - res.m_position) * interp;
         }
+    }
 
-        if(interp == 0.0f) {
-			res.m_scale = m_scalingKeys[key1].m_data;
+    //rotation
+    {
+        const RotationTrack& track = boneTracks.m_rotation;
+        const uint16_t * values = &m_rotationKeys.m_values[(size_t) track.m_firstKey * 3];
+        size_t key2;
+
+        glm::mediump_float interp = findKeys(&m_rotationKeys.m_times[track.m_firstKey], track.m_numKeys, time, m_duration, m_sampleRate, lastFrameInfo.m_lastRotationKey, key2);
+        res.m_rotation = unpackQuatSmallestThree(values + lastFrameInfo.m_lastRotationKey * 3);
+
+        if(interp != 0.0f) {
+            res.m_rotation = glm::shortMix(res.m_rotation, unpackQuatSmallestThree(values + key2 * 3), interp);
         }
-        else {
-            interp = (time - m_scalingKeys[key1].m_time) / interp;
-            res.m_scale = m_scalingKeys[key1].m_data + (m_scalingKeys[key2].m_data - m_scalingKeys[key1].m_data) * interp;
+    }
+
+    //scaling
+    {
+        const VectorTrack& track = boneTracks.m_scaling;
+        const uint16_t * values = &m_scalingKeys.m_values[(size_t) track.m_firstKey * 3];
+        size_t key2;
+
+        glm::mediump_float interp = findKeys(&m_scalingKeys.m_times[track.m_firstKey], track.m_numKeys, time, m_duration, m_sampleRate, lastFrameInfo.m_lastScalingKey, key2);
+        res.m_scale = decodeVectorKey(track, values + lastFrameInfo.m_lastScalingKey * 3);
+
+        if(interp != 0.0f) {
+            res.m_scale += (decodeVectorKey(track, values + key2 * 3) - res.m_scale) * interp;
         }
     }
 
     return res;
 }
 
+void SkeletonAnimation::encode(glm::mediump_float duration, const BoneAnimationMap& boneAnimation, const SkeletonAnimationErrorBounds& errorBounds,
+        glm::mediump_float sampleRate) {
+    clear();
+
+    m_duration = duration;
+    m_sampleRate = sampleRate > 0.0f ? sampleRate : 0.0f;
+
+    bool dropKeys = m_sampleRate == 0.0f;
+    uint32_t numSamples = dropKeys ? 0 : uniformSampleCount(duration, m_sampleRate);
+
+    //go through the bones in order so the keys come out the same every time
+    std::vector<uint16_t> boneIndices;
+
+    for(BoneAnimationMap::const_iterator iter = boneAnimation.begin(); iter != boneAnimation.end(); iter++) {
+        boneIndices.push_back(iter->first);
+    }
+
+    std::sort(boneIndices.begin(), boneIndices.end());
+
+    m_numAnimatedBones = (unsigned int) boneIndices.size();
+    m_boneTracks.resize(boneIndices.empty() ? 0 : boneIndices.back() + 1);
+
+    if(m_boneTracks.size() > 0) {
+        memset(&m_boneTracks[0], 0, m_boneTracks.size() * sizeof(BoneTracks));
+    }
+
+    std::vector<float> positionTimes, rotationTimes, scalingTimes;
+    std::vector<uint16_t> positionValues, rotationValues, scalingValues;
+
+    for(size_t bone = 0; bone < boneIndices.size(); bone++) {
+        const AnimData * animData = &boneAnimation.find(boneIndices[bone])->second;
+        BoneTracks& boneTracks = m_boneTracks[boneIndices[bone]];
+
+        AnimData resampled;
+
+        if(!dropKeys) {
+            resampleAnimDataKeys(animData->m_positionKeys, duration, m_sampleRate, numSamples, lerpAnimDataKeys, resampled.m_positionKeys);
+            resampleAnimDataKeys(animData->m_rotationKeys, duration, m_sampleRate, numSamples, slerpAnimDataKeys, resampled.m_rotationKeys);
+            resampleAnimDataKeys(animData->m_scalingKeys, duration, m_sampleRate, numSamples, lerpAnimDataKeys, resampled.m_scalingKeys);
+
+            animData = &resampled;
+        }
+
+        encodeVectorTrack(animData->m_positionKeys, errorBounds.m_position, dropKeys, glm::vec3(0.0f), boneTracks.m_position, positionTimes, positionValues);
+        encodeRotationTrack(animData->m_rotationKeys, errorBounds.m_rotation, dropKeys, boneTracks.m_rotation, rotationTimes, rotationValues);
+        encodeVectorTrack(animData->m_scalingKeys, errorBounds.m_scaling, dropKeys, glm::vec3(1.0f), boneTracks.m_scaling, scalingTimes, scalingValues);
+    }
+
+    copyToArray(positionTimes, m_positionKeys.m_times);
+    copyToArray(positionValues, m_positionKeys.m_values);
+    copyToArray(rotationTimes, m_rotationKeys.m_times);
+    copyToArray(rotationValues, m_rotationKeys.m_values);
+    copyToArray(scalingTimes, m_scalingKeys.m_times);
+    copyToArray(scalingValues, m_scalingKeys.m_values);
+}
+
+void SkeletonAnimation::writeIllanim1(illFileSystem::File * file) const {
+    //header
+    file->writeB64(ANIM1_MAGIC);
+    file->writeLF(m_duration);
+    file->writeL16((uint16_t) m_boneTracks.size());
+    file->writeL16((uint16_t) m_numAnimatedBones);
+    file->writeL32((uint32_t) m_positionKeys.m_times.size());
+    file->writeL32((uint32_t) m_rotationKeys.m_times.size());
+    file->writeL32((uint32_t) m_scalingKeys.m_times.size());
+    file->writeLF(m_sampleRate);
+
+    //bone slots
+    for(size_t bone = 0; bone < m_boneTracks.size(); bone++) {
+        writeAnim1VectorTrack(file, m_boneTracks[bone].m_position);
+
+        file->writeL32(m_boneTracks[bone].m_rotation.m_firstKey);
+        file->writeL32(m_boneTracks[bone].m_rotation.m_numKeys);
+
+        writeAnim1VectorTrack(file, m_boneTracks[bone].m_scaling);
+    }
+
+    //keys
+    writeAnim1Channel(file, m_positionKeys);
+    writeAnim1Channel(file, m_rotationKeys);
+    writeAnim1Channel(file, m_scalingKeys);
+}
+
+size_t SkeletonAnimation::getCpuMemoryUsage() const {
+    return sizeof(SkeletonAnimation)
+        + m_boneTracks.size() * sizeof(BoneTracks)
+        + m_positionKeys.m_times.size() * sizeof(float) + m_positionKeys.m_values.size() * sizeof(uint16_t)
+        + m_rotationKeys.m_times.size() * sizeof(float) + m_rotationKeys.m_values.size() * sizeof(uint16_t)
+        + m_scalingKeys.m_times.size() * sizeof(float) + m_scalingKeys.m_values.size() * sizeof(uint16_t);
+}
+
+void SkeletonAnimation::clear() {
+    m_duration = 0;
+    m_sampleRate = 0;
+    m_numAnimatedBones = 0;
+
+    m_boneTracks.resize(0);
+    m_positionKeys.m_times.resize(0);
+    m_positionKeys.m_values.resize(0);
+    m_rotationKeys.m_times.resize(0);
+    m_rotationKeys.m_values.resize(0);
+    m_scalingKeys.m_times.resize(0);
+    m_scalingKeys.m_values.resize(0);
+}
+
 void SkeletonAnimation::unload() {
     if(m_state == RES_LOADING) {
         LOG_FATAL_ERROR("Attempting to unload skeleton animation while it's loading");
@@ -122,9 +715,7 @@ void SkeletonAnimation::unload() {
         return;
     }
 
-    m_duration = 0;
-
-    m_boneAnimation.clear();
+    clear();
     
     m_state = RES_UNLOADED;
 }
@@ -132,27 +723,57 @@ void SkeletonAnimation::unload() {
 void SkeletonAnimation::reload(GraphicsBackend * backend) {
     unload();
 
+    m_state = RES_LOADING;
+
+    reloadCpu();
+    reloadFinish(backend);
+}
+
+void SkeletonAnimation::reloadCpu() {
+    m_readSucceeded = readAnimation();
+}
+
+void SkeletonAnimation::reloadFinish(GraphicsBackend * backend) {
     m_loader = backend;
 
-    m_state = RES_LOADING;
-	
-    illFileSystem::File * openFile = illFileSystem::fileSystem->openRead(m_loadArgs.m_path.c_str());
+    m_state = m_readSucceeded ? RES_LOADED : RES_UNLOADED;
+}
+
+bool SkeletonAnimation::readAnimation() {
+    illFileSystem::BufferedFileReader * openFile = illFileSystem::openBufferedRead(m_loadArgs.m_path.c_str());
 	
 	//read magic string
-    {
-		uint64_t magic;
-        openFile->readB64(magic);
+    uint64_t magic;
+    openFile->readB64(magic);
 
-        if(magic != ANIM_MAGIC) {
-            LOG_ERROR("Not a valid ILLANIM0 file.");
-            m_state = RES_UNLOADED;
-            delete openFile;
-            return;
-        }
+    bool succeeded;
+
+    if(magic == ANIM_MAGIC) {
+        succeeded = readIllanim0(openFile);
     }
-	
+    else if(magic == ANIM1_MAGIC) {
+        succeeded = readIllanim1(openFile);
+    }
+    else {
+        LOG_ERROR("Not a valid ILLANIM0 or ILLANIM1 file.");
+        succeeded = false;
+    }
+
+    delete openFile;
+
+    if(!succeeded) {
+        clear();
+    }
+
+    return succeeded;
+}
+
+bool SkeletonAnimation::readIllanim0(illFileSystem::BufferedFileReader * openFile) {
+    BoneAnimationMap boneAnimation;
+
     //read duration
-    openFile->readLF(m_duration);
+    glm::mediump_float duration;
+    openFile->readLF(duration);
 
     //read the number of bones
 	uint16_t numBones;
@@ -166,16 +787,13 @@ void SkeletonAnimation::reload(GraphicsBackend * backend) {
         
         AnimData * currentAnim;
 
-        if(m_boneAnimation.find(boneIndex) != m_boneAnimation.end()) {
+        if(boneAnimation.find(boneIndex) != boneAnimation.end()) {
             LOG_ERROR("Skeleton animation %s has duplicate bone index %d. This will cause problems when animating. Aborting loading animation.", 
 				m_loadArgs.m_path.c_str(), boneIndex);
-            m_state = RES_LOADED;
-            delete openFile;
-            unload();
-            return;
+            return false;
         }
         else {
-            currentAnim = &m_boneAnimation[boneIndex];
+            currentAnim = &boneAnimation[boneIndex];
         }
 
         //read the number of position keys
@@ -233,10 +851,82 @@ void SkeletonAnimation::reload(GraphicsBackend * backend) {
             openFile->readLF(currentAnim->m_scalingKeys[frame].m_data.z);
         }
     }
-    
-    delete openFile;
 
-    m_state = RES_LOADED;
+    encode(duration, boneAnimation);
+
+    return true;
+}
+
+bool SkeletonAnimation::readIllanim1(illFileSystem::BufferedFileReader * openFile) {
+    //header
+    openFile->readLF(m_duration);
+
+    uint16_t numBoneSlots;
+    openFile->readL16(numBoneSlots);
+
+    uint16_t numAnimatedBones;
+    openFile->readL16(numAnimatedBones);
+    m_numAnimatedBones = numAnimatedBones;
+
+    uint32_t numPositionKeys, numRotationKeys, numScalingKeys;
+    openFile->readL32(numPositionKeys);
+    openFile->readL32(numRotationKeys);
+    openFile->readL32(numScalingKeys);
+
+    //older files have 0 here
+    openFile->readLF(m_sampleRate);
+
+    if(!(m_sampleRate >= 0.0f && m_sampleRate <= ANIM_MAX_SAMPLE_RATE)) {
+        LOG_ERROR("Skeleton animation %s has invalid sample rate %f. Aborting loading animation.", m_loadArgs.m_path.c_str(), m_sampleRate);
+        return false;
+    }
+
+    if(!(m_duration > 0.0f)) {
+        LOG_ERROR("Skeleton animation %s has invalid duration %f. Aborting loading animation.", m_loadArgs.m_path.c_str(), m_duration);
+        return false;
+    }
+
+    uint32_t numSamples = m_sampleRate > 0.0f ? uniformSampleCount(m_duration, m_sampleRate) : 0;
+
+    openFile->seek(ANIM1_HEADER_SIZE);
+
+    //bone slots
+    m_boneTracks.resize(numBoneSlots);
+
+    for(uint16_t bone = 0; bone < numBoneSlots; bone++) {
+        BoneTracks& boneTracks = m_boneTracks[bone];
+
+        readAnim1VectorTrack(openFile, boneTracks.m_position);
+
+        openFile->readL32(boneTracks.m_rotation.m_firstKey);
+        openFile->readL32(boneTracks.m_rotation.m_numKeys);
+
+        readAnim1VectorTrack(openFile, boneTracks.m_scaling);
+
+        //a bone is either animated in all the channels or none of them, and the keys have to be in the file
+        bool animated = boneTracks.m_position.m_numKeys > 0;
+
+        if(animated != (boneTracks.m_rotation.m_numKeys > 0) || animated != (boneTracks.m_scaling.m_numKeys > 0)
+                || (uint64_t) boneTracks.m_position.m_firstKey + boneTracks.m_position.m_numKeys > numPositionKeys
+                || (uint64_t) boneTracks.m_rotation.m_firstKey + boneTracks.m_rotation.m_numKeys > numRotationKeys
+                || (uint64_t) boneTracks.m_scaling.m_firstKey + boneTracks.m_scaling.m_numKeys > numScalingKeys
+                || (numSamples > 0 && animated && !(uniformTrackKeys(boneTracks.m_position.m_numKeys, numSamples)
+                    && uniformTrackKeys(boneTracks.m_rotation.m_numKeys, numSamples)
+                    && uniformTrackKeys(boneTracks.m_scaling.m_numKeys, numSamples)))) {
+            LOG_ERROR("Skeleton animation %s has invalid keys for bone %u. Aborting loading animation.", m_loadArgs.m_path.c_str(), (unsigned int) bone);
+            return false;
+        }
+    }
+
+    //keys
+    if(!readAnim1Channel(openFile, numPositionKeys, m_positionKeys)
+            || !readAnim1Channel(openFile, numRotationKeys, m_rotationKeys)
+            || !readAnim1Channel(openFile, numScalingKeys, m_scalingKeys)) {
+        LOG_ERROR("Skeleton animation %s has more keys than fit in the file. Aborting loading animation.", m_loadArgs.m_path.c_str());
+        return false;
+    }
+
+    return true;
 }
 
 }
@@ -15,6 +15,11 @@
 
 #include "Util/Geometry/Transform.h"
 
+namespace illFileSystem {
+class File;
+class BufferedFileReader;
+}
+
 namespace illGraphics {
 
 class GraphicsBackend;
@@ -27,8 +32,58 @@ struct SkeletonAnimationLoadArgs {
     //TODO: more to come?  Maybe?
 };
 
+/**
+How far off the compressed keyframes are allowed to be from the originals when encoding an animation.
+*/
+struct SkeletonAnimationErrorBounds {
+    SkeletonAnimationErrorBounds(float position = 0.0001f, float rotation = 0.0005f, float scaling = 0.0001f)
+        : m_position(position),
+        m_rotation(rotation),
+        m_scaling(scaling)
+    {}
+
+    float m_position;       ///<Distance in model units
+    float m_rotation;       ///<Angle in radians
+    float m_scaling;        ///<Distance in scale units
+};
+
+/**
+A skeleton animation, stored compressed the way the ILLANIM1 format stores it.
+
+Keys are kept in structure of arrays form, all the key times of a channel in one array and all the quantized values in another,
+with each bone's keys contiguous.  Bones are looked up by indexing an array with the bone index instead of going through a hash map.
+- Rotations are packed into 48 bits with packQuatSmallestThree.
+- Positions and scales are quantized to 16 bits per component within the range the bone's keys for that channel cover.
+- A channel that doesn't change gets only one key, positions and scales in it are then exact.
+- Keys that can be interpolated from their neighbors within the error bounds are dropped, unless the animation is uniformly sampled.
+
+The values are at most the error bounds off from the original, or about 1/131070 of the channel's range for positions and scales
+and 0.00011 radians for rotations if that's bigger, since that's as precise as the quantization gets.
+
+ILLANIM1 files load straight into this layout.  Old ILLANIM0 files with uncompressed keys get encoded when loaded, Tools/illAnim converts them ahead of time.
+The ILLANIM1 layout is:
+- 8 bytes magic string ILLANIM1
+- 32 bit float duration in seconds
+- 16 bit number of bone slots, one more than the highest bone index animated
+- 16 bit number of animated bones
+- 32 bit number of position keys
+- 32 bit number of rotation keys
+- 32 bit number of scaling keys
+- 32 bit float sample rate in keys per second if the keys are uniformly sampled, 0 if they're at arbitrary times.
+  Uniformly sampled channels have either 1 key or a key at every multiple of 1 / sample rate before the duration.
+- The bone slots, 72 bytes each, for each channel a 32 bit first key and 32 bit number of keys, 0 if the bone isn't animated,
+  and for positions and scales also 3 32 bit floats range min and 3 32 bit floats range extent divided by 65535
+  in the order position, rotation, scaling
+- 6 blocks, each starting on a multiple of 16 bytes, the position key times, position values, rotation key times,
+  rotation values, scaling key times, and scaling values.  Times are 32 bit floats and values are 3 16 bit integers per key.
+
+Everything after the magic string is little endian.
+*/
 class SkeletonAnimation : public ResourceBase<SkeletonAnimationLoadArgs, GraphicsBackend> {
 public:
+    /**
+    Uncompressed keyframes of a bone, what ILLANIM0 files store and what encode() takes.
+    */
     struct AnimData {
         template <typename T>
         struct Key {
@@ -36,7 +91,20 @@ public:
             T m_data;
         };
 
-        Transform<> getTransform(glm::mediump_float time, glm::mediump_float duration, LastFrameInfo& lastFrameInfo = LastFrameInfo()) const;
+        /**
+        Interpolates the keys at some time in seconds, looping past the duration and before 0.
+
+        @param lastFrameInfo Where the keys were found last time, which makes finding them again quick when the time hasn't moved much.
+        */
+        Transform<> getTransform(glm::mediump_float time, glm::mediump_float duration, LastFrameInfo& lastFrameInfo) const;
+
+        /**
+        Interpolates the keys at some time without a cursor, binary searching for the keys.
+        */
+        inline Transform<> getTransform(glm::mediump_float time, glm::mediump_float duration) const {
+            LastFrameInfo lastFrameInfo;
+            return getTransform(time, duration, lastFrameInfo);
+        }
 		
         Array<Key<glm::vec3>> m_positionKeys;
         Array<Key<glm::quat>> m_rotationKeys;
@@ -45,9 +113,44 @@ public:
 
 	typedef std::unordered_map<uint16_t, AnimData> BoneAnimationMap;
 
+    /**
+    Where a bone's position or scaling keys are and the range they're quantized in.
+    */
+    struct VectorTrack {
+        uint32_t m_firstKey;
+        uint32_t m_numKeys;             ///<0 if the bone isn't animated
+        glm::vec3 m_rangeMin;
+        glm::vec3 m_rangeScale;         ///<The range extent divided by 65535
+    };
+
+    /**
+    Where a bone's rotation keys are.
+    */
+    struct RotationTrack {
+        uint32_t m_firstKey;
+        uint32_t m_numKeys;             ///<0 if the bone isn't animated
+    };
+
+    struct BoneTracks {
+        VectorTrack m_position;
+        RotationTrack m_rotation;
+        VectorTrack m_scaling;
+    };
+
+    /**
+    All the keys of one channel for all the bones.  m_values has 3 entries per key.
+    */
+    struct KeyChannel {
+        Array<float> m_times;
+        Array<uint16_t> m_values;
+    };
+
     SkeletonAnimation()
         : ResourceBase(),
-          m_duration(0.0f)
+          m_duration(0.0f),
+          m_sampleRate(0.0f),
+          m_numAnimatedBones(0),
+          m_readSucceeded(false)
     {}
 
     virtual ~SkeletonAnimation() {
@@ -57,8 +160,40 @@ public:
     virtual void unload();
     virtual void reload(GraphicsBackend * backend);
 
+    /**
+    Reads the animation file, nothing in here needs the backend.
+    */
+    virtual void reloadCpu();
+    virtual void reloadFinish(GraphicsBackend * backend);
+
+    /**
+    The keyframes of all the bones.
+    */
+    virtual size_t getCpuMemoryUsage() const;
+
+    /**
+    Compresses uncompressed keyframes into this animation, replacing whatever keys it had.
+    This doesn't change the resource state, it's for the loader and for tools converting animations.
+
+    @param duration Duration in seconds.
+    @param boneAnimation The uncompressed keys of each bone.  Every bone needs at least one key in each channel.
+    @param sampleRate If not 0, the keys are resampled at this many keys per second and none are dropped,
+        so looking up keys is just a multiply instead of a search.  This takes more memory than dropping keys unless the
+        animation is baked at about that rate anyway.  Channels that don't change still get only one key.
+    */
+    void encode(glm::mediump_float duration, const BoneAnimationMap& boneAnimation, const SkeletonAnimationErrorBounds& errorBounds = SkeletonAnimationErrorBounds(),
+        glm::mediump_float sampleRate = 0.0f);
+
+    /**
+    Writes the animation as an ILLANIM1 file.
+    */
+    void writeIllanim1(illFileSystem::File * file) const;
+
+    /**
+    Gets the number of bones this animation animates.
+    */
     inline unsigned int getNumBones() const {
-        return (unsigned int) m_boneAnimation.size();
+        return m_numAnimatedBones;
     }
 
     /**
@@ -68,28 +203,76 @@ public:
         return m_duration;
     }
 
+    /**
+    The total number of position, rotation, and scaling keys stored for all the bones.
+    */
+    inline size_t getNumKeys() const {
+        return m_positionKeys.m_times.size() + m_rotationKeys.m_times.size() + m_scalingKeys.m_times.size();
+    }
+
+    /**
+    If the keys are uniformly sampled, how many keys per second, otherwise 0.
+    */
+    inline glm::mediump_float getSampleRate() const {
+        return m_sampleRate;
+    }
+
     /**
     Gets a bone's transform some time in the animation in seconds relative to the bind pose.
     Allows looping of passing in seconds past the duration and negative times and all that.
-	Returns an identity transform if passing in a bone index that isn't affected by this animation.
-    */
-    inline bool getTransform(uint16_t boneIndex, glm::mediump_float time, Transform<>& dest, LastFrameInfo& lastFrameInfo = LastFrameInfo()) const {
-        BoneAnimationMap::const_iterator iter = m_boneAnimation.find(boneIndex);
+	Returns false and leaves dest alone if passing in a bone index that isn't affected by this animation.
 
-        if(iter == m_boneAnimation.end()) {
-            //return Transform<>();
+    The keys are found by checking a few keys around where they were last time in lastFrameInfo,
+    and binary searching if they're not there, so playing forward or backward and seeking around are all fast.
+    Uniformly sampled animations go straight to the key from the time and don't need lastFrameInfo.
+    */
+    inline bool getTransform(uint16_t boneIndex, glm::mediump_float time, Transform<>& dest, LastFrameInfo& lastFrameInfo) const {
+        if(boneIndex >= m_boneTracks.size() || m_boneTracks[boneIndex].m_position.m_numKeys == 0) {
             return false;
         }
-        else {
-            //return iter->second.getTransform(time, m_duration, lastFrameInfo);
-            dest = iter->second.getTransform(time, m_duration, lastFrameInfo);
-            return true;
-        }
+        
+        dest = getBoneTransform(m_boneTracks[boneIndex], time, lastFrameInfo);
+        return true;
+    }
+
+    /**
+    Gets a bone's transform without a cursor, for one off lookups like seeking.
+    */
+    inline bool getTransform(uint16_t boneIndex, glm::mediump_float time, Transform<>& dest) const {
+        LastFrameInfo lastFrameInfo;
+        return getTransform(boneIndex, time, dest, lastFrameInfo);
     }
 	
 private:
+    Transform<> getBoneTransform(const BoneTracks& boneTracks, glm::mediump_float time, LastFrameInfo& lastFrameInfo) const;
+
+    /**
+    Reads the animation file into the key arrays.  On failure leaves them empty and returns false.
+    */
+    bool readAnimation();
+
+    /**
+    Reads the rest of an ILLANIM0 file after the magic string and encodes it.
+    */
+    bool readIllanim0(illFileSystem::BufferedFileReader * openFile);
+
+    /**
+    Reads the rest of an ILLANIM1 file after the magic string.
+    */
+    bool readIllanim1(illFileSystem::BufferedFileReader * openFile);
+
+    void clear();
+
     glm::mediump_float m_duration;          ///<Duration in seconds
-    BoneAnimationMap m_boneAnimation;		///<map of bone index to animation
+    glm::mediump_float m_sampleRate;        ///<Keys per second if uniformly sampled, 0 otherwise
+    unsigned int m_numAnimatedBones;
+
+    Array<BoneTracks> m_boneTracks;         ///<Indexed by bone index
+    KeyChannel m_positionKeys;
+    KeyChannel m_rotationKeys;
+    KeyChannel m_scalingKeys;
+
+    bool m_readSucceeded;                   ///<Whether reloadCpu() read the file successfully
 };
 
 typedef uint32_t SkeletonAnimationId;
@@ -0,0 +1,170 @@
+#include "Graphics/serial/ResourceHotReloader.h"
+#include "Graphics/GraphicsBackend.h"
+#include "FileSystem/FileWatcher.h"
+
+#include "Logging/logging.h"
+
+namespace illGraphics {
+
+namespace {
+
+template <typename Manager, typename T>
+void queueResourceReloads(std::deque<std::function<void ()> >& pendingReloads, Manager * manager, const std::vector<IntrusivePtr<T> >& resources) {
+    for(size_t resource = 0; resource < resources.size(); resource++) {
+        IntrusivePtr<T> resourcePtr = resources[resource];
+
+        pendingReloads.push_back([manager, resourcePtr] () {
+            manager->reloadResource(resourcePtr.get());
+        });
+    }
+}
+
+/**
+Finds the cached resources whose load args have a path to one of the changed files.
+*/
+template <typename Manager, typename T>
+void findChangedPathResources(Manager * manager, const std::unordered_set<std::string>& changedPaths, std::vector<IntrusivePtr<T> >& dest) {
+    if(!manager) {
+        return;
+    }
+
+    manager->findCachedResources([&changedPaths] (const T& resource) {
+        return changedPaths.find(hotReloadPath(resource.getLoadArgs().m_path)) != changedPaths.end();
+    }, dest);
+}
+
+}
+
+std::string hotReloadPath(const std::string& path) {
+    std::string res(path);
+
+    for(size_t character = 0; character < res.size(); character++) {
+        if(res[character] == '\\') {
+            res[character] = '/';
+        }
+    }
+
+    size_t start = 0;
+
+    while(res.compare(start, 2, "./") == 0) {
+        start += 2;
+    }
+
+    return res.substr(start);
+}
+
+size_t ResourceHotReloader::update(std::chrono::steady_clock::duration budget) {
+    auto start = std::chrono::steady_clock::now();
+
+    m_polledPaths.clear();
+    m_fileWatcher->pollChanges(m_polledPaths);
+
+    if(!m_polledPaths.empty()) {
+        m_lastChangeTime = start;
+
+        for(size_t path = 0; path < m_polledPaths.size(); path++) {
+            m_changedPaths.insert(hotReloadPath(m_polledPaths[path]));
+        }
+    }
+
+    //wait for things to settle down so a bulk save is one batch
+    if(!m_changedPaths.empty() && start - m_lastChangeTime >= m_debounceTime) {
+        queueReloads();
+        m_changedPaths.clear();
+    }
+
+    size_t numReloaded = 0;
+
+    while(!m_pendingReloads.empty()) {
+        std::function<void ()> reload = m_pendingReloads.front();
+        m_pendingReloads.pop_front();
+
+        reload();
+        ++numReloaded;
+
+        if(std::chrono::steady_clock::now() - start >= budget) {
+            break;
+        }
+    }
+
+    return numReloaded;
+}
+
+void ResourceHotReloader::queueReloads() {
+    //resources loaded straight from the changed files
+    std::vector<IntrusivePtr<Texture> > textures;
+    std::vector<IntrusivePtr<Shader> > shaders;
+    std::vector<IntrusivePtr<Mesh> > meshes;
+    std::vector<IntrusivePtr<SkeletonAnimation> > skeletonAnimations;
+
+    findChangedPathResources(m_textureManager, m_changedPaths, textures);
+    findChangedPathResources(m_meshManager, m_changedPaths, meshes);
+    findChangedPathResources(m_skeletonAnimationManager, m_changedPaths, skeletonAnimations);
+
+    if(m_shaderManager) {
+        const GraphicsBackend * backend = m_shaderManager->getLoader();
+        const std::unordered_set<std::string>& changedPaths = m_changedPaths;
+
+        m_shaderManager->findCachedResources([backend, &changedPaths] (const Shader& shader) {
+            const char * path = backend->getShaderPath(shader.getLoadArgs());
+
+            return path && changedPaths.find(hotReloadPath(path)) != changedPaths.end();
+        }, shaders);
+    }
+
+    //resources depending on those
+    std::vector<IntrusivePtr<ShaderProgram> > shaderPrograms;
+    std::vector<IntrusivePtr<Material> > materials;
+
+    if(m_shaderProgramManager && !shaders.empty()) {
+        std::unordered_set<const Shader *> reloadedShaders;
+
+        for(size_t shader = 0; shader < shaders.size(); shader++) {
+            reloadedShaders.insert(shaders[shader].get());
+        }
+
+        m_shaderProgramManager->findCachedResources([&reloadedShaders] (const ShaderProgram& shaderProgram) {
+            const std::vector<IntrusivePtr<Shader> >& programShaders = shaderProgram.getShaders();
+
+            for(size_t shader = 0; shader < programShaders.size(); shader++) {
+                if(reloadedShaders.find(programShaders[shader].get()) != reloadedShaders.end()) {
+                    return true;
+                }
+            }
+
+            return false;
+        }, shaderPrograms);
+    }
+
+    if(m_materialManager && !textures.empty()) {
+        std::unordered_set<const Texture *> reloadedTextures;
+
+        for(size_t texture = 0; texture < textures.size(); texture++) {
+            reloadedTextures.insert(textures[texture].get());
+        }
+
+        m_materialManager->findCachedResources([&reloadedTextures] (const Material& material) {
+            return reloadedTextures.find(material.getDiffuseTexture()) != reloadedTextures.end()
+                || reloadedTextures.find(material.getSpecularTexture()) != reloadedTextures.end()
+                || reloadedTextures.find(material.getEmissiveTexture()) != reloadedTextures.end()
+                || reloadedTextures.find(material.getNormalTexture()) != reloadedTextures.end();
+        }, materials);
+    }
+
+    size_t numReloads = textures.size() + shaders.size() + meshes.size() + skeletonAnimations.size() + shaderPrograms.size() + materials.size();
+
+    if(numReloads == 0) {
+        return;
+    }
+
+    LOG_INFO("Hot reloading %u resources for %u changed files.", (unsigned int) numReloads, (unsigned int) m_changedPaths.size());
+
+    queueResourceReloads(m_pendingReloads, m_textureManager, textures);
+    queueResourceReloads(m_pendingReloads, m_shaderManager, shaders);
+    queueResourceReloads(m_pendingReloads, m_meshManager, meshes);
+    queueResourceReloads(m_pendingReloads, m_skeletonAnimationManager, skeletonAnimations);
+    queueResourceReloads(m_pendingReloads, m_shaderProgramManager, shaderPrograms);
+    queueResourceReloads(m_pendingReloads, m_materialManager, materials);
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef ILL_RESOURCE_HOT_RELOADER_H__
+#define ILL_RESOURCE_HOT_RELOADER_H__
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Graphics/serial/Material/Material.h"
+#include "Graphics/serial/Material/Shader.h"
+#include "Graphics/serial/Material/ShaderProgram.h"
+#include "Graphics/serial/Material/Texture.h"
+#include "Graphics/serial/Model/Mesh.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+
+namespace illFileSystem {
+class FileWatcher;
+}
+
+namespace illGraphics {
+
+/**
+Reloads graphics resources while the game runs when their files change, so iterating on textures and shaders doesn't need a restart.
+
+Changed files are matched up with resources through the load args of what's in the managers' caches.
+Textures, meshes, and animations match on their path, and shaders on the file the backend's getShaderPath() gives.
+Resources that aren't cached aren't touched since they load whatever's on disk whenever they're next requested.
+Resources that depend on reloaded ones get reloaded after them, shader programs using a reloaded shader get relinked
+and materials using a reloaded texture get reloaded.
+
+Saving a bunch of files at once, like a texture export or a version control update, shows up as lots of changes over
+a few frames.  Nothing happens until there haven't been any changes for the debounce time, then everything changed is handled as one batch
+so something depending on several of the files only gets reloaded once.  The reloads are spread out over frames with a time budget.
+
+Everything happens on the main thread in update().  Any of the managers can be NULL to not reload that kind of resource.
+*/
+class ResourceHotReloader {
+public:
+    ResourceHotReloader(illFileSystem::FileWatcher * fileWatcher,
+            TextureManager * textureManager, ShaderManager * shaderManager, ShaderProgramManager * shaderProgramManager,
+            MaterialManager * materialManager, MeshManager * meshManager = NULL, SkeletonAnimationManager * skeletonAnimationManager = NULL,
+            std::chrono::steady_clock::duration debounceTime = std::chrono::milliseconds(200))
+        : m_fileWatcher(fileWatcher),
+        m_textureManager(textureManager),
+        m_shaderManager(shaderManager),
+        m_shaderProgramManager(shaderProgramManager),
+        m_materialManager(materialManager),
+        m_meshManager(meshManager),
+        m_skeletonAnimationManager(skeletonAnimationManager),
+        m_debounceTime(debounceTime)
+    {}
+
+    /**
+    Checks for changed files and does pending reloads, spending about as much time as the budget.
+    Always does at least one reload if there are any pending so things keep moving with a tiny budget.
+    Call it on the main thread once a frame.
+
+    @return How many resources were reloaded.
+    */
+    size_t update(std::chrono::steady_clock::duration budget);
+
+    /**
+    How many reloads are waiting for time in update().
+    */
+    inline size_t getNumPendingReloads() const {
+        return m_pendingReloads.size();
+    }
+
+    /**
+    How many changed files are waiting for the debounce time to pass.
+    */
+    inline size_t getNumChangedFiles() const {
+        return m_changedPaths.size();
+    }
+
+private:
+    /**
+    Finds the resources using the changed files and the ones depending on those, and queues up reloading them.
+    */
+    void queueReloads();
+
+    illFileSystem::FileWatcher * m_fileWatcher;
+
+    TextureManager * m_textureManager;
+    ShaderManager * m_shaderManager;
+    ShaderProgramManager * m_shaderProgramManager;
+    MaterialManager * m_materialManager;
+    MeshManager * m_meshManager;
+    SkeletonAnimationManager * m_skeletonAnimationManager;
+
+    std::chrono::steady_clock::duration m_debounceTime;
+    std::chrono::steady_clock::time_point m_lastChangeTime;
+
+    std::unordered_set<std::string> m_changedPaths;         ///<Changed since the last batch, cleaned up with hotReloadPath()
+    std::vector<std::string> m_polledPaths;                 ///<Kept around to not reallocate every frame
+
+    std::deque<std::function<void ()> > m_pendingReloads;   ///<Dependencies always come before what depends on them
+};
+
+/**
+Cleans up a path so the same file always gives the same string, with forward slashes and without a leading ./
+*/
+std::string hotReloadPath(const std::string& path);
+
+}
+
+#endif
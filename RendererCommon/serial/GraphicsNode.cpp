@@ -47,6 +47,18 @@ void GraphicsNode::move(const glm::mat4& transform, const Box<>& boundingVolume)
     m_scene->moveNode(this, prevBounds);
 }
 
+const RenderQueues::LightList& GraphicsNode::getAffectingLights() const {
+    if(!m_affectingLightsValid) {
+        m_scene->getLights(getWorldBoundingVolume(), m_affectingLights);
+
+        //while a batched move is pending the node isn't in the cells for its bounds yet,
+        //so the scene wouldn't find it to invalidate the list if a light moved, so don't keep it around
+        m_affectingLightsValid = m_pendingMove == NO_PENDING_MOVE;
+    }
+
+    return m_affectingLights;
+}
+
 void GraphicsNode::addToScene() {
     assert(m_state == State::OUT_SCENE);
     m_scene->addNode(this);
@@ -3,6 +3,7 @@
 
 #include <unordered_map>
 #include "Util/Geometry/geomUtil.h"
+#include "Util/serial/SparseCellStorage.h"
 #include "RendererCommon/serial/RenderQueues.h"
 
 namespace illRendererCommon {
@@ -111,6 +112,15 @@ public:
         }
     }
 
+    /**
+    Returns the lights whose bounds overlap the node's bounds, for forward rendering.
+
+    The list is cached, and only looked up in the scene again after the node moves, or a light near it is added, removed, or moved.
+    Looking it up only touches the node itself, so this is fine to call from a worker thread while the scene is being
+    rendered in parallel.
+    */
+    const RenderQueues::LightList& getAffectingLights() const;
+
     inline bool addedToRenderQueue(uint64_t renderAccessCounter) const {
         if(m_renderAccessCounter <= renderAccessCounter) {
             m_renderAccessCounter = renderAccessCounter + 1;
@@ -131,7 +141,9 @@ protected:
         m_boundingVol(boundingVol),
         m_scene(scene),
         m_type(type),
-        m_occlusionCull(false)
+        m_occlusionCull(false),
+        m_pendingMove(NO_PENDING_MOVE),
+        m_affectingLightsValid(false)
     {
         if(initialState == State::IN_SCENE) {
             m_state = State::OUT_SCENE;
@@ -179,6 +191,33 @@ private:
     */
     mutable std::unordered_map<size_t, uint64_t> m_lastNonvisibleFrame;
 
+    /**
+    Where the node is stored in the scene's visibility grid cells, so it can be removed without searching.
+    */
+    SparseCellLocationList m_sceneCellLocations;
+
+    /**
+    Where the node is stored in the scene's interaction grid cells if it's a light.
+    */
+    SparseCellLocationList m_lightCellLocations;
+
+    static const size_t NO_PENDING_MOVE = (size_t) -1;
+
+    /**
+    Where the node is in the scene's list of batched moves, or NO_PENDING_MOVE if it hasn't moved since they were last applied.
+    */
+    size_t m_pendingMove;
+
+    inline void invalidateAffectingLights() const {
+        m_affectingLightsValid = false;
+    }
+
+    /**
+    The cached lights returned by getAffectingLights.  The scene invalidates it when something moves that could change it.
+    */
+    mutable RenderQueues::LightList m_affectingLights;
+    mutable bool m_affectingLightsValid;
+
     friend class GraphicsScene;
 };
 
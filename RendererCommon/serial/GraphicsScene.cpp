@@ -1,64 +1,89 @@
+#include <algorithm>
 #include <cassert>
 #include "GraphicsScene.h"
 #include "Util/Geometry/Iterators/ConvexMeshIterator.h"
 #include "LightNode.h"
+#include "Graphics/serial/Model/Mesh.h"
+#include "Graphics/serial/Material/Material.h"
 
 namespace illRendererCommon {
 
-void GraphicsScene::getLights(const Box<>& boundingBox, std::set<LightNode*>& destination) const {    
+void GraphicsScene::finishResourceLoads() {
+    auto start = std::chrono::steady_clock::now();
+
+    if(m_meshManager) {
+        m_meshManager->pumpCompletions(m_resourceLoadBudget);
+    }
+
+    //the materials get whatever's left, which still finishes at least one if any are ready
+    if(m_materialManager) {
+        std::chrono::steady_clock::duration remaining = m_resourceLoadBudget - (std::chrono::steady_clock::now() - start);
+        m_materialManager->pumpCompletions(remaining > std::chrono::steady_clock::duration::zero() ? remaining : std::chrono::steady_clock::duration::zero());
+    }
+}
+
+void GraphicsScene::getLights(const Box<>& boundingBox, RenderQueues::LightList& destination) const {
+    destination.clear();
+
     BoxIterator<> iter = m_interactionGrid.boxIterForWorldBounds(boundingBox);
-    
-    while(!iter.atEnd()) {
+
+    do {
         //static lights
         {
-            StaticLightNodeContainer& cell = m_staticLightNodes[m_grid.indexForCell(iter.getCurrentPosition())];
+            const StaticLightNodeContainer& cell = m_interactionGrid.getCell(iter.getCurrentPosition());
 
             for(size_t nodeInd = 0; nodeInd < cell.size(); nodeInd++) {
-                LightNode * node = cell[nodeInd];
-                assert(node->getType() == GraphicsNode::Type::LIGHT);
-
-                if(node->m_accessCounter <= m_accessCounter) {
-                    node->m_accessCounter = m_accessCounter + 1;
-
-                    if(boundingBox.intersects(node->getWorldBoundingVolume())) {
-                        destination.insert(node);
-                    }
+                if(boundingBox.intersects(cell[nodeInd]->getWorldBoundingVolume())) {
+                    destination.push_back(cell[nodeInd]);
                 }
             }
         }
 
         //moveable lights
         {
-            LightNodeContainer& cell = m_lightNodes[m_grid.indexForCell(iter.getCurrentPosition())];
-
-            for(auto nodeIter = cell.cbegin(); nodeIter != cell.cbegin(); nodeIter++) {
-                LightNode * node = *nodeIter;
-                assert(node->getType() == GraphicsNode::Type::LIGHT);
+            const LightNodeContainer& cell = m_lightNodes.getCell(m_interactionGrid.indexForCell(iter.getCurrentPosition()));
 
-                if(node->m_accessCounter <= m_accessCounter) {
-                    node->m_accessCounter = m_accessCounter + 1;
-
-                    if(boundingBox.intersects(node->getWorldBoundingVolume())) {
-                        destination.insert(node);
-                    }
+            for(size_t nodeInd = 0; nodeInd < cell.size(); nodeInd++) {
+                if(boundingBox.intersects(cell[nodeInd]->getWorldBoundingVolume())) {
+                    destination.push_back(cell[nodeInd]);
                 }
             }
         }
+    } while(iter.forward());
 
-        iter.forward();
-    }
+    //lights overlapping several cells were found more than once
+    std::sort(destination.begin(), destination.end());
+    destination.shrink(std::unique(destination.begin(), destination.end()) - destination.begin());
+}
+
+void GraphicsScene::invalidateLitNodes(const Box<>& lightBounds) {
+    BoxIterator<> iter = m_grid.boxIterForWorldBounds(lightBounds);
 
-    ++m_accessCounter;
+    do {
+        const NodeContainer& cell = m_sceneNodes.getCell(m_grid.indexForCell(iter.getCurrentPosition()));
+
+        for(size_t nodeInd = 0; nodeInd < cell.size(); nodeInd++) {
+            cell[nodeInd]->invalidateAffectingLights();
+        }
+
+        const StaticNodeContainer& staticCell = m_grid.getCell(iter.getCurrentPosition());
+
+        for(size_t nodeInd = 0; nodeInd < staticCell.size(); nodeInd++) {
+            staticCell[nodeInd]->invalidateAffectingLights();
+        }
+    } while(iter.forward());
 }
 
 void GraphicsScene::addNode(GraphicsNode * node) {
+    node->invalidateAffectingLights();
+
     //regular nodes
-    if(node->getType() != GraphicsNode::Type::LIGHT
-            || (m_trackLightsInVisibilityGrid && node->getType() == GraphicsNode::Type::LIGHT)) {
-        BoxIterator<> iter = m_grid.boxIterForWorldBounds(node->getWorldBoundingVolume());
+    if(isInVisibilityGrid(node)) {
+        Box<> bounds = node->getWorldBoundingVolume();
+        BoxIterator<> iter = m_grid.boxIterForWorldBounds(bounds);
        
         do {
-            m_sceneNodes[m_grid.indexForCell(iter.getCurrentPosition())].insert(node);
+            m_sceneNodes.add(m_grid.indexForCell(iter.getCurrentPosition()), node, &node->m_sceneCellLocations, bounds);
         } while(iter.forward());
     }
 
@@ -67,76 +92,192 @@ void GraphicsScene::addNode(GraphicsNode * node) {
         BoxIterator<> iter = m_interactionGrid.boxIterForWorldBounds(node->getWorldBoundingVolume());
                 
         do {
-            m_lightNodes[m_grid.indexForCell(iter.getCurrentPosition())].insert(static_cast<LightNode *>(node));
+            m_lightNodes.add(m_interactionGrid.indexForCell(iter.getCurrentPosition()), static_cast<LightNode *>(node), &node->m_lightCellLocations);
         } while(iter.forward());
+
+        invalidateLitNodes(node->getWorldBoundingVolume());
     }
 }
 
 void GraphicsScene::removeNode(GraphicsNode * node) {
+    //nodes near a light have it in their cached lists, including near where it was before a batched move
+    if(node->getType() == GraphicsNode::Type::LIGHT) {
+        invalidateLitNodes(node->getWorldBoundingVolume());
+
+        if(node->m_pendingMove != GraphicsNode::NO_PENDING_MOVE) {
+            invalidateLitNodes(m_pendingMoves[node->m_pendingMove].m_prevBounds);
+        }
+    }
+
+    //the node remembers every cell it's in so nothing needs to be looked up in the grids
+    m_sceneNodes.removeAll(&node->m_sceneCellLocations);
+    m_lightNodes.removeAll(&node->m_lightCellLocations);
+
+    //forget about any batched move
+    if(node->m_pendingMove != GraphicsNode::NO_PENDING_MOVE) {
+        size_t lastMove = m_pendingMoves.size() - 1;
+
+        if(node->m_pendingMove != lastMove) {
+            m_pendingMoves[node->m_pendingMove] = m_pendingMoves[lastMove];
+            m_pendingMoves[node->m_pendingMove].m_node->m_pendingMove = node->m_pendingMove;
+        }
+
+        m_pendingMoves.pop_back();
+        node->m_pendingMove = GraphicsNode::NO_PENDING_MOVE;
+    }
+}
+
+/**
+Removes a node's entries in some cell storage from the cells it doesn't overlap anymore.
+Cells it still overlaps keep their entry, with the attached data updated.
+*/
+template <typename T, typename Attachment>
+static void removeMovedNodeCells(const GridVolume3D<>& grid, SparseCellStorage<T, Attachment>& storage,
+        SparseCellLocationList * locations, const Box<>& bounds, const typename Attachment::value_type& attachment) {
+    Box<unsigned int> cells = grid.cellBoundsForWorldBounds(bounds);
+
+    //going from the back since removing moves the last location into the hole
+    for(size_t location = locations->size(); location-- > 0;) {
+        if(!cells.intersects(grid.cellForIndex((*locations)[location].m_cell))) {
+            storage.remove(locations, location);
+        }
+        else {
+            storage.setAttachment(locations, location, attachment);
+        }
+    }
+}
+
+/**
+Calls a function with the cell array index of every cell a node overlaps now that it didn't overlap before.
+*/
+template <typename Function>
+static void forEachNewNodeCell(const GridVolume3D<>& grid, const Box<>& prevBounds, const Box<>& bounds, Function function) {
+    Box<unsigned int> prevCells = grid.cellBoundsForWorldBounds(prevBounds);
+    BoxIterator<> iter = grid.boxIterForCellBounds(grid.cellBoundsForWorldBounds(bounds));
+
+    do {
+        if(!prevCells.intersects(iter.getCurrentPosition())) {
+            function((uint32_t) grid.indexForCell(iter.getCurrentPosition()));
+        }
+    } while(iter.forward());
+}
+
+/**
+Moves a node's entries in some cell storage from the cells it used to overlap to the cells it overlaps now.
+Cells that are in both keep their entry, with the attached data updated.
+*/
+template <typename T, typename Attachment>
+static void moveNodeCells(const GridVolume3D<>& grid, SparseCellStorage<T, Attachment>& storage, T node,
+        SparseCellLocationList * locations, const Box<>& prevBounds, const Box<>& bounds, const typename Attachment::value_type& attachment) {
+    removeMovedNodeCells(grid, storage, locations, bounds, attachment);
+
+    forEachNewNodeCell(grid, prevBounds, bounds, [&] (uint32_t cell) {
+        storage.add(cell, node, locations, attachment);
+    });
+}
+
+void GraphicsScene::moveNode(GraphicsNode * node, const Box<>& prevBounds) {
+    node->invalidateAffectingLights();
+
+    if(node->getType() == GraphicsNode::Type::LIGHT) {
+        invalidateLitNodes(prevBounds);
+        invalidateLitNodes(node->getWorldBoundingVolume());
+    }
+
+    //a node already waiting on a batched move keeps waiting, its cells still match the bounds from before its first move
+    if(m_batchMoves || node->m_pendingMove != GraphicsNode::NO_PENDING_MOVE) {
+        if(node->m_pendingMove == GraphicsNode::NO_PENDING_MOVE) {
+            node->m_pendingMove = m_pendingMoves.size();
+
+            PendingMove move;
+            move.m_node = node;
+            move.m_prevBounds = prevBounds;
+
+            m_pendingMoves.push_back(move);
+        }
+
+        return;
+    }
+
     //regular nodes
-    if(node->getType() != GraphicsNode::Type::LIGHT
-            || (m_trackLightsInVisibilityGrid && node->getType() == GraphicsNode::Type::LIGHT)) {
-        BoxIterator<> iter = m_grid.boxIterForWorldBounds(node->getWorldBoundingVolume());
-            
-        do {
-            m_sceneNodes[m_grid.indexForCell(iter.getCurrentPosition())].erase(node);
-        } while(iter.forward());
+    if(isInVisibilityGrid(node)) {
+        Box<> bounds = node->getWorldBoundingVolume();
+        moveNodeCells(m_grid, m_sceneNodes, node, &node->m_sceneCellLocations, prevBounds, bounds, bounds);
     }
 
     //lights
     if(node->getType() == GraphicsNode::Type::LIGHT) {
-        BoxIterator<> iter = m_interactionGrid.boxIterForWorldBounds(node->getWorldBoundingVolume());
-                
-        do {
-            m_lightNodes[m_grid.indexForCell(iter.getCurrentPosition())].erase(static_cast<LightNode *>(node));
-        } while(iter.forward());
+        moveNodeCells(m_interactionGrid, m_lightNodes, static_cast<LightNode *>(node), &node->m_lightCellLocations, prevBounds, node->getWorldBoundingVolume(),
+            SparseCellNoAttachment::value_type());
     }
 }
 
-void GraphicsScene::moveNode(GraphicsNode * node, const Box<>& prevBounds) {
-    //remove
-    {
+void GraphicsScene::applyMoves() {
+    if(m_pendingMoves.empty()) {
+        return;
+    }
+
+    m_pendingSceneAdds.clear();
+    m_pendingLightAdds.clear();
+
+    //take the nodes out of the cells they left first, which frees up slots for the adds to reuse
+    for(uint32_t moveInd = 0; moveInd < (uint32_t) m_pendingMoves.size(); moveInd++) {
+        PendingMove& move = m_pendingMoves[moveInd];
+        GraphicsNode * node = move.m_node;
+
+        node->m_pendingMove = GraphicsNode::NO_PENDING_MOVE;
+        move.m_bounds = node->getWorldBoundingVolume();
+
         //regular nodes
-        if(node->getType() != GraphicsNode::Type::LIGHT
-                || (m_trackLightsInVisibilityGrid && node->getType() == GraphicsNode::Type::LIGHT)) {
-            BoxOmitIterator<> iter = m_grid.boxOmitIterForWorldBounds(prevBounds, node->getWorldBoundingVolume());
+        if(isInVisibilityGrid(node)) {
+            removeMovedNodeCells(m_grid, m_sceneNodes, &node->m_sceneCellLocations, move.m_bounds, move.m_bounds);
+
+            forEachNewNodeCell(m_grid, move.m_prevBounds, move.m_bounds, [&] (uint32_t cell) {
+                PendingCellAdd add;
+                add.m_cell = cell;
+                add.m_move = moveInd;
 
-            do {
-                m_sceneNodes[m_grid.indexForCell(iter.getCurrentPosition())].insert(node);
-            } while(iter.forward());
+                m_pendingSceneAdds.push_back(add);
+            });
         }
 
         //lights
         if(node->getType() == GraphicsNode::Type::LIGHT) {
-            BoxOmitIterator<> iter = m_interactionGrid.boxOmitIterForWorldBounds(prevBounds, node->getWorldBoundingVolume());
+            removeMovedNodeCells(m_interactionGrid, m_lightNodes, &node->m_lightCellLocations, move.m_bounds, SparseCellNoAttachment::value_type());
+
+            forEachNewNodeCell(m_interactionGrid, move.m_prevBounds, move.m_bounds, [&] (uint32_t cell) {
+                PendingCellAdd add;
+                add.m_cell = cell;
+                add.m_move = moveInd;
+
+                m_pendingLightAdds.push_back(add);
+            });
 
-            do {
-                m_lightNodes[m_grid.indexForCell(iter.getCurrentPosition())].insert(static_cast<LightNode *>(node));
-            } while(iter.forward());
+            //the light's cells changing changes what the nodes around it find
+            invalidateLitNodes(move.m_prevBounds);
+            invalidateLitNodes(move.m_bounds);
         }
     }
-        
-    //add
-    {
-        //regular nodes
-        if(node->getType() != GraphicsNode::Type::LIGHT
-                || (m_trackLightsInVisibilityGrid && node->getType() == GraphicsNode::Type::LIGHT)) {
-            BoxOmitIterator<> iter = m_grid.boxOmitIterForWorldBounds(node->getWorldBoundingVolume(), prevBounds);
 
-            do {
-                m_sceneNodes[m_grid.indexForCell(iter.getCurrentPosition())].erase(node);
-            } while(iter.forward());
-        }
+    //then add them to the cells they entered in order of cell index, so each cell gets all its new nodes in one go
+    std::sort(m_pendingSceneAdds.begin(), m_pendingSceneAdds.end());
+    std::sort(m_pendingLightAdds.begin(), m_pendingLightAdds.end());
 
-        //lights
-        if(node->getType() == GraphicsNode::Type::LIGHT) {
-            BoxOmitIterator<> iter = m_interactionGrid.boxOmitIterForWorldBounds(node->getWorldBoundingVolume(), prevBounds);
+    for(size_t addInd = 0; addInd < m_pendingSceneAdds.size(); addInd++) {
+        const PendingCellAdd& add = m_pendingSceneAdds[addInd];
+        const PendingMove& move = m_pendingMoves[add.m_move];
 
-            do {
-                m_lightNodes[m_grid.indexForCell(iter.getCurrentPosition())].erase(static_cast<LightNode *>(node));
-            } while(iter.forward());
-        }
+        m_sceneNodes.add(add.m_cell, move.m_node, &move.m_node->m_sceneCellLocations, move.m_bounds);
     }
+
+    for(size_t addInd = 0; addInd < m_pendingLightAdds.size(); addInd++) {
+        const PendingCellAdd& add = m_pendingLightAdds[addInd];
+        const PendingMove& move = m_pendingMoves[add.m_move];
+
+        m_lightNodes.add(add.m_cell, static_cast<LightNode *>(move.m_node), &move.m_node->m_lightCellLocations);
+    }
+
+    m_pendingMoves.clear();
 }
 
-}
\ No newline at end of file
+}
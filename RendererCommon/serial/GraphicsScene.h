@@ -2,11 +2,16 @@
 #define ILL_GRAPHICS_SCENE_H_
 
 #include <stdint.h>
+#include <chrono>
 #include <set>
-#include <unordered_set>
+#include <vector>
 
 #include "Util/serial/Array.h"
+#include "Util/serial/FrameArena.h"
+#include "Util/serial/SparseCellStorage.h"
+#include "Util/Geometry/BoxBatch.h"
 #include "Util/Geometry/GridVolume3D.h"
+#include "Util/Geometry/SparseGridVolume3D.h"
 #include "Util/Geometry/Sphere.h"
 #include "Util/Geometry/Iterators/BoxIterator.h"
 #include "Util/Geometry/Iterators/BoxOmitIterator.h"
@@ -44,18 +49,18 @@ More docs to come.
 */
 class GraphicsScene {
 public:
-    typedef std::unordered_set<GraphicsNode*> NodeContainer;
+    /**
+    The scene nodes keep their world bounds next to them in each cell so a whole cell can be frustum culled at once.
+    */
+    typedef SparseCellStorage<GraphicsNode*, BoxBatch> NodeStorage;
+    typedef NodeStorage::Cell NodeContainer;
     typedef Array<GraphicsNode*> StaticNodeContainer;
 
-    typedef std::unordered_set<LightNode*> LightNodeContainer;
+    typedef SparseCellStorage<LightNode*> LightNodeStorage;
+    typedef LightNodeStorage::Cell LightNodeContainer;
     typedef Array<LightNode*> StaticLightNodeContainer;
     
-    virtual inline ~GraphicsScene() {
-        delete[] m_sceneNodes;
-        delete[] m_staticSceneNodes;
-        delete[] m_lightNodes;
-        delete[] m_staticLightNodes;
-    }
+    virtual inline ~GraphicsScene() {}
     
     /**
     Call this each frame before making any render calls to prepare the scene for rendering the next frame.
@@ -91,7 +96,7 @@ public:
     If you have a cell grid index (a 3 element vector) you can call getGridVolume to help convert that into an array index.
     */
     const NodeContainer& getSceneNodeCell(size_t cellArrayIndex) const {
-        return m_sceneNodes[cellArrayIndex];
+        return m_sceneNodes.getCell((uint32_t) cellArrayIndex);
     }
 
     /**
@@ -99,7 +104,7 @@ public:
     If you have a cell grid index (a 3 element vector) you can call getGridVolume to help convert that into an array index.
     */
     const StaticNodeContainer& getStaticNodeCell(size_t cellArrayIndex) const {
-        return m_staticSceneNodes[cellArrayIndex];
+        return m_grid.getCell((unsigned int) cellArrayIndex);
     }
 
     /**
@@ -107,7 +112,7 @@ public:
     If you have a cell grid index (a 3 element vector) you can call getInteractionGridVolume to help convert that into an array index.
     */
     const LightNodeContainer& getLightCell(size_t cellArrayIndex) const {
-        return m_lightNodes[cellArrayIndex];
+        return m_lightNodes.getCell((uint32_t) cellArrayIndex);
     }
 
     /**
@@ -115,16 +120,56 @@ public:
     If you have a cell grid index (a 3 element vector) you can call getInteractionGridVolume to help convert that into an array index.
     */
     const StaticLightNodeContainer& getStaticLightCell(size_t cellArrayIndex) const {
-        return m_staticLightNodes[cellArrayIndex];
+        return m_interactionGrid.getCell((unsigned int) cellArrayIndex);
+    }
+
+    /**
+    Gets lights within a bounding box into a list, replacing what was in it, in order of address with no duplicates.
+    This doesn't use the access counters so it's fine to call from worker threads.
+    Nodes cache this for their own bounds, see GraphicsNode::getAffectingLights.
+    */
+    void getLights(const Box<>& boundingBox, RenderQueues::LightList& destination) const;
+
+    /**
+    Returns the render queues the scene fills every frame, for changing how they get filled.
+    */
+    inline RenderQueues& getRenderQueues() {
+        return m_renderQueues;
+    }
+
+    /**
+    If set, moving a node only writes down that it moved, and the grid cells of all the moved nodes get updated at once in applyMoves.
+    This is a lot quicker when lots of nodes move every frame, since a node that moves several times only has its cells updated once,
+    and the new cells get filled in order of cell index instead of jumping all over the place.
+
+    Until applyMoves is called, moved nodes are still found in the cells they were in before they moved.
+    DeferredShadingScene::setupFrame calls it, so normally nothing else needs to.
+    */
+    bool m_batchMoves;
+
+    /**
+    Updates the grid cells of every node moved since the last call while m_batchMoves was set.
+    */
+    void applyMoves();
+
+    /**
+    How many nodes have moved since the last applyMoves.
+    */
+    inline size_t getNumPendingMoves() const {
+        return m_pendingMoves.size();
     }
 
     /**
-    Gets lights within a bounding box by querying the lights interaction grid.
+    About how much time finishResourceLoads spends each frame finishing meshes and materials that were loading in the background.
+    Whatever doesn't fit is left for the next frame.
+    */
+    std::chrono::steady_clock::duration m_resourceLoadBudget;
 
-    @param boundingBox The bounding box to get intersections.
-    @param destination The destination set of where to write the intersections.
+    /**
+    Finishes loading the meshes and materials requested with StaticMeshNode::requestLoad whose background part is done,
+    within m_resourceLoadBudget.  DeferredShadingScene::setupFrame calls it, so normally nothing else needs to.
     */
-    void getLights(const Box<>& boundingBox, std::set<LightNode*>& destination) const;
+    void finishResourceLoads();
 
 protected:
     /**
@@ -145,25 +190,12 @@ protected:
         m_renderAccessCounter(0),
         m_grid(cellDimensions, cellNumber),
         m_interactionGrid(interactionCellDimensions, interactionCellNumber),
-        m_trackLightsInVisibilityGrid(trackLightsInVisibilityGrid)
+        m_trackLightsInVisibilityGrid(trackLightsInVisibilityGrid),
+        m_batchMoves(false),
+        m_resourceLoadBudget(std::chrono::milliseconds(2))
     {
-        size_t numCells = cellNumber.x * cellNumber.y * cellNumber.z;
-        size_t numInteractionCells = interactionCellNumber.x * interactionCellNumber.y * interactionCellNumber.z;
-
-        m_sceneNodes = new NodeContainer[numCells];
-        //LOG_DEBUG("Allocated %u Scene Node Cells. Each cell is %u bytes. Allocated %u bytes, %f megabytes.", numCells, sizeof(NodeContainer), numCells * sizeof(NodeContainer), (float) numCells * sizeof(NodeContainer) / 1024.0f / 1024.0f);
-
-        m_staticSceneNodes = new StaticNodeContainer[numCells];
-        //LOG_DEBUG("Allocated %u Static Scene Node Cells. Each cell is %u bytes. Allocated %u bytes, %f megabytes.", numCells, sizeof(StaticNodeContainer), numCells * sizeof(StaticNodeContainer), (float) numCells * sizeof(NodeContainer) / 1024.0f / 1024.0f);
-
-        m_lightNodes = new LightNodeContainer[numInteractionCells];
-        //LOG_DEBUG("Allocated %u Light Node Cells. Each cell is %u bytes. Allocated %u bytes, %f megabytes.", numInteractionCells, sizeof(LightNodeContainer), numInteractionCells * sizeof(LightNodeContainer), (float) numInteractionCells * sizeof(LightNodeContainer) / 1024.0f / 1024.0f);
-
-        m_staticLightNodes = new StaticLightNodeContainer[numInteractionCells];
-        //LOG_DEBUG("Allocated %u Static Light Cells. Each cell is %u bytes. Allocated %u bytes, %f megabytes.", numInteractionCells, sizeof(StaticLightNodeContainer), numInteractionCells * sizeof(StaticLightNodeContainer), (float) numInteractionCells * sizeof(StaticLightNodeContainer) / 1024.0f / 1024.0f);
-
-        //LOG_DEBUG("Scene cells take %u bytes, %f megabytes", (numCells * sizeof(NodeContainer) + numCells * sizeof(StaticNodeContainer) + numInteractionCells * sizeof(LightNodeContainer) + numInteractionCells * sizeof(StaticLightNodeContainer)),
-        //    (float) (numCells * sizeof(NodeContainer) + numCells * sizeof(StaticNodeContainer) + numInteractionCells * sizeof(LightNodeContainer) + numInteractionCells * sizeof(StaticLightNodeContainer)) / 1024.0f / 1024.0f);
+        //no per cell memory is allocated up front, cells are only allocated in the parts of the world where nodes are added
+        m_renderQueues.m_frameArena = &m_frameArena;
     }
 
 private:
@@ -187,7 +219,61 @@ private:
     */
     void moveNode(GraphicsNode * node, const Box<>& prevBounds);
 
+    /**
+    Invalidates the cached affecting lights of every node in the visibility grid cells a light's bounds overlap.
+    Called with the old and new bounds of lights that are added, removed, or moved.
+    */
+    void invalidateLitNodes(const Box<>& lightBounds);
+
+    /**
+    Whether a node is stored in the visibility grid cells.  Lights are always in the interaction grid cells as well.
+    */
+    inline bool isInVisibilityGrid(const GraphicsNode * node) const {
+        return node->getType() != GraphicsNode::Type::LIGHT || m_trackLightsInVisibilityGrid;
+    }
+
+    /**
+    A node that moved while m_batchMoves was set.
+    */
+    struct PendingMove {
+        GraphicsNode * m_node;
+
+        /**
+        The bounds before the node's first move since the last applyMoves, which are the bounds its cells still match.
+        */
+        Box<> m_prevBounds;
+
+        /**
+        Filled in by applyMoves.
+        */
+        Box<> m_bounds;
+    };
+
+    /**
+    A cell a moved node needs adding to, sorted by cell so the cells get filled in order.
+    */
+    struct PendingCellAdd {
+        uint32_t m_cell;
+        uint32_t m_move;    //index into m_pendingMoves
+
+        inline bool operator<(const PendingCellAdd& other) const {
+            return m_cell < other.m_cell || (m_cell == other.m_cell && m_move < other.m_move);
+        }
+    };
+
+    std::vector<PendingMove> m_pendingMoves;
+
+    //kept around between calls to avoid reallocating
+    std::vector<PendingCellAdd> m_pendingSceneAdds;
+    std::vector<PendingCellAdd> m_pendingLightAdds;
+
 protected:
+    /**
+    Memory for anything that only lives until the end of a frame, like the render queue contents.
+    It's reset when the render queues are cleared at the end of the frame, subclasses shouldn't reset it themselves.
+    */
+    FrameArena m_frameArena;
+
     illRendererCommon::RenderQueues m_renderQueues;
 
     RendererBackend * m_rendererBackend;
@@ -209,38 +295,33 @@ protected:
     /**
     The 3D uniform grid for the scene.
     This grid is more sparce and is used for the visibility computation.
+    
+    The cells store the static scene nodes.  Moveable nodes are in m_sceneNodes.
     */
-    GridVolume3D<> m_grid;
+    SparseGridVolume3D<StaticNodeContainer> m_grid;
 
     /**
     An additional finer grid for keeping track of interactions with other objects.
     This would speed up spatial queries to find all surrounding lights for example.
-    */
-    GridVolume3D<> m_interactionGrid;
 
-    /**
-    The scene nodes for each cell managed by the main visibility grid.
+    The cells store the static light nodes.  Moveable lights are in m_lightNodes.
+    Lights are also kept track of in the static scene cells structure as well if trackLightsInMain is true.
     */
-    NodeContainer * m_sceneNodes;
+    SparseGridVolume3D<StaticLightNodeContainer> m_interactionGrid;
 
     /**
-    The static scene nodes for each cell managed by the main visibility grid.
+    The scene nodes for each cell managed by the main visibility grid.
+    Only cells that have something in them take up memory.
     */
-    StaticNodeContainer * m_staticSceneNodes;
+    NodeStorage m_sceneNodes;
 
     /**
     The light nodes for each cell managed by the interaction grid.
 
     Lights are also kept track of in the scene cells structure as well if trackLightsInMain is true.
+    Only cells that have something in them take up memory.
     */
-    LightNodeContainer * m_lightNodes;
-
-    /**
-    The static light nodes for each cell managed by the interaction grid.
-
-    Lights are also kept track of in the static scene cells structure as well if trackLightsInMain is true.
-    */
-    StaticLightNodeContainer * m_staticLightNodes;
+    LightNodeStorage m_lightNodes;
 
     friend class GraphicsNode;
 };
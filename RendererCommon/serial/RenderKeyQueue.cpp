@@ -0,0 +1,55 @@
+#include <cstring>
+#include "RenderKeyQueue.h"
+
+namespace illRendererCommon {
+
+void RenderKeyQueue::sort() {
+    if(m_size < 2) {
+        return;
+    }
+
+    //build the histograms for all 8 bytes in one pass over the keys
+    size_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+
+    {
+        const Entry * entries = &m_entries[m_front][0];
+
+        for(size_t entry = 0; entry < m_size; entry++) {
+            uint64_t key = entries[entry].m_key;
+
+            for(unsigned int byte = 0; byte < 8; byte++) {
+                ++counts[byte][(key >> (byte << 3)) & 0xFF];
+            }
+        }
+    }
+
+    for(unsigned int byte = 0; byte < 8; byte++) {
+        const Entry * src = &m_entries[m_front][0];
+        Entry * dest = &m_entries[1 - m_front][0];
+
+        unsigned int shift = byte << 3;
+
+        //if every key has the same value in this byte the pass wouldn't move anything
+        if(counts[byte][(src[0].m_key >> shift) & 0xFF] == m_size) {
+            continue;
+        }
+
+        //turn the counts into starting offsets
+        size_t offsets[256];
+        size_t offset = 0;
+
+        for(unsigned int bucket = 0; bucket < 256; bucket++) {
+            offsets[bucket] = offset;
+            offset += counts[byte][bucket];
+        }
+
+        for(size_t entry = 0; entry < m_size; entry++) {
+            dest[offsets[(src[entry].m_key >> shift) & 0xFF]++] = src[entry];
+        }
+
+        m_front = 1 - m_front;
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+#ifndef ILL_RENDER_KEY_QUEUE_H_
+#define ILL_RENDER_KEY_QUEUE_H_
+
+#include <cassert>
+#include <cstdint>
+
+#include "Util/serial/Array.h"
+
+namespace illRendererCommon {
+
+/**
+A flat list of 64 bit sort keys, each paired with an index into a payload array owned by whoever fills the queue.
+Meant as a replacement for the maps of maps of maps in the render queues.
+Pushing is just a write into a preallocated array, and sorting is a stable LSD radix sort
+so equal keys stay in the order they were pushed in.
+
+The memory is never released when the queue is cleared, so after the first few frames there are no more allocations.
+*/
+class RenderKeyQueue {
+public:
+    struct Entry {
+        uint64_t m_key;
+        uint32_t m_payload;
+    };
+
+    /**
+    Creates the queue with room for some number of entries before it needs to grow.
+    */
+    inline RenderKeyQueue(size_t capacity = 0)
+        : m_size(0),
+        m_front(0)
+    {
+        reserve(capacity);
+    }
+
+    /**
+    Makes sure the queue can hold at least this many entries without reallocating.
+    */
+    inline void reserve(size_t capacity) {
+        if(m_entries[0].size() < capacity) {
+            m_entries[0].resize(capacity);
+            m_entries[1].resize(capacity);
+        }
+    }
+
+    inline void push(uint64_t key, uint32_t payload) {
+        if(m_size == m_entries[m_front].size()) {
+            reserve(m_size < 256 ? 256 : m_size << 1);
+        }
+
+        Entry& entry = m_entries[m_front][m_size++];
+        entry.m_key = key;
+        entry.m_payload = payload;
+    }
+
+    /**
+    Empties the queue but keeps the memory around for next time.
+    */
+    inline void clear() {
+        m_size = 0;
+    }
+
+    inline size_t size() const {
+        return m_size;
+    }
+
+    inline bool empty() const {
+        return m_size == 0;
+    }
+
+    inline const Entry& operator[](size_t index) const {
+        assert(index < m_size);
+        return m_entries[m_front][index];
+    }
+
+    /**
+    Sorts the entries by key.  Byte positions that are the same for every key are skipped,
+    so in practice this only does as many passes as there are distinct shaders, materials, etc...
+    */
+    void sort();
+
+private:
+    //Array has no copy semantics
+    RenderKeyQueue(const RenderKeyQueue&);
+    RenderKeyQueue& operator=(const RenderKeyQueue&);
+
+    /**
+    The entries and a scratch buffer the same size for the radix sort to scatter into.
+    The two are swapped after every pass so m_front says which one currently holds the data.
+    */
+    Array<Entry> m_entries[2];
+    size_t m_size;
+    uint8_t m_front;
+};
+
+}
+
+#endif
@@ -1,31 +1,46 @@
+#include <new>
 #include "RenderQueues.h"
 
 namespace illRendererCommon {
 
+/**
+How many entries the sorted queues start out with room for.  They grow as needed and never shrink.
+*/
+const size_t RENDERQUEUE_SORTED_INITIAL_CAPACITY = 4096;
+
 RenderQueues::RenderQueues()
-    : m_mapMemory(RENDERQUEUE_SMALL_MAPS + RENDERQUEUE_LARGE_MAPS),
-    m_pointerVectorMemory(RENDERQUEUE_POINTER_VECTORS),
-    m_staticMeshInfoVectorMemory(RENDERQUEUE_STATIC_MESH_INFO_VECTORS)
+    : m_frameArena(NULL),
+    m_useSortedQueues(false),
+    m_getSolidAffectingLights(false),
+    m_queueLights(true),
+    m_depthPassLimit((size_t) -1),
+    m_depthPassObjects(0)
 {
-    //the maps
-    {
-        size_t currMapInd = 0;
-
-        for(int map = 0; map < RENDERQUEUE_SMALL_MAPS; map++, currMapInd++) {
-            m_smallMapPool.push(&m_mapMemory[currMapInd]);
-            m_mapMemory[currMapInd].rehash(RENDERQUEUE_SMALL_MAP_BUCKETS);
-        }
-
-        for(int map = 0; map < RENDERQUEUE_LARGE_MAPS; map++, currMapInd++) {
-            m_largeMapPool.push(&m_mapMemory[currMapInd]);
-            m_mapMemory[currMapInd].rehash(RENDERQUEUE_LARGE_MAP_BUCKETS);
-        }
+    m_sortedDepthPassSolidStaticMeshes.reserve(RENDERQUEUE_SORTED_INITIAL_CAPACITY);
+    m_sortedSolidStaticMeshes.reserve(RENDERQUEUE_SORTED_INITIAL_CAPACITY);
+    m_sortedUnsolidStaticMeshes.reserve(RENDERQUEUE_SORTED_INITIAL_CAPACITY);
+}
+
+void RenderQueues::clear() {
+    clearDepthPass();
+
+    m_solidStaticMeshes.clear();
+    m_unsolidStaticMeshes.clear();
+    m_unsolidDepthsortedStaticMeshes.clear();
+
+    m_sortedSolidStaticMeshes.clear();
+    m_sortedUnsolidStaticMeshes.clear();
+
+    //even after clear() the maps hold on to their bucket arrays in the arena, and some standard libraries allocate a sentinel node
+    //as soon as a map is constructed, so the old queue has to be gone before the reset and the new one built after it
+    m_lights.~LightQueue();
+
+    if(m_frameArena) {
+        m_frameArena->reset();
     }
 
-    //the vectors
+    new (&m_lights) LightQueue(0, LightQueue::hasher(), LightQueue::key_equal(), 
+        LightQueue::allocator_type(FrameArenaAllocator<LightQueue::value_type>(m_frameArena)));
 }
 
-RenderQueues::~RenderQueues() {
 }
-
-}
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef ILL_RENDER_QUEUES_H_
 #define ILL_RENDER_QUEUES_H_
 
-#include <set>
 #include <glm/glm.hpp>
+#include <scoped_allocator>
 #include <unordered_map>
 #include <vector>
 
 #include "Graphics/serial/Light.h"
+#include "RendererCommon/serial/RenderKeyQueue.h"
+#include "Util/serial/FrameArena.h"
+#include "Util/serial/SmallVector.h"
 
 namespace illGraphics {
 class Mesh;
@@ -25,6 +28,21 @@ class StaticMeshNode;
 /**
 */
 struct RenderQueues {
+    RenderQueues();
+
+    /**
+    Where the per frame containers in here get their memory from.  This is owned by the scene and reset by clear() at the end of each frame.
+    If NULL, everything comes from the heap like usual.
+    */
+    FrameArena * m_frameArena;
+
+    /**
+    Whether to write static meshes into the flat sorted key queues instead of the maps of maps of maps.
+    The maps hash and allocate for every node every frame, the sorted queues just append to preallocated arrays
+    and get radix sorted once per pass.  Backends should walk both since only one of them ever has anything in it.
+    */
+    bool m_useSortedQueues;
+
     /**
     Whether or not to get the lights that affect solid objects.
     This should be false if doing deferred shading, but true if doing forward rendering.
@@ -54,16 +72,35 @@ struct RenderQueues {
     Storing their transforms sorted by mesh.
     */
     struct StaticMeshInfo {
+        inline StaticMeshInfo()
+            : m_node(NULL),
+            m_primitiveGroup(0)
+        {}
+
         const StaticMeshNode * m_node;
         uint8_t m_primitiveGroup;
     };
 
+    /**
+    A list of lights affecting an object in order of address.
+    Nodes cache one of these, see GraphicsNode::getAffectingLights.  Most objects are only touched by a few lights so they fit inline.
+    */
+    typedef SmallVector<LightNode *, 4> LightList;
+
     std::unordered_map<const illGraphics::ShaderProgram *, 
         std::unordered_map<const illGraphics::Material *, 
             std::unordered_map<const illGraphics::Mesh *, std::vector<StaticMeshInfo>>>> m_depthPassSolidStaticMeshes;
     
     struct StaticMeshLightInfo {
-        std::set<LightNode *> m_affectingLights;
+        inline StaticMeshLightInfo()
+            : m_affectingLights(NULL)
+        {}
+
+        /**
+        The lights affecting the node, if m_getSolidAffectingLights is on or the material is forward rendered, otherwise NULL.
+        This points at the node's cached list, which stays put until the node or a light near it moves.
+        */
+        const LightList * m_affectingLights;
         StaticMeshInfo m_meshInfo;
     };
 
@@ -95,12 +132,196 @@ struct RenderQueues {
             std::unordered_map<const illGraphics::Mesh *, std::vector<StaticMeshLightInfo>>>> 
         m_unsolidDepthsortedStaticMeshes;
 
+    typedef std::vector<const LightNode *, FrameArenaAllocator<const LightNode *>> LightNodeList;
+
+    typedef std::unordered_map<illGraphics::LightBase *, LightNodeList,
+            std::hash<illGraphics::LightBase *>, std::equal_to<illGraphics::LightBase *>,
+            std::scoped_allocator_adaptor<FrameArenaAllocator<std::pair<illGraphics::LightBase * const, LightNodeList>>>>
+        LightInstanceQueue;
+
+    typedef std::unordered_map<illGraphics::LightBase::Type, LightInstanceQueue,
+            std::hash<illGraphics::LightBase::Type>, std::equal_to<illGraphics::LightBase::Type>,
+            std::scoped_allocator_adaptor<FrameArenaAllocator<std::pair<const illGraphics::LightBase::Type, LightInstanceQueue>>>>
+        LightQueue;
+
     /**
     Lights to be drawn in deferred shading sorted by light type and light.
     This should make lights instanceable.
+    All levels allocate from the frame arena, the scoped allocator passes it down to the inner containers.
+    */
+    LightQueue m_lights;
+
+    /**
+    A queue of mesh infos ordered by 64 bit sort keys, see staticMeshSortKey().
+    The payloads are stored in the order they were added and the key queue indexes into them.
+    Each payload keeps the pointers that would have been the map keys so the backend can tell when state changes.
+    */
+    template <typename Info>
+    struct SortedQueue {
+        struct Payload {
+            const illGraphics::ShaderProgram * m_program;
+            const illGraphics::Material * m_material;
+            const illGraphics::Mesh * m_mesh;
+            Info m_info;
+        };
+
+        inline Info& add(uint64_t sortKey, const illGraphics::ShaderProgram * program, const illGraphics::Material * material, const illGraphics::Mesh * mesh) {
+            m_keys.push(sortKey, (uint32_t) m_payloads.size());
+
+            m_payloads.emplace_back();
+            m_payloads.back().m_program = program;
+            m_payloads.back().m_material = material;
+            m_payloads.back().m_mesh = mesh;
+
+            return m_payloads.back().m_info;
+        }
+
+        /**
+        Adds an already filled in payload.  Used for merging in queues that were built separately.
+        */
+        inline void add(uint64_t sortKey, Payload&& payload) {
+            m_keys.push(sortKey, (uint32_t) m_payloads.size());
+            m_payloads.push_back(std::move(payload));
+        }
+
+        inline void reserve(size_t capacity) {
+            m_keys.reserve(capacity);
+            m_payloads.reserve(capacity);
+        }
+
+        inline void sort() {
+            m_keys.sort();
+        }
+
+        inline void clear() {
+            m_keys.clear();
+            m_payloads.clear();
+        }
+
+        inline size_t size() const {
+            return m_keys.size();
+        }
+
+        inline bool empty() const {
+            return m_keys.empty();
+        }
+
+        /**
+        Returns the payload at some position in sorted order, assuming sort() was called.
+        */
+        inline const Payload& operator[](size_t index) const {
+            return m_payloads[m_keys[index].m_payload];
+        }
+
+        RenderKeyQueue m_keys;
+        std::vector<Payload> m_payloads;
+    };
+
+    /**
+    Sorted equivalent of m_depthPassSolidStaticMeshes.
+    */
+    SortedQueue<StaticMeshInfo> m_sortedDepthPassSolidStaticMeshes;
+
+    /**
+    Sorted equivalent of m_solidStaticMeshes.
+    */
+    SortedQueue<StaticMeshLightInfo> m_sortedSolidStaticMeshes;
+
+    /**
+    Sorted equivalent of m_unsolidStaticMeshes.
+    */
+    SortedQueue<StaticMeshLightInfo> m_sortedUnsolidStaticMeshes;
+
+    /**
+    Builds the sort key for a static mesh primitive group.
+    From the most significant bits down:
+    16 bits of the shader program feature mask, 20 bits of material id, 20 bits of mesh id, and 8 bits of primitive group.
+    The ids are truncated, which only ever costs a redundant state change since the payload has the real pointers.
+    */
+    inline static uint64_t staticMeshSortKey(uint64_t programFeatures, uint32_t materialId, uint32_t meshId, uint8_t primitiveGroup) {
+        return ((programFeatures & 0xFFFF) << 48)
+            | ((uint64_t) (materialId & 0xFFFFF) << 28)
+            | ((uint64_t) (meshId & 0xFFFFF) << 8)
+            | primitiveGroup;
+    }
+
+    /**
+    Adds a primitive group of a static mesh to the depth pass for the current cell, to whichever queue is being used.
+    Fill in the returned info.
+    */
+    inline StaticMeshInfo& addDepthPassSolidStaticMesh(uint64_t sortKey, const illGraphics::ShaderProgram * program, 
+            const illGraphics::Material * material, const illGraphics::Mesh * mesh) {
+        if(m_useSortedQueues) {
+            return m_sortedDepthPassSolidStaticMeshes.add(sortKey, program, material, mesh);
+        }
+        else {
+            auto& list = m_depthPassSolidStaticMeshes[program][material][mesh];
+            list.emplace_back();
+            return list.back();
+        }
+    }
+
+    /**
+    Adds a primitive group of a static mesh to the solid render pass, to whichever queue is being used.
+    Fill in the returned info.
+    */
+    inline StaticMeshLightInfo& addSolidStaticMesh(uint64_t sortKey, const illGraphics::ShaderProgram * program, 
+            const illGraphics::Material * material, const illGraphics::Mesh * mesh) {
+        if(m_useSortedQueues) {
+            return m_sortedSolidStaticMeshes.add(sortKey, program, material, mesh);
+        }
+        else {
+            auto& list = m_solidStaticMeshes[program][material][mesh];
+            list.emplace_back();
+            return list.back();
+        }
+    }
+
+    /**
+    Adds a primitive group of a static mesh to the unsolid render pass, to whichever queue is being used.
+    Fill in the returned info.
+    */
+    inline StaticMeshLightInfo& addUnsolidStaticMesh(uint64_t sortKey, const illGraphics::ShaderProgram * program, 
+            const illGraphics::Material * material, const illGraphics::Mesh * mesh) {
+        if(m_useSortedQueues) {
+            return m_sortedUnsolidStaticMeshes.add(sortKey, program, material, mesh);
+        }
+        else {
+            auto& list = m_unsolidStaticMeshes[program][material][mesh];
+            list.emplace_back();
+            return list.back();
+        }
+    }
+
+    /**
+    Sorts the depth pass queue.  Call before handing the queues to the backend for a depth pass.
+    */
+    inline void sortDepthPass() {
+        m_sortedDepthPassSolidStaticMeshes.sort();
+    }
+
+    /**
+    Sorts the render pass queues.  Call before handing the queues to the backend for the main render.
+    */
+    inline void sort() {
+        m_sortedSolidStaticMeshes.sort();
+        m_sortedUnsolidStaticMeshes.sort();
+    }
+
+    /**
+    Empties the depth pass queues after a cell's depth pass is done.
+    */
+    inline void clearDepthPass() {
+        m_depthPassSolidStaticMeshes.clear();
+        m_sortedDepthPassSolidStaticMeshes.clear();
+    }
+
+    /**
+    Empties everything at the end of the frame and resets the frame arena.
+    The containers living in the arena are torn down before the reset and rebuilt after it, so nothing is left pointing at reused memory.
+    Nothing else should reset the arena while it's in use by the queues.
     */
-    std::unordered_map<const illGraphics::LightBase::Type, 
-        std::unordered_map<illGraphics::LightBase *, std::vector<const LightNode *>>> m_lights;
+    void clear();
 };
 
 }
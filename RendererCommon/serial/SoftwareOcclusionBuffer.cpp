@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "RendererCommon/serial/SoftwareOcclusionBuffer.h"
+#include "Util/simd.h"
+
+namespace illRendererCommon {
+
+/**
+The triangles making up the faces of a box, wound counter clockwise when looking at the outside of the face,
+indexing the corners the way projectBox orders them.
+*/
+static const unsigned int BOX_TRIANGLES[12][3] = {
+    {0, 4, 6}, {0, 6, 2},   //-x
+    {1, 3, 7}, {1, 7, 5},   //+x
+    {0, 1, 5}, {0, 5, 4},   //-y
+    {2, 6, 7}, {2, 7, 3},   //+y
+    {0, 2, 3}, {0, 3, 1},   //-z
+    {4, 5, 7}, {4, 7, 6}    //+z
+};
+
+SoftwareOcclusionBuffer::SoftwareOcclusionBuffer(unsigned int width, unsigned int height)
+    : m_debugNumOccluders(0),
+    m_debugNumTests(0),
+    m_debugNumOccluded(0)
+{
+    setResolution(width, height);
+}
+
+void SoftwareOcclusionBuffer::setResolution(unsigned int width, unsigned int height) {
+    m_widthTiles = (std::max(width, 1u) + SOFTWARE_OCCLUSION_TILE_SIZE - 1) / SOFTWARE_OCCLUSION_TILE_SIZE;
+    m_heightTiles = (std::max(height, 1u) + SOFTWARE_OCCLUSION_TILE_SIZE - 1) / SOFTWARE_OCCLUSION_TILE_SIZE;
+    m_width = m_widthTiles * SOFTWARE_OCCLUSION_TILE_SIZE;
+    m_height = m_heightTiles * SOFTWARE_OCCLUSION_TILE_SIZE;
+
+    m_depth.assign(m_width * m_height, FLT_MAX);
+    m_tileMaxDepth.assign(m_widthTiles * m_heightTiles, FLT_MAX);
+}
+
+void SoftwareOcclusionBuffer::clear(const glm::mat4& viewProjection) {
+    m_viewProjection = viewProjection;
+
+    std::fill(m_depth.begin(), m_depth.end(), FLT_MAX);
+    std::fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), FLT_MAX);
+
+    m_debugNumOccluders = 0;
+    m_debugNumTests = 0;
+    m_debugNumOccluded = 0;
+}
+
+bool SoftwareOcclusionBuffer::projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3 * corners) const {
+    //the transformed corners are sums of the matrix columns scaled by min or max of each axis, so only do those multiplies once
+    glm::vec4 xTerms[2] = { m_viewProjection[0] * boxMin.x, m_viewProjection[0] * boxMax.x };
+    glm::vec4 yTerms[2] = { m_viewProjection[1] * boxMin.y, m_viewProjection[1] * boxMax.y };
+    glm::vec4 zTerms[2] = { m_viewProjection[2] * boxMin.z + m_viewProjection[3], m_viewProjection[2] * boxMax.z + m_viewProjection[3] };
+
+    for(unsigned int corner = 0; corner < 8; corner++) {
+        glm::vec4 clip = xTerms[corner & 1] + yTerms[(corner >> 1) & 1] + zTerms[(corner >> 2) & 1];
+
+        //in front of the near plane
+        if(clip.w <= 0.0f || clip.z < -clip.w) {
+            return false;
+        }
+
+        float invW = 1.0f / clip.w;
+
+        corners[corner] = glm::vec3(
+            (clip.x * invW * 0.5f + 0.5f) * (float) m_width,
+            (clip.y * invW * 0.5f + 0.5f) * (float) m_height,
+            clip.z * invW * 0.5f + 0.5f);
+    }
+
+    return true;
+}
+
+bool SoftwareOcclusionBuffer::rasterizeBox(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 corners[8];
+
+    if(!projectBox(boxMin, boxMax, corners)) {
+        return false;
+    }
+
+    for(unsigned int triangle = 0; triangle < 12; triangle++) {
+        rasterizeTriangle(corners[BOX_TRIANGLES[triangle][0]], corners[BOX_TRIANGLES[triangle][1]], corners[BOX_TRIANGLES[triangle][2]]);
+    }
+
+    float minX = corners[0].x;
+    float minY = corners[0].y;
+    float maxX = corners[0].x;
+    float maxY = corners[0].y;
+
+    for(unsigned int corner = 1; corner < 8; corner++) {
+        minX = std::min(minX, corners[corner].x);
+        minY = std::min(minY, corners[corner].y);
+        maxX = std::max(maxX, corners[corner].x);
+        maxY = std::max(maxY, corners[corner].y);
+    }
+
+    updateTiles((int) std::floor(minX), (int) std::floor(minY), (int) std::ceil(maxX), (int) std::ceil(maxY));
+
+    ++m_debugNumOccluders;
+
+    return true;
+}
+
+void SoftwareOcclusionBuffer::rasterizeTriangle(const glm::vec3& vert0, const glm::vec3& vert1, const glm::vec3& vert2) {
+    float area = (vert1.x - vert0.x) * (vert2.y - vert0.y) - (vert2.x - vert0.x) * (vert1.y - vert0.y);
+
+    //back facing or degenerate, the front faces of a closed occluder cover everything the back faces would
+    if(area <= 0.0f) {
+        return;
+    }
+
+    int minX = std::max(0, (int) std::floor(std::min(vert0.x, std::min(vert1.x, vert2.x))));
+    int minY = std::max(0, (int) std::floor(std::min(vert0.y, std::min(vert1.y, vert2.y))));
+    int maxX = std::min((int) m_width - 1, (int) std::ceil(std::max(vert0.x, std::max(vert1.x, vert2.x))));
+    int maxY = std::min((int) m_height - 1, (int) std::ceil(std::max(vert0.y, std::max(vert1.y, vert2.y))));
+
+    if(minX > maxX || minY > maxY) {
+        return;
+    }
+
+    //start at a multiple of 4 pixels, the width is a multiple of the tile size so a group of 4 never runs off the end of a row
+    minX &= ~3;
+
+    //edge functions, a * x + b * y + c, positive on the inside of each edge
+    float edgeA0 = vert0.y - vert1.y;
+    float edgeB0 = vert1.x - vert0.x;
+    float edgeC0 = -(edgeA0 * vert0.x + edgeB0 * vert0.y);
+
+    float edgeA1 = vert1.y - vert2.y;
+    float edgeB1 = vert2.x - vert1.x;
+    float edgeC1 = -(edgeA1 * vert1.x + edgeB1 * vert1.y);
+
+    float edgeA2 = vert2.y - vert0.y;
+    float edgeB2 = vert0.x - vert2.x;
+    float edgeC2 = -(edgeA2 * vert2.x + edgeB2 * vert2.y);
+
+    //depth is linear in screen space, depthA * x + depthB * y + depthC
+    float invArea = 1.0f / area;
+    float depthA = ((vert1.z - vert0.z) * (vert2.y - vert0.y) - (vert2.z - vert0.z) * (vert1.y - vert0.y)) * invArea;
+    float depthB = ((vert2.z - vert0.z) * (vert1.x - vert0.x) - (vert1.z - vert0.z) * (vert2.x - vert0.x)) * invArea;
+    float depthC = vert0.z - depthA * vert0.x - depthB * vert0.y;
+
+#ifdef ILL_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+
+    const __m128 edgeStep0 = _mm_set1_ps(edgeA0 * 4.0f);
+    const __m128 edgeStep1 = _mm_set1_ps(edgeA1 * 4.0f);
+    const __m128 edgeStep2 = _mm_set1_ps(edgeA2 * 4.0f);
+    const __m128 depthStep = _mm_set1_ps(depthA * 4.0f);
+
+    for(int y = minY; y <= maxY; y++) {
+        float pixelY = (float) y + 0.5f;
+        float * row = &m_depth[y * m_width];
+
+        //values at the centers of the first 4 pixels in the row
+        __m128 pixelX = _mm_add_ps(_mm_set1_ps((float) minX), laneOffsets);
+        __m128 edge0 = _mm_add_ps(_mm_mul_ps(pixelX, _mm_set1_ps(edgeA0)), _mm_set1_ps(edgeB0 * pixelY + edgeC0));
+        __m128 edge1 = _mm_add_ps(_mm_mul_ps(pixelX, _mm_set1_ps(edgeA1)), _mm_set1_ps(edgeB1 * pixelY + edgeC1));
+        __m128 edge2 = _mm_add_ps(_mm_mul_ps(pixelX, _mm_set1_ps(edgeA2)), _mm_set1_ps(edgeB2 * pixelY + edgeC2));
+        __m128 depth = _mm_add_ps(_mm_mul_ps(pixelX, _mm_set1_ps(depthA)), _mm_set1_ps(depthB * pixelY + depthC));
+
+        for(int x = minX; x <= maxX; x += 4) {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+
+            if(_mm_movemask_ps(inside)) {
+                __m128 oldDepth = _mm_loadu_ps(row + x);
+                __m128 newDepth = _mm_min_ps(oldDepth, depth);
+
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+            }
+
+            edge0 = _mm_add_ps(edge0, edgeStep0);
+            edge1 = _mm_add_ps(edge1, edgeStep1);
+            edge2 = _mm_add_ps(edge2, edgeStep2);
+            depth = _mm_add_ps(depth, depthStep);
+        }
+    }
+#else
+    for(int y = minY; y <= maxY; y++) {
+        float pixelY = (float) y + 0.5f;
+        float * row = &m_depth[y * m_width];
+
+        for(int x = minX; x <= maxX; x++) {
+            float pixelX = (float) x + 0.5f;
+
+            if(edgeA0 * pixelX + edgeB0 * pixelY + edgeC0 >= 0.0f
+                    && edgeA1 * pixelX + edgeB1 * pixelY + edgeC1 >= 0.0f
+                    && edgeA2 * pixelX + edgeB2 * pixelY + edgeC2 >= 0.0f) {
+                row[x] = std::min(row[x], depthA * pixelX + depthB * pixelY + depthC);
+            }
+        }
+    }
+#endif
+}
+
+void SoftwareOcclusionBuffer::updateTiles(int minX, int minY, int maxX, int maxY) {
+    int minTileX = std::max(0, minX) / (int) SOFTWARE_OCCLUSION_TILE_SIZE;
+    int minTileY = std::max(0, minY) / (int) SOFTWARE_OCCLUSION_TILE_SIZE;
+    int maxTileX = std::min((int) m_width - 1, maxX) / (int) SOFTWARE_OCCLUSION_TILE_SIZE;
+    int maxTileY = std::min((int) m_height - 1, maxY) / (int) SOFTWARE_OCCLUSION_TILE_SIZE;
+
+    for(int tileY = minTileY; tileY <= maxTileY; tileY++) {
+        for(int tileX = minTileX; tileX <= maxTileX; tileX++) {
+            const float * tile = &m_depth[tileY * SOFTWARE_OCCLUSION_TILE_SIZE * m_width + tileX * SOFTWARE_OCCLUSION_TILE_SIZE];
+
+#ifdef ILL_SSE2
+            __m128 maxDepth = _mm_loadu_ps(tile);
+
+            for(unsigned int y = 0; y < SOFTWARE_OCCLUSION_TILE_SIZE; y++) {
+                for(unsigned int x = 0; x < SOFTWARE_OCCLUSION_TILE_SIZE; x += 4) {
+                    maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(tile + y * m_width + x));
+                }
+            }
+
+            maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+            maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            m_tileMaxDepth[tileX + tileY * m_widthTiles] = _mm_cvtss_f32(maxDepth);
+#else
+            float maxDepth = tile[0];
+
+            for(unsigned int y = 0; y < SOFTWARE_OCCLUSION_TILE_SIZE; y++) {
+                for(unsigned int x = 0; x < SOFTWARE_OCCLUSION_TILE_SIZE; x++) {
+                    maxDepth = std::max(maxDepth, tile[y * m_width + x]);
+                }
+            }
+
+            m_tileMaxDepth[tileX + tileY * m_widthTiles] = maxDepth;
+#endif
+        }
+    }
+}
+
+bool SoftwareOcclusionBuffer::testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    ++m_debugNumTests;
+
+    glm::vec3 corners[8];
+
+    if(!projectBox(boxMin, boxMax, corners)) {
+        return true;
+    }
+
+    float minX = corners[0].x;
+    float minY = corners[0].y;
+    float maxX = corners[0].x;
+    float maxY = corners[0].y;
+    float nearest = corners[0].z;
+
+    for(unsigned int corner = 1; corner < 8; corner++) {
+        minX = std::min(minX, corners[corner].x);
+        minY = std::min(minY, corners[corner].y);
+        maxX = std::max(maxX, corners[corner].x);
+        maxY = std::max(maxY, corners[corner].y);
+        nearest = std::min(nearest, corners[corner].z);
+    }
+
+    //the pixels the box's screen rectangle touches
+    int rectMinX = std::max(0, (int) std::floor(minX));
+    int rectMinY = std::max(0, (int) std::floor(minY));
+    int rectMaxX = std::min((int) m_width - 1, (int) std::floor(maxX));
+    int rectMaxY = std::min((int) m_height - 1, (int) std::floor(maxY));
+
+    //off screen
+    if(rectMinX > rectMaxX || rectMinY > rectMaxY) {
+        ++m_debugNumOccluded;
+        return false;
+    }
+
+    for(int tileY = rectMinY / (int) SOFTWARE_OCCLUSION_TILE_SIZE; tileY <= rectMaxY / (int) SOFTWARE_OCCLUSION_TILE_SIZE; tileY++) {
+        for(int tileX = rectMinX / (int) SOFTWARE_OCCLUSION_TILE_SIZE; tileX <= rectMaxX / (int) SOFTWARE_OCCLUSION_TILE_SIZE; tileX++) {
+            //everything in the tile is already nearer than the box
+            if(m_tileMaxDepth[tileX + tileY * m_widthTiles] <= nearest) {
+                continue;
+            }
+
+            int tileMinX = tileX * (int) SOFTWARE_OCCLUSION_TILE_SIZE;
+            int tileMinY = tileY * (int) SOFTWARE_OCCLUSION_TILE_SIZE;
+            int tileMaxX = tileMinX + (int) SOFTWARE_OCCLUSION_TILE_SIZE - 1;
+            int tileMaxY = tileMinY + (int) SOFTWARE_OCCLUSION_TILE_SIZE - 1;
+
+            //the box covers the whole tile so the farthest pixel in it is behind the box
+            if(rectMinX <= tileMinX && rectMaxX >= tileMaxX && rectMinY <= tileMinY && rectMaxY >= tileMaxY) {
+                return true;
+            }
+
+            //otherwise look at the pixels in the part of the tile the box covers
+            for(int y = std::max(rectMinY, tileMinY); y <= std::min(rectMaxY, tileMaxY); y++) {
+                const float * row = &m_depth[y * m_width];
+
+                for(int x = std::max(rectMinX, tileMinX); x <= std::min(rectMaxX, tileMaxX); x++) {
+                    if(row[x] > nearest) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    ++m_debugNumOccluded;
+    return false;
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef ILL_SOFTWARE_OCCLUSION_BUFFER_H_
+#define ILL_SOFTWARE_OCCLUSION_BUFFER_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace illRendererCommon {
+
+const unsigned int SOFTWARE_OCCLUSION_TILE_SIZE = 8;
+
+/**
+A low resolution depth buffer on the CPU for occlusion culling within the same frame.
+
+Occluders are rasterized into it as they're found, and boxes can be tested against whatever was rasterized so far.
+So if things are traversed front to back, anything behind the nearby occluders can be culled right away,
+rather than waiting a frame or more for hardware occlusion query results to come back.
+
+Along with the depth per pixel, the farthest depth of each 8x8 tile of pixels is kept.
+Tests against a tile that's entirely covered by a box only need to look at that one value, and tiles where everything
+is already nearer than the box get skipped, so most tests never look at individual pixels.
+
+The rasterization uses SSE2 when available, see Util/simd.h.
+
+Occluders should be conservative, meaning they shouldn't cover anything the real object doesn't cover.
+Otherwise things behind the edges of the occluder get culled when they're actually visible.
+*/
+class SoftwareOcclusionBuffer {
+public:
+    /**
+    @param width The width of the buffer in pixels.  Gets rounded up to a multiple of the tile size.
+    @param height The height of the buffer in pixels.  Gets rounded up to a multiple of the tile size.
+    */
+    SoftwareOcclusionBuffer(unsigned int width = 256, unsigned int height = 128);
+
+    void setResolution(unsigned int width, unsigned int height);
+
+    inline unsigned int getWidth() const {
+        return m_width;
+    }
+
+    inline unsigned int getHeight() const {
+        return m_height;
+    }
+
+    /**
+    Empties the buffer and sets up the view for the frame.
+
+    @param viewProjection The camera's model view projection matrix, usually camera.getModelViewProjection().
+    */
+    void clear(const glm::mat4& viewProjection);
+
+    /**
+    Rasterizes the front faces of a world space box as an occluder.
+    Boxes that cross the near plane are skipped since they'd need clipping, and a box that close to the camera
+    is probably best left to the hardware to deal with anyway.
+
+    @return Whether or not anything was rasterized.
+    */
+    bool rasterizeBox(const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+    /**
+    Tests whether any part of a world space box might be visible past what's been rasterized so far.
+    This is conservative, it may say something is visible when it isn't, but never the other way around.
+    Boxes crossing the near plane are always visible.
+    */
+    bool testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    /**
+    The depth of a pixel, from 0 at the near plane to 1 at the far plane.
+    Pixels nothing was rasterized to are a really big number.
+    */
+    inline float getDepth(unsigned int x, unsigned int y) const {
+        return m_depth[x + y * m_width];
+    }
+
+    size_t m_debugNumOccluders;
+    mutable size_t m_debugNumTests;
+    mutable size_t m_debugNumOccluded;
+
+private:
+    /**
+    Projects the 8 corners of a box into screen space, with x and y in pixels and z the depth from 0 to 1.
+    Corner i has the max x if bit 0 of i is set, the max y if bit 1 is set, and the max z if bit 2 is set.
+
+    @return False if any corner is in front of the near plane, in which case the corners aren't usable.
+    */
+    bool projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3 * corners) const;
+
+    void rasterizeTriangle(const glm::vec3& vert0, const glm::vec3& vert1, const glm::vec3& vert2);
+
+    /**
+    Recomputes the farthest depth of the tiles in a range of pixels.
+    */
+    void updateTiles(int minX, int minY, int maxX, int maxY);
+
+    unsigned int m_width;
+    unsigned int m_height;
+    unsigned int m_widthTiles;
+    unsigned int m_heightTiles;
+
+    glm::mat4 m_viewProjection;
+
+    std::vector<float> m_depth;
+    std::vector<float> m_tileMaxDepth;
+};
+
+}
+
+#endif
@@ -6,6 +6,11 @@ namespace illRendererCommon {
 
 void StaticMeshNode::render(RenderQueues& renderQueues) {
     assert(!m_mesh.isNull());
+
+    //still loading in the background from requestLoad
+    if(!m_mesh->isLoaded()) {
+        return;
+    }
     
     //place the mesh in the appropriate render queue
     for(uint8_t groupInd = 0; groupInd < m_primitiveGroups.size(); groupInd++) {
@@ -13,46 +18,57 @@ void StaticMeshNode::render(RenderQueues& renderQueues) {
 
         assert(!group.m_material.isNull());
 
+        if(!group.m_material->isLoaded()) {
+            continue;
+        }
+
         switch(group.m_material->getLoadArgs().m_blendMode) {
         case illGraphics::MaterialLoadArgs::BlendMode::NONE: {
                 
                 if(m_occluderType == OccluderType::ALWAYS || (m_occluderType == OccluderType::LIMITED && renderQueues.m_depthPassObjects < renderQueues.m_depthPassLimit)) {
-                    MeshData<>::PrimitiveGroup& test = m_mesh->getMeshFrontentData()->getPrimitiveGroup(groupInd);
+                    const illGraphics::ShaderProgram * program = group.m_material->getDepthPassProgram();
 
-                    auto& list = renderQueues.m_depthPassSolidStaticMeshes[group.m_material->getDepthPassProgram()][group.m_material.get()][m_mesh.get()];
+                    auto& info = renderQueues.addDepthPassSolidStaticMesh(
+                        RenderQueues::staticMeshSortKey(program->getLoadArgs(), group.m_materialId, m_meshId, groupInd),
+                        program, group.m_material.get(), m_mesh.get());
 
-                    list.emplace_back();
-                    list.back().m_node = this;
-                    list.back().m_primitiveGroup = groupInd;
+                    info.m_node = this;
+                    info.m_primitiveGroup = groupInd;
 
                     ++renderQueues.m_depthPassObjects;
                 }
                 
                 {
-                    auto& list = renderQueues.m_solidStaticMeshes[group.m_material->getShaderProgram()][group.m_material.get()][m_mesh.get()];
+                    const illGraphics::ShaderProgram * program = group.m_material->getShaderProgram();
+
+                    auto& info = renderQueues.addSolidStaticMesh(
+                        RenderQueues::staticMeshSortKey(program->getLoadArgs(), group.m_materialId, m_meshId, groupInd),
+                        program, group.m_material.get(), m_mesh.get());
 
-                    list.emplace_back();
-                    list.back().m_meshInfo.m_node = this;
-                    list.back().m_meshInfo.m_primitiveGroup = groupInd;
+                    info.m_meshInfo.m_node = this;
+                    info.m_meshInfo.m_primitiveGroup = groupInd;
 
                     if(renderQueues.m_getSolidAffectingLights || group.m_material->getLoadArgs().m_forceForwardRendering) {
-                        getScene()->getLights(getWorldBoundingVolume(), list.back().m_affectingLights);
+                        info.m_affectingLights = &getAffectingLights();
                     }
                 }
             }
             break;
 
         case illGraphics::MaterialLoadArgs::BlendMode::ADDITIVE: {
-                auto& list = renderQueues.m_unsolidStaticMeshes[group.m_material->getShaderProgram()][group.m_material.get()][m_mesh.get()];
+                const illGraphics::ShaderProgram * program = group.m_material->getShaderProgram();
+
+                auto& info = renderQueues.addUnsolidStaticMesh(
+                    RenderQueues::staticMeshSortKey(program->getLoadArgs(), group.m_materialId, m_meshId, groupInd),
+                    program, group.m_material.get(), m_mesh.get());
 
-                list.emplace_back();
-                list.back().m_meshInfo.m_node = this;
-                list.back().m_meshInfo.m_primitiveGroup = groupInd;
+                info.m_meshInfo.m_node = this;
+                info.m_meshInfo.m_primitiveGroup = groupInd;
 
                 //TODO: when this is used, also store whether or not an occlusion query is needed for the node
 
                 if(renderQueues.m_getSolidAffectingLights || group.m_material->getLoadArgs().m_forceForwardRendering) {
-                    getScene()->getLights(getWorldBoundingVolume(), list.back().m_affectingLights);
+                    info.m_affectingLights = &getAffectingLights();
                 }
             }
             break;
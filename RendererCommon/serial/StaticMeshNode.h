@@ -2,7 +2,7 @@
 #define ILL_STATIC_MESH_NODE_H_
 
 #include "RendererCommon/serial/GraphicsNode.h"
-#include "Util/serial/RefCountPtr.h"
+#include "Util/serial/IntrusivePtr.h"
 #include "Graphics/serial/Model/Mesh.h"
 #include "Graphics/serial/Material/Material.h"
 
@@ -22,7 +22,8 @@ public:
             State initialState = State::IN_SCENE)
         : GraphicsNode(scene, transform, boundingVol, Type::MESH, initialState),
         m_meshId(-1),
-        m_occluderType(occluderType)
+        m_occluderType(occluderType),
+        m_hasOccluderBounds(false)
     {}
 
     virtual ~StaticMeshNode() {}
@@ -43,6 +44,24 @@ public:
         }
     }
 
+    /**
+    Like load(), but the mesh and materials load in the background, see ResourceManager::requestResource.
+    The node doesn't render until they're all done, the scene finishes them a bit at a time in GraphicsScene::finishResourceLoads.
+    */
+    inline void requestLoad(illGraphics::MeshManager * meshManager, illGraphics::MaterialManager * materialManager) {
+        if(m_mesh.isNull()) {
+            m_mesh = meshManager->requestResource(m_meshId);
+        }
+        
+        for(auto iter = m_primitiveGroups.begin(); iter != m_primitiveGroups.end(); iter++) {
+            PrimitiveGroupInfo& groupInfo = *iter;
+
+            if(groupInfo.m_visible && groupInfo.m_material.isNull()) {
+                groupInfo.m_material = materialManager->requestResource(groupInfo.m_materialId);
+            }
+        }
+    }
+
     inline void unload() {
         m_mesh.reset();
 
@@ -52,7 +71,7 @@ public:
     }
         
     illGraphics::MeshId m_meshId;
-    RefCountPtr<illGraphics::Mesh> m_mesh;
+    IntrusivePtr<illGraphics::Mesh> m_mesh;
 
     struct PrimitiveGroupInfo {
         PrimitiveGroupInfo()
@@ -61,11 +80,22 @@ public:
         {}
 
         illGraphics::MaterialId m_materialId;
-        RefCountPtr<illGraphics::Material> m_material;
+        IntrusivePtr<illGraphics::Material> m_material;
         bool m_visible;
     };
 
     OccluderType m_occluderType;
+
+    /**
+    A box that's entirely inside the mesh, relative to the node's position the same way the bounding volume is.
+    The mesh data doesn't stay around on the CPU after loading, so this is what gets rasterized in software occlusion culling.
+    It has to be authored or computed from the mesh ahead of time, and it must not stick out of the mesh anywhere,
+    or things behind it get culled when they're actually visible.
+    Only used if m_hasOccluderBounds is set, nodes without it don't occlude anything in software occlusion culling.
+    */
+    Box<> m_occluderBounds;
+    bool m_hasOccluderBounds;
+
     std::vector<PrimitiveGroupInfo> m_primitiveGroups;
 };
 
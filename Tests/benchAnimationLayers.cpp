@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
+
+#include "benchmarks.h"
+#include "testSkeletonUtil.h"
+#include "Logging/logging.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Graphics/serial/Model/Skeleton.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+#include "Graphics/serial/Model/ModelAnimationSystem.h"
+
+const uint16_t BENCH_LAYERS_BONES = 80;
+const unsigned int BENCH_LAYERS_CHARACTERS = 500;
+const unsigned int BENCH_LAYERS_FRAMES = 20;
+const unsigned int BENCH_LAYERS_LAYERS = 4;
+
+/**
+Writes an ILLSKEL0 file with a spine of every 4th bone and 3 bone chains coming off of it.
+*/
+void benchLayersWriteSkeleton(const char * path) {
+    std::vector<glm::mat4> relativeTransforms(BENCH_LAYERS_BONES);
+    std::vector<glm::mat4> offsetTransforms(BENCH_LAYERS_BONES);
+    std::vector<uint16_t> parents(BENCH_LAYERS_BONES);
+
+    for(uint16_t bone = 0; bone < BENCH_LAYERS_BONES; bone++) {
+        relativeTransforms[bone] = glm::translate(glm::vec3(0.0f, 0.1f, 0.0f));
+        offsetTransforms[bone] = glm::translate(glm::vec3(0.0f, -0.1f * (float) (bone % 8), 0.0f));
+        parents[bone] = bone == 0 ? 0 : (bone % 4 == 0 ? bone - 4 : bone - 1);
+    }
+
+    writeTestSkeleton(path, relativeTransforms, offsetTransforms, parents);
+}
+
+void benchLayersMakeAnimation(illGraphics::SkeletonAnimation& animation, float duration, float amount) {
+    illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+
+    for(uint16_t bone = 0; bone < BENCH_LAYERS_BONES; bone++) {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[bone];
+
+        animData.m_positionKeys.resize(31);
+        animData.m_rotationKeys.resize(31);
+        animData.m_scalingKeys.resize(31);
+
+        for(unsigned int key = 0; key <= 30; key++) {
+            float time = duration * (float) key / 30.0f;
+            float angle = std::sin((float) key / 30.0f * 6.28f + (float) bone) * amount;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3(0.0f, 0.1f, 0.0f);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::quat(std::cos(angle), std::sin(angle), 0.0f, 0.0f);
+
+            animData.m_scalingKeys[key].m_time = time;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+
+    animation.encode(duration, boneAnimation);
+}
+
+/**
+Poses a crowd with more and more layers turned on, up to all 4 of:
+a walk, jog, and run blend space over the base animation, an upper body aim masked to the spine,
+a full body additive breathing, and an additive flinch masked to one arm.
+Everything is on one thread so the numbers are per character work.
+*/
+void benchAnimationLayers() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    benchLayersWriteSkeleton("benchAnimationLayers.illskel");
+
+    illGraphics::Skeleton skeleton;
+
+    {
+        illGraphics::SkeletonLoadArgs loadArgs;
+        loadArgs.m_path = "benchAnimationLayers.illskel";
+        skeleton.load(loadArgs, NULL);
+    }
+
+    remove("benchAnimationLayers.illskel");
+
+    illGraphics::SkeletonAnimation idle;
+    illGraphics::SkeletonAnimation walk;
+    illGraphics::SkeletonAnimation jog;
+    illGraphics::SkeletonAnimation run;
+    illGraphics::SkeletonAnimation aim;
+    illGraphics::SkeletonAnimation breathe;
+    illGraphics::SkeletonAnimation flinch;
+
+    benchLayersMakeAnimation(idle, 2.0f, 0.1f);
+    benchLayersMakeAnimation(walk, 1.0f, 0.3f);
+    benchLayersMakeAnimation(jog, 0.8f, 0.4f);
+    benchLayersMakeAnimation(run, 0.6f, 0.5f);
+    benchLayersMakeAnimation(aim, 1.0f, 0.2f);
+    benchLayersMakeAnimation(breathe, 3.0f, 0.05f);
+    benchLayersMakeAnimation(flinch, 0.5f, 0.3f);
+
+    illGraphics::ModelAnimationSystem system;
+
+    for(unsigned int character = 0; character < BENCH_LAYERS_CHARACTERS; character++) {
+        illGraphics::ModelAnimationController * controller = system.addController(&skeleton);
+        controller->queueTransition(&idle, 0.0f, 0.0f, (float) character * 0.001f);
+
+        float speed = (float) (character % 10) / 9.0f;
+
+        size_t locomotion = controller->addLayer(illGraphics::ModelAnimationController::LayerMode::OVERRIDE);
+        controller->getLayer(locomotion).addAnimation(&walk, 1.0f - speed);
+        controller->getLayer(locomotion).addAnimation(&jog, 1.0f - std::abs(speed - 0.5f));
+        controller->getLayer(locomotion).addAnimation(&run, speed);
+        controller->getLayer(locomotion).m_synchronize = true;
+
+        size_t upperBody = controller->addLayer(illGraphics::ModelAnimationController::LayerMode::OVERRIDE);
+        controller->getLayer(upperBody).addAnimation(&aim, 1.0f);
+        controller->getLayer(upperBody).maskBoneSubtree(&skeleton, 8);
+
+        size_t breathing = controller->addLayer(illGraphics::ModelAnimationController::LayerMode::ADDITIVE, 0.5f);
+        controller->getLayer(breathing).addAnimation(&breathe, 1.0f, (float) character * 0.01f);
+
+        size_t flinching = controller->addLayer(illGraphics::ModelAnimationController::LayerMode::ADDITIVE, 0.7f);
+        controller->getLayer(flinching).addAnimation(&flinch, 1.0f);
+        controller->getLayer(flinching).maskBoneSubtree(&skeleton, 13);
+    }
+
+    long long baseTime = 0;
+
+    for(unsigned int numLayers = 0; numLayers <= BENCH_LAYERS_LAYERS; numLayers++) {
+        //layers at 0 weight are skipped entirely
+        for(unsigned int character = 0; character < BENCH_LAYERS_CHARACTERS; character++) {
+            illGraphics::ModelAnimationController& controller = system.getController(character);
+
+            for(unsigned int layer = 0; layer < BENCH_LAYERS_LAYERS; layer++) {
+                controller.getLayer(layer).m_weight = layer >= numLayers ? 0.0f : (layer == 2 ? 0.5f : (layer == 3 ? 0.7f : 1.0f));
+            }
+        }
+
+        //the first frame grows the scratch space for the layers
+        system.update(0.02f);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int frame = 0; frame < BENCH_LAYERS_FRAMES; frame++) {
+            system.update(1.0f / 60.0f);
+        }
+
+        long long time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count()
+            / BENCH_LAYERS_FRAMES;
+
+        if(numLayers == 0) {
+            baseTime = time;
+        }
+
+        LOG_INFO("Animating %u characters of %u bones with %u layers: %lld us per frame, %.1f ns per bone, %.2fx the base animation alone",
+            BENCH_LAYERS_CHARACTERS, (unsigned int) BENCH_LAYERS_BONES, numLayers, time,
+            (double) time * 1000.0 / (BENCH_LAYERS_CHARACTERS * BENCH_LAYERS_BONES), (double) time / (double) baseTime);
+    }
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmarks.h"
+#include "Logging/logging.h"
+#include "Util/Geometry/frustumCull.h"
+
+const unsigned int BENCH_BOX_BATCH_BOXES = 100000;
+const unsigned int BENCH_BOX_BATCH_RUNS = 100;
+
+inline float benchBoxBatchRandom(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+/**
+Culls a lot of boxes scattered around the camera, once testing each Box against the Frustum planes one at a time
+and once with the structure of arrays batch.
+*/
+void benchBoxBatch() {
+    Frustum<> frustum(glm::perspective(70.0f, 16.0f / 9.0f, 0.1f, 500.0f)
+        * glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, -0.1f, 0.6f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    std::vector<Box<> > boxList;
+    BoxBatch boxBatch;
+
+    srand(5678);
+
+    for(unsigned int box = 0; box < BENCH_BOX_BATCH_BOXES; box++) {
+        glm::vec3 center(benchBoxBatchRandom(-500.0f, 500.0f), benchBoxBatchRandom(-50.0f, 50.0f), benchBoxBatchRandom(-500.0f, 500.0f));
+        glm::vec3 halfDimensions(benchBoxBatchRandom(0.5f, 8.0f));
+
+        boxList.push_back(Box<>(center - halfDimensions, center + halfDimensions));
+        boxBatch.push_back(boxList.back());
+    }
+
+    //plain version
+    size_t numVisibleReference = 0;
+    long long referenceTime;
+
+    {
+        std::vector<uint8_t> visible(BENCH_BOX_BATCH_BOXES);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int run = 0; run < BENCH_BOX_BATCH_RUNS; run++) {
+            numVisibleReference = 0;
+
+            for(size_t box = 0; box < boxList.size(); box++) {
+                visible[box] = frustumBoxVisible(frustum, boxList[box]);
+                numVisibleReference += visible[box];
+            }
+        }
+
+        referenceTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    //batched version
+    size_t numVisible = 0;
+    long long batchTime;
+
+    {
+        std::vector<uint32_t> visibleMask((BENCH_BOX_BATCH_BOXES + 31) / 32);
+        FrustumCullPlanes planes(frustum);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int run = 0; run < BENCH_BOX_BATCH_RUNS; run++) {
+            numVisible = frustumCullBoxBatch(planes, boxBatch, visibleMask.data());
+        }
+
+        batchTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+#if defined(ILL_AVX)
+    const char * instructionSet = "AVX";
+#elif defined(ILL_SSE2)
+    const char * instructionSet = "SSE2";
+#else
+    const char * instructionSet = "no SIMD";
+#endif
+
+    LOG_INFO("Frustum culling %u boxes %u times: one at a time %lld us, %u visible.  Batched with %s %lld us, %u visible.",
+        BENCH_BOX_BATCH_BOXES, BENCH_BOX_BATCH_RUNS,
+        referenceTime, (unsigned int) numVisibleReference,
+        instructionSet, batchTime, (unsigned int) numVisible);
+}
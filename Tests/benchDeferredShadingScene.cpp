@@ -0,0 +1,215 @@
+#include <chrono>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmarks.h"
+#include "testUtil.h"
+#include "Logging/logging.h"
+#include "Util/parallel/ThreadPool.h"
+#include "Graphics/serial/Camera/Camera.h"
+#include "RendererCommon/serial/StaticMeshNode.h"
+#include "RendererCommon/serial/LightNode.h"
+#include "DeferredShadingRenderer/serial/DeferredShadingScene.h"
+#include "DeferredShadingRenderer/serial/Null/DeferredShadingBackendNull.h"
+
+using namespace illRendererCommon;
+using namespace illDeferredShadingRenderer;
+
+const unsigned int BENCH_CITY_BLOCKS = 100;            //blocks along each side of the city
+const unsigned int BENCH_CITY_BUILDINGS_PER_BLOCK = 2;
+const unsigned int BENCH_CITY_PROPS_PER_BLOCK = 2;
+const unsigned int BENCH_CITY_LIGHTS_PER_BLOCK = 1;
+const float BENCH_CITY_BLOCK_SIZE = 40.0f;
+const unsigned int BENCH_CITY_FRAMES = 100;
+
+const unsigned int BENCH_CITY_PROGRAMS = 8;
+const unsigned int BENCH_CITY_MATERIALS = 64;
+const unsigned int BENCH_CITY_MESHES = 256;
+
+/**
+Queues itself up the same way StaticMeshNode::render does, but with made up meshes and materials
+since real ones need a graphics context to load.
+*/
+class BenchCityNode : public StaticMeshNode {
+public:
+    BenchCityNode(GraphicsScene * scene, const glm::vec3& position, const Box<>& boundingVol, OccluderType occluderType, unsigned int id)
+        : StaticMeshNode(scene, glm::translate(glm::mat4(), position), boundingVol, occluderType),
+        m_id(id)
+    {
+        //the made up meshes fill their whole bounding box
+        m_occluderBounds = boundingVol;
+        m_hasOccluderBounds = true;
+    }
+
+    virtual void render(RenderQueues& renderQueues) {
+        for(uint8_t groupInd = 0; groupInd < 2; groupInd++) {
+            unsigned int program = (m_id + groupInd) % BENCH_CITY_PROGRAMS;
+            unsigned int material = (m_id * 7 + groupInd) % BENCH_CITY_MATERIALS;
+            unsigned int mesh = m_id % BENCH_CITY_MESHES;
+            uint64_t sortKey = RenderQueues::staticMeshSortKey(program, material, mesh, groupInd);
+
+            if(m_occluderType == OccluderType::ALWAYS || (m_occluderType == OccluderType::LIMITED && renderQueues.m_depthPassObjects < renderQueues.m_depthPassLimit)) {
+                auto& info = renderQueues.addDepthPassSolidStaticMesh(sortKey, fakePointer<illGraphics::ShaderProgram>(program),
+                    fakePointer<illGraphics::Material>(material), fakePointer<illGraphics::Mesh>(mesh));
+
+                info.m_node = this;
+                info.m_primitiveGroup = groupInd;
+
+                ++renderQueues.m_depthPassObjects;
+            }
+
+            auto& info = renderQueues.addSolidStaticMesh(sortKey, fakePointer<illGraphics::ShaderProgram>(program),
+                fakePointer<illGraphics::Material>(material), fakePointer<illGraphics::Mesh>(mesh));
+
+            info.m_meshInfo.m_node = this;
+            info.m_meshInfo.m_primitiveGroup = groupInd;
+
+            if(renderQueues.m_getSolidAffectingLights) {
+                info.m_affectingLights = &getAffectingLights();
+            }
+        }
+    }
+
+    unsigned int m_id;
+};
+
+/**
+A grid of city blocks, each with a couple of tall buildings that always occlude, some street props that are limited occluders,
+and a street light.
+*/
+struct BenchCity {
+    BenchCity(ThreadPool * threadPool, bool forwardLights,
+            DeferredShadingScene::OcclusionMode occlusionMode = DeferredShadingScene::OcclusionMode::HARDWARE_QUERIES)
+        : m_cellDimensions(25.0f),
+        m_interactionCellDimensions(50.0f),
+        m_scene(&m_backend, NULL, NULL,
+            m_cellDimensions, glm::uvec3((unsigned int) (BENCH_CITY_BLOCKS * BENCH_CITY_BLOCK_SIZE / 25.0f), 8, (unsigned int) (BENCH_CITY_BLOCKS * BENCH_CITY_BLOCK_SIZE / 25.0f)),
+            m_interactionCellDimensions, glm::uvec3((unsigned int) (BENCH_CITY_BLOCKS * BENCH_CITY_BLOCK_SIZE / 50.0f), 4, (unsigned int) (BENCH_CITY_BLOCKS * BENCH_CITY_BLOCK_SIZE / 50.0f)))
+    {
+        m_scene.m_threadPool = threadPool;
+        m_scene.m_occlusionMode = occlusionMode;
+        m_viewport = m_scene.registerViewport();
+
+        //shade the lights per object like a forward renderer would, which makes building the queues a lot more expensive
+        if(forwardLights) {
+            m_scene.getRenderQueues().m_getSolidAffectingLights = true;
+        }
+
+        //cells more than a few blocks away are behind buildings most of the time, and some closer ones are too
+        m_backend.m_cellVisibility = [] (const illGraphics::Camera& camera, unsigned int cellArrayIndex, size_t viewport) -> bool {
+            return (cellArrayIndex * 2654435769u) >> 30 != 0;
+        };
+
+        m_light = RefCountPtr<illGraphics::LightBase>(new illGraphics::PointLight(glm::vec3(1.0f), 1.0f, true, 5.0f, 20.0f));
+
+        uint32_t random = 12345;
+        unsigned int id = 0;
+
+        for(unsigned int blockZ = 0; blockZ < BENCH_CITY_BLOCKS; blockZ++) {
+            for(unsigned int blockX = 0; blockX < BENCH_CITY_BLOCKS; blockX++) {
+                glm::vec3 blockCorner(blockX * BENCH_CITY_BLOCK_SIZE, 0.0f, blockZ * BENCH_CITY_BLOCK_SIZE);
+
+                for(unsigned int building = 0; building < BENCH_CITY_BUILDINGS_PER_BLOCK; building++) {
+                    random = random * 1664525 + 1013904223;
+                    float height = 20.0f + (float) (random >> 24) / 255.0f * 150.0f;
+
+                    m_nodes.push_back(new BenchCityNode(&m_scene, blockCorner + glm::vec3(10.0f + building * 18.0f, 0.0f, 10.0f),
+                        Box<>(glm::vec3(-8.0f, 0.0f, -8.0f), glm::vec3(8.0f, height, 8.0f)), StaticMeshNode::OccluderType::ALWAYS, id++));
+                }
+
+                for(unsigned int prop = 0; prop < BENCH_CITY_PROPS_PER_BLOCK; prop++) {
+                    m_nodes.push_back(new BenchCityNode(&m_scene, blockCorner + glm::vec3(5.0f + prop * 25.0f, 0.0f, 35.0f),
+                        Box<>(glm::vec3(-2.0f, 0.0f, -2.0f), glm::vec3(2.0f, 3.0f, 2.0f)), StaticMeshNode::OccluderType::LIMITED, id++));
+                }
+
+                for(unsigned int light = 0; light < BENCH_CITY_LIGHTS_PER_BLOCK; light++) {
+                    LightNode * lightNode = new LightNode(&m_scene, glm::translate(glm::mat4(), blockCorner + glm::vec3(20.0f, 8.0f, 36.0f)),
+                        Box<>(glm::vec3(-20.0f), glm::vec3(20.0f)));
+                    lightNode->m_light = m_light;
+
+                    m_nodes.push_back(lightNode);
+                }
+            }
+        }
+    }
+
+    ~BenchCity() {
+        for(size_t node = 0; node < m_nodes.size(); node++) {
+            delete m_nodes[node];
+        }
+    }
+
+    /**
+    Flies the camera diagonally across the city a bit above the rooftops, returning the average microseconds per frame.
+    */
+    long long run() {
+        m_backend.resetStats();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int frame = 0; frame < BENCH_CITY_FRAMES; frame++) {
+            float progress = (float) frame / (float) BENCH_CITY_FRAMES;
+            glm::vec3 eye = glm::vec3(progress * 0.8f + 0.1f) * glm::vec3(BENCH_CITY_BLOCKS * BENCH_CITY_BLOCK_SIZE, 0.0f, BENCH_CITY_BLOCKS * BENCH_CITY_BLOCK_SIZE)
+                + glm::vec3(0.0f, 60.0f, 0.0f);
+
+            illGraphics::Camera camera;
+            camera.setPerspectiveTransform(glm::inverse(glm::lookAt(eye, eye + glm::vec3(1.0f, -0.1f, 0.6f), glm::vec3(0.0f, 1.0f, 0.0f))),
+                16.0f / 9.0f, 70.0f, 0.1f, 1500.0f);
+
+            m_scene.setupFrame();
+            m_scene.render(camera, m_viewport);
+        }
+
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count() / BENCH_CITY_FRAMES;
+    }
+
+    void logStats(const char * name, long long frameTime) {
+        const DeferredShadingBackendNull::Stats& stats = m_backend.getStats();
+
+        LOG_INFO("Scene %s: %lld us per frame.  Per frame: %d traversed cells, %d empty, %d culled, %d frustum culled and %d rendered nodes, %u cell queries, %u depth passes, %u depth pass objects, %u solid objects, %u light instances",
+            name, frameTime,
+            m_scene.m_debugNumTraversedCells, m_scene.m_debugNumEmptyCells, m_scene.m_debugNumCulledCells, m_scene.m_debugNumFrustumCulledNodes, m_scene.m_debugNumRenderedNodes,
+            (unsigned int) (stats.m_cellQueries / BENCH_CITY_FRAMES), (unsigned int) (stats.m_depthPasses / BENCH_CITY_FRAMES),
+            (unsigned int) (stats.m_depthPassObjects / BENCH_CITY_FRAMES), (unsigned int) (stats.m_solidObjects / BENCH_CITY_FRAMES),
+            (unsigned int) (stats.m_lightInstances / BENCH_CITY_FRAMES));
+    }
+
+    glm::vec3 m_cellDimensions;
+    glm::vec3 m_interactionCellDimensions;
+    DeferredShadingBackendNull m_backend;
+    DeferredShadingScene m_scene;
+    size_t m_viewport;
+    RefCountPtr<illGraphics::LightBase> m_light;
+    std::vector<GraphicsNode *> m_nodes;
+};
+
+void benchDeferredShadingScene() {
+    ThreadPool threadPool;
+
+    LOG_INFO("Scene benchmark city: %u static meshes, %u lights, %u worker threads",
+        BENCH_CITY_BLOCKS * BENCH_CITY_BLOCKS * (BENCH_CITY_BUILDINGS_PER_BLOCK + BENCH_CITY_PROPS_PER_BLOCK),
+        BENCH_CITY_BLOCKS * BENCH_CITY_BLOCKS * BENCH_CITY_LIGHTS_PER_BLOCK,
+        (unsigned int) threadPool.getNumThreads());
+
+    for(int forwardLights = 0; forwardLights < 2; forwardLights++) {
+        {
+            BenchCity city(NULL, forwardLights != 0);
+            long long frameTime = city.run();
+            city.logStats(forwardLights ? "serial, forward lights" : "serial", frameTime);
+        }
+
+        {
+            BenchCity city(&threadPool, forwardLights != 0);
+            long long frameTime = city.run();
+            city.logStats(forwardLights ? "parallel, forward lights" : "parallel", frameTime);
+        }
+    }
+
+    //the buildings hide most of the city from the software occlusion buffer in the same frame
+    {
+        BenchCity city(NULL, false, DeferredShadingScene::OcclusionMode::SOFTWARE);
+        long long frameTime = city.run();
+        city.logStats("software occlusion", frameTime);
+    }
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdio>
+
+#include "benchmarks.h"
+#include "Logging/logging.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/Illmesh/IllmeshLoader.h"
+#include "Util/Illmesh/IllmeshWriter.h"
+
+const uint32_t BENCH_ILLMESH_VERTICES = 100000;
+const uint32_t BENCH_ILLMESH_INDICES = 60000;         //ILLMESH1 can't store more than 65535
+const unsigned int BENCH_ILLMESH_LOADS = 20;
+
+/**
+Loads the same mesh file a bunch of times the way Mesh::reload does, returning the average microseconds per load.
+*/
+long long benchIllmeshLoad(const char * path) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(unsigned int load = 0; load < BENCH_ILLMESH_LOADS; load++) {
+        IllmeshLoader meshLoader(path);
+
+        MeshData<> mesh(meshLoader.m_numInd, meshLoader.m_numVert, meshLoader.m_numGroups, meshLoader.m_features, true, meshLoader.m_indexSize);
+        meshLoader.buildMesh(mesh);
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count() / BENCH_ILLMESH_LOADS;
+}
+
+void benchIllmesh() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    //the default features, positions, normals, tangents, and texture coordinates, forced to 16 bit indices so ILLMESH1 can store it
+    MeshData<> mesh(BENCH_ILLMESH_INDICES, BENCH_ILLMESH_VERTICES, 1, MF_POSITION | MF_NORMAL | MF_TANGENT | MF_TEX_COORD, true, sizeof(uint16_t));
+
+    {
+        float * vertexData = reinterpret_cast<float *>(mesh.getData());
+        size_t numElements = (size_t) mesh.getNumVert() * mesh.getVertexSize() / sizeof(float);
+
+        for(size_t element = 0; element < numElements; element++) {
+            vertexData[element] = (float) (element % 1000) * 0.01f;
+        }
+
+        for(uint32_t index = 0; index < mesh.getNumInd(); index++) {
+            mesh.getIndices()[index] = (uint16_t) (index * 7 % 65536);
+        }
+
+        mesh.getPrimitiveGroup(0).m_type = MeshData<>::PrimitiveGroup::Type::TRIANGLES;
+        mesh.getPrimitiveGroup(0).m_beginIndex = 0;
+        mesh.getPrimitiveGroup(0).m_numIndices = BENCH_ILLMESH_INDICES;
+    }
+
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("benchIllmesh1.illmesh");
+        writeIllmesh1(mesh, file);
+        delete file;
+    }
+
+    convertIllmesh("benchIllmesh1.illmesh", "benchIllmesh2.illmesh");
+
+    double megabytes = (double) (mesh.getNumVert() * mesh.getVertexSize() + mesh.getNumInd() * sizeof(uint16_t)) / (1024.0 * 1024.0);
+
+    long long illmesh1Time = benchIllmeshLoad("benchIllmesh1.illmesh");
+    long long illmesh2Time = benchIllmeshLoad("benchIllmesh2.illmesh");
+
+    LOG_INFO("Illmesh load, %u vertices, %u indices: ILLMESH1 %lld us (%.1f MB/s), ILLMESH2 %lld us (%.1f MB/s)",
+        BENCH_ILLMESH_VERTICES, BENCH_ILLMESH_INDICES,
+        illmesh1Time, megabytes / ((double) illmesh1Time * 1e-6),
+        illmesh2Time, megabytes / ((double) illmesh2Time * 1e-6));
+
+    remove("benchIllmesh1.illmesh");
+    remove("benchIllmesh2.illmesh");
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
+
+#include "benchmarks.h"
+#include "testSkeletonUtil.h"
+#include "Logging/logging.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/parallel/ThreadPool.h"
+#include "Graphics/serial/Model/Skeleton.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+#include "Graphics/serial/Model/ModelAnimationSystem.h"
+
+const uint16_t BENCH_ANIMATION_SYSTEM_BONES = 80;
+const unsigned int BENCH_ANIMATION_SYSTEM_CHARACTERS = 2000;
+const unsigned int BENCH_ANIMATION_SYSTEM_FRAMES = 20;
+
+/**
+Writes an ILLSKEL0 file with a spine of every 4th bone and 3 bone chains coming off of it.
+*/
+void benchAnimationSystemWriteSkeleton(const char * path) {
+    std::vector<glm::mat4> relativeTransforms(BENCH_ANIMATION_SYSTEM_BONES);
+    std::vector<glm::mat4> offsetTransforms(BENCH_ANIMATION_SYSTEM_BONES);
+    std::vector<uint16_t> parents(BENCH_ANIMATION_SYSTEM_BONES);
+
+    for(uint16_t bone = 0; bone < BENCH_ANIMATION_SYSTEM_BONES; bone++) {
+        relativeTransforms[bone] = glm::translate(glm::vec3(0.0f, 0.1f, 0.0f));
+        offsetTransforms[bone] = glm::translate(glm::vec3(0.0f, -0.1f * (float) (bone % 8), 0.0f));
+        parents[bone] = bone == 0 ? 0 : (bone % 4 == 0 ? bone - 4 : bone - 1);
+    }
+
+    writeTestSkeleton(path, relativeTransforms, offsetTransforms, parents);
+}
+
+void benchAnimationSystemMakeAnimation(illGraphics::SkeletonAnimation& animation, float speed) {
+    illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+
+    for(uint16_t bone = 0; bone < BENCH_ANIMATION_SYSTEM_BONES; bone++) {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[bone];
+
+        animData.m_positionKeys.resize(31);
+        animData.m_rotationKeys.resize(31);
+        animData.m_scalingKeys.resize(31);
+
+        for(unsigned int key = 0; key <= 30; key++) {
+            float time = (float) key / 30.0f;
+            float angle = std::sin(time * 6.28f * speed + (float) bone) * 0.5f;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3(0.0f, 0.1f, 0.0f);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::quat(std::cos(angle), std::sin(angle), 0.0f, 0.0f);
+
+            animData.m_scalingKeys[key].m_time = time;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+
+    animation.encode(1.0f, boneAnimation);
+}
+
+/**
+Updates a crowd with 1 thread up to as many as there are hardware threads, checking the palette comes out the same every time.
+Every 4th character is transitioning between animations the whole time, which is about twice the work of the others.
+*/
+void benchModelAnimationSystem() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    benchAnimationSystemWriteSkeleton("benchModelAnimationSystem.illskel");
+
+    illGraphics::Skeleton skeleton;
+
+    {
+        illGraphics::SkeletonLoadArgs loadArgs;
+        loadArgs.m_path = "benchModelAnimationSystem.illskel";
+        skeleton.load(loadArgs, NULL);
+    }
+
+    remove("benchModelAnimationSystem.illskel");
+
+    illGraphics::SkeletonAnimation walk;
+    illGraphics::SkeletonAnimation run;
+    benchAnimationSystemMakeAnimation(walk, 1.0f);
+    benchAnimationSystemMakeAnimation(run, 2.0f);
+
+    unsigned int maxThreads = std::thread::hardware_concurrency();
+
+    if(maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    std::vector<glm::mat4> firstPalette;
+    long long singleThreadTime = 0;
+
+    for(unsigned int numThreads = 1; numThreads <= maxThreads; numThreads++) {
+        ThreadPool threadPool(numThreads - 1);
+        illGraphics::ModelAnimationSystem system(&threadPool);
+
+        for(unsigned int character = 0; character < BENCH_ANIMATION_SYSTEM_CHARACTERS; character++) {
+            illGraphics::ModelAnimationController * controller = system.addController(&skeleton);
+
+            controller->queueTransition(&walk, 0.0f, 0.0f, (float) character * 0.001f);
+
+            if(character % 4 == 0) {
+                controller->queueTransition(&run, 1000.0f, 0.01f);
+            }
+        }
+
+        //the first frame starts the animations
+        system.update(0.02f);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int frame = 0; frame < BENCH_ANIMATION_SYSTEM_FRAMES; frame++) {
+            system.update(1.0f / 60.0f);
+        }
+
+        long long time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        bool same = true;
+
+        if(numThreads == 1) {
+            firstPalette.assign(system.getPalette(), system.getPalette() + system.getPaletteSize());
+            singleThreadTime = time;
+        }
+        else {
+            same = memcmp(&firstPalette[0], system.getPalette(), firstPalette.size() * sizeof(glm::mat4)) == 0;
+        }
+
+        LOG_INFO("Animating %u characters of %u bones with %u threads: %lld us per frame, %.2fx speedup, %s as 1 thread",
+            BENCH_ANIMATION_SYSTEM_CHARACTERS, (unsigned int) BENCH_ANIMATION_SYSTEM_BONES, numThreads,
+            time / BENCH_ANIMATION_SYSTEM_FRAMES, (double) singleThreadTime / (double) time, same ? "same palette" : "DIFFERENT PALETTE");
+    }
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
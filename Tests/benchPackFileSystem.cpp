@@ -0,0 +1,116 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define benchPackMkdir(path) _mkdir(path)
+#define benchPackRmdir(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define benchPackMkdir(path) mkdir(path, 0755)
+#define benchPackRmdir(path) rmdir(path)
+#endif
+
+#include "benchmarks.h"
+#include "Logging/logging.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem-Pack/PackFileSystem.h"
+#include "FileSystem-Pack/PackWriter.h"
+
+const unsigned int BENCH_PACK_NUM_FILES = 50000;
+
+/**
+Opens and reads every file once the way a resource loader would, returning the total microseconds.
+*/
+long long benchPackReadAll(const illFileSystem::FileSystem& fileSystem, const std::vector<std::string>& paths, size_t& totalSize) {
+    std::vector<uint8_t> data;
+    totalSize = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(size_t path = 0; path < paths.size(); path++) {
+        illFileSystem::File * file = fileSystem.openRead(paths[path].c_str());
+
+        data.resize(file->getSize());
+        file->read(&data[0], data.size());
+        totalSize += data.size();
+
+        delete file;
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void benchPackFileSystem() {
+    illStdio::StdioFileSystem stdioFileSystem;
+
+    //lots of small files like materials and shaders, between 64 bytes and 2kb
+    benchPackMkdir("benchPack");
+
+    std::vector<std::string> paths(BENCH_PACK_NUM_FILES);
+    std::vector<uint8_t> data(2048);
+
+    for(size_t byte = 0; byte < data.size(); byte++) {
+        data[byte] = (uint8_t) (byte * 13);
+    }
+
+    {
+        illFileSystem::File * packFile = stdioFileSystem.openWrite("benchPack.illpack");
+        illPack::PackWriter writer(packFile);
+
+        for(unsigned int fileInd = 0; fileInd < BENCH_PACK_NUM_FILES; fileInd++) {
+            char path[64];
+            sprintf(path, "benchPack/file%u.mat", fileInd);
+            paths[fileInd] = path;
+
+            size_t size = 64 + (fileInd * 2654435761u >> 8) % (data.size() - 64);
+
+            illFileSystem::File * file = stdioFileSystem.openWrite(path);
+            file->write(&data[0], size);
+            delete file;
+
+            writer.addFile(path, &data[0], size);
+        }
+
+        writer.finish();
+        delete packFile;
+    }
+
+    //the loose files were just written so they're in the OS file cache same as the pack is once it's mapped
+    size_t stdioSize;
+    long long stdioTime = benchPackReadAll(stdioFileSystem, paths, stdioSize);
+
+    size_t packSize;
+    long long mountTime;
+    long long packTime;
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        illPack::PackFileSystem packFileSystem;
+        packFileSystem.addPath("benchPack.illpack");
+
+        mountTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        packTime = benchPackReadAll(packFileSystem, paths, packSize);
+    }
+
+    assert(stdioSize == packSize);
+
+    LOG_INFO("Open and read %u files, %u bytes: stdio %lld ms (%.2f us per file), pack %lld ms (%.2f us per file) plus %lld us to mount",
+        BENCH_PACK_NUM_FILES, (unsigned int) packSize,
+        stdioTime / 1000, (double) stdioTime / BENCH_PACK_NUM_FILES,
+        packTime / 1000, (double) packTime / BENCH_PACK_NUM_FILES,
+        mountTime);
+
+    for(size_t path = 0; path < paths.size(); path++) {
+        remove(paths[path].c_str());
+    }
+
+    benchPackRmdir("benchPack");
+    remove("benchPack.illpack");
+}
@@ -0,0 +1,154 @@
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+
+#include "benchmarks.h"
+#include "testUtil.h"
+#include "Logging/logging.h"
+#include "RendererCommon/serial/RenderQueues.h"
+
+using namespace illRendererCommon;
+
+const size_t BENCH_QUEUE_ENTRIES = 100000;
+const unsigned int BENCH_QUEUE_FRAMES = 10;
+
+const unsigned int BENCH_QUEUE_PROGRAMS = 8;
+const unsigned int BENCH_QUEUE_MATERIALS = 128;
+const unsigned int BENCH_QUEUE_MESHES = 512;
+
+struct BenchQueueEntry {
+    unsigned int m_program;
+    unsigned int m_material;
+    unsigned int m_mesh;
+    uint8_t m_primitiveGroup;
+};
+
+/**
+Fills the queues with the entries and drains them the way a backend would, counting state changes.
+Returns the time spent in microseconds.
+*/
+long long benchFillAndDrain(RenderQueues& queues, const BenchQueueEntry * entries, size_t& stateChanges, size_t& drained) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(size_t entryInd = 0; entryInd < BENCH_QUEUE_ENTRIES; entryInd++) {
+        const BenchQueueEntry& entry = entries[entryInd];
+
+        auto& info = queues.addSolidStaticMesh(
+            RenderQueues::staticMeshSortKey(entry.m_program, entry.m_material, entry.m_mesh, entry.m_primitiveGroup),
+            fakePointer<illGraphics::ShaderProgram>(entry.m_program),
+            fakePointer<illGraphics::Material>(entry.m_material),
+            fakePointer<illGraphics::Mesh>(entry.m_mesh));
+
+        info.m_meshInfo.m_node = fakePointer<StaticMeshNode>((unsigned int) entryInd);
+        info.m_meshInfo.m_primitiveGroup = entry.m_primitiveGroup;
+    }
+
+    stateChanges = 0;
+    drained = 0;
+
+    if(queues.m_useSortedQueues) {
+        queues.sort();
+
+        const illGraphics::ShaderProgram * currentProgram = NULL;
+        const illGraphics::Material * currentMaterial = NULL;
+        const illGraphics::Mesh * currentMesh = NULL;
+        uint64_t lastKey = 0;
+
+        for(size_t entry = 0; entry < queues.m_sortedSolidStaticMeshes.size(); entry++) {
+            const auto& payload = queues.m_sortedSolidStaticMeshes[entry];
+
+            //make sure the radix sort did its job
+            uint64_t key = queues.m_sortedSolidStaticMeshes.m_keys[entry].m_key;
+            assert(key >= lastKey);
+            lastKey = key;
+
+            if(payload.m_program != currentProgram) {
+                currentProgram = payload.m_program;
+                currentMaterial = NULL;
+                ++stateChanges;
+            }
+
+            if(payload.m_material != currentMaterial) {
+                currentMaterial = payload.m_material;
+                currentMesh = NULL;
+                ++stateChanges;
+            }
+
+            if(payload.m_mesh != currentMesh) {
+                currentMesh = payload.m_mesh;
+                ++stateChanges;
+            }
+
+            if(payload.m_info.m_meshInfo.m_node) {
+                ++drained;
+            }
+        }
+    }
+    else {
+        for(auto shaderIter = queues.m_solidStaticMeshes.begin(); shaderIter != queues.m_solidStaticMeshes.end(); shaderIter++) {
+            ++stateChanges;
+
+            for(auto materialIter = shaderIter->second.begin(); materialIter != shaderIter->second.end(); materialIter++) {
+                ++stateChanges;
+
+                for(auto meshIter = materialIter->second.begin(); meshIter != materialIter->second.end(); meshIter++) {
+                    ++stateChanges;
+
+                    for(auto nodeIter = meshIter->second.begin(); nodeIter != meshIter->second.end(); nodeIter++) {
+                        if(nodeIter->m_meshInfo.m_node) {
+                            ++drained;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    queues.clear();
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void benchRenderQueues() {
+    BenchQueueEntry * entries = new BenchQueueEntry[BENCH_QUEUE_ENTRIES];
+
+    srand(1234);
+
+    for(size_t entryInd = 0; entryInd < BENCH_QUEUE_ENTRIES; entryInd++) {
+        entries[entryInd].m_program = rand() % BENCH_QUEUE_PROGRAMS;
+        entries[entryInd].m_material = rand() % BENCH_QUEUE_MATERIALS;
+        entries[entryInd].m_mesh = rand() % BENCH_QUEUE_MESHES;
+        entries[entryInd].m_primitiveGroup = (uint8_t) (rand() % 4);
+    }
+
+    RenderQueues mapQueues;
+    mapQueues.m_useSortedQueues = false;
+
+    RenderQueues sortedQueues;
+    sortedQueues.m_useSortedQueues = true;
+
+    long long mapTime = 0;
+    long long sortedTime = 0;
+
+    for(unsigned int frame = 0; frame < BENCH_QUEUE_FRAMES; frame++) {
+        size_t mapStateChanges;
+        size_t mapDrained;
+        mapTime += benchFillAndDrain(mapQueues, entries, mapStateChanges, mapDrained);
+
+        size_t sortedStateChanges;
+        size_t sortedDrained;
+        sortedTime += benchFillAndDrain(sortedQueues, entries, sortedStateChanges, sortedDrained);
+
+        assert(mapDrained == BENCH_QUEUE_ENTRIES);
+        assert(sortedDrained == BENCH_QUEUE_ENTRIES);
+
+        //both should end up binding each shader, material, and mesh combination exactly once
+        assert(mapStateChanges == sortedStateChanges);
+    }
+
+    LOG_INFO("Render queues, %u entries over %u frames: maps %lld us per frame, sorted keys %lld us per frame",
+        (unsigned int) BENCH_QUEUE_ENTRIES, BENCH_QUEUE_FRAMES, 
+        mapTime / BENCH_QUEUE_FRAMES, sortedTime / BENCH_QUEUE_FRAMES);
+
+    delete[] entries;
+}
@@ -0,0 +1,206 @@
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <unordered_set>
+
+#include "benchmarks.h"
+#include "Logging/logging.h"
+#include "Util/serial/SparseCellStorage.h"
+
+const unsigned int BENCH_CELLS_DIMENSION = 64;
+const unsigned int BENCH_CELLS = BENCH_CELLS_DIMENSION * BENCH_CELLS_DIMENSION * BENCH_CELLS_DIMENSION;
+const unsigned int BENCH_CELLS_NODES = 20000;
+const unsigned int BENCH_CELLS_FRAMES = 10;
+
+struct BenchCellNode {
+    unsigned int m_min[3];
+    unsigned int m_size[3];
+    SparseCellLocationList m_locations;
+};
+
+size_t g_benchCellsHeapBytes = 0;
+
+/**
+Counts how much memory the old style per cell sets take including their buckets and nodes.
+*/
+template <typename T>
+struct BenchCountingAllocator : public std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        typedef BenchCountingAllocator<U> other;
+    };
+
+    BenchCountingAllocator() {}
+
+    template <typename U>
+    BenchCountingAllocator(const BenchCountingAllocator<U>&) {}
+
+    T * allocate(size_t num, const void * = NULL) {
+        g_benchCellsHeapBytes += num * sizeof(T);
+        return std::allocator<T>::allocate(num);
+    }
+
+    void deallocate(T * ptr, size_t num) {
+        g_benchCellsHeapBytes -= num * sizeof(T);
+        std::allocator<T>::deallocate(ptr, num);
+    }
+};
+
+typedef std::unordered_set<BenchCellNode *, std::hash<BenchCellNode *>, std::equal_to<BenchCellNode *>, BenchCountingAllocator<BenchCellNode *> > BenchDenseCell;
+
+inline unsigned int benchCellIndex(unsigned int x, unsigned int y, unsigned int z) {
+    return x + BENCH_CELLS_DIMENSION * (y + BENCH_CELLS_DIMENSION * z);
+}
+
+/**
+Walks every cell the way the renderer walks the cells in a frustum, skipping empty ones and touching every node.
+*/
+template <typename Cells>
+inline size_t benchWalkCells(const Cells& getCell) {
+    size_t res = 0;
+
+    for(unsigned int cell = 0; cell < BENCH_CELLS; cell++) {
+        const auto& cellContents = getCell(cell);
+
+        if(cellContents.empty()) {
+            continue;
+        }
+
+        for(auto iter = cellContents.begin(); iter != cellContents.end(); iter++) {
+            res += (*iter)->m_size[0];
+        }
+    }
+
+    return res;
+}
+
+void benchSceneCells() {
+    std::vector<BenchCellNode> nodes(BENCH_CELLS_NODES);
+
+    srand(2468);
+
+    //most of the world is empty, nodes cluster in a few areas like a real level
+    for(unsigned int nodeInd = 0; nodeInd < BENCH_CELLS_NODES; nodeInd++) {
+        for(unsigned int dim = 0; dim < 3; dim++) {
+            nodes[nodeInd].m_size[dim] = 1 + rand() % 2;
+            nodes[nodeInd].m_min[dim] = (dim == 1 ? 0 : (rand() % 4) * 16) + rand() % 14;
+        }
+    }
+
+    //old layout, a set per cell
+    size_t denseBaseBytes = g_benchCellsHeapBytes;
+    BenchDenseCell * denseCells = new BenchDenseCell[BENCH_CELLS];
+    size_t denseEmptyBytes = g_benchCellsHeapBytes - denseBaseBytes + BENCH_CELLS * sizeof(BenchDenseCell);
+
+    //new layout
+    SparseCellStorage<BenchCellNode *> sparseCells;
+
+    long long denseFillTime;
+    long long sparseFillTime;
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int nodeInd = 0; nodeInd < BENCH_CELLS_NODES; nodeInd++) {
+            BenchCellNode& node = nodes[nodeInd];
+
+            for(unsigned int z = node.m_min[2]; z < node.m_min[2] + node.m_size[2]; z++)
+            for(unsigned int y = node.m_min[1]; y < node.m_min[1] + node.m_size[1]; y++)
+            for(unsigned int x = node.m_min[0]; x < node.m_min[0] + node.m_size[0]; x++) {
+                denseCells[benchCellIndex(x, y, z)].insert(&node);
+            }
+        }
+
+        denseFillTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int nodeInd = 0; nodeInd < BENCH_CELLS_NODES; nodeInd++) {
+            BenchCellNode& node = nodes[nodeInd];
+
+            for(unsigned int z = node.m_min[2]; z < node.m_min[2] + node.m_size[2]; z++)
+            for(unsigned int y = node.m_min[1]; y < node.m_min[1] + node.m_size[1]; y++)
+            for(unsigned int x = node.m_min[0]; x < node.m_min[0] + node.m_size[0]; x++) {
+                sparseCells.add(benchCellIndex(x, y, z), &node, &node.m_locations);
+            }
+        }
+
+        sparseFillTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    size_t denseBytes = g_benchCellsHeapBytes - denseBaseBytes + BENCH_CELLS * sizeof(BenchDenseCell);
+    size_t sparseBytes = sparseCells.getMemoryUsage();
+
+    //iteration
+    long long denseWalkTime = 0;
+    long long sparseWalkTime = 0;
+
+    for(unsigned int frame = 0; frame < BENCH_CELLS_FRAMES; frame++) {
+        size_t denseSum;
+        size_t sparseSum;
+
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            denseSum = benchWalkCells([&](unsigned int cell) -> const BenchDenseCell& { return denseCells[cell]; });
+            denseWalkTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            sparseSum = benchWalkCells([&](unsigned int cell) -> const SparseCellStorage<BenchCellNode *>::Cell& { return sparseCells.getCell(cell); });
+            sparseWalkTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        assert(denseSum == sparseSum);
+    }
+
+    //removal
+    long long denseRemoveTime;
+    long long sparseRemoveTime;
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int nodeInd = 0; nodeInd < BENCH_CELLS_NODES; nodeInd++) {
+            BenchCellNode& node = nodes[nodeInd];
+
+            for(unsigned int z = node.m_min[2]; z < node.m_min[2] + node.m_size[2]; z++)
+            for(unsigned int y = node.m_min[1]; y < node.m_min[1] + node.m_size[1]; y++)
+            for(unsigned int x = node.m_min[0]; x < node.m_min[0] + node.m_size[0]; x++) {
+                denseCells[benchCellIndex(x, y, z)].erase(&node);
+            }
+        }
+
+        denseRemoveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int nodeInd = 0; nodeInd < BENCH_CELLS_NODES; nodeInd++) {
+            sparseCells.removeAll(&nodes[nodeInd].m_locations);
+        }
+
+        sparseRemoveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    assert(sparseCells.getNumOccupiedCells() == 0);
+
+    LOG_INFO("Scene cells, %u cells, %u nodes: empty cell costs %u bytes in a set per cell, 1 bit sparse",
+        BENCH_CELLS, BENCH_CELLS_NODES, (unsigned int) (denseEmptyBytes / BENCH_CELLS));
+
+    LOG_INFO("Scene cells memory: set per cell %f MB, sparse %f MB",
+        (float) denseBytes / 1024.0f / 1024.0f, (float) sparseBytes / 1024.0f / 1024.0f);
+
+    LOG_INFO("Scene cells fill: set per cell %lld us, sparse %lld us", denseFillTime, sparseFillTime);
+
+    LOG_INFO("Scene cells walk: set per cell %lld us per frame, sparse %lld us per frame", 
+        denseWalkTime / BENCH_CELLS_FRAMES, sparseWalkTime / BENCH_CELLS_FRAMES);
+
+    LOG_INFO("Scene cells remove: set per cell %lld us, sparse %lld us", denseRemoveTime, sparseRemoveTime);
+
+    delete[] denseCells;
+}
@@ -0,0 +1,276 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "benchmarks.h"
+#include "Logging/logging.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem/File.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+
+const uint16_t BENCH_ANIM_BONES = 100;
+const uint16_t BENCH_ANIM_KEYS = 600;            //per bone for each of position, rotation, and scaling
+const unsigned int BENCH_ANIM_LOADS = 10;
+const unsigned int BENCH_ANIM_FRAMES = 1000;      //frames sampled at 60 fps for the decode benchmark
+
+/**
+Writes an ILLANIM0 file with every bone animated, a long cutscene basically.
+*/
+void benchSkeletonAnimationWrite(illFileSystem::FileSystem * fileSystem, const char * path) {
+    illFileSystem::File * file = fileSystem->openWrite(path);
+
+    file->writeB64(0x494C4C414E494D30);     //ILLANIM0
+    file->writeLF((float) BENCH_ANIM_KEYS / 30.0f);
+    file->writeL16(BENCH_ANIM_BONES);
+
+    for(uint16_t bone = 0; bone < BENCH_ANIM_BONES; bone++) {
+        file->writeL16(bone);
+
+        //positions, rotations, scaling
+        for(unsigned int keyType = 0; keyType < 3; keyType++) {
+            file->writeL16(BENCH_ANIM_KEYS);
+
+            for(uint16_t key = 0; key < BENCH_ANIM_KEYS; key++) {
+                file->writeLF((float) key / 30.0f);
+                file->writeLF((float) bone);
+                file->writeLF((float) key);
+                file->writeLF(1.0f);
+
+                if(keyType == 1) {
+                    file->writeLF(0.0f);
+                }
+            }
+        }
+    }
+
+    delete file;
+}
+
+/**
+Loads the animation a bunch of times, returning the average microseconds per load.
+*/
+long long benchSkeletonAnimationLoad(const char * path) {
+    illGraphics::SkeletonAnimationLoadArgs loadArgs;
+    loadArgs.m_path = path;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(unsigned int load = 0; load < BENCH_ANIM_LOADS; load++) {
+        illGraphics::SkeletonAnimation animation;
+        animation.load(loadArgs, NULL);
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count() / BENCH_ANIM_LOADS;
+}
+
+/**
+Makes smooth made up motion for every bone, closer to real motion capture than the straight lines in the file benchmark
+so the encoder has something to do.
+*/
+void benchSkeletonAnimationMotion(illGraphics::SkeletonAnimation::BoneAnimationMap& boneAnimation) {
+    for(uint16_t bone = 0; bone < BENCH_ANIM_BONES; bone++) {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[bone];
+
+        animData.m_positionKeys.resize(BENCH_ANIM_KEYS);
+        animData.m_rotationKeys.resize(BENCH_ANIM_KEYS);
+        animData.m_scalingKeys.resize(BENCH_ANIM_KEYS);
+
+        float phase = (float) bone * 0.37f;
+
+        for(uint16_t key = 0; key < BENCH_ANIM_KEYS; key++) {
+            float time = (float) key / 30.0f;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3(std::sin(time + phase), std::cos(time * 0.5f + phase) * 2.0f, (float) bone);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::normalize(glm::quat(1.0f, std::sin(time * 2.0f + phase) * 0.3f, std::cos(time + phase) * 0.2f, 0.1f));
+
+            //most real bones don't scale
+            animData.m_scalingKeys[key].m_time = time;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+}
+
+/**
+Samples every bone for a bunch of frames like a character playing the animation, returning the nanoseconds per bone sample.
+Sums up the positions so the work doesn't get optimized out.
+*/
+double benchSkeletonAnimationDecodeRaw(const illGraphics::SkeletonAnimation::BoneAnimationMap& boneAnimation, float duration, float& checksum) {
+    std::vector<const illGraphics::SkeletonAnimation::AnimData *> bones(BENCH_ANIM_BONES);
+    std::vector<illGraphics::LastFrameInfo> lastFrameInfo(BENCH_ANIM_BONES);
+
+    for(uint16_t bone = 0; bone < BENCH_ANIM_BONES; bone++) {
+        bones[bone] = &boneAnimation.at(bone);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(unsigned int frame = 0; frame < BENCH_ANIM_FRAMES; frame++) {
+        float time = (float) frame / 60.0f;
+
+        for(uint16_t bone = 0; bone < BENCH_ANIM_BONES; bone++) {
+            checksum += bones[bone]->getTransform(time, duration, lastFrameInfo[bone]).m_position.x;
+        }
+    }
+
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count()
+        / (BENCH_ANIM_FRAMES * BENCH_ANIM_BONES);
+}
+
+double benchSkeletonAnimationDecode(const illGraphics::SkeletonAnimation& animation, float& checksum) {
+    std::vector<illGraphics::LastFrameInfo> lastFrameInfo(BENCH_ANIM_BONES);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(unsigned int frame = 0; frame < BENCH_ANIM_FRAMES; frame++) {
+        float time = (float) frame / 60.0f;
+
+        for(uint16_t bone = 0; bone < BENCH_ANIM_BONES; bone++) {
+            Transform<> transform;
+            animation.getTransform(bone, time, transform, lastFrameInfo[bone]);
+            checksum += transform.m_position.x;
+        }
+    }
+
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count()
+        / (BENCH_ANIM_FRAMES * BENCH_ANIM_BONES);
+}
+
+/**
+Samples every bone at each of the given times in order, keeping a cursor per bone, returning the nanoseconds per bone sample.
+*/
+double benchSkeletonAnimationSeek(const illGraphics::SkeletonAnimation& animation, const std::vector<float>& times, float& checksum) {
+    std::vector<illGraphics::LastFrameInfo> lastFrameInfo(BENCH_ANIM_BONES);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(size_t frame = 0; frame < times.size(); frame++) {
+        for(uint16_t bone = 0; bone < BENCH_ANIM_BONES; bone++) {
+            Transform<> transform;
+            animation.getTransform(bone, times[frame], transform, lastFrameInfo[bone]);
+            checksum += transform.m_position.x;
+        }
+    }
+
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count()
+        / (times.size() * BENCH_ANIM_BONES);
+}
+
+void benchSkeletonAnimation() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    benchSkeletonAnimationWrite(&stdioFileSystem, "benchSkeletonAnimation.illanim");
+
+    stdioFileSystem.setReadBufferSize(0);
+    long long unbufferedTime = benchSkeletonAnimationLoad("benchSkeletonAnimation.illanim");
+
+    stdioFileSystem.setReadBufferSize(illFileSystem::DEFAULT_READ_BUFFER_SIZE);
+    long long bufferedTime = benchSkeletonAnimationLoad("benchSkeletonAnimation.illanim");
+
+    LOG_INFO("SkeletonAnimation::reload, %u bones with %u keys each: unbuffered %lld us, buffered %lld us (%u byte buffer)",
+        (unsigned int) BENCH_ANIM_BONES, (unsigned int) BENCH_ANIM_KEYS * 3,
+        unbufferedTime, bufferedTime, (unsigned int) illFileSystem::DEFAULT_READ_BUFFER_SIZE);
+
+    //the compressed format loads with one read per block instead of a few per key and has no encoding to do
+    {
+        illGraphics::SkeletonAnimation animation;
+        illGraphics::SkeletonAnimationLoadArgs loadArgs;
+        loadArgs.m_path = "benchSkeletonAnimation.illanim";
+        animation.load(loadArgs, NULL);
+
+        illFileSystem::File * file = stdioFileSystem.openWrite("benchSkeletonAnimation.illanim1");
+        animation.writeIllanim1(file);
+        delete file;
+    }
+
+    long long illanim1Time = benchSkeletonAnimationLoad("benchSkeletonAnimation.illanim1");
+
+    LOG_INFO("SkeletonAnimation::reload, ILLANIM0 encoded on load %lld us, ILLANIM1 %lld us", bufferedTime, illanim1Time);
+
+    remove("benchSkeletonAnimation.illanim");
+    remove("benchSkeletonAnimation.illanim1");
+
+    //decoding the compressed keys versus interpolating the raw ones
+    {
+        illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+        benchSkeletonAnimationMotion(boneAnimation);
+
+        float duration = (float) (BENCH_ANIM_KEYS - 1) / 30.0f;
+
+        illGraphics::SkeletonAnimation animation;
+        animation.encode(duration, boneAnimation);
+
+        size_t rawSize = 0;
+
+        for(auto boneIter = boneAnimation.begin(); boneIter != boneAnimation.end(); ++boneIter) {
+            rawSize += boneIter->second.m_positionKeys.size() * sizeof(illGraphics::SkeletonAnimation::AnimData::Key<glm::vec3>)
+                + boneIter->second.m_rotationKeys.size() * sizeof(illGraphics::SkeletonAnimation::AnimData::Key<glm::quat>)
+                + boneIter->second.m_scalingKeys.size() * sizeof(illGraphics::SkeletonAnimation::AnimData::Key<glm::vec3>);
+        }
+
+        float rawChecksum = 0.0f;
+        float checksum = 0.0f;
+
+        double rawTime = benchSkeletonAnimationDecodeRaw(boneAnimation, duration, rawChecksum);
+        double decodeTime = benchSkeletonAnimationDecode(animation, checksum);
+
+        LOG_INFO("SkeletonAnimation decode, %u bones for %u frames: raw keys %.1f ns per bone, compressed %.1f ns per bone (checksums %f %f)",
+            (unsigned int) BENCH_ANIM_BONES, BENCH_ANIM_FRAMES, rawTime, decodeTime, rawChecksum, checksum);
+
+        LOG_INFO("SkeletonAnimation memory: raw keys %u bytes, compressed %u bytes with %u of %u keys kept",
+            (unsigned int) rawSize, (unsigned int) animation.getCpuMemoryUsage(),
+            (unsigned int) animation.getNumKeys(), (unsigned int) BENCH_ANIM_BONES * BENCH_ANIM_KEYS * 3);
+    }
+
+    //playing forwards, backwards, and scrubbing around at random, with the keys found by searching versus sampled uniformly
+    {
+        illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+        benchSkeletonAnimationMotion(boneAnimation);
+
+        float duration = (float) (BENCH_ANIM_KEYS - 1) / 30.0f;
+
+        illGraphics::SkeletonAnimation animation;
+        animation.encode(duration, boneAnimation);
+
+        illGraphics::SkeletonAnimation uniformAnimation;
+        uniformAnimation.encode(duration, boneAnimation, illGraphics::SkeletonAnimationErrorBounds(), 30.0f);
+
+        std::vector<float> forwardTimes(BENCH_ANIM_FRAMES);
+        std::vector<float> reverseTimes(BENCH_ANIM_FRAMES);
+        std::vector<float> randomTimes(BENCH_ANIM_FRAMES);
+
+        srand(1);
+
+        for(unsigned int frame = 0; frame < BENCH_ANIM_FRAMES; frame++) {
+            forwardTimes[frame] = (float) frame / 60.0f;
+            reverseTimes[frame] = duration - (float) frame / 60.0f;
+            randomTimes[frame] = duration * (float) rand() / (float) RAND_MAX;
+        }
+
+        const char * workloadNames[] = { "forward", "reverse", "random seek" };
+        const std::vector<float> * workloads[] = { &forwardTimes, &reverseTimes, &randomTimes };
+
+        for(unsigned int workload = 0; workload < 3; workload++) {
+            float checksum = 0.0f;
+            float uniformChecksum = 0.0f;
+
+            double keyedTime = benchSkeletonAnimationSeek(animation, *workloads[workload], checksum);
+            double uniformTime = benchSkeletonAnimationSeek(uniformAnimation, *workloads[workload], uniformChecksum);
+
+            LOG_INFO("SkeletonAnimation %s, %u bones for %u frames: keyed %.1f ns per bone, uniform %.1f ns per bone (checksums %f %f)",
+                workloadNames[workload], (unsigned int) BENCH_ANIM_BONES, BENCH_ANIM_FRAMES, keyedTime, uniformTime, checksum, uniformChecksum);
+        }
+
+        LOG_INFO("SkeletonAnimation memory: keyed %u bytes with %u keys, uniform %u bytes with %u keys",
+            (unsigned int) animation.getCpuMemoryUsage(), (unsigned int) animation.getNumKeys(),
+            (unsigned int) uniformAnimation.getCpuMemoryUsage(), (unsigned int) uniformAnimation.getNumKeys());
+    }
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
@@ -0,0 +1,198 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
+
+#include "benchmarks.h"
+#include "testSkeletonUtil.h"
+#include "Logging/logging.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Graphics/serial/Model/Skeleton.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+#include "Graphics/serial/Model/ModelAnimationController.h"
+
+const uint16_t BENCH_POSE_BONES = 100;
+const unsigned int BENCH_POSE_SKELETONS = 1000;
+const unsigned int BENCH_POSE_FRAMES = 10;
+
+/**
+Writes a humanoid-ish ILLSKEL0 file, a spine with limbs coming off of it that are a few bones long.
+*/
+void benchPoseWriteSkeleton(const char * path) {
+    std::vector<glm::mat4> relativeTransforms(BENCH_POSE_BONES);
+    std::vector<glm::mat4> offsetTransforms(BENCH_POSE_BONES);
+    std::vector<uint16_t> parents(BENCH_POSE_BONES);
+
+    for(uint16_t bone = 0; bone < BENCH_POSE_BONES; bone++) {
+        relativeTransforms[bone] = glm::translate(glm::vec3(0.0f, 0.1f, 0.0f)) * glm::rotate((float) (bone % 7) * 5.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+        offsetTransforms[bone] = glm::translate(glm::vec3(0.0f, -0.1f * (float) (bone % 10), 0.0f));
+
+        //the spine is every 5th bone, and the 4 bones after each spine bone are a chain coming off of it
+        if(bone == 0) {
+            parents[bone] = 0;
+        }
+        else if(bone % 5 == 0) {
+            parents[bone] = bone - 5;
+        }
+        else {
+            parents[bone] = bone - 1;
+        }
+    }
+
+    writeTestSkeleton(path, relativeTransforms, offsetTransforms, parents);
+}
+
+/**
+Animates 3/4 of the bones with a second of smooth keys at 30 fps, the rest stay in the bind pose.
+*/
+void benchPoseMakeAnimation(illGraphics::SkeletonAnimation& animation) {
+    illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+
+    for(uint16_t bone = 0; bone < BENCH_POSE_BONES; bone++) {
+        if(bone % 4 == 3) {
+            continue;
+        }
+
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[bone];
+
+        animData.m_positionKeys.resize(31);
+        animData.m_rotationKeys.resize(31);
+        animData.m_scalingKeys.resize(31);
+
+        for(unsigned int key = 0; key <= 30; key++) {
+            float time = (float) key / 30.0f;
+            float angle = std::sin(time * 6.28f + (float) bone) * 0.5f;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3(0.0f, 0.1f, 0.0f);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::quat(std::cos(angle), 0.0f, 0.0f, std::sin(angle));
+
+            animData.m_scalingKeys[key].m_time = time;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+
+    animation.encode(1.0f, boneAnimation);
+}
+
+/**
+How ModelAnimationController::computeAnimPose() used to work, recursing through the heirarchy nodes with a hash map of frame info,
+decomposing the bind pose of bones that aren't animated and building the orientation fix rotation for every bone.
+Only does the single animation case without transitions.
+*/
+void benchPoseRecursive(const illGraphics::Skeleton& skeleton, const illGraphics::Skeleton::BoneHeirarchy * node, glm::mat4 transform,
+        const illGraphics::SkeletonAnimation& animation, float time, std::unordered_map<size_t, illGraphics::LastFrameInfo>& lastFrameInfo,
+        glm::mat4 * skelMats) {
+    Transform<> localTransform;
+
+    if(!animation.getTransform(node->m_boneIndex, time, localTransform, lastFrameInfo[node->m_boneIndex])) {
+        localTransform.set(skeleton.getBone(node->m_boneIndex).m_relativeTransform);
+    }
+
+    transform = transform * localTransform.getMatrix();
+
+    skelMats[node->m_boneIndex] = transform * skeleton.getBone(node->m_boneIndex).m_offsetTransform
+        * glm::rotate(-90.0f, glm::vec3(1.0f, 0.0, 0.0f));
+
+    for(std::vector<illGraphics::Skeleton::BoneHeirarchy *>::const_iterator iter = node->m_children.begin(); iter != node->m_children.end(); iter++) {
+        benchPoseRecursive(skeleton, *iter, transform, animation, time, lastFrameInfo, skelMats);
+    }
+}
+
+void benchSkeletonPose() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    benchPoseWriteSkeleton("benchSkeletonPose.illskel");
+
+    illGraphics::Skeleton skeleton;
+
+    {
+        illGraphics::SkeletonLoadArgs loadArgs;
+        loadArgs.m_path = "benchSkeletonPose.illskel";
+        skeleton.load(loadArgs, NULL);
+    }
+
+    remove("benchSkeletonPose.illskel");
+
+    illGraphics::SkeletonAnimation animation;
+    benchPoseMakeAnimation(animation);
+
+    //every skeleton is at a different point in the animation like a crowd would be
+    std::vector<glm::mat4> skelMats(BENCH_POSE_SKELETONS * BENCH_POSE_BONES);
+    std::vector<glm::mat4> recursiveSkelMats(BENCH_POSE_SKELETONS * BENCH_POSE_BONES);
+
+    long long recursiveTime;
+
+    {
+        std::vector<std::unordered_map<size_t, illGraphics::LastFrameInfo> > lastFrameInfo(BENCH_POSE_SKELETONS);
+        std::vector<float> times(BENCH_POSE_SKELETONS);
+
+        //advanced the same way the controllers do it so they end up at exactly the same times
+        for(unsigned int skeletonInd = 0; skeletonInd < BENCH_POSE_SKELETONS; skeletonInd++) {
+            times[skeletonInd] = 0.0f;
+            times[skeletonInd] += (float) skeletonInd * 0.001f;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int frame = 0; frame < BENCH_POSE_FRAMES; frame++) {
+            for(unsigned int skeletonInd = 0; skeletonInd < BENCH_POSE_SKELETONS; skeletonInd++) {
+                benchPoseRecursive(skeleton, skeleton.getRootBoneNode(), glm::mat4(), animation,
+                    times[skeletonInd], lastFrameInfo[skeletonInd],
+                    &recursiveSkelMats[skeletonInd * BENCH_POSE_BONES]);
+
+                times[skeletonInd] += 1.0f / 60.0f;
+            }
+        }
+
+        recursiveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    long long flatTime;
+
+    {
+        std::vector<illGraphics::ModelAnimationController> controllers(BENCH_POSE_SKELETONS);
+
+        for(unsigned int skeletonInd = 0; skeletonInd < BENCH_POSE_SKELETONS; skeletonInd++) {
+            controllers[skeletonInd].setSkeleton(&skeleton);
+            controllers[skeletonInd].queueTransition(&animation, 0.0f, 0.0f);
+            controllers[skeletonInd].update(1.0f);
+            controllers[skeletonInd].update((float) skeletonInd * 0.001f);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int frame = 0; frame < BENCH_POSE_FRAMES; frame++) {
+            for(unsigned int skeletonInd = 0; skeletonInd < BENCH_POSE_SKELETONS; skeletonInd++) {
+                controllers[skeletonInd].computeAnimPose(&skelMats[skeletonInd * BENCH_POSE_BONES]);
+                controllers[skeletonInd].update(1.0f / 60.0f);
+            }
+        }
+
+        flatTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    //make sure both did the same thing, and so the work doesn't get optimized out
+    float maxDifference = 0.0f;
+
+    for(size_t mat = 0; mat < skelMats.size(); mat++) {
+        for(unsigned int col = 0; col < 4; col++) {
+            for(unsigned int row = 0; row < 4; row++) {
+                maxDifference = glm::max(maxDifference, std::abs(skelMats[mat][col][row] - recursiveSkelMats[mat][col][row]));
+            }
+        }
+    }
+
+    LOG_INFO("Posing %u skeletons of %u bones, %u frames: recursive %lld us per frame, flat %lld us per frame (max difference %f)",
+        BENCH_POSE_SKELETONS, (unsigned int) BENCH_POSE_BONES, BENCH_POSE_FRAMES,
+        recursiveTime / BENCH_POSE_FRAMES, flatTime / BENCH_POSE_FRAMES, maxDifference);
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
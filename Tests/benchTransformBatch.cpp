@@ -0,0 +1,126 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "benchmarks.h"
+#include "Logging/logging.h"
+#include "Util/Geometry/transformBatchMath.h"
+
+const unsigned int BENCH_TRANSFORM_BATCH_TRANSFORMS = 100000;
+const unsigned int BENCH_TRANSFORM_BATCH_RUNS = 20;
+
+inline float benchTransformBatchRandom(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+/**
+Does what posing a lot of bones during a transition does, blending two sets of local transforms,
+turning them into matrices, and multiplying them by a parent matrix and an offset matrix.
+Once with a Transform at a time and glm, and once with the batch kernels.
+*/
+void benchTransformBatch() {
+    std::vector<Transform<> > from(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    std::vector<Transform<> > to(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    std::vector<glm::mat4> offsets(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+
+    TransformBatch fromBatch;
+    TransformBatch toBatch;
+
+    fromBatch.resize(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    toBatch.resize(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+
+    srand(2222);
+
+    for(unsigned int transform = 0; transform < BENCH_TRANSFORM_BATCH_TRANSFORMS; transform++) {
+        glm::quat rotation = glm::normalize(glm::quat(benchTransformBatchRandom(-1.0f, 1.0f), benchTransformBatchRandom(-1.0f, 1.0f),
+            benchTransformBatchRandom(-1.0f, 1.0f), benchTransformBatchRandom(-1.0f, 1.0f)));
+
+        from[transform] = Transform<>(glm::vec3(benchTransformBatchRandom(-1.0f, 1.0f), benchTransformBatchRandom(0.0f, 1.0f), 0.0f), rotation);
+
+        //nearby rotations like a transition between two similar animations
+        to[transform] = Transform<>(from[transform].m_position + glm::vec3(0.0f, 0.1f, 0.0f),
+            glm::normalize(rotation + glm::quat(0.0f, benchTransformBatchRandom(-0.3f, 0.3f), benchTransformBatchRandom(-0.3f, 0.3f), 0.0f)));
+
+        offsets[transform] = Transform<>(glm::vec3(0.0f, -benchTransformBatchRandom(0.0f, 2.0f), 0.0f), glm::quat()).getMatrix();
+
+        fromBatch.set(transform, from[transform]);
+        toBatch.set(transform, to[transform]);
+    }
+
+    //every bone's parent is the one before it, which is a worst case chain but keeps the two versions comparable
+    std::vector<glm::mat4> referenceMatrices(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    std::vector<glm::mat4> referenceSkinning(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    long long referenceTime;
+
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int run = 0; run < BENCH_TRANSFORM_BATCH_RUNS; run++) {
+            float delta = (float) (run + 1) / (float) (BENCH_TRANSFORM_BATCH_RUNS + 1);
+
+            for(unsigned int transform = 0; transform < BENCH_TRANSFORM_BATCH_TRANSFORMS; transform++) {
+                glm::mat4 local = from[transform].interpolate(to[transform], delta).getMatrix();
+
+                referenceMatrices[transform] = transform % 100 == 0
+                    ? local
+                    : referenceMatrices[transform - 1] * local;
+
+                referenceSkinning[transform] = referenceMatrices[transform] * offsets[transform];
+            }
+        }
+
+        referenceTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    std::vector<glm::mat4> batchMatrices(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    std::vector<glm::mat4> batchSkinning(BENCH_TRANSFORM_BATCH_TRANSFORMS);
+    long long batchTime;
+
+    {
+        TransformBatch blended;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(unsigned int run = 0; run < BENCH_TRANSFORM_BATCH_RUNS; run++) {
+            float delta = (float) (run + 1) / (float) (BENCH_TRANSFORM_BATCH_RUNS + 1);
+
+            blendTransformBatch(fromBatch, toBatch, delta, blended);
+            transformBatchMatrices(blended, batchMatrices.data());
+
+            for(unsigned int transform = 0; transform < BENCH_TRANSFORM_BATCH_TRANSFORMS; transform++) {
+                if(transform % 100 != 0) {
+                    multiplyMatrix(batchMatrices[transform - 1], batchMatrices[transform], batchMatrices[transform]);
+                }
+
+                multiplyMatrix(batchMatrices[transform], offsets[transform], batchSkinning[transform]);
+            }
+        }
+
+        batchTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    //make sure both did the same thing, and so the work doesn't get optimized out
+    float maxDifference = 0.0f;
+
+    for(unsigned int transform = 0; transform < BENCH_TRANSFORM_BATCH_TRANSFORMS; transform++) {
+        for(unsigned int col = 0; col < 4; col++) {
+            for(unsigned int row = 0; row < 4; row++) {
+                maxDifference = glm::max(maxDifference, std::abs(batchSkinning[transform][col][row] - referenceSkinning[transform][col][row]));
+            }
+        }
+    }
+
+#if defined(ILL_AVX)
+    const char * instructionSet = "AVX";
+#elif defined(ILL_SSE2)
+    const char * instructionSet = "SSE2";
+#else
+    const char * instructionSet = "no SIMD";
+#endif
+
+    LOG_INFO("Blending and composing %u transforms %u times: one at a time %lld us.  Batched with %s %lld us (max difference %f).",
+        BENCH_TRANSFORM_BATCH_TRANSFORMS, BENCH_TRANSFORM_BATCH_RUNS,
+        referenceTime, instructionSet, batchTime, maxDifference);
+}
@@ -0,0 +1,32 @@
+#ifndef ILL_BENCHMARKS_H__
+#define ILL_BENCHMARKS_H__
+
+/**
+CPU only benchmarks for comparing implementations of performance sensitive stuff.
+These print their timings with LOG_INFO.
+*/
+void benchRenderQueues();
+
+void benchSceneCells();
+
+void benchDeferredShadingScene();
+
+void benchBoxBatch();
+
+void benchIllmesh();
+
+void benchSkeletonAnimation();
+
+void benchRefCountPtr();
+
+void benchPackFileSystem();
+
+void benchSkeletonPose();
+
+void benchTransformBatch();
+
+void benchModelAnimationSystem();
+
+void benchAnimationLayers();
+
+#endif
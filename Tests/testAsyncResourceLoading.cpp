@@ -0,0 +1,211 @@
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "tests.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/Illmesh/IllmeshWriter.h"
+#include "Util/parallel/TaskQueue.h"
+#include "Graphics/GraphicsBackend.h"
+#include "Graphics/serial/Model/Mesh.h"
+
+const unsigned int TEST_ASYNC_MESHES = 16;
+
+/**
+Only does mesh loading, and checks that it only happens on the main thread.
+*/
+class TestAsyncBackend : public illGraphics::GraphicsBackend {
+public:
+    TestAsyncBackend()
+        : m_mainThread(std::this_thread::get_id()),
+        m_numMeshesLoaded(0),
+        m_numMeshesUnloaded(0)
+    {}
+
+    virtual void initialize() {}
+    virtual void uninitialize() {}
+
+    virtual void beginFrame() {}
+    virtual void endFrame() {}
+
+    virtual void loadTexture(void ** textureData, const illGraphics::TextureLoadArgs& loadArgs) {}
+    virtual void unloadTexture(void ** textureData) {}
+    virtual size_t getTextureMemoryUsage(const void * textureData) { return 0; }
+
+    virtual void loadMesh(void** meshBackendData, const MeshData<>& meshFrontendData) {
+        assert(std::this_thread::get_id() == m_mainThread);
+        assert(meshFrontendData.getData());
+
+        *meshBackendData = new uint32_t(meshFrontendData.getNumVert());
+        ++m_numMeshesLoaded;
+    }
+
+    virtual void unloadMesh(void** meshBackendData) {
+        assert(std::this_thread::get_id() == m_mainThread);
+
+        delete (uint32_t *) *meshBackendData;
+        *meshBackendData = NULL;
+        ++m_numMeshesUnloaded;
+    }
+
+    virtual void loadShader(void ** shaderData, uint64_t featureMask) {}
+    virtual void loadShaderInternal(void ** shaderData, const char * path, unsigned int shaderType, const char * defines) {}
+    virtual void unloadShader(void **) {}
+
+    virtual void loadShaderProgram(void **, const std::vector<IntrusivePtr<illGraphics::Shader> >& shaderList) {}
+    virtual void unloadShaderProgram(void **) {}
+
+    std::thread::id m_mainThread;
+    unsigned int m_numMeshesLoaded;
+    unsigned int m_numMeshesUnloaded;
+};
+
+std::string testAsyncMeshPath(unsigned int mesh) {
+    char path[64];
+    sprintf(path, "testAsyncMesh%u.illmesh", mesh);
+    return path;
+}
+
+/**
+Mesh number n has n + 3 vertices so they can be told apart once loaded.
+*/
+void testAsyncWriteMeshes() {
+    for(unsigned int meshInd = 0; meshInd < TEST_ASYNC_MESHES; meshInd++) {
+        MeshData<> mesh(3, meshInd + 3, 1, MF_POSITION);
+
+        for(uint32_t vertex = 0; vertex < mesh.getNumVert(); vertex++) {
+            mesh.getPosition(vertex) = glm::vec3((float) vertex);
+        }
+
+        for(uint32_t index = 0; index < mesh.getNumInd(); index++) {
+            mesh.setIndex(index, index);
+        }
+
+        mesh.getPrimitiveGroup(0).m_type = MeshData<>::PrimitiveGroup::Type::TRIANGLES;
+        mesh.getPrimitiveGroup(0).m_beginIndex = 0;
+        mesh.getPrimitiveGroup(0).m_numIndices = 3;
+
+        illFileSystem::File * file = illFileSystem::fileSystem->openWrite(testAsyncMeshPath(meshInd).c_str());
+        writeIllmesh2(mesh, file);
+        delete file;
+    }
+}
+
+void testAsyncInitializeManager(illGraphics::MeshManager& meshManager) {
+    illGraphics::MeshLoadArgs * loadArgs = new illGraphics::MeshLoadArgs[TEST_ASYNC_MESHES];
+    std::map<std::string, illGraphics::MeshId> * nameMap = new std::map<std::string, illGraphics::MeshId>();
+
+    for(unsigned int mesh = 0; mesh < TEST_ASYNC_MESHES; mesh++) {
+        loadArgs[mesh].m_path = testAsyncMeshPath(mesh);
+        (*nameMap)[loadArgs[mesh].m_path] = mesh;
+    }
+
+    meshManager.initialize(loadArgs, nameMap);
+}
+
+void testAsyncResourceLoading() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    testAsyncWriteMeshes();
+
+    TestAsyncBackend backend;
+
+    //with workers, and with everything on the main thread
+    for(unsigned int useTaskQueue = 0; useTaskQueue < 2; useTaskQueue++) {
+        TaskQueue taskQueue(2);
+
+        backend.m_numMeshesLoaded = 0;
+        backend.m_numMeshesUnloaded = 0;
+
+        {
+            illGraphics::MeshManager meshManager(&backend);
+            meshManager.setTaskQueue(useTaskQueue ? &taskQueue : NULL);
+            testAsyncInitializeManager(meshManager);
+
+            std::vector<IntrusivePtr<illGraphics::Mesh> > meshes;
+
+            for(unsigned int mesh = 0; mesh < TEST_ASYNC_MESHES - 1; mesh++) {
+                meshes.push_back(meshManager.requestResource(mesh));
+            }
+
+            //nothing gets to the backend until it's pumped
+            assert(backend.m_numMeshesLoaded == 0);
+            assert(meshManager.getNumPendingLoads() == TEST_ASYNC_MESHES - 1);
+
+            for(unsigned int mesh = 0; mesh < meshes.size(); mesh++) {
+                assert(!meshes[mesh]->isLoaded());
+                assert(meshes[mesh]->isLoading());
+            }
+
+            //requesting again before it's done gives the same resource without queueing another load
+            assert(meshManager.requestResource(3) == meshes[3]);
+            assert(meshManager.requestResource(3)->isLoading());
+            assert(meshManager.getNumPendingLoads() == TEST_ASYNC_MESHES - 1);
+
+            //getting a resource the usual way waits for it
+            {
+                IntrusivePtr<illGraphics::Mesh> mesh = meshManager.getResource(5);
+
+                assert(mesh == meshes[5]);
+                assert(mesh->isLoaded());
+                assert(mesh->getMeshFrontentData()->getNumVert() == 5 + 3);
+                assert(backend.m_numMeshesLoaded == 1);
+                assert(meshManager.getNumPendingLoads() == TEST_ASYNC_MESHES - 2);
+            }
+
+            //pump with no time budget, which still makes progress every time something's ready
+            while(meshManager.getNumPendingLoads() > 0) {
+                if(meshManager.pumpCompletions(std::chrono::steady_clock::duration::zero()) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+            assert(backend.m_numMeshesLoaded == TEST_ASYNC_MESHES - 1);
+
+            for(unsigned int mesh = 0; mesh < meshes.size(); mesh++) {
+                assert(meshes[mesh]->isLoaded());
+                assert(*(uint32_t *) meshes[mesh]->getMeshBackendData() == mesh + 3);
+
+                //the frontend data is freed after uploading but the metadata is still around
+                assert(meshes[mesh]->getMeshFrontentData()->getNumVert() == mesh + 3);
+                assert(meshes[mesh]->getMeshFrontentData()->getData() == NULL);
+            }
+
+            //already loaded so nothing's pending
+            assert(meshManager.requestResource(0)->isLoaded());
+            assert(meshManager.getNumPendingLoads() == 0);
+
+            //a resource that got unloaded while still in the cache loads again when requested
+            meshes[1]->unload();
+            assert(meshManager.requestResource(1)->isLoading());
+            assert(meshManager.getNumPendingLoads() == 1);
+
+            while(meshManager.getNumPendingLoads() > 0) {
+                if(meshManager.pumpCompletions(std::chrono::steady_clock::duration::zero()) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+            assert(meshes[1]->isLoaded());
+            assert(*(uint32_t *) meshes[1]->getMeshBackendData() == 1 + 3);
+
+            //the manager finishes whatever is still loading when it goes away
+            meshManager.requestResource(TEST_ASYNC_MESHES - 1);
+            assert(meshManager.getNumPendingLoads() == 1);
+        }
+
+        //one more for the mesh that was unloaded and loaded again
+        assert(backend.m_numMeshesLoaded == TEST_ASYNC_MESHES + 1);
+        assert(backend.m_numMeshesUnloaded == TEST_ASYNC_MESHES + 1);
+    }
+
+    for(unsigned int mesh = 0; mesh < TEST_ASYNC_MESHES; mesh++) {
+        remove(testAsyncMeshPath(mesh).c_str());
+    }
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
@@ -0,0 +1,116 @@
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "tests.h"
+#include "Util/Geometry/frustumCull.h"
+
+inline float testBoxBatchRandom(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+inline bool testBoxBatchVisible(const uint32_t * visibleMask, size_t box) {
+    return (visibleMask[box >> 5] >> (box & 31) & 1) != 0;
+}
+
+/**
+Checks the batch results against testing the boxes one at a time.
+*/
+void checkBoxBatch(const Frustum<>& frustum, const BoxBatch& boxes) {
+    std::vector<uint32_t> visibleMask((boxes.size() + 31) / 32 + 1, 0xFFFFFFFF);
+
+    size_t numVisible = frustumCullBoxBatch(FrustumCullPlanes(frustum), boxes, visibleMask.data());
+    size_t numVisibleReference = 0;
+
+    for(size_t box = 0; box < boxes.size(); box++) {
+        bool visible = frustumBoxVisible(frustum, boxes.get(box));
+        assert(testBoxBatchVisible(visibleMask.data(), box) == visible);
+
+        if(visible) {
+            ++numVisibleReference;
+        }
+    }
+
+    assert(numVisible == numVisibleReference);
+
+    //nothing past the end gets touched, and the bits for the padding in the last word are cleared
+    assert(visibleMask.back() == 0xFFFFFFFF);
+
+    for(size_t box = boxes.size(); box < ((boxes.size() + 31) & ~(size_t) 31); box++) {
+        assert(!testBoxBatchVisible(visibleMask.data(), box));
+    }
+}
+
+void testBoxBatch() {
+    //looking down -z from the origin
+    Frustum<> frustum(glm::perspective(90.0f, 1.0f, 0.1f, 100.0f)
+        * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    //some obvious cases
+    {
+        BoxBatch boxes;
+
+        boxes.push_back(Box<>(glm::vec3(-1.0f, -1.0f, -11.0f), glm::vec3(1.0f, 1.0f, -9.0f)));      //in front
+        boxes.push_back(Box<>(glm::vec3(-1.0f, -1.0f, 9.0f), glm::vec3(1.0f, 1.0f, 11.0f)));        //behind
+        boxes.push_back(Box<>(glm::vec3(-100.0f, -1.0f, -11.0f), glm::vec3(-50.0f, 1.0f, -9.0f)));  //off to the left
+        boxes.push_back(Box<>(glm::vec3(-100.0f, -1.0f, -11.0f), glm::vec3(0.0f, 1.0f, -9.0f)));    //sticking out to the left
+        boxes.push_back(Box<>(glm::vec3(-1.0f, -1.0f, -300.0f), glm::vec3(1.0f, 1.0f, -200.0f)));   //past the far plane
+        boxes.push_back(Box<>(glm::vec3(-1.0f), glm::vec3(1.0f)));                                  //around the camera
+
+        uint32_t visibleMask;
+        assert(frustumCullBoxBatch(FrustumCullPlanes(frustum), boxes, &visibleMask) == 3);
+        assert(visibleMask == ((1 << 0) | (1 << 3) | (1 << 5)));
+
+        checkBoxBatch(frustum, boxes);
+    }
+
+    //random boxes compared to the one at a time test, with enough of them to need more than one mask word
+    {
+        BoxBatch boxes;
+        std::vector<Box<> > reference;
+
+        srand(1234);
+
+        for(unsigned int box = 0; box < 203; box++) {
+            glm::vec3 center(testBoxBatchRandom(-150.0f, 150.0f), testBoxBatchRandom(-150.0f, 150.0f), testBoxBatchRandom(-150.0f, 150.0f));
+            glm::vec3 halfDimensions(testBoxBatchRandom(0.0f, 10.0f), testBoxBatchRandom(0.0f, 10.0f), testBoxBatchRandom(0.0f, 10.0f));
+
+            boxes.push_back(Box<>(center - halfDimensions, center + halfDimensions));
+            reference.push_back(Box<>(center - halfDimensions, center + halfDimensions));
+        }
+
+        checkBoxBatch(frustum, boxes);
+
+        //remove some and change some, keeping the reference in sync the same way
+        for(unsigned int step = 0; step < 150; step++) {
+            size_t box = rand() % boxes.size();
+
+            if(step % 3 == 0) {
+                glm::vec3 offset(testBoxBatchRandom(-20.0f, 20.0f));
+                reference[box] = Box<>(reference[box].m_min + offset, reference[box].m_max + offset);
+                boxes.set(box, reference[box]);
+            }
+            else {
+                reference[box] = reference.back();
+                reference.pop_back();
+                boxes.swapRemove(box);
+            }
+
+            assert(boxes.size() == reference.size());
+        }
+
+        for(size_t box = 0; box < boxes.size(); box++) {
+            assert(boxes.get(box).m_min == reference[box].m_min);
+            assert(boxes.get(box).m_max == reference[box].m_max);
+        }
+
+        checkBoxBatch(frustum, boxes);
+
+        boxes.clear();
+        assert(boxes.empty());
+
+        checkBoxBatch(frustum, boxes);
+    }
+}
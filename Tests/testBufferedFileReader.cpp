@@ -0,0 +1,98 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "tests.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem/BufferedFileReader.h"
+
+const uint32_t TEST_BUFFERED_VALUES = 1000;
+
+void testBufferedFileReaderValues(illFileSystem::BufferedFileReader& reader) {
+    assert(reader.getSize() == TEST_BUFFERED_VALUES * 7 + 4096 + 6);
+
+    //typed reads, 7 bytes each so they straddle the buffer edges
+    for(uint32_t value = 0; value < TEST_BUFFERED_VALUES; value++) {
+        uint8_t byte;
+        reader.read8(byte);
+        assert(byte == (uint8_t) value);
+
+        uint16_t shortValue;
+        reader.readB16(shortValue);
+        assert(shortValue == (uint16_t) (value * 3));
+
+        float floatValue;
+        reader.readLF(floatValue);
+        assert(floatValue == (float) value * 0.5f);
+    }
+
+    assert(reader.tell() == TEST_BUFFERED_VALUES * 7);
+    assert(!reader.eof());
+
+    //a read bigger than the buffer
+    {
+        uint8_t block[4096];
+        reader.read(block, sizeof(block));
+
+        for(unsigned int byte = 0; byte < sizeof(block); byte++) {
+            assert(block[byte] == (uint8_t) (byte * 7));
+        }
+    }
+
+    //a string through the File interface
+    {
+        illFileSystem::File& file = reader;
+
+        char string[8];
+        uint16_t length = file.readStringBufferLength();
+        assert(length == 5);
+
+        file.readString(string, length);
+        assert(strcmp(string, "illE") == 0);
+    }
+
+    assert(reader.eof());
+
+    //seek back to somewhere that's likely not in the buffer anymore, then forward a bit
+    reader.seek(7 * 10);
+    reader.seekAhead(7 * 5);
+
+    uint8_t byte;
+    reader.read8(byte);
+    assert(byte == 15);
+    assert(reader.tell() == 7 * 15 + 1);
+}
+
+void testBufferedFileReader() {
+    illStdio::StdioFileSystem stdioFileSystem;
+
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testBufferedFileReader.bin");
+
+        for(uint32_t value = 0; value < TEST_BUFFERED_VALUES; value++) {
+            file->write8((uint8_t) value);
+            file->writeB16((uint16_t) (value * 3));
+            file->writeLF((float) value * 0.5f);
+        }
+
+        for(unsigned int byte = 0; byte < 4096; byte++) {
+            file->write8((uint8_t) (byte * 7));
+        }
+
+        file->writeString("illE");
+
+        delete file;
+    }
+
+    //tiny buffer, a buffer in between, big buffer that holds the whole file, and no buffer
+    size_t bufferSizes[] = { 5, 64, 1024 * 1024, 0 };
+
+    for(unsigned int test = 0; test < sizeof(bufferSizes) / sizeof(bufferSizes[0]); test++) {
+        illFileSystem::BufferedFileReader reader(stdioFileSystem.openRead("testBufferedFileReader.bin"), bufferSizes[test]);
+        assert(reader.getBufferSize() == bufferSizes[test]);
+
+        testBufferedFileReaderValues(reader);
+    }
+
+    remove("testBufferedFileReader.bin");
+}
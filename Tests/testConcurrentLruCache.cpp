@@ -0,0 +1,266 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tests.h"
+#include "Util/parallel/ConcurrentLruCache.h"
+
+const unsigned int TEST_CONCURRENT_LRU_THREADS = 32;
+const unsigned int TEST_CONCURRENT_LRU_KEYS = 200;
+const unsigned int TEST_CONCURRENT_LRU_OPERATIONS = 20000;
+const unsigned int TEST_CONCURRENT_LRU_HELD = 4;
+
+std::atomic<int> testConcurrentLruNumCreated;
+std::atomic<int> testConcurrentLruNumDeleted;
+
+struct TestConcurrentLruElement : public RefCounted<AtomicRefCount> {
+    TestConcurrentLruElement(int key)
+        : m_key(key)
+    {
+        ++testConcurrentLruNumCreated;
+    }
+
+    virtual ~TestConcurrentLruElement() {
+        ++testConcurrentLruNumDeleted;
+    }
+
+    int m_key;
+};
+
+typedef ConcurrentLruCache<int, TestConcurrentLruElement> TestConcurrentLruCache;
+
+/**
+Which instance of each key the threads are holding and how many are holding it.
+Two threads holding different instances for the same key at once would mean the element got loaded twice.
+*/
+struct TestConcurrentLruHeld {
+    TestConcurrentLruHeld()
+        : m_element(NULL),
+        m_numHolders(0)
+    {}
+
+    std::mutex m_mutex;
+    const TestConcurrentLruElement * m_element;
+    unsigned int m_numHolders;
+};
+
+/**
+Starts a bunch of threads at the same time and waits for them all to finish.
+*/
+inline void testConcurrentLruRunThreads(const std::function<void (unsigned int)>& function) {
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+
+    for(unsigned int thread = 0; thread < TEST_CONCURRENT_LRU_THREADS; thread++) {
+        threads.push_back(std::thread([&go, &function, thread] () {
+            while(!go) {
+                std::this_thread::yield();
+            }
+
+            function(thread);
+        }));
+    }
+
+    go = true;
+
+    for(size_t thread = 0; thread < threads.size(); thread++) {
+        threads[thread].join();
+    }
+}
+
+void testConcurrentLruCache() {
+    testConcurrentLruNumCreated = 0;
+    testConcurrentLruNumDeleted = 0;
+
+    //every thread asks for the same new element at once and it gets created only once
+    {
+        TestConcurrentLruCache cache([] (int key) {
+            //slow enough that every thread gets there while it's being created
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return new TestConcurrentLruElement(key);
+        });
+
+        std::vector<const TestConcurrentLruElement *> results(TEST_CONCURRENT_LRU_THREADS);
+
+        testConcurrentLruRunThreads([&cache, &results] (unsigned int thread) {
+            IntrusivePtr<TestConcurrentLruElement> element = cache.getElement(7);
+            assert(element->m_key == 7);
+
+            results[thread] = element.get();
+        });
+
+        for(unsigned int thread = 1; thread < TEST_CONCURRENT_LRU_THREADS; thread++) {
+            assert(results[thread] == results[0]);
+        }
+
+        assert(testConcurrentLruNumCreated == 1);
+        assert(cache.getStats().m_misses == 1);
+        assert(cache.getStats().m_hits == TEST_CONCURRENT_LRU_THREADS - 1);
+
+        //only the cache has a reference now
+        cache.evict();
+        assert(cache.getNumElements() == 1);
+    }
+
+    assert(testConcurrentLruNumDeleted == 1);
+
+    //hammering random keys with a tight memory budget so evictions happen all the time
+    {
+        testConcurrentLruNumCreated = 0;
+        testConcurrentLruNumDeleted = 0;
+
+        TestConcurrentLruCache cache([] (int key) {
+            if(key % 8 == 0) {
+                std::this_thread::yield();
+            }
+
+            return new TestConcurrentLruElement(key);
+        });
+
+        cache.setSizeFunc([] (const TestConcurrentLruElement&) {
+            return (size_t) 1;
+        });
+
+        cache.setMemoryBudget(cache.getNumShards() * 4);
+
+        std::vector<TestConcurrentLruHeld> held(TEST_CONCURRENT_LRU_KEYS);
+
+        testConcurrentLruRunThreads([&cache, &held] (unsigned int thread) {
+            IntrusivePtr<TestConcurrentLruElement> elements[TEST_CONCURRENT_LRU_HELD];
+            uint32_t random = thread * 2654435761u + 1;
+
+            for(unsigned int operation = 0; operation < TEST_CONCURRENT_LRU_OPERATIONS; operation++) {
+                random = random * 1664525 + 1013904223;
+
+                unsigned int slot = (random >> 8) % TEST_CONCURRENT_LRU_HELD;
+
+                //let go of whatever was in the slot
+                if(!elements[slot].isNull()) {
+                    TestConcurrentLruHeld& heldKey = held[elements[slot]->m_key];
+
+                    {
+                        std::lock_guard<std::mutex> lock(heldKey.m_mutex);
+                        --heldKey.m_numHolders;
+                    }
+
+                    elements[slot].reset();
+                }
+
+                //lower keys get asked for more often
+                int key = (int) (((random >> 16) % TEST_CONCURRENT_LRU_KEYS) * ((random >> 12) % TEST_CONCURRENT_LRU_KEYS) / TEST_CONCURRENT_LRU_KEYS);
+
+                elements[slot] = cache.getElement(key);
+                assert(elements[slot]->m_key == key);
+
+                {
+                    TestConcurrentLruHeld& heldKey = held[key];
+                    std::lock_guard<std::mutex> lock(heldKey.m_mutex);
+
+                    if(heldKey.m_numHolders > 0) {
+                        assert(heldKey.m_element == elements[slot].get());
+                    }
+                    else {
+                        heldKey.m_element = elements[slot].get();
+                    }
+
+                    ++heldKey.m_numHolders;
+                }
+
+                if(thread == 0 && operation % 100 == 0) {
+                    cache.evict();
+                }
+            }
+
+            for(unsigned int slot = 0; slot < TEST_CONCURRENT_LRU_HELD; slot++) {
+                if(!elements[slot].isNull()) {
+                    std::lock_guard<std::mutex> lock(held[elements[slot]->m_key].m_mutex);
+                    --held[elements[slot]->m_key].m_numHolders;
+                }
+            }
+        });
+
+        TestConcurrentLruCache::Stats stats = cache.getStats();
+
+        assert(stats.m_hits + stats.m_misses == TEST_CONCURRENT_LRU_THREADS * TEST_CONCURRENT_LRU_OPERATIONS);
+        assert(stats.m_evictions > 0);
+
+        //everything created is either still in there or got evicted and deleted
+        assert(stats.m_misses == (uint64_t) testConcurrentLruNumCreated);
+        assert(stats.m_evictions == (uint64_t) testConcurrentLruNumDeleted);
+        assert(stats.m_misses == stats.m_evictions + cache.getNumElements());
+
+        //nothing is referenced anymore, so it all fits the budget after evicting
+        cache.evict();
+        assert(cache.getMemoryUsage() <= cache.getMemoryBudget());
+    }
+
+    //no leaks
+    assert(testConcurrentLruNumCreated == testConcurrentLruNumDeleted);
+
+    //with no memory budget, unreferenced elements go away once the cache has noticed them unreferenced for the eviction time
+    {
+        testConcurrentLruNumCreated = 0;
+        testConcurrentLruNumDeleted = 0;
+
+        TestConcurrentLruCache cache([] (int key) {
+            return new TestConcurrentLruElement(key);
+        }, 1, std::chrono::milliseconds(20));
+
+        IntrusivePtr<TestConcurrentLruElement> held = cache.getElement(0);
+
+        for(int key = 1; key < 100; key++) {
+            cache.getElement(key);
+        }
+
+        //nothing has been around for the eviction time yet
+        cache.evict();
+        assert(cache.getNumElements() == 100);
+
+        //the first pass after the eviction time only notices they're unreferenced
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cache.evict();
+        assert(cache.getNumElements() == 100);
+
+        //asking for one again keeps it around longer
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cache.getElement(50);
+        cache.evict();
+        assert(cache.getNumElements() == 2);
+        assert(testConcurrentLruNumDeleted == 98);
+
+        held.reset();
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cache.evict();
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cache.evict();
+        assert(cache.getNumElements() == 0);
+    }
+
+    assert(testConcurrentLruNumCreated == testConcurrentLruNumDeleted);
+
+    //elements still referenced when the cache goes away stay alive until they're let go
+    {
+        testConcurrentLruNumCreated = 0;
+        testConcurrentLruNumDeleted = 0;
+
+        IntrusivePtr<TestConcurrentLruElement> survivor;
+
+        {
+            TestConcurrentLruCache cache([] (int key) {
+                return new TestConcurrentLruElement(key);
+            });
+
+            survivor = cache.getElement(3);
+            cache.getElement(4);
+        }
+
+        assert(testConcurrentLruNumDeleted == 1);
+        assert(survivor->m_key == 3);
+
+        survivor.reset();
+        assert(testConcurrentLruNumDeleted == 2);
+    }
+}
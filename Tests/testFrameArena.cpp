@@ -0,0 +1,254 @@
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "tests.h"
+#include "testUtil.h"
+#include "Util/serial/FrameArena.h"
+#include "Graphics/serial/Camera/Camera.h"
+#include "RendererCommon/serial/RenderQueues.h"
+#include "RendererCommon/serial/LightNode.h"
+#include "RendererCommon/serial/StaticMeshNode.h"
+#include "DeferredShadingRenderer/serial/DeferredShadingScene.h"
+#include "DeferredShadingRenderer/serial/Null/DeferredShadingBackendNull.h"
+
+using namespace illRendererCommon;
+using namespace illDeferredShadingRenderer;
+
+/**
+How many times anything in the program called the global operator new.
+Replacing the global operators affects the whole test program, but they only count and pass everything on to malloc and free.
+*/
+static std::atomic<size_t> testNumGlobalAllocations(0);
+
+void * operator new(size_t size) {
+    ++testNumGlobalAllocations;
+
+    void * res = malloc(size ? size : 1);
+
+    if(!res) {
+        throw std::bad_alloc();
+    }
+
+    return res;
+}
+
+void operator delete(void * ptr) throw() {
+    free(ptr);
+}
+
+/**
+Queues a fake mesh entry the way StaticMeshNode does for a mesh with one primitive group.
+*/
+class TestFrameArenaMeshNode : public StaticMeshNode {
+public:
+    TestFrameArenaMeshNode(GraphicsScene * scene, const glm::vec3& position, size_t id)
+        : StaticMeshNode(scene, glm::translate(glm::mat4(), position), Box<>(glm::vec3(-4.0f), glm::vec3(4.0f))),
+        m_id(id)
+    {}
+
+    virtual void render(RenderQueues& renderQueues) {
+        uint64_t key = RenderQueues::staticMeshSortKey(m_id % 3, (uint32_t) (m_id % 7), (uint32_t) (m_id % 11), 0);
+
+        renderQueues.addDepthPassSolidStaticMesh(key, fakePointer<illGraphics::ShaderProgram>(m_id % 3),
+            fakePointer<illGraphics::Material>(m_id % 7), fakePointer<illGraphics::Mesh>(m_id % 11)).m_node = this;
+
+        auto& info = renderQueues.addSolidStaticMesh(key, fakePointer<illGraphics::ShaderProgram>(m_id % 3),
+            fakePointer<illGraphics::Material>(m_id % 7), fakePointer<illGraphics::Mesh>(m_id % 11));
+        info.m_meshInfo.m_node = this;
+        info.m_affectingLights = &getAffectingLights();
+    }
+
+    size_t m_id;
+};
+
+void testFrameArena() {
+    //bump allocation
+    {
+        FrameArena arena(256);
+
+        assert(arena.getNumHeapAllocations() == 0);
+
+        void * a = arena.allocate(3, 1);
+        void * b = arena.allocate(8, 8);
+
+        assert(a != b);
+        assert((uintptr_t) b % 8 == 0);
+        assert(arena.getNumAllocations() == 2);
+        assert(arena.getNumHeapAllocations() == 1);
+
+        //doesn't fit in the first block
+        arena.allocate(1000);
+        assert(arena.getNumHeapAllocations() == 2);
+
+        //the two blocks get merged into one
+        arena.reset();
+        assert(arena.getNumAllocations() == 0);
+        assert(arena.getNumHeapAllocations() == 3);
+
+        //now the same frame fits without going to the heap
+        arena.allocate(3, 1);
+        arena.allocate(8, 8);
+        arena.allocate(1000);
+        assert(arena.getNumHeapAllocations() == 3);
+    }
+
+    //no arena falls back on the heap
+    {
+        std::vector<int, FrameArenaAllocator<int>> heapVector;
+        heapVector.push_back(1);
+        heapVector.push_back(2);
+        assert(heapVector[0] == 1 && heapVector[1] == 2);
+    }
+
+    //the render queue containers stop going to the heap once the arena is warmed up,
+    //and a steady state frame of the sorted queues doesn't call the global allocator at all.
+    //Out of scope here: the map mode queues, which allocate per node and are only kept around for comparing against the sorted queues.
+    {
+        FrameArena arena;
+
+        RenderQueues queues;
+        queues.m_frameArena = &arena;
+        queues.m_useSortedQueues = true;
+
+        //the light queue was built before there was an arena, clearing rebuilds it on top of the arena
+        queues.clear();
+
+        size_t warmHeapAllocations = 0;
+
+        std::vector<RenderQueues::LightList> nodeLights(50);
+
+        for(size_t node = 0; node < nodeLights.size(); node++) {
+            for(size_t light = 0; light < 4; light++) {
+                nodeLights[node].push_back(fakePointer<LightNode>((node + light) % 50));
+            }
+        }
+
+        for(unsigned int frame = 0; frame < 10; frame++) {
+            size_t frameGlobalAllocations = testNumGlobalAllocations;
+
+            for(size_t node = 0; node < 1000; node++) {
+                if(node % 4 == 0) {
+                    queues.addDepthPassSolidStaticMesh(RenderQueues::staticMeshSortKey(node % 3, node % 7, node % 11, 0),
+                        fakePointer<illGraphics::ShaderProgram>(node % 3), 
+                        fakePointer<illGraphics::Material>(node % 7), 
+                        fakePointer<illGraphics::Mesh>(node % 11)).m_node = fakePointer<StaticMeshNode>(node);
+                }
+
+                auto& info = queues.addSolidStaticMesh(RenderQueues::staticMeshSortKey(node % 3, node % 7, node % 11, 0),
+                    fakePointer<illGraphics::ShaderProgram>(node % 3), 
+                    fakePointer<illGraphics::Material>(node % 7), 
+                    fakePointer<illGraphics::Mesh>(node % 11));
+
+                info.m_meshInfo.m_node = fakePointer<StaticMeshNode>(node);
+
+                //the affecting lights point at the node's cached list so they don't allocate anything
+                info.m_affectingLights = &nodeLights[node % 50];
+                assert(info.m_affectingLights->size() == 4);
+            }
+
+            for(size_t light = 0; light < 50; light++) {
+                queues.m_lights[illGraphics::LightBase::Type::POINT][fakePointer<illGraphics::LightBase>(light % 5)].push_back(fakePointer<LightNode>(light));
+            }
+
+            assert(queues.m_lights[illGraphics::LightBase::Type::POINT].size() == 5);
+            assert(queues.m_lights[illGraphics::LightBase::Type::POINT][fakePointer<illGraphics::LightBase>(0)].size() == 10);
+
+            queues.sortDepthPass();
+            assert(queues.m_sortedDepthPassSolidStaticMeshes.size() == 250);
+            queues.clearDepthPass();
+
+            queues.sort();
+            assert(queues.m_sortedSolidStaticMeshes.size() == 1000);
+
+            assert(arena.getNumAllocations() > 0);
+
+            //this also resets the arena
+            queues.clear();
+
+            if(frame == 1) {
+                warmHeapAllocations = arena.getNumHeapAllocations();
+            }
+            else if(frame > 1) {
+                assert(arena.getNumHeapAllocations() == warmHeapAllocations);
+                assert(testNumGlobalAllocations == frameGlobalAllocations);
+            }
+        }
+    }
+
+    //a steady state frame of the whole scene, clipping and walking the frustum included, doesn't call the global allocator either
+    {
+        DeferredShadingBackendNull backend;
+
+        //some cells come back occluded so culling gets exercised too
+        backend.m_cellVisibility = [] (const illGraphics::Camera&, unsigned int cellArrayIndex, size_t) {
+            return cellArrayIndex % 5 != 0;
+        };
+
+        glm::vec3 cellDimensions(10.0f);
+        glm::vec3 interactionCellDimensions(20.0f);
+
+        DeferredShadingScene scene(&backend, NULL, NULL,
+            cellDimensions, glm::uvec3(32, 8, 32),
+            interactionCellDimensions, glm::uvec3(16, 4, 16));
+
+        size_t viewport = scene.registerViewport();
+
+        RefCountPtr<illGraphics::LightBase> pointLight(new illGraphics::PointLight(glm::vec3(1.0f), 1.0f, true, 5.0f, 15.0f));
+
+        std::vector<GraphicsNode *> nodes;
+        uint32_t random = 54321;
+
+        for(size_t node = 0; node < 2000; node++) {
+            glm::vec3 position;
+
+            for(int axis = 0; axis < 3; axis++) {
+                random = random * 1664525 + 1013904223;
+                position[axis] = (float) (random >> 8) / (float) (1 << 24) * (axis == 1 ? 75.0f : 315.0f) + 2.5f;
+            }
+
+            if(node % 50 == 0) {
+                LightNode * light = new LightNode(&scene, glm::translate(glm::mat4(), position), Box<>(glm::vec3(-15.0f), glm::vec3(15.0f)));
+                light->m_light = pointLight;
+                nodes.push_back(light);
+            }
+            else {
+                nodes.push_back(new TestFrameArenaMeshNode(&scene, position, node));
+            }
+        }
+
+        //the same few views over and over, so after the first time around everything has grown as big as it needs to be
+        const glm::vec3 eyes[] = { glm::vec3(5.0f, 40.0f, 5.0f), glm::vec3(160.0f, 30.0f, 160.0f), glm::vec3(310.0f, 10.0f, 20.0f) };
+        const glm::vec3 targets[] = { glm::vec3(320.0f, 0.0f, 320.0f), glm::vec3(0.0f, 40.0f, 300.0f), glm::vec3(20.0f, 50.0f, 310.0f) };
+
+        illGraphics::Camera cameras[3];
+
+        for(int view = 0; view < 3; view++) {
+            cameras[view].setPerspectiveTransform(glm::inverse(glm::lookAt(eyes[view], targets[view], glm::vec3(0.0f, 1.0f, 0.0f))),
+                1.5f, 70.0f, 0.1f, 400.0f);
+        }
+
+        for(unsigned int frame = 0; frame < 12; frame++) {
+            size_t frameGlobalAllocations = testNumGlobalAllocations;
+
+            scene.setupFrame();
+            scene.render(cameras[frame % 3], viewport);
+
+            assert(scene.m_debugNumTraversedCells > 0);
+
+            if(frame >= 6) {
+                assert(testNumGlobalAllocations == frameGlobalAllocations);
+            }
+        }
+
+        assert(backend.getStats().m_cellsOccluded > 0);
+        assert(backend.getStats().m_solidObjects > 0);
+        assert(backend.getStats().m_lightInstances > 0);
+
+        for(size_t node = 0; node < nodes.size(); node++) {
+            delete nodes[node];
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "tests.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/Illmesh/IllmeshLoader.h"
+#include "Util/Illmesh/IllmeshWriter.h"
+
+void testIllmeshLoad(const MeshData<>& expected, const char * path) {
+    IllmeshLoader meshLoader(path);
+
+    assert(meshLoader.m_features == expected.getFeatures());
+    assert(meshLoader.m_numVert == expected.getNumVert());
+    assert(meshLoader.m_numInd == expected.getNumInd());
+    assert(meshLoader.m_numGroups == expected.getNumPrimitiveGroups());
+    assert(meshLoader.m_indexSize == expected.getIndexSize());
+
+    MeshData<> mesh(meshLoader.m_numInd, meshLoader.m_numVert, meshLoader.m_numGroups, meshLoader.m_features, true, meshLoader.m_indexSize);
+    meshLoader.buildMesh(mesh);
+
+    for(uint8_t group = 0; group < mesh.getNumPrimitiveGroups(); group++) {
+        assert(mesh.getPrimitiveGroup(group).m_type == expected.getPrimitiveGroup(group).m_type);
+        assert(mesh.getPrimitiveGroup(group).m_beginIndex == expected.getPrimitiveGroup(group).m_beginIndex);
+        assert(mesh.getPrimitiveGroup(group).m_numIndices == expected.getPrimitiveGroup(group).m_numIndices);
+    }
+
+    assert(memcmp(mesh.getData(), expected.getData(), mesh.getNumVert() * mesh.getVertexSize()) == 0);
+    assert(memcmp(mesh.getIndexData(), expected.getIndexData(), mesh.getNumInd() * mesh.getIndexSize()) == 0);
+}
+
+void testIllmesh() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    //a box with texture coordinates split into 2 groups, an odd vertex size and index count to make sure the padding works
+    MeshData<> mesh(Box<>(glm::vec3(-1.0f, -2.0f, -3.0f), glm::vec3(1.0f, 2.0f, 3.0f)), MF_POSITION | MF_TEX_COORD);
+
+    mesh.getPrimitiveGroup(0).m_numIndices = 18;
+
+    for(uint32_t vertex = 0; vertex < mesh.getNumVert(); vertex++) {
+        mesh.getTexCoord(vertex) = glm::vec2((float) vertex * 0.125f, 1.0f - (float) vertex * 0.125f);
+    }
+
+    {
+        MeshData<> groupedMesh(mesh.getNumInd() - 1, mesh.getNumVert(), 2, mesh.getFeatures());
+
+        memcpy(groupedMesh.getData(), mesh.getData(), mesh.getNumVert() * mesh.getVertexSize());
+        memcpy(groupedMesh.getIndices(), mesh.getIndices(), groupedMesh.getNumInd() * sizeof(uint16_t));
+        assert(groupedMesh.getIndexSize() == sizeof(uint16_t));
+
+        groupedMesh.getPrimitiveGroup(0) = mesh.getPrimitiveGroup(0);
+
+        groupedMesh.getPrimitiveGroup(1).m_type = MeshData<>::PrimitiveGroup::Type::LINE_LOOP;
+        groupedMesh.getPrimitiveGroup(1).m_beginIndex = 18;
+        groupedMesh.getPrimitiveGroup(1).m_numIndices = groupedMesh.getNumInd() - 18;
+
+        illFileSystem::File * file = stdioFileSystem.openWrite("testIllmesh1.illmesh");
+        writeIllmesh1(groupedMesh, file);
+        delete file;
+
+        testIllmeshLoad(groupedMesh, "testIllmesh1.illmesh");
+
+        //converting keeps everything the same
+        convertIllmesh("testIllmesh1.illmesh", "testIllmesh2.illmesh");
+        testIllmeshLoad(groupedMesh, "testIllmesh2.illmesh");
+
+        //blocks are aligned
+        {
+            IllmeshLoader meshLoader("testIllmesh2.illmesh");
+
+            assert(meshLoader.m_version == 2);
+            assert(meshLoader.m_numInd == 35);
+
+            file = stdioFileSystem.openRead("testIllmesh2.illmesh");
+
+            file->seek(MESH2_HEADER_SIZE - 8);
+
+            uint32_t vertexOffset;
+            file->readL32(vertexOffset);
+
+            uint32_t indexOffset;
+            file->readL32(indexOffset);
+
+            assert(vertexOffset % MESH2_BLOCK_ALIGNMENT == 0);
+            assert(indexOffset % MESH2_BLOCK_ALIGNMENT == 0);
+            assert(indexOffset >= vertexOffset + groupedMesh.getNumVert() * groupedMesh.getVertexSize());
+            assert(file->getSize() == indexOffset + groupedMesh.getNumInd() * sizeof(uint16_t));
+
+            delete file;
+        }
+    }
+
+    //a strip that needs 32 bit indices to reach the last vertices, small meshes still get 16 bit ones
+    {
+        assert(MeshData<>(3, MESH_MAX_16_BIT_INDEXED_VERTICES, 1, MF_POSITION, false).getIndexSize() == sizeof(uint16_t));
+
+        MeshData<> bigMesh(6, MESH_MAX_16_BIT_INDEXED_VERTICES + 2, 1, MF_POSITION);
+        assert(bigMesh.getIndexSize() == sizeof(uint32_t));
+
+        for(uint32_t vertex = 0; vertex < bigMesh.getNumVert(); vertex++) {
+            bigMesh.getPosition(vertex) = glm::vec3((float) vertex, 0.0f, (float) (vertex & 1));
+        }
+
+        for(uint32_t index = 0; index < bigMesh.getNumInd(); index++) {
+            bigMesh.setIndex(index, bigMesh.getNumVert() - 1 - index);
+        }
+
+        assert(bigMesh.getIndices32()[0] == MESH_MAX_16_BIT_INDEXED_VERTICES + 1);
+        assert(bigMesh.getIndex(5) == MESH_MAX_16_BIT_INDEXED_VERTICES - 4);
+
+        bigMesh.getPrimitiveGroup(0).m_type = MeshData<>::PrimitiveGroup::Type::TRIANGLE_STRIP;
+        bigMesh.getPrimitiveGroup(0).m_beginIndex = 0;
+        bigMesh.getPrimitiveGroup(0).m_numIndices = bigMesh.getNumInd();
+
+        illFileSystem::File * file = stdioFileSystem.openWrite("testIllmesh2.illmesh");
+        writeIllmesh2(bigMesh, file);
+        delete file;
+
+        testIllmeshLoad(bigMesh, "testIllmesh2.illmesh");
+    }
+
+    remove("testIllmesh1.illmesh");
+    remove("testIllmesh2.illmesh");
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
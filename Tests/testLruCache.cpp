@@ -0,0 +1,158 @@
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+#include "tests.h"
+#include "Util/serial/LruCache.h"
+
+/**
+An element that says how big it is and can hold on to another element from the same cache.
+*/
+struct TestLruElement : public RefCounted<> {
+    TestLruElement(size_t size)
+        : m_size(size)
+    {}
+
+    size_t m_size;
+    IntrusivePtr<TestLruElement> m_child;
+};
+
+typedef LruCache<int, TestLruElement> TestLruCache;
+
+void testLruCache() {
+    //byte budget
+    {
+        int numCreated = 0;
+
+        TestLruCache cache([&numCreated] (int key) {
+            ++numCreated;
+            return new TestLruElement(key);
+        }, 50, std::chrono::hours(1));
+
+        cache.setSizeFunc([] (const TestLruElement& element) {
+            return element.m_size;
+        });
+
+        cache.setMemoryBudget(100);
+
+        {
+            IntrusivePtr<TestLruElement> a = cache.getElement(40);
+            IntrusivePtr<TestLruElement> b = cache.getElement(30);
+            IntrusivePtr<TestLruElement> c = cache.getElement(20);
+
+            assert(cache.getMemoryUsage() == 90);
+            assert(cache.getNumUnreferenced() == 0);
+
+            //referenced elements never get evicted even over the budget
+            IntrusivePtr<TestLruElement> d = cache.getElement(50);
+            assert(cache.getMemoryUsage() == 140);
+            assert(cache.getStats().m_evictions == 0);
+
+            //released in the order b, a, then d and c when the scope ends
+            b.reset();
+            assert(cache.getNumElements() == 3);         //b evicted right away since the cache is over budget
+            assert(cache.getMemoryUsage() == 110);
+            assert(cache.getStats().m_evictions == 1);
+
+            a.reset();
+            assert(cache.getMemoryUsage() == 70);
+            assert(cache.getStats().m_evictions == 2);
+        }
+
+        //under budget now so d and c stay cached
+        assert(cache.getNumElements() == 2);
+        assert(cache.getNumUnreferenced() == 2);
+        assert(cache.getMemoryUsage() == 70);
+
+        numCreated = 0;
+        cache.getElement(50);
+        cache.getElement(20);
+        assert(numCreated == 0);
+        assert(cache.getStats().m_misses == 4);
+        assert(cache.getStats().m_hits == 2);
+
+        //shrinking the budget evicts the least recently released first, which is now d
+        cache.setMemoryBudget(30);
+        assert(cache.getNumElements() == 1);
+        assert(cache.getMemoryUsage() == 20);
+        cache.getElement(20);
+        assert(numCreated == 0);
+
+        cache.resetStats();
+        assert(cache.getStats().m_hits == 0);
+
+        cache.clear();
+        assert(cache.getMemoryUsage() == 0);
+    }
+
+    //the size gets measured again on release
+    {
+        TestLruCache cache([] (int) {
+            return new TestLruElement(0);
+        });
+
+        cache.setSizeFunc([] (const TestLruElement& element) {
+            return element.m_size;
+        });
+
+        IntrusivePtr<TestLruElement> element = cache.getElement(1);
+        assert(cache.getMemoryUsage() == 0);
+
+        element->m_size = 64;
+        element.reset();
+        assert(cache.getMemoryUsage() == 64);
+    }
+
+    //evicting an element that releases another element in the same cache
+    {
+        TestLruCache cache([] (int) {
+            return new TestLruElement(10);
+        }, 50, std::chrono::hours(1));
+
+        cache.setSizeFunc([] (const TestLruElement& element) {
+            return element.m_size;
+        });
+
+        cache.setMemoryBudget(15);
+
+        {
+            IntrusivePtr<TestLruElement> parent = cache.getElement(1);
+            parent->m_child = cache.getElement(2);
+        }
+
+        //the parent got evicted, which released the child, which is within budget alone
+        assert(cache.getNumElements() == 1);
+        assert(cache.getMemoryUsage() == 10);
+        assert(cache.getStats().m_evictions == 1);
+
+        cache.setMemoryBudget(5);
+        assert(cache.getNumElements() == 0);
+        assert(cache.getMemoryUsage() == 0);
+    }
+
+    //eviction time without a budget
+    {
+        TestLruCache cache([] (int) {
+            return new TestLruElement(1);
+        }, 50, std::chrono::milliseconds(20));
+
+        cache.getElement(1);
+        cache.getElement(2);
+        assert(cache.getNumElements() == 2);
+
+        //too soon
+        cache.evict();
+        assert(cache.getNumElements() == 2);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cache.getElement(3);
+
+        //the two old ones go and the just released one stays
+        assert(cache.getNumElements() == 1);
+        assert(cache.getStats().m_evictions == 2);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        cache.evict();
+        assert(cache.getNumElements() == 0);
+    }
+}
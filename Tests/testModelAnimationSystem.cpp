@@ -0,0 +1,161 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
+
+#include "tests.h"
+#include "testSkeletonUtil.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/parallel/ThreadPool.h"
+#include "Graphics/serial/Model/Skeleton.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+#include "Graphics/serial/Model/ModelAnimationSystem.h"
+
+/**
+Writes an ILLSKEL0 file with a chain of bones, each one the parent of the next.
+*/
+void testAnimationSystemWriteSkeleton(const char * path, uint16_t numBones) {
+    std::vector<glm::mat4> relativeTransforms(numBones);
+    std::vector<glm::mat4> offsetTransforms(numBones);
+    std::vector<uint16_t> parents(numBones);
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        relativeTransforms[bone] = glm::translate(glm::vec3(0.0f, 0.2f, 0.0f)) * glm::rotate((float) bone * 3.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+        offsetTransforms[bone] = glm::translate(glm::vec3(0.0f, -0.2f * (float) bone, 0.0f));
+        parents[bone] = bone == 0 ? 0 : bone - 1;
+    }
+
+    writeTestSkeleton(path, relativeTransforms, offsetTransforms, parents);
+}
+
+/**
+Animates every bone spinning around a different axis.
+*/
+void testAnimationSystemMakeAnimation(illGraphics::SkeletonAnimation& animation, uint16_t numBones, float speed) {
+    illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+
+    for(uint16_t bone = 0; bone < numBones; bone++) {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[bone];
+
+        animData.m_positionKeys.resize(5);
+        animData.m_rotationKeys.resize(5);
+        animData.m_scalingKeys.resize(5);
+
+        glm::vec3 axis = glm::normalize(glm::vec3(1.0f, (float) (bone % 3), (float) (bone % 5)));
+
+        for(unsigned int key = 0; key < 5; key++) {
+            float time = (float) key * 0.5f;
+            float angle = time * speed + (float) bone;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3(0.0f, 0.2f, 0.0f);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::quat(std::cos(angle), axis.x * std::sin(angle), axis.y * std::sin(angle), axis.z * std::sin(angle));
+
+            animData.m_scalingKeys[key].m_time = time;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+
+    animation.encode(2.0f, boneAnimation);
+}
+
+/**
+Adds the same crowd to a system every time, with skeletons of different sizes so the controllers take different amounts of time,
+and transitions at different times so some are blending on any given frame.
+*/
+void testAnimationSystemSetup(illGraphics::ModelAnimationSystem& system, illGraphics::Skeleton * skeletons,
+        illGraphics::SkeletonAnimation * walks, illGraphics::SkeletonAnimation * runs) {
+    for(unsigned int character = 0; character < 300; character++) {
+        unsigned int skeleton = character % 3;
+
+        illGraphics::ModelAnimationController * controller = system.addController(&skeletons[skeleton]);
+        controller->queueTransition(&walks[skeleton], 0.0f, 0.0f);
+        controller->queueTransition(&runs[skeleton], 0.3f, 0.1f + (float) (character % 10) * 0.05f);
+        controller->queueTransition(&walks[skeleton], 0.5f, 0.4f + (float) (character % 7) * 0.05f);
+    }
+}
+
+void testModelAnimationSystem() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    const uint16_t numBones[] = { 5, 40, 120 };
+
+    illGraphics::Skeleton skeletons[3];
+    illGraphics::SkeletonAnimation walks[3];
+    illGraphics::SkeletonAnimation runs[3];
+
+    for(unsigned int skeleton = 0; skeleton < 3; skeleton++) {
+        testAnimationSystemWriteSkeleton("testModelAnimationSystem.illskel", numBones[skeleton]);
+
+        illGraphics::SkeletonLoadArgs loadArgs;
+        loadArgs.m_path = "testModelAnimationSystem.illskel";
+        skeletons[skeleton].load(loadArgs, NULL);
+
+        testAnimationSystemMakeAnimation(walks[skeleton], numBones[skeleton], 1.0f);
+        testAnimationSystemMakeAnimation(runs[skeleton], numBones[skeleton], 3.0f);
+    }
+
+    remove("testModelAnimationSystem.illskel");
+
+    ThreadPool threadPool(3);
+
+    illGraphics::ModelAnimationSystem serialSystem;
+    illGraphics::ModelAnimationSystem parallelSystem(&threadPool);
+
+    testAnimationSystemSetup(serialSystem, skeletons, walks, runs);
+    testAnimationSystemSetup(parallelSystem, skeletons, walks, runs);
+
+    //the palette is packed with each controller's bones right after the last one's
+    size_t paletteSize = 0;
+
+    for(size_t controller = 0; controller < serialSystem.getNumControllers(); controller++) {
+        assert(serialSystem.getPaletteOffset(controller) == paletteSize);
+        paletteSize += numBones[controller % 3];
+    }
+
+    assert(serialSystem.getPaletteSize() == paletteSize);
+    assert(parallelSystem.getPaletteSize() == paletteSize);
+
+    //a controller posed on its own, to check the system writes the same thing into the palette
+    illGraphics::ModelAnimationController loneController;
+    loneController.setSkeleton(&skeletons[2]);
+    loneController.queueTransition(&walks[2], 0.0f, 0.0f);
+    loneController.queueTransition(&runs[2], 0.3f, 0.1f + (float) (5 % 10) * 0.05f);
+    loneController.queueTransition(&walks[2], 0.5f, 0.4f + (float) (5 % 7) * 0.05f);
+
+    std::vector<glm::mat4> loneMats(numBones[2]);
+
+    bool sawTransition = false;
+
+    for(unsigned int frame = 0; frame < 60; frame++) {
+        serialSystem.update(1.0f / 60.0f);
+        parallelSystem.update(1.0f / 60.0f);
+
+        //exactly the same, not just close
+        assert(memcmp(serialSystem.getPalette(), parallelSystem.getPalette(), paletteSize * sizeof(glm::mat4)) == 0);
+
+        loneController.update(1.0f / 60.0f);
+        loneController.computeAnimPose(&loneMats[0]);
+
+        assert(memcmp(&loneMats[0], serialSystem.getPalette() + serialSystem.getPaletteOffset(5), numBones[2] * sizeof(glm::mat4)) == 0);
+
+        if(serialSystem.getController(5).m_transitionWeight > 0.0f) {
+            sawTransition = true;
+        }
+    }
+
+    assert(sawTransition);
+
+    parallelSystem.clear();
+    assert(parallelSystem.getNumControllers() == 0 && parallelSystem.getPaletteSize() == 0 && parallelSystem.getPalette() == NULL);
+
+    parallelSystem.update(1.0f / 60.0f);
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
@@ -0,0 +1,154 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "tests.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem/BufferedFileReader.h"
+#include "FileSystem-Pack/PackFileSystem.h"
+#include "FileSystem-Pack/PackFile.h"
+#include "FileSystem-Pack/PackWriter.h"
+
+const unsigned int TEST_PACK_NUM_SMALL_FILES = 500;
+
+/**
+Reads a whole file from a pack and checks it has exactly the expected contents.
+*/
+void testPackFileContents(const illPack::PackFileSystem& packFileSystem, const char * path, const void * expected, size_t size) {
+    illFileSystem::File * file = packFileSystem.openRead(path);
+    assert(file->getSize() == size);
+
+    if(size > 0) {
+        char contents[2048];
+        assert(size <= sizeof(contents));
+
+        file->read(contents, size);
+        assert(memcmp(contents, expected, size) == 0);
+    }
+
+    assert(file->eof());
+    delete file;
+}
+
+void testPackFileSystem() {
+    illStdio::StdioFileSystem stdioFileSystem;
+
+    uint8_t block[1000];
+
+    for(unsigned int byte = 0; byte < sizeof(block); byte++) {
+        block[byte] = (uint8_t) (byte * 7);
+    }
+
+    //the first pack, with odd sizes so the alignment padding gets exercised
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testPack1.illpack");
+        illPack::PackWriter writer(file, 64);
+
+        writer.addFile("a.txt", "hello", 5);
+        writer.addFile("dir\\block.bin", block, sizeof(block));
+        writer.addFile("empty", NULL, 0);
+
+        for(unsigned int smallFile = 0; smallFile < TEST_PACK_NUM_SMALL_FILES; smallFile++) {
+            char path[64];
+            sprintf(path, "small/file%u.mat", smallFile);
+
+            writer.addFile(path, &smallFile, sizeof(smallFile));
+        }
+
+        writer.finish();
+        assert(writer.getNumFiles() == TEST_PACK_NUM_SMALL_FILES + 3);
+
+        delete file;
+    }
+
+    //the second pack has a file with the same path as the first, which should be hidden by the first
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testPack2.illpack");
+        illPack::PackWriter writer(file);
+
+        writer.addFile("a.txt", "goodbye", 7);
+        writer.addFile("c.txt", "see", 3);
+
+        writer.finish();
+        delete file;
+    }
+
+    {
+        illPack::PackFileSystem packFileSystem;
+        packFileSystem.addPath("testPack1.illpack");
+        packFileSystem.addPath("testPack2.illpack");
+        assert(packFileSystem.getNumPacks() == 2);
+
+        assert(packFileSystem.fileExists("a.txt"));
+        assert(packFileSystem.fileExists("c.txt"));
+        assert(packFileSystem.fileExists("dir/block.bin"));
+        assert(packFileSystem.fileExists("dir\\block.bin"));
+        assert(!packFileSystem.fileExists("dir/block.bi"));
+        assert(!packFileSystem.fileExists("missing"));
+        assert(!packFileSystem.fileExists(""));
+
+        testPackFileContents(packFileSystem, "a.txt", "hello", 5);
+        testPackFileContents(packFileSystem, "c.txt", "see", 3);
+        testPackFileContents(packFileSystem, "empty", NULL, 0);
+        testPackFileContents(packFileSystem, "dir/block.bin", block, sizeof(block));
+
+        for(unsigned int smallFile = 0; smallFile < TEST_PACK_NUM_SMALL_FILES; smallFile++) {
+            char path[64];
+            sprintf(path, "small/file%u.mat", smallFile);
+
+            testPackFileContents(packFileSystem, path, &smallFile, sizeof(smallFile));
+        }
+
+        //seeking around and reading in place
+        {
+            illPack::PackFile * file = static_cast<illPack::PackFile *>(packFileSystem.openRead("dir/block.bin"));
+
+            assert(((uintptr_t) file->getData() & 63) == 0);
+            assert(memcmp(file->getData(), block, sizeof(block)) == 0);
+
+            file->seek(100);
+            assert(file->tell() == 100);
+
+            uint8_t byte;
+            file->read8(byte);
+            assert(byte == block[100]);
+
+            file->seekAhead(10);
+            assert(file->tell() == 111);
+
+            uint32_t value;
+            file->readL32(value);
+
+            uint32_t expected;
+            memcpy(&expected, block + 111, sizeof(expected));
+            assert(value == little32(expected));
+
+            file->seek(sizeof(block));
+            assert(file->eof());
+
+            delete file;
+        }
+
+        //the buffered reader the loaders use works on top of it
+        {
+            illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+            illFileSystem::fileSystem = &packFileSystem;
+
+            illFileSystem::BufferedFileReader * reader = illFileSystem::openBufferedRead("dir/block.bin");
+
+            for(unsigned int byte = 0; byte < sizeof(block); byte++) {
+                uint8_t value;
+                reader->read8(value);
+                assert(value == block[byte]);
+            }
+
+            assert(reader->eof());
+            delete reader;
+
+            illFileSystem::fileSystem = oldFileSystem;
+        }
+    }
+
+    remove("testPack1.illpack");
+    remove("testPack2.illpack");
+}
@@ -0,0 +1,312 @@
+#include <cassert>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "tests.h"
+#include "testUtil.h"
+#include "Util/parallel/ThreadPool.h"
+#include "Graphics/serial/Camera/Camera.h"
+#include "RendererCommon/serial/LightNode.h"
+#include "RendererCommon/serial/StaticMeshNode.h"
+#include "DeferredShadingRenderer/serial/DeferredShadingScene.h"
+
+using namespace illRendererCommon;
+using namespace illDeferredShadingRenderer;
+
+/**
+Lets the test find out which node something came from, since the two scenes have different node pointers.
+*/
+struct TestNodeId {
+    TestNodeId(uint64_t id)
+        : m_id(id)
+    {}
+
+    uint64_t m_id;
+};
+
+class TestLightNode : public LightNode, public TestNodeId {
+public:
+    TestLightNode(GraphicsScene * scene, const glm::vec3& position, uint64_t id)
+        : LightNode(scene, glm::translate(glm::mat4(), position), Box<>(glm::vec3(-15.0f), glm::vec3(15.0f))),
+        TestNodeId(id)
+    {}
+};
+
+/**
+Queues some fake mesh entries the way StaticMeshNode does, including getting the affecting lights.
+A third of the nodes always occlude and a third are limited occluders, so the depth pass limit decides whether those get queued.
+*/
+class TestMeshNode : public StaticMeshNode, public TestNodeId {
+public:
+    TestMeshNode(GraphicsScene * scene, const glm::vec3& position, uint64_t id)
+        : StaticMeshNode(scene, glm::translate(glm::mat4(), position), Box<>(glm::vec3(-4.0f), glm::vec3(4.0f)),
+            id % 3 == 0 ? OccluderType::ALWAYS : (id % 3 == 1 ? OccluderType::LIMITED : OccluderType::NEVER)),
+        TestNodeId(id)
+    {}
+
+    virtual void render(RenderQueues& renderQueues) {
+        //lots of equal keys so the merge order actually matters
+        uint64_t key = RenderQueues::staticMeshSortKey(m_id % 3, (uint32_t) (m_id % 5), (uint32_t) (m_id % 7), 0);
+
+        if(m_occluderType == OccluderType::ALWAYS || (m_occluderType == OccluderType::LIMITED && renderQueues.m_depthPassObjects < renderQueues.m_depthPassLimit)) {
+            auto& depthInfo = renderQueues.addDepthPassSolidStaticMesh(key, fakePointer<illGraphics::ShaderProgram>(m_id % 3),
+                fakePointer<illGraphics::Material>(m_id % 5), fakePointer<illGraphics::Mesh>(m_id % 7));
+            depthInfo.m_node = this;
+
+            ++renderQueues.m_depthPassObjects;
+        }
+
+        auto& info = renderQueues.addSolidStaticMesh(key, fakePointer<illGraphics::ShaderProgram>(m_id % 3),
+            fakePointer<illGraphics::Material>(m_id % 5), fakePointer<illGraphics::Mesh>(m_id % 7));
+        info.m_meshInfo.m_node = this;
+
+        info.m_affectingLights = &getAffectingLights();
+
+        if(m_id % 4 == 0) {
+            auto& unsolidInfo = renderQueues.addUnsolidStaticMesh(key, fakePointer<illGraphics::ShaderProgram>(m_id % 3),
+                fakePointer<illGraphics::Material>(m_id % 5), fakePointer<illGraphics::Mesh>(m_id % 7));
+            unsolidInfo.m_meshInfo.m_node = this;
+        }
+    }
+};
+
+/**
+A backend that doesn't draw anything, it just writes down everything it was asked to do.
+Cell queries come back visible for 2 out of every 3 cells so some cells get culled.
+*/
+class TestBackend : public DeferredShadingBackend {
+public:
+    TestBackend()
+        : DeferredShadingBackend(NULL),
+        m_numLimitedOccluders(0)
+    {}
+
+    virtual void initialize(const glm::uvec2 screenResolution, illGraphics::ShaderProgramManager * shaderProgramManager) {}
+    virtual void uninitialize() {}
+    virtual void setupFrame() {}
+    virtual void setupViewport(const illGraphics::Camera& camera) {}
+
+    virtual void retreiveCellQueries(CellQueryFrames& lastViewedFrames, uint64_t lastFrameCounter,
+            uint64_t successDuration, uint64_t failureDuration, uint64_t randomAddMax) {
+        for(size_t query = 0; query < m_queriedCells.size(); query++) {
+            unsigned int cell = m_queriedCells[query];
+            bool visible = cell % 3 != 0;
+
+            lastViewedFrames.at(0).getMutable(cell) = encodeVisible(visible)
+                | codeFrame(lastFrameCounter + (visible ? successDuration : failureDuration));
+        }
+
+        m_queriedCells.clear();
+    }
+
+    virtual void retreiveNodeQueries(uint64_t lastFrameCounter) {
+        for(size_t node = 0; node < m_hiddenNodes.size(); node++) {
+            m_hiddenNodes[node]->setLastNonvisibleFrame(0, lastFrameCounter);
+        }
+    }
+
+    virtual void setupQuery() {
+        m_log.push_back(1);
+    }
+
+    virtual void endQuery() {
+        m_log.push_back(2);
+    }
+
+    virtual void * occlusionQueryCell(const illGraphics::Camera& camera, const glm::vec3& cellCenter, const glm::vec3& cellSize,
+            unsigned int cellArrayIndex, size_t viewport, bool debugDraw) {
+        m_queriedCells.push_back(cellArrayIndex);
+
+        m_log.push_back(3);
+        m_log.push_back(cellArrayIndex);
+
+        return fakePointer<void>(cellArrayIndex);
+    }
+
+    virtual void * occlusionQueryNode(const illGraphics::Camera& camera, GraphicsNode * node, size_t viewport) {
+        m_log.push_back(4);
+        m_log.push_back(dynamic_cast<TestNodeId *>(node)->m_id);
+
+        return NULL;
+    }
+
+    virtual void depthPass(RenderQueues& renderQueues, const illGraphics::Camera& camera, void * cellOcclusionQuery, size_t viewport) {
+        m_log.push_back(5);
+        m_log.push_back((uint64_t) (uintptr_t) cellOcclusionQuery);
+        m_log.push_back(renderQueues.m_sortedDepthPassSolidStaticMeshes.size());
+
+        for(size_t entry = 0; entry < renderQueues.m_sortedDepthPassSolidStaticMeshes.size(); entry++) {
+            const StaticMeshNode * node = renderQueues.m_sortedDepthPassSolidStaticMeshes[entry].m_info.m_node;
+
+            m_log.push_back(dynamic_cast<const TestNodeId *>(node)->m_id);
+
+            if(node->m_occluderType == StaticMeshNode::OccluderType::LIMITED) {
+                ++m_numLimitedOccluders;
+            }
+        }
+
+        renderQueues.clearDepthPass();
+    }
+
+    virtual void render(RenderQueues& renderQueues, const illGraphics::Camera& camera, size_t viewport,
+            const GridVolume3D<>* debugGridVolume, const CellQueryFrames* debugLastViewedFrames, uint64_t debugFrameCounter,
+            int debugTraversals) {
+        logQueue(renderQueues.m_sortedSolidStaticMeshes, 6);
+        logQueue(renderQueues.m_sortedUnsolidStaticMeshes, 7);
+
+        //all the test lights share one light so there's one list to check
+        for(auto typeIter = renderQueues.m_lights.begin(); typeIter != renderQueues.m_lights.end(); typeIter++) {
+            for(auto lightIter = typeIter->second.begin(); lightIter != typeIter->second.end(); lightIter++) {
+                m_log.push_back(8);
+
+                for(size_t node = 0; node < lightIter->second.size(); node++) {
+                    m_log.push_back(dynamic_cast<const TestNodeId *>(lightIter->second[node])->m_id);
+                }
+            }
+        }
+    }
+
+    void logQueue(const RenderQueues::SortedQueue<RenderQueues::StaticMeshLightInfo>& queue, uint64_t tag) {
+        m_log.push_back(tag);
+        m_log.push_back(queue.size());
+
+        for(size_t entry = 0; entry < queue.size(); entry++) {
+            const RenderQueues::StaticMeshLightInfo& info = queue[entry].m_info;
+
+            m_log.push_back(dynamic_cast<const TestNodeId *>(info.m_meshInfo.m_node)->m_id);
+            //the test only gives the solid entries their lights
+            if(!info.m_affectingLights) {
+                m_log.push_back(0);
+                continue;
+            }
+
+            m_log.push_back(info.m_affectingLights->size());
+
+            for(auto light = info.m_affectingLights->begin(); light != info.m_affectingLights->end(); light++) {
+                m_log.push_back(dynamic_cast<const TestNodeId *>(*light)->m_id);
+            }
+        }
+    }
+
+    std::vector<uint64_t> m_log;
+    size_t m_numLimitedOccluders;
+    std::vector<unsigned int> m_queriedCells;
+    std::vector<GraphicsNode *> m_hiddenNodes;
+};
+
+/**
+A scene along with its nodes, set up the same way every time.
+*/
+struct TestScene {
+    TestScene(ThreadPool * threadPool)
+        : m_cellDimensions(10.0f),
+        m_interactionCellDimensions(20.0f),
+        m_scene(&m_backend, NULL, NULL,
+            m_cellDimensions, glm::uvec3(32, 8, 32),
+            m_interactionCellDimensions, glm::uvec3(16, 4, 16))
+    {
+        m_scene.m_threadPool = threadPool;
+        m_scene.m_debugPerObjectCull = true;
+        m_viewport = m_scene.registerViewport();
+
+        m_light = RefCountPtr<illGraphics::LightBase>(new illGraphics::PointLight(glm::vec3(1.0f), 1.0f, true, 5.0f, 15.0f));
+
+        //same pseudo random positions for every scene
+        uint32_t random = 12345;
+
+        for(uint64_t node = 0; node < 2000; node++) {
+            glm::vec3 position;
+
+            for(int axis = 0; axis < 3; axis++) {
+                random = random * 1664525 + 1013904223;
+                position[axis] = (float) (random >> 8) / (float) (1 << 24) * (axis == 1 ? 75.0f : 315.0f) + 2.5f;
+            }
+
+            if(node % 50 == 0) {
+                TestLightNode * light = new TestLightNode(&m_scene, position, node);
+                light->m_light = m_light;
+                m_nodes.push_back(light);
+            }
+            else {
+                m_nodes.push_back(new TestMeshNode(&m_scene, position, node));
+            }
+
+            if(node % 37 == 0) {
+                m_backend.m_hiddenNodes.push_back(m_nodes.back());
+            }
+        }
+    }
+
+    ~TestScene() {
+        for(size_t node = 0; node < m_nodes.size(); node++) {
+            delete m_nodes[node];
+        }
+    }
+
+    void renderFrame(const illGraphics::Camera& camera) {
+        m_backend.m_log.clear();
+        m_backend.m_numLimitedOccluders = 0;
+
+        m_scene.setupFrame();
+        m_scene.render(camera, m_viewport);
+    }
+
+    glm::vec3 m_cellDimensions;
+    glm::vec3 m_interactionCellDimensions;
+    TestBackend m_backend;
+    DeferredShadingScene m_scene;
+    size_t m_viewport;
+    RefCountPtr<illGraphics::LightBase> m_light;
+    std::vector<GraphicsNode *> m_nodes;
+};
+
+void testParallelRender() {
+    ThreadPool threadPool(3);
+
+    TestScene serialScene(NULL);
+    TestScene parallelScene(&threadPool);
+
+    //look around from a few spots for a few frames each so the query results from earlier frames come into play
+    const glm::vec3 eyes[] = { glm::vec3(5.0f, 40.0f, 5.0f), glm::vec3(160.0f, 30.0f, 160.0f), glm::vec3(310.0f, 10.0f, 20.0f) };
+    const glm::vec3 targets[] = { glm::vec3(320.0f, 0.0f, 320.0f), glm::vec3(0.0f, 40.0f, 300.0f), glm::vec3(20.0f, 50.0f, 310.0f) };
+
+    //how many limited occluders made it into the depth pass with and without the limit
+    size_t numLimitedOccluders[2] = { 0, 0 };
+
+    for(int frame = 0; frame < 12; frame++) {
+        illGraphics::Camera camera;
+        camera.setPerspectiveTransform(glm::inverse(glm::lookAt(eyes[frame / 4], targets[frame / 4], glm::vec3(0.0f, 1.0f, 0.0f))),
+            1.5f, 70.0f, 0.1f, 400.0f);
+
+        //also limit the traversal for a frame
+        int maxTraversals = frame == 6 ? 50 : -1;
+        serialScene.m_scene.m_debugMaxCellTraversals = maxTraversals;
+        parallelScene.m_scene.m_debugMaxCellTraversals = maxTraversals;
+
+        //every other frame cut off the limited occluders partway through the frame,
+        //the scene starts each frame counting 75 depth pass objects already
+        size_t depthPassLimit = frame % 2 == 0 ? 150 : (size_t) -1;
+        serialScene.m_scene.getRenderQueues().m_depthPassLimit = depthPassLimit;
+        parallelScene.m_scene.getRenderQueues().m_depthPassLimit = depthPassLimit;
+
+        serialScene.renderFrame(camera);
+        parallelScene.renderFrame(camera);
+
+        assert(!serialScene.m_backend.m_log.empty());
+        assert(serialScene.m_backend.m_log == parallelScene.m_backend.m_log);
+
+        assert(serialScene.m_backend.m_numLimitedOccluders == parallelScene.m_backend.m_numLimitedOccluders);
+        assert(serialScene.m_backend.m_numLimitedOccluders <= depthPassLimit - 75);
+        numLimitedOccluders[frame % 2] += serialScene.m_backend.m_numLimitedOccluders;
+
+        assert(serialScene.m_scene.m_debugNumTraversedCells == parallelScene.m_scene.m_debugNumTraversedCells);
+        assert(serialScene.m_scene.m_debugNumEmptyCells == parallelScene.m_scene.m_debugNumEmptyCells);
+        assert(serialScene.m_scene.m_debugNumCulledCells == parallelScene.m_scene.m_debugNumCulledCells);
+        assert(serialScene.m_scene.m_debugNumRenderedNodes == parallelScene.m_scene.m_debugNumRenderedNodes);
+        assert(serialScene.m_scene.m_debugNumQueries == parallelScene.m_scene.m_debugNumQueries);
+    }
+
+    assert(numLimitedOccluders[0] > 0);
+    assert(numLimitedOccluders[1] > 0);
+}
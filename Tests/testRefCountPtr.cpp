@@ -1,9 +1,16 @@
 #include <SDL_assert.h>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "Logging/logging.h"
 #include "Util/serial/RefCountPtr.h"
+#include "Util/serial/IntrusivePtr.h"
 
 #include "tests.h"
+#include "benchmarks.h"
 
 //not exactly the best written tests right now, relies on you manually putting breakpoints and debugging, it works though and helped me fix an awful bug
 
@@ -111,3 +118,230 @@ void testRefCountPtr() {
    LOG_INFO("Should be freed");
    SDL_TriggerBreakpoint();
 }
+
+template <typename RefCountPolicy>
+struct TestIntrusiveObject : public RefCounted<RefCountPolicy> {
+   TestIntrusiveObject(int * numDeleted)
+      : m_numDeleted(numDeleted),
+      m_value(0)
+   {}
+
+   virtual ~TestIntrusiveObject() {
+      ++*m_numDeleted;
+   }
+
+   int * m_numDeleted;
+   int m_value;
+};
+
+struct TestIntrusiveOwner : public RefCountOwner {
+   TestIntrusiveOwner()
+      : m_numZero(0),
+      m_numNonZero(0)
+   {}
+
+   virtual void onZeroReferences(void * ownerData) {
+      assert(ownerData == this);
+      ++m_numZero;
+   }
+
+   virtual void onNonZeroReferences(void * ownerData) {
+      assert(ownerData == this);
+      ++m_numNonZero;
+   }
+
+   int m_numZero;
+   int m_numNonZero;
+};
+
+void testIntrusivePtr() {
+   int numDeleted = 0;
+
+   //copying, moving, and deleting itself
+   {
+      IntrusivePtr<TestIntrusiveObject<SerialRefCount> > ptr(new TestIntrusiveObject<SerialRefCount>(&numDeleted));
+      assert(ptr->getReferences() == 1);
+
+      {
+         IntrusivePtr<TestIntrusiveObject<SerialRefCount> > copy = ptr;
+         assert(ptr->getReferences() == 2);
+         assert(copy == ptr);
+      }
+
+      assert(ptr->getReferences() == 1);
+
+      IntrusivePtr<TestIntrusiveObject<SerialRefCount> > moved(std::move(ptr));
+      assert(ptr.isNull());
+      assert(moved->getReferences() == 1);
+
+      ptr = std::move(moved);
+      assert(moved.isNull());
+      assert(ptr->getReferences() == 1);
+
+      //assigning over the last reference to something else deletes the old object
+      ptr = IntrusivePtr<TestIntrusiveObject<SerialRefCount> >(new TestIntrusiveObject<SerialRefCount>(&numDeleted));
+      assert(numDeleted == 1);
+
+      ptr = ptr;
+      assert(ptr->getReferences() == 1);
+   }
+
+   assert(numDeleted == 2);
+
+   //an owner gets told instead of the object deleting itself
+   {
+      TestIntrusiveOwner owner;
+      TestIntrusiveObject<SerialRefCount> * object = new TestIntrusiveObject<SerialRefCount>(&numDeleted);
+      object->setRefCountOwner(&owner, &owner);
+
+      {
+         IntrusivePtr<TestIntrusiveObject<SerialRefCount> > ptr(object);
+         IntrusivePtr<TestIntrusiveObject<SerialRefCount> > copy = ptr;
+      }
+
+      assert(owner.m_numNonZero == 1);
+      assert(owner.m_numZero == 1);
+      assert(numDeleted == 2);
+
+      IntrusivePtr<TestIntrusiveObject<SerialRefCount> > ptr(object);
+      assert(owner.m_numNonZero == 2);
+
+      ptr.reset();
+      assert(owner.m_numZero == 2);
+
+      delete object;
+      assert(numDeleted == 3);
+   }
+
+   //lots of threads copying and dropping the same atomic object, it should be deleted exactly once at the end
+   {
+      IntrusivePtr<TestIntrusiveObject<AtomicRefCount> > shared(new TestIntrusiveObject<AtomicRefCount>(&numDeleted));
+      std::vector<std::thread> threads;
+
+      for(int thread = 0; thread < 8; thread++) {
+         threads.push_back(std::thread([shared] () {
+            for(int copy = 0; copy < 10000; copy++) {
+               IntrusivePtr<TestIntrusiveObject<AtomicRefCount> > local = shared;
+               IntrusivePtr<TestIntrusiveObject<AtomicRefCount> > moved = std::move(local);
+            }
+         }));
+      }
+
+      for(size_t thread = 0; thread < threads.size(); thread++) {
+         threads[thread].join();
+      }
+
+      assert(shared->getReferences() == 1);
+      assert(numDeleted == 3);
+   }
+
+   assert(numDeleted == 4);
+}
+
+const unsigned int BENCH_REF_COUNT_PTR_OBJECTS = 10000;
+const unsigned int BENCH_REF_COUNT_PTR_RUNS = 1000;
+
+struct BenchRefCountPtrObject {
+   BenchRefCountPtrObject(int value)
+      : m_value(value)
+   {}
+
+   int m_value;
+};
+
+template <typename RefCountPolicy>
+struct BenchIntrusiveObject : public RefCounted<RefCountPolicy> {
+   BenchIntrusiveObject(int value)
+      : m_value(value)
+   {}
+
+   int m_value;
+};
+
+/**
+Times copying then dropping, moving back and forth, and dereferencing a list of pointers.
+*/
+template <typename Ptr>
+void benchRefCountPtrRun(const char * name, std::vector<Ptr>& pointers) {
+   std::vector<Ptr> copies(pointers.size());
+   volatile int sink = 0;
+
+   auto start = std::chrono::high_resolution_clock::now();
+
+   for(unsigned int run = 0; run < BENCH_REF_COUNT_PTR_RUNS; run++) {
+      for(size_t pointer = 0; pointer < pointers.size(); pointer++) {
+         copies[pointer] = pointers[pointer];
+      }
+
+      for(size_t pointer = 0; pointer < pointers.size(); pointer++) {
+         copies[pointer].reset();
+      }
+   }
+
+   long long copyTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+   start = std::chrono::high_resolution_clock::now();
+
+   for(unsigned int run = 0; run < BENCH_REF_COUNT_PTR_RUNS; run++) {
+      for(size_t pointer = 0; pointer < pointers.size(); pointer++) {
+         copies[pointer] = std::move(pointers[pointer]);
+      }
+
+      for(size_t pointer = 0; pointer < pointers.size(); pointer++) {
+         pointers[pointer] = std::move(copies[pointer]);
+      }
+   }
+
+   long long moveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+   start = std::chrono::high_resolution_clock::now();
+
+   for(unsigned int run = 0; run < BENCH_REF_COUNT_PTR_RUNS; run++) {
+      int sum = 0;
+
+      for(size_t pointer = 0; pointer < pointers.size(); pointer++) {
+         sum += pointers[pointer]->m_value;
+      }
+
+      sink = sink + sum;
+   }
+
+   long long dereferenceTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+   LOG_INFO("%s: %u copies and releases %lld us, %u moves %lld us, %u dereferences %lld us", name,
+      BENCH_REF_COUNT_PTR_OBJECTS * BENCH_REF_COUNT_PTR_RUNS, copyTime,
+      BENCH_REF_COUNT_PTR_OBJECTS * BENCH_REF_COUNT_PTR_RUNS * 2, moveTime,
+      BENCH_REF_COUNT_PTR_OBJECTS * BENCH_REF_COUNT_PTR_RUNS, dereferenceTime);
+}
+
+void benchRefCountPtr() {
+   {
+      std::vector<RefCountPtr<BenchRefCountPtrObject> > pointers;
+
+      for(unsigned int object = 0; object < BENCH_REF_COUNT_PTR_OBJECTS; object++) {
+         pointers.push_back(RefCountPtr<BenchRefCountPtrObject>(new BenchRefCountPtrObject(object)));
+      }
+
+      benchRefCountPtrRun("RefCountPtr", pointers);
+   }
+
+   {
+      std::vector<IntrusivePtr<BenchIntrusiveObject<SerialRefCount> > > pointers;
+
+      for(unsigned int object = 0; object < BENCH_REF_COUNT_PTR_OBJECTS; object++) {
+         pointers.push_back(IntrusivePtr<BenchIntrusiveObject<SerialRefCount> >(new BenchIntrusiveObject<SerialRefCount>(object)));
+      }
+
+      benchRefCountPtrRun("IntrusivePtr serial", pointers);
+   }
+
+   {
+      std::vector<IntrusivePtr<BenchIntrusiveObject<AtomicRefCount> > > pointers;
+
+      for(unsigned int object = 0; object < BENCH_REF_COUNT_PTR_OBJECTS; object++) {
+         pointers.push_back(IntrusivePtr<BenchIntrusiveObject<AtomicRefCount> >(new BenchIntrusiveObject<AtomicRefCount>(object)));
+      }
+
+      benchRefCountPtrRun("IntrusivePtr atomic", pointers);
+   }
+}
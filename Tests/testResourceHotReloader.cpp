@@ -0,0 +1,322 @@
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "tests.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem-Stdio/StdioFileWatcher.h"
+#include "FileSystem/File.h"
+#include "Graphics/GraphicsBackend.h"
+#include "Graphics/serial/ResourceHotReloader.h"
+
+/**
+Counts what gets loaded.  Shaders come from made up files depending on their type.
+*/
+class TestHotReloadBackend : public illGraphics::GraphicsBackend {
+public:
+    TestHotReloadBackend()
+        : m_numShadersLoaded(0),
+        m_numShaderProgramsLoaded(0)
+    {}
+
+    virtual void initialize() {}
+    virtual void uninitialize() {}
+
+    virtual void beginFrame() {}
+    virtual void endFrame() {}
+
+    virtual void loadTexture(void ** textureData, const illGraphics::TextureLoadArgs& loadArgs) {
+        ++m_texturesLoaded[loadArgs.m_path];
+    }
+
+    virtual void unloadTexture(void ** textureData) {}
+    virtual size_t getTextureMemoryUsage(const void * textureData) { return 0; }
+
+    virtual void loadMesh(void** meshBackendData, const MeshData<>& meshFrontendData) {}
+    virtual void unloadMesh(void** meshBackendData) {}
+
+    virtual void loadShader(void ** shaderData, uint64_t featureMask) {
+        ++m_numShadersLoaded;
+    }
+
+    virtual const char * getShaderPath(uint64_t featureMask) const {
+        if(featureMask & illGraphics::Shader::SHADER_DEFERRED_FRAG) {
+            return "shaders/deferred.frag";
+        }
+
+        if(featureMask & illGraphics::Shader::SHADER_FORWARD_FRAG) {
+            return "shaders/forward.frag";
+        }
+
+        return "shaders/main.vert";
+    }
+
+    virtual void loadShaderInternal(void ** shaderData, const char * path, unsigned int shaderType, const char * defines) {}
+    virtual void unloadShader(void **) {}
+
+    virtual void loadShaderProgram(void **, const std::vector<IntrusivePtr<illGraphics::Shader> >& shaderList) {
+        assert(shaderList.size() == 2);
+        ++m_numShaderProgramsLoaded;
+    }
+
+    virtual void unloadShaderProgram(void **) {}
+
+    std::map<std::string, unsigned int> m_texturesLoaded;
+    unsigned int m_numShadersLoaded;
+    unsigned int m_numShaderProgramsLoaded;
+};
+
+/**
+Reports whatever the test says changed.
+*/
+class TestFileWatcher : public illFileSystem::FileWatcher {
+public:
+    virtual void pollChanges(std::vector<std::string>& changedPaths) {
+        changedPaths.insert(changedPaths.end(), m_changes.begin(), m_changes.end());
+        m_changes.clear();
+    }
+
+    std::vector<std::string> m_changes;
+};
+
+const std::chrono::milliseconds TEST_HOT_RELOAD_DEBOUNCE(20);
+
+/**
+Updates until the changes are all handled, returning how many resources got reloaded.
+*/
+size_t testHotReloadSettle(illGraphics::ResourceHotReloader& hotReloader, std::chrono::steady_clock::duration budget) {
+    size_t numReloaded = hotReloader.update(budget);
+
+    while(hotReloader.getNumChangedFiles() > 0 || hotReloader.getNumPendingReloads() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        numReloaded += hotReloader.update(budget);
+    }
+
+    return numReloaded;
+}
+
+void testHotReloadMaterialArgs(illGraphics::MaterialLoadArgs& loadArgs, int diffuseTexture) {
+    loadArgs.m_diffuseTextureIndex = diffuseTexture;
+    loadArgs.m_specularTextureIndex = -1;
+    loadArgs.m_emissiveTextureIndex = -1;
+    loadArgs.m_normalTextureIndex = -1;
+    loadArgs.m_normalMultiplier = 1.0f;
+    loadArgs.m_blendMode = illGraphics::MaterialLoadArgs::BlendMode::NONE;
+    loadArgs.m_billboardMode = illGraphics::MaterialLoadArgs::BillboardMode::NONE;
+    loadArgs.m_noLighting = false;
+    loadArgs.m_skinning = false;
+    loadArgs.m_forceForwardRendering = false;
+}
+
+#ifdef __linux__
+void testHotReloadWriteFile(const char * path, const char * contents) {
+    FILE * file = fopen(path, "wb");
+    assert(file);
+
+    fputs(contents, file);
+    fclose(file);
+}
+
+/**
+The stdio file system's search paths and watching them for real.
+*/
+void testStdioFileWatcher() {
+    mkdir("testHotReload", 0755);
+    mkdir("testHotReload/textures", 0755);
+    testHotReloadWriteFile("testHotReload/textures/a.tex", "a");
+
+    illStdio::StdioFileSystem stdioFileSystem;
+    stdioFileSystem.addPath("testHotReload");
+
+    assert(stdioFileSystem.fileExists("textures/a.tex"));
+    assert(!stdioFileSystem.fileExists("testHotReload/textures/a.tex"));
+
+    {
+        illFileSystem::File * file = stdioFileSystem.openRead("textures/a.tex");
+        assert(file->getSize() == 1);
+        delete file;
+    }
+
+    illStdio::StdioFileWatcher watcher(stdioFileSystem);
+    assert(watcher.getNumWatchedDirectories() == 2);
+
+    std::vector<std::string> changedPaths;
+    watcher.pollChanges(changedPaths);
+    assert(changedPaths.empty());
+
+    //saving in place and saving by renaming over the file both show up
+    testHotReloadWriteFile("testHotReload/textures/a.tex", "aa");
+    testHotReloadWriteFile("testHotReload/b.tmp", "b");
+    rename("testHotReload/b.tmp", "testHotReload/b.tex");
+
+    watcher.pollChanges(changedPaths);
+    assert(changedPaths.size() == 3);
+    assert(changedPaths[0] == "textures/a.tex");
+    assert(changedPaths[1] == "b.tmp");
+    assert(changedPaths[2] == "b.tex");
+
+    //new directories get watched
+    mkdir("testHotReload/new", 0755);
+
+    changedPaths.clear();
+    watcher.pollChanges(changedPaths);
+    assert(changedPaths.empty());
+    assert(watcher.getNumWatchedDirectories() == 3);
+
+    testHotReloadWriteFile("testHotReload/new/c.tex", "c");
+
+    watcher.pollChanges(changedPaths);
+    assert(changedPaths.size() == 1);
+    assert(changedPaths[0] == "new/c.tex");
+
+    remove("testHotReload/new/c.tex");
+    remove("testHotReload/b.tex");
+    remove("testHotReload/textures/a.tex");
+    rmdir("testHotReload/new");
+    rmdir("testHotReload/textures");
+    rmdir("testHotReload");
+}
+#endif
+
+void testResourceHotReloader() {
+#ifdef __linux__
+    testStdioFileWatcher();
+#endif
+
+    TestHotReloadBackend backend;
+
+    illGraphics::TextureManager textureManager(&backend);
+
+    {
+        illGraphics::TextureLoadArgs * loadArgs = new illGraphics::TextureLoadArgs[3];
+        std::map<std::string, illGraphics::TextureId> * nameMap = new std::map<std::string, illGraphics::TextureId>();
+
+        //paths written a few different ways still match
+        loadArgs[0].m_path = "textures/a.tex";
+        loadArgs[1].m_path = "textures\\b.tex";
+        loadArgs[2].m_path = "./textures/unused.tex";
+
+        for(illGraphics::TextureId texture = 0; texture < 3; texture++) {
+            (*nameMap)[loadArgs[texture].m_path] = texture;
+        }
+
+        textureManager.initialize(loadArgs, nameMap);
+    }
+
+    illGraphics::ShaderManager shaderManager(&backend);
+    illGraphics::ShaderProgramLoader shaderProgramLoader(&backend, &shaderManager);
+    illGraphics::ShaderProgramManager shaderProgramManager(&shaderProgramLoader);
+    illGraphics::MaterialLoader materialLoader(&shaderProgramManager, &textureManager);
+    illGraphics::MaterialManager materialManager(&materialLoader);
+
+    {
+        illGraphics::MaterialLoadArgs * loadArgs = new illGraphics::MaterialLoadArgs[2];
+        std::map<std::string, illGraphics::MaterialId> * nameMap = new std::map<std::string, illGraphics::MaterialId>();
+
+        testHotReloadMaterialArgs(loadArgs[0], 0);
+        testHotReloadMaterialArgs(loadArgs[1], 1);
+        (*nameMap)["material0"] = 0;
+        (*nameMap)["material1"] = 1;
+
+        materialManager.initialize(loadArgs, nameMap);
+    }
+
+    //both materials use the same shader programs, a deferred one and a depth pass one, each with a vertex and fragment shader
+    IntrusivePtr<illGraphics::Material> material0 = materialManager.getResource(0);
+    IntrusivePtr<illGraphics::Material> material1 = materialManager.getResource(1);
+
+    assert(backend.m_texturesLoaded["textures/a.tex"] == 1);
+    assert(backend.m_texturesLoaded["textures\\b.tex"] == 1);
+    assert(backend.m_numShadersLoaded == 4);
+    assert(backend.m_numShaderProgramsLoaded == 2);
+
+    const illGraphics::Texture * texture0 = material0->getDiffuseTexture();
+
+    TestFileWatcher watcher;
+    illGraphics::ResourceHotReloader hotReloader(&watcher, &textureManager, &shaderManager, &shaderProgramManager, &materialManager,
+        NULL, NULL, TEST_HOT_RELOAD_DEBOUNCE);
+
+    //nothing changed
+    assert(hotReloader.update(std::chrono::seconds(1)) == 0);
+
+    //a texture saved a few times in a row gets reloaded once along with the material using it
+    {
+        watcher.m_changes.push_back("textures/a.tex");
+        assert(hotReloader.update(std::chrono::seconds(1)) == 0);
+        assert(hotReloader.getNumChangedFiles() == 1);
+
+        watcher.m_changes.push_back("textures/a.tex");
+        watcher.m_changes.push_back("./textures/a.tex");
+
+        assert(testHotReloadSettle(hotReloader, std::chrono::seconds(1)) == 2);
+
+        assert(backend.m_texturesLoaded["textures/a.tex"] == 2);
+        assert(backend.m_texturesLoaded["textures\\b.tex"] == 1);
+        assert(backend.m_numShadersLoaded == 4);
+
+        //reloaded in place
+        assert(material0->getDiffuseTexture() == texture0);
+        assert(material0->isLoaded());
+        assert(texture0->isLoaded());
+    }
+
+    //a shader file used by both vertex shaders gets them reloaded and the programs using them relinked
+    {
+        watcher.m_changes.push_back("shaders/main.vert");
+
+        assert(testHotReloadSettle(hotReloader, std::chrono::seconds(1)) == 4);
+        assert(backend.m_numShadersLoaded == 6);
+        assert(backend.m_numShaderProgramsLoaded == 4);
+        assert(material0->getShaderProgram()->getShaders().size() == 2);
+    }
+
+    //a fragment shader only used by one program
+    {
+        watcher.m_changes.push_back("shaders/forward.frag");
+
+        assert(testHotReloadSettle(hotReloader, std::chrono::seconds(1)) == 2);
+        assert(backend.m_numShadersLoaded == 7);
+        assert(backend.m_numShaderProgramsLoaded == 5);
+    }
+
+    //files that aren't used by anything loaded, including a texture that isn't in the cache
+    {
+        watcher.m_changes.push_back("textures/unused.tex");
+        watcher.m_changes.push_back("something/else.txt");
+
+        assert(testHotReloadSettle(hotReloader, std::chrono::seconds(1)) == 0);
+        assert(backend.m_texturesLoaded.find("./textures/unused.tex") == backend.m_texturesLoaded.end());
+    }
+
+    //with no time budget a batch gets spread out over updates one reload at a time, textures before materials
+    {
+        watcher.m_changes.push_back("textures/a.tex");
+        watcher.m_changes.push_back("textures/b.tex");
+
+        assert(hotReloader.update(std::chrono::steady_clock::duration::zero()) == 0);
+        std::this_thread::sleep_for(TEST_HOT_RELOAD_DEBOUNCE * 2);
+
+        assert(hotReloader.update(std::chrono::steady_clock::duration::zero()) == 1);
+        assert(hotReloader.getNumPendingReloads() == 3);
+
+        assert(hotReloader.update(std::chrono::steady_clock::duration::zero()) == 1);
+        assert(hotReloader.getNumPendingReloads() == 2);
+        assert(backend.m_texturesLoaded["textures/a.tex"] == 3);
+        assert(backend.m_texturesLoaded["textures\\b.tex"] == 2);
+
+        assert(testHotReloadSettle(hotReloader, std::chrono::steady_clock::duration::zero()) == 2);
+        assert(material0->isLoaded());
+        assert(material1->isLoaded());
+    }
+
+    assert(illGraphics::hotReloadPath(".\\dir\\file.tex") == "dir/file.tex");
+    assert(illGraphics::hotReloadPath("././file") == "file");
+    assert(illGraphics::hotReloadPath("../file") == "../file");
+}
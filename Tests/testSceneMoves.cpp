@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "tests.h"
+#include "RendererCommon/serial/LightNode.h"
+#include "DeferredShadingRenderer/serial/DeferredShadingScene.h"
+#include "DeferredShadingRenderer/serial/Null/DeferredShadingBackendNull.h"
+
+using namespace illRendererCommon;
+using namespace illDeferredShadingRenderer;
+
+const unsigned int TEST_MOVES_NODES = 60;
+const unsigned int TEST_MOVES_LIGHTS = 20;
+const float TEST_MOVES_WORLD_SIZE = 80.0f;
+
+class TestMoveNode : public GraphicsNode {
+public:
+    TestMoveNode(GraphicsScene * scene, const glm::vec3& position, const Box<>& boundingVol)
+        : GraphicsNode(scene, glm::translate(glm::mat4(), position), boundingVol, Type::MESH)
+    {}
+
+    virtual void render(RenderQueues& renderQueues) {}
+};
+
+inline float testMovesRandom(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+/**
+A random position and box that keeps the node inside the world.
+*/
+inline void testMovesRandomPlacement(glm::vec3& position, Box<>& boundingVol) {
+    glm::vec3 halfDimensions(testMovesRandom(0.5f, 12.0f), testMovesRandom(0.5f, 12.0f), testMovesRandom(0.5f, 12.0f));
+
+    position = glm::vec3(testMovesRandom(12.0f, TEST_MOVES_WORLD_SIZE - 12.0f),
+        testMovesRandom(12.0f, TEST_MOVES_WORLD_SIZE - 12.0f),
+        testMovesRandom(12.0f, TEST_MOVES_WORLD_SIZE - 12.0f));
+
+    boundingVol = Box<>(glm::vec3(0.0f) - halfDimensions, halfDimensions);
+}
+
+/**
+Rebuilds what every cell should hold from scratch by going through every node, and checks the scene's cells hold exactly that,
+with the right bounds attached.  Also checks the nodes' cached affecting lights against every light in the scene,
+which catches cached lists that should have been invalidated but weren't.
+*/
+void checkSceneMoves(const DeferredShadingScene& scene, const std::vector<GraphicsNode *>& nodes) {
+    std::map<unsigned int, std::vector<GraphicsNode *>> sceneCells;
+    std::map<unsigned int, std::vector<GraphicsNode *>> lightCells;
+
+    for(size_t nodeInd = 0; nodeInd < nodes.size(); nodeInd++) {
+        GraphicsNode * node = nodes[nodeInd];
+
+        if(!node || node->getState() != GraphicsNode::State::IN_SCENE) {
+            continue;
+        }
+
+        BoxIterator<> iter = scene.getGridVolume().boxIterForWorldBounds(node->getWorldBoundingVolume());
+
+        do {
+            sceneCells[scene.getGridVolume().indexForCell(iter.getCurrentPosition())].push_back(node);
+        } while(iter.forward());
+
+        if(node->getType() == GraphicsNode::Type::LIGHT) {
+            BoxIterator<> lightIter = scene.getInteractionGridVolume().boxIterForWorldBounds(node->getWorldBoundingVolume());
+
+            do {
+                lightCells[scene.getInteractionGridVolume().indexForCell(lightIter.getCurrentPosition())].push_back(node);
+            } while(lightIter.forward());
+        }
+    }
+
+    glm::uvec3 cellNumber = scene.getGridVolume().getCellNumber();
+
+    for(unsigned int cell = 0; cell < cellNumber.x * cellNumber.y * cellNumber.z; cell++) {
+        const GraphicsScene::NodeContainer& cellContents = scene.getSceneNodeCell(cell);
+        auto expected = sceneCells.find(cell);
+
+        assert(cellContents.size() == (expected == sceneCells.end() ? 0 : expected->second.size()));
+        assert(cellContents.getAttachment().size() == cellContents.size());
+
+        for(size_t item = 0; item < cellContents.size(); item++) {
+            GraphicsNode * node = cellContents[item];
+
+            assert(std::find(expected->second.begin(), expected->second.end(), node) != expected->second.end());
+
+            Box<> bounds = cellContents.getAttachment().get(item);
+            assert(bounds.m_min == node->getWorldBoundingVolume().m_min);
+            assert(bounds.m_max == node->getWorldBoundingVolume().m_max);
+        }
+    }
+
+    for(size_t nodeInd = 0; nodeInd < nodes.size(); nodeInd++) {
+        GraphicsNode * node = nodes[nodeInd];
+
+        if(!node || node->getState() != GraphicsNode::State::IN_SCENE) {
+            continue;
+        }
+
+        std::vector<LightNode *> expected;
+
+        for(size_t lightInd = 0; lightInd < nodes.size(); lightInd++) {
+            GraphicsNode * light = nodes[lightInd];
+
+            if(light && light->getState() == GraphicsNode::State::IN_SCENE && light->getType() == GraphicsNode::Type::LIGHT
+                    && node->getWorldBoundingVolume().intersects(light->getWorldBoundingVolume())) {
+                expected.push_back(static_cast<LightNode *>(light));
+            }
+        }
+
+        std::sort(expected.begin(), expected.end());
+
+        const RenderQueues::LightList& affectingLights = node->getAffectingLights();
+
+        assert(affectingLights.size() == expected.size());
+        assert(std::equal(affectingLights.begin(), affectingLights.end(), expected.begin()));
+    }
+
+    glm::uvec3 lightCellNumber = scene.getInteractionGridVolume().getCellNumber();
+
+    for(unsigned int cell = 0; cell < lightCellNumber.x * lightCellNumber.y * lightCellNumber.z; cell++) {
+        const GraphicsScene::LightNodeContainer& cellContents = scene.getLightCell(cell);
+        auto expected = lightCells.find(cell);
+
+        assert(cellContents.size() == (expected == lightCells.end() ? 0 : expected->second.size()));
+
+        for(size_t item = 0; item < cellContents.size(); item++) {
+            assert(std::find(expected->second.begin(), expected->second.end(), cellContents[item]) != expected->second.end());
+        }
+    }
+}
+
+void testSceneMoves() {
+    DeferredShadingBackendNull backend;
+    glm::vec3 cellDimensions(10.0f);
+    glm::vec3 interactionCellDimensions(5.0f);
+
+    DeferredShadingScene scene(&backend, NULL, NULL,
+        cellDimensions, glm::uvec3((unsigned int) (TEST_MOVES_WORLD_SIZE / 10.0f)),
+        interactionCellDimensions, glm::uvec3((unsigned int) (TEST_MOVES_WORLD_SIZE / 5.0f)));
+
+    std::vector<GraphicsNode *> nodes;
+
+    srand(2468);
+
+    for(unsigned int node = 0; node < TEST_MOVES_NODES + TEST_MOVES_LIGHTS; node++) {
+        glm::vec3 position;
+        Box<> boundingVol;
+        testMovesRandomPlacement(position, boundingVol);
+
+        if(node < TEST_MOVES_NODES) {
+            nodes.push_back(new TestMoveNode(&scene, position, boundingVol));
+        }
+        else {
+            nodes.push_back(new LightNode(&scene, glm::translate(glm::mat4(), position), boundingVol));
+        }
+    }
+
+    checkSceneMoves(scene, nodes);
+
+    //moving right away
+    for(unsigned int step = 0; step < 200; step++) {
+        GraphicsNode * node = nodes[rand() % nodes.size()];
+
+        glm::vec3 position;
+        Box<> boundingVol;
+        testMovesRandomPlacement(position, boundingVol);
+
+        if(step % 2 == 0) {
+            node->move(position);
+        }
+        else {
+            node->move(position, boundingVol);
+        }
+    }
+
+    assert(scene.getNumPendingMoves() == 0);
+    checkSceneMoves(scene, nodes);
+
+    //batched, with nodes moving several times, small moves that stay in the same cells,
+    //and nodes leaving and being deleted before the moves are applied
+    scene.m_batchMoves = true;
+
+    for(unsigned int frame = 0; frame < 20; frame++) {
+        for(unsigned int step = 0; step < 40; step++) {
+            size_t nodeInd = rand() % nodes.size();
+            GraphicsNode * node = nodes[nodeInd];
+
+            if(!node) {
+                continue;
+            }
+
+            unsigned int action = rand() % 10;
+
+            if(action == 0 && frame % 5 == 4) {
+                delete node;
+                nodes[nodeInd] = NULL;
+            }
+            else if(action == 1) {
+                if(node->getState() == GraphicsNode::State::IN_SCENE) {
+                    node->removeFromScene();
+                }
+                else {
+                    node->addToScene();
+                }
+            }
+            else if(node->getState() == GraphicsNode::State::IN_SCENE) {
+                if(action < 5) {
+                    node->move(node->getPosition() + glm::vec3(testMovesRandom(-0.2f, 0.2f)));
+                }
+                else {
+                    glm::vec3 position;
+                    Box<> boundingVol;
+                    testMovesRandomPlacement(position, boundingVol);
+
+                    node->move(position, boundingVol);
+                }
+            }
+        }
+
+        scene.setupFrame();
+
+        assert(scene.getNumPendingMoves() == 0);
+        checkSceneMoves(scene, nodes);
+    }
+
+    for(size_t node = 0; node < nodes.size(); node++) {
+        delete nodes[node];
+    }
+}
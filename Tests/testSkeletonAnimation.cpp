@@ -0,0 +1,425 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tests.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem/File.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+#include "Util/Geometry/quantization.h"
+
+const uint16_t TEST_ANIM_KEYS = 200;
+const float TEST_ANIM_DURATION = 4.0f;
+
+/**
+The angle in radians between two rotations, for checking the error bounds.
+*/
+double testAnimRotationError(const glm::quat& rotation1, const glm::quat& rotation2) {
+    //in double since float can't tell apart angles this small
+    double dot = 0.0;
+    double length1 = 0.0;
+    double length2 = 0.0;
+
+    for(int component = 0; component < 4; component++) {
+        dot += (double) rotation1[component] * rotation2[component];
+        length1 += (double) rotation1[component] * rotation1[component];
+        length2 += (double) rotation2[component] * rotation2[component];
+    }
+
+    dot = fabs(dot) / sqrt(length1 * length2);
+
+    return dot >= 1.0 ? 0.0 : 2.0 * acos(dot);
+}
+
+/**
+Fills in keys for a few bones with different kinds of motion.
+*/
+void testAnimBuildKeys(illGraphics::SkeletonAnimation::BoneAnimationMap& boneAnimation) {
+    //bone 0 moves in a straight line while spinning and stays the same size
+    {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[0];
+        animData.m_positionKeys.resize(TEST_ANIM_KEYS);
+        animData.m_rotationKeys.resize(TEST_ANIM_KEYS);
+        animData.m_scalingKeys.resize(TEST_ANIM_KEYS);
+
+        for(uint16_t key = 0; key < TEST_ANIM_KEYS; key++) {
+            float time = TEST_ANIM_DURATION * key / TEST_ANIM_KEYS;
+            float angle = time * 0.7f;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3(time * 2.0f, 1.0f, -time);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::quat(cos(angle), 0.0f, sin(angle), 0.0f);
+
+            animData.m_scalingKeys[key].m_time = time;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+
+    //bone 3 jitters around randomly so nothing can be dropped
+    {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[3];
+        animData.m_positionKeys.resize(TEST_ANIM_KEYS);
+        animData.m_rotationKeys.resize(TEST_ANIM_KEYS);
+        animData.m_scalingKeys.resize(TEST_ANIM_KEYS / 2);
+
+        srand(3);
+
+        for(uint16_t key = 0; key < TEST_ANIM_KEYS; key++) {
+            float time = TEST_ANIM_DURATION * key / TEST_ANIM_KEYS;
+
+            animData.m_positionKeys[key].m_time = time;
+            animData.m_positionKeys[key].m_data = glm::vec3((float) (rand() % 1000) * 0.01f, (float) (rand() % 1000) * -0.02f, 5.0f);
+
+            animData.m_rotationKeys[key].m_time = time;
+            animData.m_rotationKeys[key].m_data = glm::normalize(glm::quat((float) (rand() % 200 - 100), (float) (rand() % 200 - 100),
+                (float) (rand() % 200 - 100), (float) (rand() % 200 - 100)));
+
+            if(key < TEST_ANIM_KEYS / 2) {
+                animData.m_scalingKeys[key].m_time = time * 2.0f;
+                animData.m_scalingKeys[key].m_data = glm::vec3(1.0f + (float) (rand() % 100) * 0.01f);
+            }
+        }
+    }
+
+    //bone 7 doesn't move at all
+    {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[7];
+        animData.m_positionKeys.resize(3);
+        animData.m_rotationKeys.resize(3);
+        animData.m_scalingKeys.resize(3);
+
+        for(uint16_t key = 0; key < 3; key++) {
+            animData.m_positionKeys[key].m_time = (float) key;
+            animData.m_positionKeys[key].m_data = glm::vec3(0.25f, -3.0f, 7.5f);
+
+            animData.m_rotationKeys[key].m_time = (float) key;
+            animData.m_rotationKeys[key].m_data = glm::quat(0.5f, 0.5f, -0.5f, 0.5f);
+
+            animData.m_scalingKeys[key].m_time = (float) key;
+            animData.m_scalingKeys[key].m_data = glm::vec3(2.0f, 2.0f, 2.0f);
+        }
+    }
+}
+
+/**
+Plays through the compressed animation next to the uncompressed keys and checks it stays within the error bounds.
+Sampling between keys can be off by a bit more than on the keys since the interpolation goes between different keys.
+*/
+void testAnimCompareToKeys(const illGraphics::SkeletonAnimation& animation, const illGraphics::SkeletonAnimation::BoneAnimationMap& boneAnimation,
+        const illGraphics::SkeletonAnimationErrorBounds& errorBounds) {
+    for(illGraphics::SkeletonAnimation::BoneAnimationMap::const_iterator iter = boneAnimation.begin(); iter != boneAnimation.end(); iter++) {
+        illGraphics::LastFrameInfo rawCursor;
+        illGraphics::LastFrameInfo cursor;
+
+        for(unsigned int sample = 0; sample < TEST_ANIM_KEYS * 4; sample++) {
+            float time = TEST_ANIM_DURATION * sample / (TEST_ANIM_KEYS * 4);
+            float slack = sample % 4 == 0 ? 1.01f : 2.0f;
+
+            Transform<> expected = iter->second.getTransform(time, TEST_ANIM_DURATION, rawCursor);
+            Transform<> transform;
+
+            assert(animation.getTransform(iter->first, time, transform, cursor));
+
+            //a bit extra for the quantization floor of the 16 bit ranges
+            assert(glm::length(transform.m_position - expected.m_position) <= errorBounds.m_position * slack + 0.0002f);
+            assert(testAnimRotationError(transform.m_rotation, expected.m_rotation) <= errorBounds.m_rotation * slack + 0.00012);
+            assert(glm::length(transform.m_scale - expected.m_scale) <= errorBounds.m_scaling * slack + 0.0001f);
+        }
+    }
+}
+
+void testSkeletonAnimation() {
+    //quantization primitives
+    {
+        assert(quantizeRange16(-1.0f, 0.0f, 10.0f) == 0);
+        assert(quantizeRange16(11.0f, 0.0f, 10.0f) == 0xFFFF);
+        assert(quantizeRange16(5.0f, 5.0f, 0.0f) == 0);
+        assert(fabs(dequantizeRange16(quantizeRange16(3.3f, -2.0f, 10.0f), -2.0f, 10.0f / 65535.0f) - 3.3f) < 0.0001f);
+
+        srand(1);
+
+        for(unsigned int rotation = 0; rotation < 10000; rotation++) {
+            glm::quat original = glm::normalize(glm::quat((float) (rand() % 2001 - 1000), (float) (rand() % 2001 - 1000),
+                (float) (rand() % 2001 - 1000), (float) (rand() % 2001 - 1000)));
+
+            uint16_t packed[3];
+            packQuatSmallestThree(original, packed);
+
+            assert(testAnimRotationError(unpackQuatSmallestThree(packed), original) < 0.00012);
+        }
+
+        //exact axis rotations where one component is 1 and the rest are 0
+        {
+            uint16_t packed[3];
+            packQuatSmallestThree(glm::quat(-1.0f, 0.0f, 0.0f, 0.0f), packed);
+            assert(testAnimRotationError(unpackQuatSmallestThree(packed), glm::quat()) < 0.00012);
+        }
+    }
+
+    illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+    testAnimBuildKeys(boneAnimation);
+
+    illGraphics::SkeletonAnimationErrorBounds errorBounds(0.001f, 0.001f, 0.001f);
+
+    //encoding
+    illGraphics::SkeletonAnimation animation;
+    animation.encode(TEST_ANIM_DURATION, boneAnimation, errorBounds);
+
+    assert(animation.getNumBones() == 3);
+    assert(animation.getDuration() == TEST_ANIM_DURATION);
+
+    testAnimCompareToKeys(animation, boneAnimation, errorBounds);
+
+    //bones in the gaps and past the end aren't animated
+    {
+        Transform<> transform;
+        illGraphics::LastFrameInfo cursor;
+
+        assert(!animation.getTransform(1, 0.0f, transform, cursor));
+        assert(!animation.getTransform(6, 0.0f, transform, cursor));
+        assert(!animation.getTransform(8, 0.0f, transform, cursor));
+        assert(!animation.getTransform(1000, 0.0f, transform, cursor));
+    }
+
+    //the constant bone comes back exact and the straight line mostly gets dropped, but the random bone keeps all its keys
+    {
+        Transform<> transform;
+        illGraphics::LastFrameInfo cursor;
+
+        assert(animation.getTransform(7, 1.5f, transform, cursor));
+        assert(transform.m_position == glm::vec3(0.25f, -3.0f, 7.5f));
+        assert(transform.m_scale == glm::vec3(2.0f, 2.0f, 2.0f));
+
+        size_t numRawKeys = TEST_ANIM_KEYS * 3                          //bone 0
+            + TEST_ANIM_KEYS * 2 + TEST_ANIM_KEYS / 2                   //bone 3
+            + 9;                                                        //bone 7
+
+        //bone 7 and bone 0's scale are one key each, bone 0's position is at most a key every 65, bone 3 has everything
+        size_t maxKeys = 3 + 1
+            + 2 * (TEST_ANIM_KEYS / 65 + 2) + TEST_ANIM_KEYS
+            + TEST_ANIM_KEYS * 2 + TEST_ANIM_KEYS / 2;
+
+        assert(animation.getNumKeys() < numRawKeys);
+        assert(animation.getNumKeys() <= maxKeys);
+    }
+
+    //the keys found are the same no matter where the cursor was, going backwards, seeking around, or with no cursor at all
+    {
+        illGraphics::LastFrameInfo cursor;
+        illGraphics::LastFrameInfo rawCursor;
+        const illGraphics::SkeletonAnimation::AnimData& rawAnimData = boneAnimation[3];
+
+        srand(24);
+
+        for(unsigned int sample = 0; sample < 2000; sample++) {
+            float time = sample < 500
+                ? TEST_ANIM_DURATION * (500 - sample) / 500
+                : TEST_ANIM_DURATION * (float) (rand() % 4001 - 2000) / 1000.0f;
+
+            Transform<> transform;
+            Transform<> expected;
+
+            assert(animation.getTransform(3, time, transform, cursor));
+            assert(animation.getTransform(3, time, expected));
+
+            assert(transform.m_position == expected.m_position);
+            assert(transform.m_rotation == expected.m_rotation);
+            assert(transform.m_scale == expected.m_scale);
+
+            Transform<> rawTransform = rawAnimData.getTransform(time, TEST_ANIM_DURATION, rawCursor);
+            Transform<> rawExpected = rawAnimData.getTransform(time, TEST_ANIM_DURATION);
+
+            assert(rawTransform.m_position == rawExpected.m_position);
+            assert(rawTransform.m_rotation == rawExpected.m_rotation);
+            assert(rawTransform.m_scale == rawExpected.m_scale);
+        }
+
+        //negative times loop around from the end
+        Transform<> transform;
+        Transform<> expected;
+
+        assert(animation.getTransform(3, -0.5f, transform));
+        assert(animation.getTransform(3, TEST_ANIM_DURATION - 0.5f, expected));
+        assert(transform.m_position == expected.m_position);
+        assert(transform.m_rotation == expected.m_rotation);
+    }
+
+    //uniformly sampled at the rate the keys are at, so nothing changes other than no keys getting dropped
+    illGraphics::SkeletonAnimation uniformAnimation;
+    uniformAnimation.encode(TEST_ANIM_DURATION, boneAnimation, errorBounds, TEST_ANIM_KEYS / TEST_ANIM_DURATION);
+
+    {
+        assert(uniformAnimation.getSampleRate() == TEST_ANIM_KEYS / TEST_ANIM_DURATION);
+
+        testAnimCompareToKeys(uniformAnimation, boneAnimation, errorBounds);
+
+        //bone 0's scale and all of bone 7 don't change so they're still one key each, bone 3's scaling gets resampled up to the full rate
+        assert(uniformAnimation.getNumKeys() == TEST_ANIM_KEYS * 2 + 1
+            + TEST_ANIM_KEYS * 3
+            + 3);
+    }
+
+    //ILLANIM1 files load back exactly what was encoded
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testSkeletonAnimation1.illanim");
+        animation.writeIllanim1(file);
+        delete file;
+
+        illGraphics::SkeletonAnimationLoadArgs loadArgs;
+        loadArgs.m_path = "testSkeletonAnimation1.illanim";
+
+        illGraphics::SkeletonAnimation loaded;
+        loaded.load(loadArgs, NULL);
+
+        assert(loaded.getNumBones() == animation.getNumBones());
+        assert(loaded.getNumKeys() == animation.getNumKeys());
+        assert(loaded.getCpuMemoryUsage() == animation.getCpuMemoryUsage());
+
+        for(uint16_t bone = 0; bone < 10; bone++) {
+            illGraphics::LastFrameInfo cursor;
+            illGraphics::LastFrameInfo loadedCursor;
+
+            for(unsigned int sample = 0; sample < 100; sample++) {
+                float time = TEST_ANIM_DURATION * 2.0f * sample / 100;
+
+                Transform<> transform;
+                Transform<> loadedTransform;
+
+                bool animated = animation.getTransform(bone, time, transform, cursor);
+                assert(loaded.getTransform(bone, time, loadedTransform, loadedCursor) == animated);
+
+                if(animated) {
+                    assert(loadedTransform.m_position == transform.m_position);
+                    assert(loadedTransform.m_rotation == transform.m_rotation);
+                    assert(loadedTransform.m_scale == transform.m_scale);
+                }
+            }
+        }
+
+        remove("testSkeletonAnimation1.illanim");
+    }
+
+    //including the sample rate of uniformly sampled ones
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testSkeletonAnimationUniform.illanim");
+        uniformAnimation.writeIllanim1(file);
+        delete file;
+
+        illGraphics::SkeletonAnimationLoadArgs loadArgs;
+        loadArgs.m_path = "testSkeletonAnimationUniform.illanim";
+
+        illGraphics::SkeletonAnimation loaded;
+        loaded.load(loadArgs, NULL);
+
+        assert(loaded.getSampleRate() == uniformAnimation.getSampleRate());
+        assert(loaded.getNumKeys() == uniformAnimation.getNumKeys());
+
+        for(unsigned int sample = 0; sample < 100; sample++) {
+            float time = TEST_ANIM_DURATION * 3.0f * (float) (rand() % 1000) / 1000.0f;
+
+            Transform<> transform;
+            Transform<> loadedTransform;
+
+            assert(uniformAnimation.getTransform(3, time, transform));
+            assert(loaded.getTransform(3, time, loadedTransform));
+
+            assert(loadedTransform.m_position == transform.m_position);
+            assert(loadedTransform.m_rotation == transform.m_rotation);
+            assert(loadedTransform.m_scale == transform.m_scale);
+        }
+
+        remove("testSkeletonAnimationUniform.illanim");
+    }
+
+    //old ILLANIM0 files get encoded with the default error bounds when loaded
+    {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testSkeletonAnimation0.illanim");
+
+        file->writeB64(0x494C4C414E494D30);     //ILLANIM0
+        file->writeLF(TEST_ANIM_DURATION);
+        file->writeL16((uint16_t) boneAnimation.size());
+
+        for(illGraphics::SkeletonAnimation::BoneAnimationMap::const_iterator iter = boneAnimation.begin(); iter != boneAnimation.end(); iter++) {
+            const illGraphics::SkeletonAnimation::AnimData& animData = iter->second;
+
+            file->writeL16(iter->first);
+
+            file->writeL16((uint16_t) animData.m_positionKeys.size());
+
+            for(size_t key = 0; key < animData.m_positionKeys.size(); key++) {
+                file->writeLF(animData.m_positionKeys[key].m_time);
+                file->writeLF(animData.m_positionKeys[key].m_data.x);
+                file->writeLF(animData.m_positionKeys[key].m_data.y);
+                file->writeLF(animData.m_positionKeys[key].m_data.z);
+            }
+
+            file->writeL16((uint16_t) animData.m_rotationKeys.size());
+
+            for(size_t key = 0; key < animData.m_rotationKeys.size(); key++) {
+                file->writeLF(animData.m_rotationKeys[key].m_time);
+                file->writeLF(animData.m_rotationKeys[key].m_data.x);
+                file->writeLF(animData.m_rotationKeys[key].m_data.y);
+                file->writeLF(animData.m_rotationKeys[key].m_data.z);
+                file->writeLF(animData.m_rotationKeys[key].m_data.w);
+            }
+
+            file->writeL16((uint16_t) animData.m_scalingKeys.size());
+
+            for(size_t key = 0; key < animData.m_scalingKeys.size(); key++) {
+                file->writeLF(animData.m_scalingKeys[key].m_time);
+                file->writeLF(animData.m_scalingKeys[key].m_data.x);
+                file->writeLF(animData.m_scalingKeys[key].m_data.y);
+                file->writeLF(animData.m_scalingKeys[key].m_data.z);
+            }
+        }
+
+        delete file;
+
+        illGraphics::SkeletonAnimationLoadArgs loadArgs;
+        loadArgs.m_path = "testSkeletonAnimation0.illanim";
+
+        illGraphics::SkeletonAnimation loaded;
+        loaded.load(loadArgs, NULL);
+
+        assert(loaded.getNumBones() == 3);
+        testAnimCompareToKeys(loaded, boneAnimation, illGraphics::SkeletonAnimationErrorBounds());
+
+        remove("testSkeletonAnimation0.illanim");
+    }
+
+    //ILLANIM1 files with a bad duration or more keys than the file has are rejected instead of loaded
+    for(unsigned int badFile = 0; badFile < 2; badFile++) {
+        illFileSystem::File * file = stdioFileSystem.openWrite("testSkeletonAnimationBad.illanim");
+
+        file->writeB64(0x494C4C414E494D31);     //ILLANIM1
+        file->writeLF(badFile == 0 ? 0.0f : TEST_ANIM_DURATION);
+        file->writeL16(0);
+        file->writeL16(0);
+        file->writeL32(badFile == 0 ? 0 : 0x40000000);
+        file->writeL32(0);
+        file->writeL32(0);
+        file->writeLF(0.0f);
+
+        delete file;
+
+        illGraphics::SkeletonAnimationLoadArgs loadArgs;
+        loadArgs.m_path = "testSkeletonAnimationBad.illanim";
+
+        illGraphics::SkeletonAnimation loaded;
+        loaded.load(loadArgs, NULL);
+
+        assert(!loaded.isLoaded());
+        assert(loaded.getNumKeys() == 0);
+
+        remove("testSkeletonAnimationBad.illanim");
+    }
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
@@ -0,0 +1,390 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <glm/gtx/transform.hpp>
+
+#include "tests.h"
+#include "testSkeletonUtil.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/Geometry/geomUtil.h"
+#include "Graphics/serial/Model/Skeleton.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+#include "Graphics/serial/Model/ModelAnimationController.h"
+
+const uint16_t TEST_POSE_BONES = 100;
+
+float testPoseRandom(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+glm::quat testPoseRandomRotation() {
+    return glm::normalize(glm::quat(testPoseRandom(-1.0f, 1.0f), testPoseRandom(-1.0f, 1.0f), testPoseRandom(-1.0f, 1.0f), testPoseRandom(-1.0f, 1.0f)));
+}
+
+/**
+Writes an ILLSKEL0 file with a random tree of bones, where parents are often listed after their children.
+The parents array gets filled in with each bone's parent, the root being its own parent.
+*/
+void testPoseWriteSkeleton(const char * path, std::vector<uint16_t>& parents) {
+    std::vector<uint16_t> shuffled(TEST_POSE_BONES);
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        shuffled[bone] = bone;
+    }
+
+    for(uint16_t bone = TEST_POSE_BONES - 1; bone > 0; bone--) {
+        std::swap(shuffled[bone], shuffled[rand() % (bone + 1)]);
+    }
+
+    //each bone in the shuffled order gets a parent from earlier in it, keeping it a tree
+    parents.resize(TEST_POSE_BONES);
+    parents[shuffled[0]] = shuffled[0];
+
+    for(uint16_t bone = 1; bone < TEST_POSE_BONES; bone++) {
+        parents[shuffled[bone]] = shuffled[rand() % bone];
+    }
+
+    std::vector<glm::mat4> relativeTransforms(TEST_POSE_BONES);
+    std::vector<glm::mat4> fullTransforms(TEST_POSE_BONES);
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        relativeTransforms[bone] = Transform<>(glm::vec3(testPoseRandom(-1.0f, 1.0f), testPoseRandom(0.0f, 1.0f), testPoseRandom(-1.0f, 1.0f)),
+            testPoseRandomRotation(), glm::vec3(testPoseRandom(0.9f, 1.1f))).getMatrix();
+    }
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        uint16_t boneIndex = shuffled[bone];
+
+        fullTransforms[boneIndex] = bone == 0
+            ? relativeTransforms[boneIndex]
+            : fullTransforms[parents[boneIndex]] * relativeTransforms[boneIndex];
+    }
+
+    std::vector<glm::mat4> offsetTransforms(TEST_POSE_BONES);
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        offsetTransforms[bone] = glm::inverse(fullTransforms[bone]);
+    }
+
+    writeTestSkeleton(path, relativeTransforms, offsetTransforms, parents);
+}
+
+/**
+Animates every other bone with a few random keys.
+*/
+void testPoseMakeAnimation(illGraphics::SkeletonAnimation& animation, float duration = 3.0f) {
+    illGraphics::SkeletonAnimation::BoneAnimationMap boneAnimation;
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone += 2) {
+        illGraphics::SkeletonAnimation::AnimData& animData = boneAnimation[bone];
+
+        animData.m_positionKeys.resize(4);
+        animData.m_rotationKeys.resize(4);
+        animData.m_scalingKeys.resize(4);
+
+        for(unsigned int key = 0; key < 4; key++) {
+            animData.m_positionKeys[key].m_time = (float) key * duration / 3.0f;
+            animData.m_positionKeys[key].m_data = glm::vec3(testPoseRandom(-1.0f, 1.0f), testPoseRandom(-1.0f, 1.0f), testPoseRandom(-1.0f, 1.0f));
+
+            animData.m_rotationKeys[key].m_time = (float) key * duration / 3.0f;
+            animData.m_rotationKeys[key].m_data = testPoseRandomRotation();
+
+            animData.m_scalingKeys[key].m_time = (float) key * duration / 3.0f;
+            animData.m_scalingKeys[key].m_data = glm::vec3(1.0f);
+        }
+    }
+
+    animation.encode(duration, boneAnimation);
+}
+
+/**
+Gets a bone's local transform the way the recursive posing used to, decomposing the bind pose for bones that aren't animated.
+*/
+Transform<> testPoseLocalTransform(const illGraphics::Skeleton& skeleton, const illGraphics::SkeletonAnimation * animation, float time, unsigned int boneIndex) {
+    Transform<> transform;
+    illGraphics::LastFrameInfo lastFrameInfo;
+
+    if(!animation || !animation->getTransform((uint16_t) boneIndex, time, transform, lastFrameInfo)) {
+        transform.set(skeleton.getBone(boneIndex).m_relativeTransform);
+    }
+
+    return transform;
+}
+
+/**
+The recursive posing going through the heirarchy nodes, to compare against.
+*/
+void testPoseRecursive(const illGraphics::Skeleton& skeleton, const illGraphics::Skeleton::BoneHeirarchy * node, glm::mat4 transform,
+        const illGraphics::SkeletonAnimation * animation, float time,
+        const illGraphics::SkeletonAnimation * transitionAnimation, float transitionTime, float transitionWeight,
+        glm::mat4 * skelMats) {
+    Transform<> localTransform = testPoseLocalTransform(skeleton, animation, time, node->m_boneIndex);
+
+    if(transitionWeight > 0.0f) {
+        localTransform = localTransform.interpolate(testPoseLocalTransform(skeleton, transitionAnimation, transitionTime, node->m_boneIndex), transitionWeight);
+    }
+
+    transform = transform * localTransform.getMatrix();
+
+    skelMats[node->m_boneIndex] = transform * skeleton.getBone(node->m_boneIndex).m_offsetTransform
+        * glm::rotate(-90.0f, glm::vec3(1.0f, 0.0, 0.0f));
+
+    for(size_t child = 0; child < node->m_children.size(); child++) {
+        testPoseRecursive(skeleton, node->m_children[child], transform, animation, time, transitionAnimation, transitionTime, transitionWeight, skelMats);
+    }
+}
+
+void testPoseCompare(illGraphics::ModelAnimationController& controller, const illGraphics::Skeleton& skeleton) {
+    glm::mat4 skelMats[TEST_POSE_BONES];
+    glm::mat4 expectedMats[TEST_POSE_BONES];
+
+    controller.computeAnimPose(skelMats);
+
+    const illGraphics::ModelAnimationController::Animation& animation = controller.m_animations[controller.m_currentAnimation];
+    const illGraphics::ModelAnimationController::Animation& transitionAnimation = controller.m_animations[!controller.m_currentAnimation];
+
+    testPoseRecursive(skeleton, skeleton.getRootBoneNode(), glm::mat4(),
+        animation.m_animation, animation.m_animTime,
+        transitionAnimation.m_animation, transitionAnimation.m_animTime, controller.m_transitionWeight,
+        expectedMats);
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        assert(eqMat4(skelMats[bone], expectedMats[bone], 0.001f));
+    }
+}
+
+/**
+Poses the skeleton recursively from local transforms worked out for each bone, to compare against the layered controller.
+*/
+void testPoseRecursiveLocal(const illGraphics::Skeleton& skeleton, const illGraphics::Skeleton::BoneHeirarchy * node, glm::mat4 transform,
+        const std::vector<Transform<> >& localTransforms, glm::mat4 * skelMats) {
+    transform = transform * localTransforms[node->m_boneIndex].getMatrix();
+
+    skelMats[node->m_boneIndex] = transform * skeleton.getBone(node->m_boneIndex).m_offsetTransform
+        * glm::rotate(-90.0f, glm::vec3(1.0f, 0.0, 0.0f));
+
+    for(size_t child = 0; child < node->m_children.size(); child++) {
+        testPoseRecursiveLocal(skeleton, node->m_children[child], transform, localTransforms, skelMats);
+    }
+}
+
+/**
+Checks the layers one Transform at a time: a blend space of two animations partly overriding the base,
+a masked layer fully overriding a subtree, and an additive layer with a different weight on each bone.
+*/
+void testPoseLayers(illGraphics::ModelAnimationController& controller, const illGraphics::Skeleton& skeleton,
+        const std::vector<bool>& inSubtree, const std::vector<float>& additiveMask) {
+    glm::mat4 skelMats[TEST_POSE_BONES];
+    glm::mat4 expectedMats[TEST_POSE_BONES];
+
+    controller.computeAnimPose(skelMats);
+
+    const illGraphics::ModelAnimationController::Animation& base = controller.m_animations[controller.m_currentAnimation];
+    const illGraphics::ModelAnimationController::Layer& blendLayer = controller.getLayer(0);
+    const illGraphics::ModelAnimationController::Layer& maskLayer = controller.getLayer(1);
+    const illGraphics::ModelAnimationController::Layer& additiveLayer = controller.getLayer(2);
+
+    std::vector<Transform<> > localTransforms(TEST_POSE_BONES);
+
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        Transform<> transform = testPoseLocalTransform(skeleton, base.m_animation, base.m_animTime, bone);
+
+        Transform<> blend = testPoseLocalTransform(skeleton, blendLayer.m_animations[0].m_animation, blendLayer.m_animations[0].m_animTime, bone)
+            .interpolate(testPoseLocalTransform(skeleton, blendLayer.m_animations[1].m_animation, blendLayer.m_animations[1].m_animTime, bone), 0.75f);
+        transform = transform.interpolate(blend, blendLayer.m_weight);
+
+        if(inSubtree[bone]) {
+            transform = testPoseLocalTransform(skeleton, maskLayer.m_animations[0].m_animation, maskLayer.m_animations[0].m_animTime, bone);
+        }
+
+        Transform<> additive = testPoseLocalTransform(skeleton, additiveLayer.m_animations[0].m_animation, additiveLayer.m_animations[0].m_animTime, bone);
+        const Transform<>& reference = skeleton.getBone(bone).m_relativeBindTransform;
+        float weight = additiveLayer.m_weight * additiveMask[bone];
+
+        glm::quat difference = glm::conjugate(reference.m_rotation) * additive.m_rotation;
+
+        if(difference.w < 0.0f) {
+            difference = -difference;
+        }
+
+        transform.m_position += weight * (additive.m_position - reference.m_position);
+        transform.m_rotation = transform.m_rotation * glm::normalize(glm::quat(1.0f - weight + weight * difference.w,
+            weight * difference.x, weight * difference.y, weight * difference.z));
+        transform.m_scale *= glm::vec3(1.0f) + weight * (additive.m_scale / reference.m_scale - glm::vec3(1.0f));
+
+        localTransforms[bone] = transform;
+    }
+
+    testPoseRecursiveLocal(skeleton, skeleton.getRootBoneNode(), glm::mat4(), localTransforms, expectedMats);
+
+    //the blend space is two approximate slerps in a row between random rotations, so it's a bit further off than a single transition
+    for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+        assert(eqMat4(skelMats[bone], expectedMats[bone], 0.005f));
+    }
+}
+
+void testSkeletonPose() {
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::FileSystem * oldFileSystem = illFileSystem::fileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    srand(21);
+
+    std::vector<uint16_t> parents;
+    testPoseWriteSkeleton("testSkeletonPose.illskel", parents);
+
+    illGraphics::Skeleton skeleton;
+
+    {
+        illGraphics::SkeletonLoadArgs loadArgs;
+        loadArgs.m_path = "testSkeletonPose.illskel";
+        skeleton.load(loadArgs, NULL);
+    }
+
+    remove("testSkeletonPose.illskel");
+
+    //every bone is in the order once and comes after its parent
+    {
+        const Array<illGraphics::Skeleton::OrderedBone>& boneOrder = skeleton.getBoneOrder();
+        assert(boneOrder.size() == TEST_POSE_BONES);
+
+        std::vector<bool> seen(TEST_POSE_BONES, false);
+
+        for(size_t ordered = 0; ordered < boneOrder.size(); ordered++) {
+            uint16_t boneIndex = boneOrder[ordered].m_boneIndex;
+
+            assert(!seen[boneIndex]);
+            seen[boneIndex] = true;
+
+            if(parents[boneIndex] == boneIndex) {
+                assert(ordered == 0);
+                assert(boneOrder[ordered].m_parent == illGraphics::Skeleton::NO_PARENT);
+            }
+            else {
+                assert(boneOrder[ordered].m_parent < ordered);
+                assert(boneOrder[boneOrder[ordered].m_parent].m_boneIndex == parents[boneIndex]);
+            }
+        }
+    }
+
+    illGraphics::SkeletonAnimation animation;
+    testPoseMakeAnimation(animation);
+
+    illGraphics::SkeletonAnimation transitionAnimation;
+    testPoseMakeAnimation(transitionAnimation);
+
+    illGraphics::ModelAnimationController controller;
+    controller.setSkeleton(&skeleton);
+
+    //the bind pose with no animation
+    testPoseCompare(controller, skeleton);
+
+    //playing an animation, a few times going forward and then looping back around
+    controller.queueTransition(&animation, 0.0f, 0.0f);
+
+    for(unsigned int frame = 0; frame < 10; frame++) {
+        controller.update(0.37f);
+        testPoseCompare(controller, skeleton);
+    }
+
+    //halfway through a transition into another animation
+    controller.queueTransition(&transitionAnimation, 1.0f, controller.getAnimationTime() + 0.1f);
+    controller.update(0.1f);
+    controller.update(0.5f);
+
+    assert(controller.m_transitionWeight > 0.0f && controller.m_transitionWeight < 1.0f);
+    testPoseCompare(controller, skeleton);
+
+    //layers on top of an animation
+    {
+        illGraphics::SkeletonAnimation run;
+        illGraphics::SkeletonAnimation aim;
+        illGraphics::SkeletonAnimation nod;
+
+        testPoseMakeAnimation(run, 1.5f);
+        testPoseMakeAnimation(aim);
+        testPoseMakeAnimation(nod);
+
+        illGraphics::ModelAnimationController layered;
+        layered.setSkeleton(&skeleton);
+        layered.queueTransition(&animation, 0.0f, 0.0f);
+
+        //a layer at 0 weight doesn't change anything
+        {
+            layered.update(0.2f);
+
+            glm::mat4 skelMats[TEST_POSE_BONES];
+            glm::mat4 layeredMats[TEST_POSE_BONES];
+
+            layered.computeAnimPose(skelMats);
+
+            size_t layer = layered.addLayer(illGraphics::ModelAnimationController::LayerMode::OVERRIDE, 0.0f);
+            layered.getLayer(layer).addAnimation(&run, 1.0f);
+            layered.computeAnimPose(layeredMats);
+
+            assert(memcmp(skelMats, layeredMats, sizeof(skelMats)) == 0);
+
+            layered.clearLayers();
+            assert(layered.getNumLayers() == 0);
+        }
+
+        //walking and running 1 to 3 kept in step, over the base animation
+        {
+            size_t layer = layered.addLayer(illGraphics::ModelAnimationController::LayerMode::OVERRIDE, 0.6f);
+            layered.getLayer(layer).addAnimation(&transitionAnimation, 1.0f);
+            layered.getLayer(layer).addAnimation(&run, 3.0f);
+            layered.getLayer(layer).m_synchronize = true;
+        }
+
+        //something else on a subtree of the skeleton, the first child of the root
+        uint16_t maskRoot = skeleton.getBoneOrder()[1].m_boneIndex;
+        std::vector<bool> inSubtree(TEST_POSE_BONES);
+
+        for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+            uint16_t ancestor = bone;
+
+            while(ancestor != maskRoot && parents[ancestor] != ancestor) {
+                ancestor = parents[ancestor];
+            }
+
+            inSubtree[bone] = ancestor == maskRoot;
+        }
+
+        {
+            size_t layer = layered.addLayer(illGraphics::ModelAnimationController::LayerMode::OVERRIDE);
+            layered.getLayer(layer).addAnimation(&aim, 1.0f, 1.0f);
+            layered.getLayer(layer).maskBoneSubtree(&skeleton, maskRoot);
+        }
+
+        //and an additive one with a random weight for each bone
+        std::vector<float> additiveMask(TEST_POSE_BONES);
+
+        for(uint16_t bone = 0; bone < TEST_POSE_BONES; bone++) {
+            additiveMask[bone] = bone % 3 == 0 ? 0.0f : testPoseRandom(0.0f, 1.0f);
+        }
+
+        {
+            size_t layer = layered.addLayer(illGraphics::ModelAnimationController::LayerMode::ADDITIVE, 0.5f);
+            layered.getLayer(layer).addAnimation(&nod, 1.0f, 2.0f);
+            layered.getLayer(layer).setBoneMask(&additiveMask[0], additiveMask.size());
+        }
+
+        for(unsigned int frame = 0; frame < 10; frame++) {
+            layered.update(0.37f);
+            testPoseLayers(layered, skeleton, inSubtree, additiveMask);
+
+            //the synchronized animations are the same fraction of the way through
+            const illGraphics::ModelAnimationController::Layer& blendLayer = layered.getLayer(0);
+            assert(eq(blendLayer.m_animations[0].m_animTime / 3.0f, blendLayer.m_animations[1].m_animTime / 1.5f, 0.0001f));
+        }
+
+        //it went for 3.7 seconds and the average duration of the blend is (3 * 1 + 1.5 * 3) / 4
+        assert(eq(layered.getLayer(0).m_phase, std::fmod(3.7f / 1.875f, 1.0f), 0.001f));
+    }
+
+    illFileSystem::fileSystem = oldFileSystem;
+}
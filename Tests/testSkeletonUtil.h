@@ -0,0 +1,50 @@
+#ifndef ILL_TEST_SKELETON_UTIL_H__
+#define ILL_TEST_SKELETON_UTIL_H__
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/File.h"
+
+/**
+Writes an ILLSKEL0 file for the tests and benchmarks that need a skeleton to load, with whatever bone layout they build.
+
+@param relativeTransforms Each bone's transform relative to its parent.
+@param offsetTransforms Each bone's offset transform, the inverse of where it is in the bind pose.
+@param parents Each bone's parent, the root being its own parent.
+*/
+inline void writeTestSkeleton(const char * path, const std::vector<glm::mat4>& relativeTransforms, const std::vector<glm::mat4>& offsetTransforms,
+        const std::vector<uint16_t>& parents) {
+    assert(offsetTransforms.size() == relativeTransforms.size() && parents.size() == relativeTransforms.size());
+
+    illFileSystem::File * file = illFileSystem::fileSystem->openWrite(path);
+
+    file->writeB64(0x494C4C534B454C30);     //ILLSKEL0
+    file->writeL16((uint16_t) relativeTransforms.size());
+
+    for(size_t bone = 0; bone < relativeTransforms.size(); bone++) {
+        for(unsigned int matCol = 0; matCol < 4; matCol++) {
+            for(unsigned int matRow = 0; matRow < 4; matRow++) {
+                file->writeLF(relativeTransforms[bone][matCol][matRow]);
+            }
+        }
+
+        for(unsigned int matCol = 0; matCol < 4; matCol++) {
+            for(unsigned int matRow = 0; matRow < 4; matRow++) {
+                file->writeLF(offsetTransforms[bone][matCol][matRow]);
+            }
+        }
+    }
+
+    for(size_t bone = 0; bone < parents.size(); bone++) {
+        file->writeL16(parents[bone]);
+    }
+
+    delete file;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include <cassert>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "tests.h"
+#include "RendererCommon/serial/SoftwareOcclusionBuffer.h"
+
+using namespace illRendererCommon;
+
+void testSoftwareOcclusionBuffer() {
+    //looking down -z from the origin
+    glm::mat4 viewProjection = glm::perspective(90.0f, 2.0f, 0.1f, 1000.0f)
+        * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    SoftwareOcclusionBuffer buffer(250, 125);
+
+    //rounded up to the tile size
+    assert(buffer.getWidth() == 256);
+    assert(buffer.getHeight() == 128);
+
+    buffer.clear(viewProjection);
+
+    //nothing rasterized yet
+    assert(buffer.testBox(glm::vec3(-2.0f, -2.0f, -60.0f), glm::vec3(2.0f, 2.0f, -50.0f)));
+
+    //a wall in front of the camera covering the middle of the screen
+    assert(buffer.rasterizeBox(glm::vec3(-5.0f, -5.0f, -11.0f), glm::vec3(5.0f, 5.0f, -10.0f)));
+    assert(buffer.getDepth(128, 64) < 1.0f);
+    assert(buffer.getDepth(2, 2) > 1.0f);
+
+    //behind the wall
+    assert(!buffer.testBox(glm::vec3(-2.0f, -2.0f, -60.0f), glm::vec3(2.0f, 2.0f, -50.0f)));
+
+    //in front of the wall
+    assert(buffer.testBox(glm::vec3(-2.0f, -2.0f, -8.0f), glm::vec3(2.0f, 2.0f, -6.0f)));
+
+    //behind the wall but off to the side of it
+    assert(buffer.testBox(glm::vec3(40.0f, -2.0f, -60.0f), glm::vec3(44.0f, 2.0f, -50.0f)));
+
+    //behind the wall but sticking out past its edge
+    assert(buffer.testBox(glm::vec3(0.0f, -2.0f, -60.0f), glm::vec3(40.0f, 2.0f, -50.0f)));
+
+    //crossing into the wall
+    assert(buffer.testBox(glm::vec3(-1.0f, -1.0f, -12.0f), glm::vec3(1.0f, 1.0f, -9.0f)));
+
+    //around the camera
+    assert(buffer.testBox(glm::vec3(-1.0f), glm::vec3(1.0f)));
+
+    //behind the camera
+    assert(!buffer.rasterizeBox(glm::vec3(-5.0f, -5.0f, 10.0f), glm::vec3(5.0f, 5.0f, 11.0f)));
+
+    assert(buffer.m_debugNumOccluders == 1);
+    assert(buffer.m_debugNumOccluded == 1);
+
+    //clearing empties it again
+    buffer.clear(viewProjection);
+    assert(buffer.testBox(glm::vec3(-2.0f, -2.0f, -60.0f), glm::vec3(2.0f, 2.0f, -50.0f)));
+}
@@ -0,0 +1,112 @@
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <unordered_set>
+
+#include "tests.h"
+#include "Util/serial/SparseCellStorage.h"
+#include "Util/Geometry/BoxBatch.h"
+
+const unsigned int TEST_SPARSE_CELLS = 64;
+const unsigned int TEST_SPARSE_ITEMS = 50;
+
+//each item gets a box attached that's just the point at its own number, so it's easy to check the boxes stay with their items
+typedef SparseCellStorage<unsigned int, BoxBatch> TestSparseCellStorage;
+
+inline Box<> testSparseItemBox(unsigned int item) {
+    return Box<>(glm::vec3((float) item));
+}
+
+/**
+Checks the storage against a plain set for every cell and makes sure every location list points where it says it does.
+*/
+void checkSparseCellStorage(const TestSparseCellStorage& storage,
+        const std::unordered_set<unsigned int> * reference, const std::vector<SparseCellLocationList>& locations) {
+    size_t occupied = 0;
+
+    for(unsigned int cell = 0; cell < TEST_SPARSE_CELLS; cell++) {
+        const TestSparseCellStorage::Cell& cellContents = storage.getCell(cell);
+
+        assert(cellContents.size() == reference[cell].size());
+        assert(cellContents.getAttachment().size() == cellContents.size());
+
+        for(size_t index = 0; index < cellContents.size(); index++) {
+            assert(reference[cell].find(cellContents[index]) != reference[cell].end());
+            assert(cellContents.getAttachment().get(index).m_min.x == (float) cellContents[index]);
+        }
+
+        if(!cellContents.empty()) {
+            ++occupied;
+        }
+    }
+
+    assert(storage.getNumOccupiedCells() == occupied);
+
+    for(unsigned int item = 0; item < TEST_SPARSE_ITEMS; item++) {
+        for(size_t location = 0; location < locations[item].size(); location++) {
+            const SparseCellLocation& loc = locations[item][location];
+            assert(storage.getCell(loc.m_cell)[loc.m_index] == item);
+        }
+    }
+}
+
+void testSparseCellStorage() {
+    //empty storage
+    {
+        SparseCellStorage<unsigned int> storage;
+
+        assert(storage.getCell(0).empty());
+        assert(storage.getCell(12345).size() == 0);
+        assert(storage.getNumOccupiedCells() == 0);
+        assert(storage.getMemoryUsage() == 0);
+    }
+
+    //random adds and removes compared to a set per cell
+    {
+        TestSparseCellStorage storage;
+        std::unordered_set<unsigned int> reference[TEST_SPARSE_CELLS];
+
+        //the location lists need to stay put in memory so size this up front
+        std::vector<SparseCellLocationList> locations(TEST_SPARSE_ITEMS);
+
+        srand(4321);
+
+        for(unsigned int step = 0; step < 20000; step++) {
+            unsigned int item = rand() % TEST_SPARSE_ITEMS;
+            
+            //spread the cells out so the hash table sees collisions and shifting on erase
+            unsigned int cell = rand() % TEST_SPARSE_CELLS;
+
+            if(rand() % 3 != 0) {
+                if(reference[cell].insert(item).second) {
+                    storage.add(cell, item, &locations[item], testSparseItemBox(item));
+                }
+            }
+            else if(!locations[item].empty()) {
+                size_t location = rand() % locations[item].size();
+                
+                reference[locations[item][location].m_cell].erase(item);
+                storage.remove(&locations[item], location);
+            }
+
+            if(step % 1000 == 0) {
+                checkSparseCellStorage(storage, reference, locations);
+            }
+        }
+
+        checkSparseCellStorage(storage, reference, locations);
+
+        //remove everything
+        for(unsigned int item = 0; item < TEST_SPARSE_ITEMS; item++) {
+            storage.removeAll(&locations[item]);
+            assert(locations[item].empty());
+        }
+
+        for(unsigned int cell = 0; cell < TEST_SPARSE_CELLS; cell++) {
+            reference[cell].clear();
+        }
+
+        checkSparseCellStorage(storage, reference, locations);
+        assert(storage.getNumOccupiedCells() == 0);
+    }
+}
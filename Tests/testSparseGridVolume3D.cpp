@@ -0,0 +1,65 @@
+#include <cassert>
+#include "tests.h"
+#include "Util/serial/SparseCellArray.h"
+#include "Util/Geometry/SparseGridVolume3D.h"
+
+void testSparseGridVolume3D() {
+    //nothing allocated up front and reads don't allocate
+    {
+        SparseCellArray<uint64_t> cells(glm::uvec3(256, 64, 256));
+
+        assert(cells.getNumBricksAllocated() == 0);
+        assert(cells.get(glm::uvec3(255, 63, 255)) == 0);
+        assert(cells.get(12345) == 0);
+        assert(cells.getNumBricksAllocated() == 0);
+
+        //one pointer per 8x8x8 brick
+        assert(cells.getMemoryUsage() == 32 * 8 * 32 * sizeof(uint64_t *));
+    }
+
+    //index and position addressing agree, including extents that aren't a multiple of the brick size
+    {
+        glm::uvec3 cellNumber(13, 9, 17);
+        SparseCellArray<unsigned int> cells(cellNumber);
+
+        for(unsigned int z = 0; z < cellNumber.z; z++) {
+            for(unsigned int y = 0; y < cellNumber.y; y++) {
+                for(unsigned int x = 0; x < cellNumber.x; x++) {
+                    unsigned int index = x + cellNumber.x * (y + cellNumber.y * z);
+                    cells.getMutable(glm::uvec3(x, y, z)) = index + 1;
+                }
+            }
+        }
+
+        //2x2x3 bricks cover 13x9x17
+        assert(cells.getNumBricksAllocated() == 12);
+
+        for(unsigned int index = 0; index < cellNumber.x * cellNumber.y * cellNumber.z; index++) {
+            assert(cells.get(index) == index + 1);
+        }
+
+        cells.clear();
+        assert(cells.getNumBricksAllocated() == 0);
+        assert(cells.get(100) == 0);
+    }
+
+    //a sparse grid volume gives the same cell indices as the dense one and only allocates where written
+    {
+        SparseGridVolume3D<unsigned int> grid(glm::vec3(10.0f), glm::uvec3(256, 16, 256));
+        GridVolume3D<> denseGrid(glm::vec3(10.0f), glm::uvec3(256, 16, 256));
+
+        glm::vec3 position(1234.0f, 55.0f, 2001.0f);
+        unsigned int index = grid.indexForWorld(position);
+
+        assert(index == denseGrid.indexForWorld(position));
+        assert(grid.cellForIndex(index).x == grid.cellForWorld(position).x);
+        assert(grid.cellForIndex(index).y == grid.cellForWorld(position).y);
+        assert(grid.cellForIndex(index).z == grid.cellForWorld(position).z);
+
+        grid.getCellMutable(index) = 7;
+
+        assert(grid.getCell(index) == 7);
+        assert(grid.getCell(grid.cellForWorld(position)) == 7);
+        assert(grid.getCells().getNumBricksAllocated() == 1);
+    }
+}
@@ -0,0 +1,64 @@
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+#include "tests.h"
+#include "Util/parallel/ThreadPool.h"
+
+/**
+Runs a parallelFor where some indices take much longer than others so the threads have to steal,
+and checks every index ran exactly once.
+*/
+void checkThreadPool(ThreadPool& threadPool, size_t count) {
+    std::vector<std::atomic<unsigned int> > runs(count);
+
+    for(size_t index = 0; index < count; index++) {
+        runs[index] = 0;
+    }
+
+    std::atomic<unsigned int> total(0);
+
+    threadPool.parallelFor(count, [&] (size_t index) {
+        //all the slow ones are at the start, which is the calling thread's piece
+        if(index < count / 8) {
+            volatile unsigned int spin = 0;
+
+            for(unsigned int iteration = 0; iteration < 20000; iteration++) {
+                spin = spin + iteration;
+            }
+        }
+
+        ++runs[index];
+        ++total;
+    });
+
+    assert(total == count);
+
+    for(size_t index = 0; index < count; index++) {
+        assert(runs[index] == 1);
+    }
+}
+
+void testThreadPool() {
+    {
+        ThreadPool threadPool(3);
+        assert(threadPool.getConcurrency() == 4);
+
+        checkThreadPool(threadPool, 0);
+        checkThreadPool(threadPool, 1);
+        checkThreadPool(threadPool, 3);
+        checkThreadPool(threadPool, 4);
+        checkThreadPool(threadPool, 1001);
+
+        //reusing it lots of times in a row
+        for(unsigned int job = 0; job < 200; job++) {
+            checkThreadPool(threadPool, job % 17);
+        }
+    }
+
+    //no workers, everything runs on the calling thread
+    {
+        ThreadPool threadPool(0);
+        checkThreadPool(threadPool, 100);
+    }
+}
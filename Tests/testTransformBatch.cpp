@@ -0,0 +1,256 @@
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "tests.h"
+#include "Util/Geometry/geomUtil.h"
+#include "Util/Geometry/transformBatchMath.h"
+
+inline float testTransformBatchRandom(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+Transform<> testTransformBatchRandomTransform() {
+    return Transform<>(glm::vec3(testTransformBatchRandom(-10.0f, 10.0f), testTransformBatchRandom(-10.0f, 10.0f), testTransformBatchRandom(-10.0f, 10.0f)),
+        glm::normalize(glm::quat(testTransformBatchRandom(-1.0f, 1.0f), testTransformBatchRandom(-1.0f, 1.0f),
+            testTransformBatchRandom(-1.0f, 1.0f), testTransformBatchRandom(-1.0f, 1.0f))),
+        glm::vec3(testTransformBatchRandom(0.5f, 2.0f), testTransformBatchRandom(0.5f, 2.0f), testTransformBatchRandom(0.5f, 2.0f)));
+}
+
+/**
+Checks the batch kernels against doing the same thing one Transform at a time, for a batch that isn't a multiple of the group size.
+*/
+void checkTransformBatch(size_t numTransforms) {
+    std::vector<Transform<> > from(numTransforms);
+    std::vector<Transform<> > to(numTransforms);
+
+    TransformBatch fromBatch;
+    TransformBatch toBatch;
+
+    fromBatch.resize(numTransforms);
+    toBatch.resize(numTransforms);
+
+    assert(fromBatch.paddedSize() % TRANSFORM_BATCH_GROUP_SIZE == 0);
+    assert(fromBatch.paddedSize() >= numTransforms);
+
+    for(size_t transform = 0; transform < numTransforms; transform++) {
+        from[transform] = testTransformBatchRandomTransform();
+        to[transform] = testTransformBatchRandomTransform();
+
+        //some of them almost the same like in most animation blends, some on opposite sides of the hypersphere
+        if(transform % 3 == 0) {
+            to[transform].m_rotation = glm::normalize(from[transform].m_rotation
+                + glm::quat(testTransformBatchRandom(-0.05f, 0.05f), testTransformBatchRandom(-0.05f, 0.05f), 0.0f, 0.0f));
+        }
+        else if(transform % 3 == 1) {
+            to[transform].m_rotation = -to[transform].m_rotation;
+        }
+
+        fromBatch.set(transform, from[transform]);
+        toBatch.set(transform, to[transform]);
+    }
+
+    //round trip
+    for(size_t transform = 0; transform < numTransforms; transform++) {
+        assert(eqMat4(fromBatch.get(transform).getMatrix(), from[transform].getMatrix(), 0.00001f));
+    }
+
+    //matrices, with a guard past the end to make sure the last group doesn't write past the array
+    {
+        std::vector<glm::mat4> matrices(numTransforms + 1, glm::mat4(7.0f));
+        transformBatchMatrices(fromBatch, matrices.data());
+
+        for(size_t transform = 0; transform < numTransforms; transform++) {
+            assert(eqMat4(matrices[transform], from[transform].getMatrix(), 0.0001f));
+        }
+
+        assert(matrices.back() == glm::mat4(7.0f));
+    }
+
+    //blending
+    const float deltas[] = { 0.0f, 0.1f, 0.5f, 0.77f, 1.0f };
+
+    for(unsigned int delta = 0; delta < sizeof(deltas) / sizeof(deltas[0]); delta++) {
+        TransformBatch blended;
+        blendTransformBatch(fromBatch, toBatch, deltas[delta], blended);
+
+        assert(blended.size() == numTransforms);
+
+        for(size_t transform = 0; transform < numTransforms; transform++) {
+            Transform<> expected = from[transform].interpolate(to[transform], deltas[delta]);
+            Transform<> result = blended.get(transform);
+
+            assert(eqMat4(result.getMatrix(), expected.getMatrix(), 0.001f));
+            assert(eq(glm::length(result.m_rotation), 1.0f, 0.0001f));
+        }
+    }
+
+    //blending in place
+    {
+        TransformBatch blended = fromBatch;
+        blendTransformBatch(blended, toBatch, 0.25f, blended);
+
+        for(size_t transform = 0; transform < numTransforms; transform++) {
+            assert(eqMat4(blended.get(transform).getMatrix(), from[transform].interpolate(to[transform], 0.25f).getMatrix(), 0.001f));
+        }
+    }
+
+    //blending by a different amount for each transform, with some of them left out entirely
+    {
+        std::vector<float> mask(fromBatch.paddedSize());
+
+        for(size_t transform = 0; transform < mask.size(); transform++) {
+            mask[transform] = transform % 4 == 0 ? 0.0f : testTransformBatchRandom(0.0f, 1.0f);
+        }
+
+        TransformBatch blended;
+        blendTransformBatchMasked(fromBatch, toBatch, 0.8f, &mask[0], blended);
+
+        assert(blended.size() == numTransforms);
+
+        for(size_t transform = 0; transform < numTransforms; transform++) {
+            Transform<> expected = from[transform].interpolate(to[transform], 0.8f * mask[transform]);
+
+            assert(eqMat4(blended.get(transform).getMatrix(), expected.getMatrix(), 0.001f));
+        }
+
+        //a mask of all 1s is exactly the same as the plain blend
+        std::vector<float> fullMask(fromBatch.paddedSize(), 1.0f);
+        TransformBatch fullBlended;
+        TransformBatch plainBlended;
+
+        blendTransformBatchMasked(fromBatch, toBatch, 0.3f, &fullMask[0], fullBlended);
+        blendTransformBatch(fromBatch, toBatch, 0.3f, plainBlended);
+
+        assert(memcmp(fullBlended.getRotationX(), plainBlended.getRotationX(), numTransforms * sizeof(float)) == 0);
+        assert(memcmp(fullBlended.getRotationW(), plainBlended.getRotationW(), numTransforms * sizeof(float)) == 0);
+        assert(memcmp(fullBlended.getPositionY(), plainBlended.getPositionY(), numTransforms * sizeof(float)) == 0);
+    }
+
+    //adding the difference between to and a reference onto from
+    {
+        std::vector<Transform<> > reference(numTransforms);
+        TransformBatch referenceBatch;
+        referenceBatch.resize(numTransforms);
+
+        std::vector<float> mask(fromBatch.paddedSize());
+
+        for(size_t transform = 0; transform < numTransforms; transform++) {
+            reference[transform] = testTransformBatchRandomTransform();
+            referenceBatch.set(transform, reference[transform]);
+            mask[transform] = testTransformBatchRandom(0.0f, 1.0f);
+        }
+
+        for(unsigned int delta = 0; delta < sizeof(deltas) / sizeof(deltas[0]); delta++) {
+            for(unsigned int masked = 0; masked < 2; masked++) {
+                TransformBatch added = fromBatch;
+                addTransformBatch(added, toBatch, referenceBatch, deltas[delta], masked ? &mask[0] : NULL, added);
+
+                for(size_t transform = 0; transform < numTransforms; transform++) {
+                    float weight = masked ? deltas[delta] * mask[transform] : deltas[delta];
+
+                    glm::quat difference = glm::conjugate(reference[transform].m_rotation) * to[transform].m_rotation;
+
+                    if(difference.w < 0.0f) {
+                        difference = -difference;
+                    }
+
+                    Transform<> expected(
+                        from[transform].m_position + weight * (to[transform].m_position - reference[transform].m_position),
+                        from[transform].m_rotation * glm::normalize(glm::quat(1.0f - weight + weight * difference.w,
+                            weight * difference.x, weight * difference.y, weight * difference.z)),
+                        from[transform].m_scale * (glm::vec3(1.0f) + weight * (to[transform].m_scale / reference[transform].m_scale - glm::vec3(1.0f))));
+
+                    assert(eqMat4(added.get(transform).getMatrix(), expected.getMatrix(), 0.001f));
+                }
+            }
+        }
+
+        //adding the whole difference onto the reference itself gets back the additive transforms
+        TransformBatch added;
+        addTransformBatch(referenceBatch, toBatch, referenceBatch, 1.0f, NULL, added);
+
+        for(size_t transform = 0; transform < numTransforms; transform++) {
+            assert(eqMat4(added.get(transform).getMatrix(), to[transform].getMatrix(), 0.001f));
+        }
+    }
+
+    //multiplying, including in place like posing a skeleton does
+    for(size_t transform = 0; transform < numTransforms; transform++) {
+        glm::mat4 left = from[transform].getMatrix();
+        glm::mat4 right = to[transform].getMatrix();
+        glm::mat4 expected = left * right;
+
+        glm::mat4 result;
+        multiplyMatrix(left, right, result);
+        assert(eqMat4(result, expected, 0.00001f));
+
+        multiplyMatrix(left, right, right);
+        assert(eqMat4(right, expected, 0.00001f));
+    }
+}
+
+void testTransformBatch() {
+    srand(22);
+
+    checkTransformBatch(1);
+    checkTransformBatch(4);
+    checkTransformBatch(8);
+    checkTransformBatch(101);
+
+    //shrinking resets the transforms cut off back to identity padding
+    {
+        TransformBatch batch;
+        batch.resize(10);
+        batch.set(9, testTransformBatchRandomTransform());
+        batch.resize(9);
+
+        assert(batch.size() == 9);
+        assert(batch.getRotationW()[9] == 1.0f && batch.getScaleX()[9] == 1.0f && batch.getPositionX()[9] == 0.0f);
+
+        batch.resize(10);
+        assert(eqMat4(batch.get(9).getMatrix(), glm::mat4(), 0.0f));
+    }
+
+    //batches of the same size blend together even if one used to be bigger and has more room,
+    //like a controller's scratch batches after switching to a smaller skeleton
+    {
+        TransformBatch big;
+        big.resize(100);
+        big.resize(3);
+
+        TransformBatch small;
+        small.resize(3);
+
+        assert(big.paddedSize() == small.paddedSize());
+        assert(small.paddedSize() == TRANSFORM_BATCH_GROUP_SIZE);
+
+        Transform<> from[3];
+        Transform<> to[3];
+
+        for(size_t transform = 0; transform < 3; transform++) {
+            from[transform] = testTransformBatchRandomTransform();
+            to[transform] = testTransformBatchRandomTransform();
+
+            big.set(transform, from[transform]);
+            small.set(transform, to[transform]);
+        }
+
+        TransformBatch blended;
+        blendTransformBatch(big, small, 0.4f, blended);
+
+        TransformBatch blendedBack;
+        blendTransformBatch(small, big, 0.6f, blendedBack);
+
+        assert(blended.size() == 3 && blendedBack.size() == 3);
+
+        for(size_t transform = 0; transform < 3; transform++) {
+            glm::mat4 expected = from[transform].interpolate(to[transform], 0.4f).getMatrix();
+
+            assert(eqMat4(blended.get(transform).getMatrix(), expected, 0.001f));
+            assert(eqMat4(blendedBack.get(transform).getMatrix(), expected, 0.001f));
+        }
+    }
+}
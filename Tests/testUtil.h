@@ -0,0 +1,17 @@
+#ifndef ILL_TEST_UTIL_H__
+#define ILL_TEST_UTIL_H__
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+Makes up a distinct, non NULL, aligned pointer for an id.
+For tests and benchmarks of code that only stores and compares pointers and never dereferences them,
+like the render queues with their shaders, materials, and meshes.
+*/
+template <typename T>
+inline T * fakePointer(size_t id) {
+    return reinterpret_cast<T *>((uintptr_t) (id + 1) * 64);
+}
+
+#endif
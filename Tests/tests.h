@@ -6,6 +6,8 @@ Just putting together some unit tests and stuff, better than nothing...
 */
 void testRefCountPtr();
 
+void testIntrusivePtr();
+
 void testEndian();
 
 void testSortDimensions();
@@ -14,4 +16,42 @@ void testPool();
 
 void testGeomUtil();
 
+void testFrameArena();
+
+void testSparseCellStorage();
+
+void testSparseGridVolume3D();
+
+void testParallelRender();
+
+void testSoftwareOcclusionBuffer();
+
+void testBoxBatch();
+
+void testSceneMoves();
+
+void testIllmesh();
+
+void testBufferedFileReader();
+
+void testAsyncResourceLoading();
+
+void testLruCache();
+
+void testConcurrentLruCache();
+
+void testPackFileSystem();
+
+void testSkeletonAnimation();
+
+void testResourceHotReloader();
+
+void testSkeletonPose();
+
+void testTransformBatch();
+
+void testThreadPool();
+
+void testModelAnimationSystem();
+
 #endif
\ No newline at end of file
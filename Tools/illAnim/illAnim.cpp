@@ -0,0 +1,66 @@
+/**
+Command line tool that converts skeleton animations of any illanim version to ILLANIM1.
+
+illAnim <input animation> <output animation> [<input animation> <output animation> ...]
+
+Old ILLANIM0 files still load, but their keys get compressed every time they're loaded.  Run them through this as part of the
+asset build so the game only ever loads ILLANIM1, which loads straight into memory.  ILLANIM0 files get encoded with the
+default error bounds, the same as loading them in the game does.  Converting an ILLANIM1 file just writes it back out as is.
+*/
+
+#include <cstdio>
+
+#include "Logging/logging.h"
+#include "Logging/serial/SerialLogger.h"
+#include "Logging/StdioLogger.h"
+#include "FileSystem/File.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Graphics/serial/Model/SkeletonAnimation.h"
+
+illLogging::Logger * illLogging::logger;
+illFileSystem::FileSystem * illFileSystem::fileSystem;
+
+void printUsage() {
+    printf("Usage: illAnim <input animation> <output animation> [<input animation> <output animation> ...]\n");
+}
+
+int main(int argc, char ** argv) {
+    illLogging::SerialLogger logger;
+    illLogging::StdioLogger stdioLogger;
+    logger.addLogDestination(&stdioLogger);
+    illLogging::logger = &logger;
+
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    if(argc < 3 || (argc - 1) % 2 != 0) {
+        printUsage();
+        return 1;
+    }
+
+    int result = 0;
+
+    for(int arg = 1; arg < argc; arg += 2) {
+        illGraphics::SkeletonAnimationLoadArgs loadArgs;
+        loadArgs.m_path = argv[arg];
+
+        //nothing in loading an animation needs the backend
+        illGraphics::SkeletonAnimation animation;
+        animation.load(loadArgs, NULL);
+
+        //the loader already logged why
+        if(!animation.isLoaded()) {
+            result = 1;
+            continue;
+        }
+
+        illFileSystem::File * file = illFileSystem::fileSystem->openWrite(argv[arg + 1]);
+        animation.writeIllanim1(file);
+        delete file;
+
+        LOG_INFO("Converted %s to ILLANIM1 %s, %u bones, %u keys.", argv[arg], argv[arg + 1],
+            animation.getNumBones(), (unsigned int) animation.getNumKeys());
+    }
+
+    return result;
+}
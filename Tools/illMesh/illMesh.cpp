@@ -0,0 +1,45 @@
+/**
+Command line tool that converts meshes of any illmesh version to ILLMESH2.
+
+illMesh <input mesh> <output mesh> [<input mesh> <output mesh> ...]
+
+Old ILLMESH1 files still load, but have to be read one value at a time.  Run them through this as part of the
+asset build so the game only ever loads ILLMESH2.  Converting an ILLMESH2 file just writes it back out as is.
+*/
+
+#include <cstdio>
+
+#include "Logging/logging.h"
+#include "Logging/serial/SerialLogger.h"
+#include "Logging/StdioLogger.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "Util/Illmesh/IllmeshWriter.h"
+
+illLogging::Logger * illLogging::logger;
+illFileSystem::FileSystem * illFileSystem::fileSystem;
+
+void printUsage() {
+    printf("Usage: illMesh <input mesh> <output mesh> [<input mesh> <output mesh> ...]\n");
+}
+
+int main(int argc, char ** argv) {
+    illLogging::SerialLogger logger;
+    illLogging::StdioLogger stdioLogger;
+    logger.addLogDestination(&stdioLogger);
+    illLogging::logger = &logger;
+
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    if(argc < 3 || (argc - 1) % 2 != 0) {
+        printUsage();
+        return 1;
+    }
+
+    for(int arg = 1; arg < argc; arg += 2) {
+        convertIllmesh(argv[arg], argv[arg + 1]);
+        LOG_INFO("Converted %s to ILLMESH2 %s.", argv[arg], argv[arg + 1]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+Command line tool that builds an ILLPACK1 pack out of loose files.
+
+illPack [-align <bytes>] [-lz4] <output pack> <root directory> <file list>
+
+The file list is a text file with one path per line relative to the root directory, which is also the path the file
+gets opened with from the pack.  Have the build scripts generate it from whatever goes in the pack.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Logging/logging.h"
+#include "Logging/serial/SerialLogger.h"
+#include "Logging/StdioLogger.h"
+#include "FileSystem/File.h"
+#include "FileSystem-Stdio/StdioFileSystem.h"
+#include "FileSystem-Pack/PackWriter.h"
+
+illLogging::Logger * illLogging::logger;
+illFileSystem::FileSystem * illFileSystem::fileSystem;
+
+void printUsage() {
+    printf("Usage: illPack [-align <bytes>] [-lz4] <output pack> <root directory> <file list>\n");
+}
+
+int main(int argc, char ** argv) {
+    illLogging::SerialLogger logger;
+    illLogging::StdioLogger stdioLogger;
+    logger.addLogDestination(&stdioLogger);
+    illLogging::logger = &logger;
+
+    illStdio::StdioFileSystem stdioFileSystem;
+    illFileSystem::fileSystem = &stdioFileSystem;
+
+    uint32_t alignment = illPack::PACK_DEFAULT_ALIGNMENT;
+    bool compress = false;
+    int arg = 1;
+
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        if(strcmp(argv[arg], "-align") == 0 && arg + 1 < argc) {
+            alignment = (uint32_t) atoi(argv[++arg]);
+
+            if(alignment == 0 || (alignment & (alignment - 1)) != 0) {
+                printf("Alignment %s must be a power of 2.\n", argv[arg]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[arg], "-lz4") == 0) {
+#ifndef ILL_PACK_LZ4
+            printf("Built without ILL_PACK_LZ4, files will be stored uncompressed.\n");
+#endif
+            compress = true;
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if(argc - arg != 3) {
+        printUsage();
+        return 1;
+    }
+
+    const char * packPath = argv[arg];
+    std::string rootPath(argv[arg + 1]);
+    const char * listPath = argv[arg + 2];
+
+    if(!rootPath.empty() && rootPath[rootPath.size() - 1] != '/' && rootPath[rootPath.size() - 1] != '\\') {
+        rootPath.push_back('/');
+    }
+
+    //read the file list
+    std::vector<std::string> paths;
+
+    {
+        FILE * list = fopen(listPath, "r");
+
+        if(!list) {
+            LOG_FATAL_ERROR("Failed to open file list %s.", listPath);
+        }
+
+        char line[1024];
+
+        while(fgets(line, sizeof(line), list)) {
+            size_t length = strlen(line);
+
+            while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+                --length;
+            }
+
+            if(length > 0) {
+                paths.push_back(std::string(line, length));
+            }
+        }
+
+        fclose(list);
+    }
+
+    //write the pack
+    illFileSystem::File * packFile = stdioFileSystem.openWrite(packPath);
+    std::vector<uint8_t> data;
+    size_t totalSize = 0;
+    uint64_t packSize;
+
+    {
+        illPack::PackWriter writer(packFile, alignment, compress);
+
+        for(size_t path = 0; path < paths.size(); path++) {
+            illFileSystem::File * file = stdioFileSystem.openRead((rootPath + paths[path]).c_str());
+
+            data.resize(file->getSize());
+
+            if(!data.empty()) {
+                file->read(&data[0], data.size());
+            }
+
+            delete file;
+
+            writer.addFile(paths[path].c_str(), data.empty() ? NULL : &data[0], data.size());
+            totalSize += data.size();
+        }
+
+        writer.finish();
+        packSize = writer.getPackSize();
+    }
+
+    delete packFile;
+
+    LOG_INFO("Packed %u files, %u bytes, into %s, %u bytes.", (unsigned int) paths.size(), (unsigned int) totalSize, packPath, (unsigned int) packSize);
+
+    return 0;
+}
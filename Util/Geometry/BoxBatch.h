@@ -0,0 +1,125 @@
+#ifndef ILL_BOX_BATCH_H_
+#define ILL_BOX_BATCH_H_
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Util/Geometry/Box.h"
+
+/**
+The box batch arrays are padded to a multiple of this many boxes so the SIMD code can always load a full group.
+8 is enough for AVX.
+*/
+const size_t BOX_BATCH_GROUP_SIZE = 8;
+
+/**
+A list of axis aligned boxes stored as a structure of arrays, one array each for the min and max x, y, and z.
+This is the layout the SIMD culling code in frustumCull.h wants, since it can load the same coordinate of 4 or 8 boxes at once.
+
+It's meant to be kept in sync with some other list of things, so removing swaps the last box into the hole
+like the other containers in the engine do.  It can be used as the attachment of a SparseCellStorage.
+
+The arrays are padded with zeroes past the last box.  Nothing should care what the results for the padding are.
+*/
+class BoxBatch {
+public:
+    typedef Box<> value_type;
+
+    inline BoxBatch()
+        : m_size(0)
+    {}
+
+    inline size_t size() const {
+        return m_size;
+    }
+
+    inline bool empty() const {
+        return m_size == 0;
+    }
+
+    inline void push_back(const Box<>& box) {
+        size_t paddedSize = (m_size / BOX_BATCH_GROUP_SIZE + 1) * BOX_BATCH_GROUP_SIZE;
+
+        if(m_minX.size() < paddedSize) {
+            m_minX.resize(paddedSize, 0.0f);
+            m_minY.resize(paddedSize, 0.0f);
+            m_minZ.resize(paddedSize, 0.0f);
+            m_maxX.resize(paddedSize, 0.0f);
+            m_maxY.resize(paddedSize, 0.0f);
+            m_maxZ.resize(paddedSize, 0.0f);
+        }
+
+        set(m_size++, box);
+    }
+
+    inline void set(size_t index, const Box<>& box) {
+        assert(index < m_size);
+
+        m_minX[index] = box.m_min.x;
+        m_minY[index] = box.m_min.y;
+        m_minZ[index] = box.m_min.z;
+        m_maxX[index] = box.m_max.x;
+        m_maxY[index] = box.m_max.y;
+        m_maxZ[index] = box.m_max.z;
+    }
+
+    inline Box<> get(size_t index) const {
+        assert(index < m_size);
+
+        return Box<>(glm::vec3(m_minX[index], m_minY[index], m_minZ[index]),
+            glm::vec3(m_maxX[index], m_maxY[index], m_maxZ[index]));
+    }
+
+    /**
+    Removes a box by moving the last one into its place.
+    */
+    inline void swapRemove(size_t index) {
+        assert(index < m_size);
+
+        size_t last = --m_size;
+
+        if(index != last) {
+            m_minX[index] = m_minX[last];
+            m_minY[index] = m_minY[last];
+            m_minZ[index] = m_minZ[last];
+            m_maxX[index] = m_maxX[last];
+            m_maxY[index] = m_maxY[last];
+            m_maxZ[index] = m_maxZ[last];
+        }
+
+        //keep the padding zeroed, the arrays themselves keep their size so refilling doesn't allocate
+        m_minX[last] = m_minY[last] = m_minZ[last] = 0.0f;
+        m_maxX[last] = m_maxY[last] = m_maxZ[last] = 0.0f;
+    }
+
+    inline void clear() {
+        while(m_size > 0) {
+            swapRemove(m_size - 1);
+        }
+    }
+
+    inline size_t getMemoryUsage() const {
+        return m_minX.capacity() * sizeof(float) * 6;
+    }
+
+    inline const float * getMinX() const { return m_minX.data(); }
+    inline const float * getMinY() const { return m_minY.data(); }
+    inline const float * getMinZ() const { return m_minZ.data(); }
+    inline const float * getMaxX() const { return m_maxX.data(); }
+    inline const float * getMaxY() const { return m_maxY.data(); }
+    inline const float * getMaxZ() const { return m_maxZ.data(); }
+
+private:
+    size_t m_size;
+
+    std::vector<float> m_minX;
+    std::vector<float> m_minY;
+    std::vector<float> m_minZ;
+    std::vector<float> m_maxX;
+    std::vector<float> m_maxY;
+    std::vector<float> m_maxZ;
+};
+
+#endif
@@ -161,22 +161,30 @@ struct Frustum {
 
     inline MeshEdgeList<T> getMeshEdgeList() const {
         MeshEdgeList<T> res;
+        getMeshEdgeList(res);
+
+        return res;
+    }
+
+    /**
+    Fills in an existing mesh edge list with the frustum instead of returning a new one.
+    Keep the mesh edge list around between frames and this won't allocate anything after the first time.
+    */
+    inline void getMeshEdgeList(MeshEdgeList<T>& destination) const {
+        destination.clear();
 
         //the edges
         for(unsigned int edge = 0; edge < 12; edge++) {
-            res.m_edges.push_back(MeshEdgeList<>::Edge(FRUSTUM_EDGE_LIST[edge][0], FRUSTUM_EDGE_LIST[edge][1]));
+            destination.m_edges.push_back(MeshEdgeList<>::Edge(FRUSTUM_EDGE_LIST[edge][0], FRUSTUM_EDGE_LIST[edge][1]));
         }
 
         //the points
         for(unsigned int point = 0; point < 8; point++) {
-            res.m_points.push_back(m_points[point]);
+            destination.m_points.push_back(m_points[point]);
         }
 
-        res.computePointEdgeMap();
-        res.computeBounds(m_bounds);
-
-        //TODO: I sure hope compilers in 2013 are smart enough to do return value optimization here, if not, optimize later
-        return res;
+        destination.computePointEdgeMap();
+        destination.computeBounds(m_bounds);
     }
 
     //the frustum planes
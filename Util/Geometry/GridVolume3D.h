@@ -54,6 +54,15 @@ public:
         return index.x + m_cellNumber.x * (index.y + m_cellNumber.y * index.z);
     }
 
+    /**
+    Gets the grid cell position for an array index, the reverse of indexForCell.
+    */
+    inline glm::uvec3 cellForIndex(unsigned int index) const {
+        return glm::uvec3(index % m_cellNumber.x,
+            (index / m_cellNumber.x) % m_cellNumber.y,
+            index / (m_cellNumber.x * m_cellNumber.y));
+    }
+
     /**
     Gets the grid cell position for a position in the  world snapped to the grid.
     */
@@ -175,11 +184,14 @@ public:
             //find the origin point
             glm::vec3 splitOrigin = m_cellDimensions * vec3cast<unsigned int, glm::mediump_float>(centerCell);
             
-            newIterator.m_iterators.resize(newIterator.m_iterators.size() + 8);
-            newIterator.m_meshEdgeListCopies.resize(newIterator.m_meshEdgeListCopies.size() + 8);
+            //only grow the arrays, the entries past m_numIterators are kept around so their memory is reused
+            if(newIterator.m_iterators.size() < newIterator.m_numIterators + 8) {
+                newIterator.m_iterators.resize(newIterator.m_numIterators + 8);
+                newIterator.m_meshEdgeListCopies.resize(newIterator.m_numIterators + 8);
+            }
 
             //split into 8
-            int currIter = 0;
+            size_t currIter = newIterator.m_numIterators;
 
             for(int iter = 0; iter < 8; iter++) {
                 glm::detail::tvec3<int8_t> directionSign;
@@ -282,8 +294,7 @@ public:
                 }
             }
 
-            newIterator.m_iterators.resize(currIter);
-            newIterator.m_meshEdgeListCopies.resize(currIter);
+            newIterator.m_numIterators = currIter;
         }
     }
     
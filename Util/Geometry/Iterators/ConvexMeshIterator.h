@@ -2,8 +2,7 @@
 #define ILL_CONVEX_MESH_ITERATOR_H_
 
 #include <algorithm>
-#include <unordered_set>
-#include <unordered_map>
+#include <vector>
 #include <list>
 
 #include "Logging/logging.h"
@@ -28,10 +27,21 @@ private:
     const static bool LEFT_SIDE = true;
     const static bool RIGHT_SIDE = false;
 
+    ///An edge that is currently being processed by the rasterizing algorithm
+    struct ActiveEdge {
+        ///Index of the edge in the mesh edge list
+        size_t m_edge;
+
+        ///How many slices until the other edge end
+        P m_countdown;
+
+        ///The point index that the slice is going towards
+        size_t m_destPoint;
+    };
+
 public:
     ConvexMeshIterator()
-        : m_isEdgeChecked(NULL),
-        m_atEnd(true)
+        : m_atEnd(true)
     {}
 
     ConvexMeshIterator(MeshEdgeList<W>* meshEdgeList, 
@@ -49,9 +59,15 @@ public:
         m_bounds = bounds;
         m_atEnd = false;
 
+        //the iterator may be getting reused, so clear out anything left from last time but keep the memory
+        m_activeEdges.clear();
+        m_pointList[0].clear();
+        m_pointList[1].clear();
+        m_sliceRasterizeEdges[0].clear();
+        m_sliceRasterizeEdges[1].clear();
+
         //initialize edges lists
-        m_isEdgeChecked = new bool[meshEdgeList->m_edges.size()];
-        memset(m_isEdgeChecked, 0, sizeof(bool) * meshEdgeList->m_edges.size());
+        m_isEdgeChecked.assign(meshEdgeList->m_edges.size(), false);
         
         //initialize world bounds, they're based on the grid not the world bounds of the volume itself
         m_worldBounds.m_min = vec3cast<P, W>(m_bounds.m_min) * cellDimensions;
@@ -98,10 +114,6 @@ public:
         setupSlice();
     }
 
-    ~ConvexMeshIterator() {
-        delete[] m_isEdgeChecked;
-    }
-
     inline bool atEnd() const {
         return m_atEnd;
     }
@@ -219,12 +231,12 @@ private:
     /**
     Should be called only from within addPoint()
     */
-    void addPointRecursive(size_t point, std::unordered_map<size_t, P>& activeEdgesDestination) {
+    void addPointRecursive(size_t point, std::vector<ActiveEdge>& activeEdgesDestination) {
         //find all inactive edges for a point
-        MeshEdgeList<W>::PointEdgeMapIterators edgeIters = m_meshEdgeList->m_pointEdgeMap.equal_range(point);
+        MeshEdgeList<W>::PointEdgeIterators edgeIters = m_meshEdgeList->getPointEdges(point);
 
-        for(MeshEdgeList<W>::PointEdgeMapIterator edgeIter = edgeIters.first; edgeIter != edgeIters.second; edgeIter++) {
-            size_t edgeIndex = edgeIter->second;
+        for(MeshEdgeList<W>::PointEdgeIterator edgeIter = edgeIters.first; edgeIter != edgeIters.second; edgeIter++) {
+            size_t edgeIndex = *edgeIter;
 
             //check if the edge is already checked
             if(!m_isEdgeChecked[edgeIndex]) {
@@ -243,9 +255,13 @@ private:
                     addPointRecursive(otherPoint, activeEdgesDestination);
                 }
                 else {
-                    //add edge to active edges
-                    activeEdgesDestination[edgeIndex] = sliceNum;
-                    m_activeEdgeDestPoint[edgeIndex] = otherPoint;
+                    //add edge to active edges, it can't be in there already since it was only just checked
+                    ActiveEdge activeEdge;
+                    activeEdge.m_edge = edgeIndex;
+                    activeEdge.m_countdown = sliceNum;
+                    activeEdge.m_destPoint = otherPoint;
+
+                    activeEdgesDestination.push_back(activeEdge);
                 }
             }
         }
@@ -254,7 +270,7 @@ private:
     /**
     Adds a point from the 3D polygon being rasterized.
     */
-    inline void addPoint(size_t point, std::unordered_map<size_t, P>& activeEdgesDestination) {
+    inline void addPoint(size_t point, std::vector<ActiveEdge>& activeEdgesDestination) {
         m_pointList[m_currentPointList].push_back(fixRasterPointPrecision(glm::detail::tvec2<W>(m_meshEdgeList->m_points[point].x, m_meshEdgeList->m_points[point].y)));
         addPointRecursive(point, activeEdgesDestination);
     }
@@ -308,17 +324,18 @@ private:
 
         //count down all active edge counts
         //a copy is needed because addPoint can't be modifying the same list that's being updated, horrible bugs happen
-        std::unordered_map<size_t, P> activeEdgesCopy(m_activeEdges.size());
+        //the copy is a member that gets swapped back and forth so it keeps its memory
+        std::vector<ActiveEdge>& activeEdgesCopy = m_activeEdgesCopy;
+        activeEdgesCopy.clear();
 
-        for(std::unordered_map<size_t, P>::iterator activeEdgeIter = m_activeEdges.begin(); activeEdgeIter != m_activeEdges.end(); activeEdgeIter++) {
-            size_t edgeIndex = activeEdgeIter->first;
-            P& activeEdgeCountdown = activeEdgeIter->second;
+        for(size_t activeEdgeIndex = 0; activeEdgeIndex < m_activeEdges.size(); activeEdgeIndex++) {
+            ActiveEdge& activeEdge = m_activeEdges[activeEdgeIndex];
             
-            if(--activeEdgeCountdown == 0) {    //discard this edge, and add its destination point
-                addPoint(m_activeEdgeDestPoint.at(edgeIndex), activeEdgesCopy);
+            if(--activeEdge.m_countdown == 0) {    //discard this edge, and add its destination point
+                addPoint(activeEdge.m_destPoint, activeEdgesCopy);
             }
             else {
-                activeEdgesCopy[edgeIndex] = activeEdgeCountdown; //keep this edge countdown
+                activeEdgesCopy.push_back(activeEdge); //keep this edge countdown
             }
         }
         
@@ -351,8 +368,8 @@ private:
         //LOG_DEBUG("Setup Slice Begin");
 
         //find intersection of active edges against other side of slice and add it to the other points list
-        for(std::unordered_map<size_t, P>::const_iterator activeEdgeIter = m_activeEdges.begin(); activeEdgeIter != m_activeEdges.end(); activeEdgeIter++) {
-            size_t activeEdge = activeEdgeIter->first;
+        for(size_t activeEdgeIndex = 0; activeEdgeIndex < m_activeEdges.size(); activeEdgeIndex++) {
+            size_t activeEdge = m_activeEdges[activeEdgeIndex].m_edge;
                         
             assert(m_meshEdgeList->m_points[m_meshEdgeList->m_edges[activeEdge].m_point[0]].z != m_meshEdgeList->m_points[m_meshEdgeList->m_edges[activeEdge].m_point[1]].z);
 
@@ -401,7 +418,8 @@ private:
             }
         };
 
-        std::vector<glm::detail::tvec2<W>*> sortedPoints;
+        std::vector<glm::detail::tvec2<W>*>& sortedPoints = m_sortedPoints;
+        sortedPoints.clear();
 
         /*
         I commented out these next few asserts because I am now supporting rasterizing of
@@ -751,14 +769,15 @@ private:
     ///Sign of each dimension in the direction vector the view frustum faces in world space, used during mapping between the two spaces
     glm::detail::tvec3<int8_t> m_directionSign;
     
-    ///Edges that have already been processed by the rasterizing algorithm and are either discarded or active
-    bool * m_isEdgeChecked;
+    ///Edges that have already been processed by the rasterizing algorithm and are either discarded or active.
+    ///Not a vector<bool> so it stays a plain array of flags, and not a raw array so copies of the iterator are safe
+    std::vector<uint8_t> m_isEdgeChecked;
 
-    ///Edges that are currently being processed by the rasterizing algorithm, mapping of edge to how many slices until the other edge end
-    std::unordered_map<size_t, P> m_activeEdges;
+    ///Edges that are currently being processed by the rasterizing algorithm
+    std::vector<ActiveEdge> m_activeEdges;
 
-    ///The active edge point index that the slice is going towards
-    std::unordered_map<size_t, size_t> m_activeEdgeDestPoint;
+    ///The active edges for the next slice while advanceSlice() is building them, kept around so its memory gets reused
+    std::vector<ActiveEdge> m_activeEdgesCopy;
 
     /*
     The mesh edge list itself, its points become mapped to algorithm space when starting the algorithm
@@ -787,6 +806,9 @@ private:
     ///The current maximums for the 2D rasterizing, the x value changes at every row, the slice is done being rasterized when m_currentPosition[m_dimensionOrder[1]] y of sliceMax is reached
     glm::detail::tvec2<P> m_sliceMax;
 
+    ///The points of both point lists sorted for the convex hull when setting up a slice, kept around so its memory gets reused
+    std::vector<glm::detail::tvec2<W>* > m_sortedPoints;
+
     ///The edge lists for the convex polygon rasterizing
     std::vector<glm::detail::tvec2<W>* > m_sliceRasterizeEdges[2];
 
@@ -256,10 +256,10 @@ public:
     */
     void addPointRecursive(size_t point, std::unordered_map<size_t, P>& activeEdgesDestination) {
         //find all inactive edges for a point
-        MeshEdgeList<W>::PointEdgeMapIterators edgeIters = m_meshEdgeList->m_pointEdgeMap.equal_range(point);
+        MeshEdgeList<W>::PointEdgeIterators edgeIters = m_meshEdgeList->getPointEdges(point);
 
-        for(MeshEdgeList<W>::PointEdgeMapIterator edgeIter = edgeIters.first; edgeIter != edgeIters.second; edgeIter++) {
-            size_t edgeIndex = edgeIter->second;
+        for(MeshEdgeList<W>::PointEdgeIterator edgeIter = edgeIters.first; edgeIter != edgeIters.second; edgeIter++) {
+            size_t edgeIndex = *edgeIter;
 
             //check if the edge is already checked
             if(!m_isEdgeChecked[edgeIndex]) {
@@ -16,17 +16,22 @@ boundaries, there is nothing stopping those cells to be iterated over multiple t
 
 You can also hold the mesh edge list copies here if they were needed.
 
+Only the first m_numIterators entries of the arrays are in use.  The arrays never shrink so an iterator
+can be reset and refilled every frame without reallocating the iterators and mesh edge list copies.
+
 This is a VERY simple class without too much encapsulation or safety, so just use it right.
 */
 template <typename W = glm::mediump_float, typename P = unsigned int>
 class MultiConvexMeshIterator {
 public:
     MultiConvexMeshIterator()
-        : m_currentIter(0)
+        : m_currentIter(0),
+        m_numIterators(0)
     {}
     
     MultiConvexMeshIterator(const MultiConvexMeshIterator& other)
         : m_currentIter(other.m_currentIter),
+        m_numIterators(other.m_numIterators),
         m_meshEdgeListCopies(other.m_meshEdgeListCopies),
         m_iterators(other.m_iterators)
     {
@@ -36,6 +41,14 @@ public:
         }
     }
 
+    /**
+    Empties the iterator but keeps the storage around for reuse.
+    */
+    inline void reset() {
+        m_currentIter = 0;
+        m_numIterators = 0;
+    }
+
     /**
     The current grid cell the iterator is on.
     */
@@ -51,8 +64,8 @@ public:
     Whether or not all cells in the iterator have been rasterized.
     */
     inline bool atEnd() const {
-        return m_currentIter >= m_iterators.size() 
-            || (m_currentIter == m_iterators.size() - 1 && m_iterators[m_currentIter].atEnd());
+        return m_currentIter >= m_numIterators 
+            || (m_currentIter == m_numIterators - 1 && m_iterators[m_currentIter].atEnd());
     }
 
     /**
@@ -76,6 +89,7 @@ public:
     }
 
     size_t m_currentIter;
+    size_t m_numIterators;
     std::vector<MeshEdgeList<W>> m_meshEdgeListCopies;
     std::vector<ConvexMeshIterator<W, P>> m_iterators; 
 };
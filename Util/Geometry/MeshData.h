@@ -66,6 +66,11 @@ inline bool featureMaskHasColors(FeaturesMask features) {
     return (features & MF_COLOR) != 0;
 }
 
+/**
+The largest vertex count that 16 bit indices can address.
+*/
+const uint32_t MESH_MAX_16_BIT_INDEXED_VERTICES = 0x10000;
+
 /**
 Contains data about a mesh and methods to access the data.
 The vertex data, such as positions, normals, etc... is stored interleaved for efficiency.
@@ -77,8 +82,11 @@ and then using the offset methods when drawing the vertex buffer object.
 TODO: It'd be nice to rewrite this to be a baseclass using variadic templates and call it InterleavedData,
 then have a MeshData class that contains this.
 
+The indices are 16 bit when all the vertices can be addressed with 16 bits, and 32 bit otherwise.
+The width is picked per mesh so small meshes still upload and draw with half the index bandwidth.
+
 @tparam T The precision of the data inside.  By default it's float.
-@tparam I The precision of the index data.  By default it's unsigned int.
+@tparam I The smallest precision of the index data.  By default it's 16 bit, the mesh goes to 32 bit indices if it needs to.
 */
 template <typename T = glm::mediump_float, typename I = uint16_t>
 class MeshData {
@@ -157,6 +165,7 @@ public:
         m_data(NULL),
         m_numIndices(0),
         m_indices(NULL),
+        m_indexSize(sizeof(I)),
         m_numPrimitiveGroups(0),
         m_primitiveGroups(NULL),
         m_features(0)
@@ -170,12 +179,15 @@ public:
     @param features Which features are stored in the verteces.
     By default it creates a mesh that stores positions, normals, tangents, and texture coordinates.
     @param allocate Whether or not the data for the mesh should be allocated on the CPU side.
+    @param indexSize The size in bytes of the indices, 2 or 4.  Leave it 0 to pick the smallest size that can address all the vertices.
     */
-    MeshData(uint32_t numInd, uint32_t numVert, uint8_t numGroups, FeaturesMask features = MF_POSITION | MF_NORMAL | MF_TANGENT | MF_TEX_COORD, bool allocate = true)
+    MeshData(uint32_t numInd, uint32_t numVert, uint8_t numGroups, FeaturesMask features = MF_POSITION | MF_NORMAL | MF_TANGENT | MF_TEX_COORD, bool allocate = true,
+            uint8_t indexSize = 0)
         : m_numVert(numVert),
         m_data(NULL),
         m_numIndices(numInd),
         m_indices(NULL),
+        m_indexSize(indexSize != 0 ? indexSize : smallestIndexSize(numVert)),
         m_numPrimitiveGroups(numGroups),
         m_primitiveGroups(NULL),
         m_features(features)
@@ -193,6 +205,7 @@ public:
         m_data(NULL),
         m_numIndices(36),
         m_indices(NULL),
+        m_indexSize(sizeof(I)),
         m_numPrimitiveGroups(1),
         m_primitiveGroups(NULL),
         m_features(features)
@@ -209,70 +222,72 @@ public:
         getPosition(6) = glm::vec3(box.m_max.x, box.m_max.y, box.m_max.z);
         getPosition(7) = glm::vec3(box.m_min.x, box.m_max.y, box.m_max.z);
 
+        I * indices = getIndices();
+
         //face 0 tri 0
-        m_indices[0] = 0;
-        m_indices[1] = 3;
-        m_indices[2] = 1;
+        indices[0] = 0;
+        indices[1] = 3;
+        indices[2] = 1;
 
         //face 0 tri 1
-        m_indices[3] = 1;
-        m_indices[4] = 3;
-        m_indices[5] = 2;
+        indices[3] = 1;
+        indices[4] = 3;
+        indices[5] = 2;
 
 
         //face 1 tri 0
-        m_indices[6] = 2;
-        m_indices[7] = 6;
-        m_indices[8] = 5;
+        indices[6] = 2;
+        indices[7] = 6;
+        indices[8] = 5;
 
         //face 1 tri 1
-        m_indices[9] = 5;
-        m_indices[10] = 1;
-        m_indices[11] = 2;
+        indices[9] = 5;
+        indices[10] = 1;
+        indices[11] = 2;
 
 
         //face 2 tri 0
-        m_indices[12] = 2;
-        m_indices[13] = 3;
-        m_indices[14] = 7;
+        indices[12] = 2;
+        indices[13] = 3;
+        indices[14] = 7;
 
         //face 2 tri 1
-        m_indices[15] = 7;
-        m_indices[16] = 6;
-        m_indices[17] = 2;
+        indices[15] = 7;
+        indices[16] = 6;
+        indices[17] = 2;
 
 
         //face 3 tri 0
-        m_indices[18] = 5;
-        m_indices[19] = 6;
-        m_indices[20] = 4;
+        indices[18] = 5;
+        indices[19] = 6;
+        indices[20] = 4;
 
         //face 3 tri 1
-        m_indices[21] = 4;
-        m_indices[22] = 6;
-        m_indices[23] = 7;
+        indices[21] = 4;
+        indices[22] = 6;
+        indices[23] = 7;
 
 
         //face 4 tri 0
-        m_indices[24] = 7;
-        m_indices[25] = 3;
-        m_indices[26] = 0;
+        indices[24] = 7;
+        indices[25] = 3;
+        indices[26] = 0;
 
         //face 4 tri 1
-        m_indices[27] = 0;
-        m_indices[28] = 4;
-        m_indices[29] = 7;
+        indices[27] = 0;
+        indices[28] = 4;
+        indices[29] = 7;
 
 
         //face 5 tri 0
-        m_indices[30] = 1;
-        m_indices[31] = 5;
-        m_indices[32] = 0;
+        indices[30] = 1;
+        indices[31] = 5;
+        indices[32] = 0;
 
         //face 5 tri 1
-        m_indices[33] = 0;
-        m_indices[34] = 5;
-        m_indices[35] = 4;
+        indices[33] = 0;
+        indices[34] = 5;
+        indices[35] = 4;
 
         m_primitiveGroups[0].m_type = PrimitiveGroup::Type::TRIANGLES;
         m_primitiveGroups[0].m_beginIndex = 0;
@@ -291,7 +306,7 @@ public:
         free();
 
         m_data = new uint8_t[m_numVert * m_vertexSize];
-        m_indices = new I[m_numIndices];
+        m_indices = new uint8_t[m_numIndices * m_indexSize];
     }
 
     /**
@@ -307,6 +322,13 @@ public:
         m_indices = NULL;
     }
 
+    /**
+    Which features are stored in the vertices.
+    */
+    inline FeaturesMask getFeatures() const {
+        return m_features;
+    }
+
     /**
     Whether or not this mesh has positions.
     */
@@ -720,12 +742,65 @@ public:
 
     /**
     Get a pointer to the indeces.
-    This is useful for uploading the data to the GPU vertex buffer object.
+    Only valid if the mesh is using indices of type I, check getIndexSize(), otherwise use getIndices32().
     */
     inline I * getIndices() const {
+        assert(m_indexSize == sizeof(I));
+        return reinterpret_cast<I *>(m_indices);
+    }
+
+    /**
+    Get a pointer to the indices of a mesh using 32 bit indices.
+    */
+    inline uint32_t * getIndices32() const {
+        assert(m_indexSize == sizeof(uint32_t));
+        return reinterpret_cast<uint32_t *>(m_indices);
+    }
+
+    /**
+    Get a pointer to the raw index data whatever the index size is.
+    This is useful for uploading the data to the GPU index buffer object.
+    */
+    inline uint8_t * getIndexData() const {
         return m_indices;
     }
 
+    /**
+    The size in bytes of each index, either sizeof(I) or 4.
+    */
+    inline uint8_t getIndexSize() const {
+        return m_indexSize;
+    }
+
+    /**
+    Gets an index whatever the index size is.
+    Slower than going through getIndices() or getIndices32() directly so avoid it in big loops.
+    */
+    inline uint32_t getIndex(uint32_t index) const {
+        assert(index < m_numIndices);
+        assert(m_indices);
+
+        return m_indexSize == sizeof(uint32_t) 
+            ? reinterpret_cast<const uint32_t *>(m_indices)[index] 
+            : (uint32_t) reinterpret_cast<const I *>(m_indices)[index];
+    }
+
+    /**
+    Sets an index whatever the index size is.
+    */
+    inline void setIndex(uint32_t index, uint32_t value) {
+        assert(index < m_numIndices);
+        assert(m_indices);
+
+        if(m_indexSize == sizeof(uint32_t)) {
+            reinterpret_cast<uint32_t *>(m_indices)[index] = value;
+        }
+        else {
+            assert(value < MESH_MAX_16_BIT_INDEXED_VERTICES);
+            reinterpret_cast<I *>(m_indices)[index] = (I) value;
+        }
+    }
+
     /**
     Get a reference to a triangle group.
     You can use this reference to modify the internal data inside too.
@@ -758,6 +833,10 @@ public:
     }
 
 private:
+    static inline uint8_t smallestIndexSize(uint32_t numVert) {
+        return sizeof(I) >= sizeof(uint32_t) || numVert <= MESH_MAX_16_BIT_INDEXED_VERTICES ? (uint8_t) sizeof(I) : (uint8_t) sizeof(uint32_t);
+    }
+
     void initialize(bool allocate) {
         free();
 
@@ -808,7 +887,8 @@ private:
     uint8_t * m_data;
 
     uint32_t m_numIndices;
-    I * m_indices;
+    uint8_t * m_indices;
+    uint8_t m_indexSize;
 
     uint8_t m_numPrimitiveGroups;
     PrimitiveGroup * m_primitiveGroups;
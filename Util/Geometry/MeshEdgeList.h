@@ -4,8 +4,6 @@
 #include <stdint.h>
 #include <algorithm>
 #include <glm/glm.hpp>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "Util/Geometry/Box.h"
@@ -21,9 +19,8 @@ with additional useful datastructures.
 */
 template<typename T = glm::mediump_float>
 struct MeshEdgeList {
-    typedef typename std::unordered_multimap<size_t, size_t> PointEdgeMap;
-    typedef typename PointEdgeMap::const_iterator PointEdgeMapIterator;
-    typedef typename std::pair<PointEdgeMapIterator, PointEdgeMapIterator> PointEdgeMapIterators;
+    typedef std::vector<size_t>::const_iterator PointEdgeIterator;
+    typedef std::pair<PointEdgeIterator, PointEdgeIterator> PointEdgeIterators;
         
     struct Edge {
         Edge() {}
@@ -39,20 +36,48 @@ struct MeshEdgeList {
     inline void clear() {
         m_points.clear();
         m_edges.clear();
-        m_pointEdgeMap.clear();
+        m_pointEdgeOffsets.clear();
+        m_pointEdges.clear();
     }
 
     /**
     Computes the point edge map for fast edge lookup by point.
+    The edges for all points are packed into one array, so this doesn't allocate anything once the arrays have grown big enough.
     */
     inline void computePointEdgeMap() {
-        m_pointEdgeMap.clear();
-        m_pointEdgeMap.rehash(m_points.size());
+        //count the edges for each point, shifted over by one so the running total below gives where each point's edges start
+        m_pointEdgeOffsets.assign(m_points.size() + 1, 0);
 
         for(size_t edgeIndex = 0; edgeIndex < m_edges.size(); edgeIndex++) {
-            m_pointEdgeMap.insert(std::pair<size_t, size_t>(m_edges[edgeIndex].m_point[0], edgeIndex));
-            m_pointEdgeMap.insert(std::pair<size_t, size_t>(m_edges[edgeIndex].m_point[1], edgeIndex));
+            m_pointEdgeOffsets[m_edges[edgeIndex].m_point[0] + 1]++;
+            m_pointEdgeOffsets[m_edges[edgeIndex].m_point[1] + 1]++;
         }
+
+        for(size_t point = 1; point < m_pointEdgeOffsets.size(); point++) {
+            m_pointEdgeOffsets[point] += m_pointEdgeOffsets[point - 1];
+        }
+
+        //fill in the edges, using the offsets as write positions, which leaves each one pointing at the start of the next point's edges
+        m_pointEdges.resize(m_edges.size() * 2);
+
+        for(size_t edgeIndex = 0; edgeIndex < m_edges.size(); edgeIndex++) {
+            m_pointEdges[m_pointEdgeOffsets[m_edges[edgeIndex].m_point[0]]++] = edgeIndex;
+            m_pointEdges[m_pointEdgeOffsets[m_edges[edgeIndex].m_point[1]]++] = edgeIndex;
+        }
+
+        //so shift them back
+        for(size_t point = m_points.size(); point > 0; point--) {
+            m_pointEdgeOffsets[point] = m_pointEdgeOffsets[point - 1];
+        }
+
+        m_pointEdgeOffsets[0] = 0;
+    }
+
+    /**
+    Gets the edges that touch a point.  computePointEdgeMap() needs to have been called since the edges last changed.
+    */
+    inline PointEdgeIterators getPointEdges(size_t point) const {
+        return PointEdgeIterators(m_pointEdges.begin() + m_pointEdgeOffsets[point], m_pointEdges.begin() + m_pointEdgeOffsets[point + 1]);
     }
 
     /**
@@ -84,9 +109,8 @@ struct MeshEdgeList {
     //TODO: for some readon Release build doesn't properly build new edges.
     void convexClip(const Plane<T>& clipPlane) {
         //find which side of the plane points are on
-        std::unordered_set<size_t> offsidePoints(m_points.size());
-
-        bool * isPointOffside = new bool[m_points.size()];                               //whether or not a point for an index is offside
+        std::vector<uint8_t>& isPointOffside = m_clipScratch.m_isPointOffside;        //whether or not a point for an index is offside
+        isPointOffside.resize(m_points.size());
 
         {
             size_t numOffsidePoints = 0;
@@ -102,51 +126,42 @@ struct MeshEdgeList {
             }
 
             if(numOffsidePoints == 0) {        //if all points are onside, no clipping needed
-                delete[] isPointOffside;
                 return;
             }
             else if(numOffsidePoints == m_points.size()) {                 //if all points are offside, the entire polygon is gone
                 clear();
-
-                delete[] isPointOffside;
                 return;
             }
         }
 
-        //backup the old edges and points so the original data can be written to
-        std::vector<glm::detail::tvec3<T> > points;
-        std::vector<Edge> edges;
+        //backup the old edges and points so the original data can be written to, the scratch arrays get swapped in so their memory is reused
+        std::vector<glm::detail::tvec3<T> >& points = m_clipScratch.m_points;
+        std::vector<Edge>& edges = m_clipScratch.m_edges;
         
         points.swap(m_points);
         edges.swap(m_edges);
 
-        /*points.assign(m_points.begin(), m_points.end());
-        edges.assign(m_edges.begin(), m_edges.end());
-
         m_points.clear();
-        m_edges.clear();*/
+        m_edges.clear();
 
         //now either clip lines that intersect the plane, or completely remove them
-        struct ClippedEdge {            
-            bool m_modifiedPointIndex;          //which point in the line is clipped off, 0 or 1
-            glm::detail::tvec3<T> m_coords;     //the new coordinates replacing the clipped off point
-        };
-                
-        bool * isEdgeModified = new bool[edges.size()];                                 //whether or not an edge for an index was modified
-        memset(isEdgeModified, 0, edges.size() * sizeof(bool));
+        std::vector<uint8_t>& isEdgeModified = m_clipScratch.m_isEdgeModified;        //whether or not an edge for an index was modified
+        isEdgeModified.assign(edges.size(), false);
 
-        size_t * oldPointRemap = new size_t[points.size()];                             //remapping of old point index to new point index
+        std::vector<size_t>& oldPointRemap = m_clipScratch.m_oldPointRemap;           //remapping of old point index to new point index
+        oldPointRemap.resize(points.size());
 
-        std::unordered_map<size_t, ClippedEdge> clippedEdges(edges.size());             //edges that were clipped
+        std::vector<ClippedEdge>& clippedEdges = m_clipScratch.m_clippedEdges;        //edges that were clipped, each edge gets clipped at most once
+        clippedEdges.clear();
         
         for(size_t point = 0; point < points.size(); point++) {
             //if point is offside
             if(isPointOffside[point]) {            
                 //get edges for offside point
-                PointEdgeMapIterators edgeIters = m_pointEdgeMap.equal_range(point);
+                PointEdgeIterators edgeIters = getPointEdges(point);
 
-                for(PointEdgeMapIterator edgeIter = edgeIters.first; edgeIter != edgeIters.second; edgeIter++) {
-                    size_t edgeIndex = edgeIter->second;
+                for(PointEdgeIterator edgeIter = edgeIters.first; edgeIter != edgeIters.second; edgeIter++) {
+                    size_t edgeIndex = *edgeIter;
                 
                     //if edge already modified, skip it
                     if(isEdgeModified[edgeIndex]) {
@@ -164,12 +179,13 @@ struct MeshEdgeList {
                     //if other point onside, clip the line, otherwise just discard it
                     if(!isPointOffside[otherPoint]) {
                         ClippedEdge clippedEdge;
+                        clippedEdge.m_edgeIndex = edgeIndex;
                         clippedEdge.m_modifiedPointIndex = modifiedPointIndex;
                     
                         bool intersection = clipPlane.lineIntersection(points[point], points[otherPoint], clippedEdge.m_coords);
                         assert(intersection);   //if there's no intersection, something went seriously wrong
 
-                        clippedEdges[edgeIndex] = clippedEdge;
+                        clippedEdges.push_back(clippedEdge);
                     }
                 }
             }
@@ -188,12 +204,11 @@ struct MeshEdgeList {
         }
 
         //go through clipped edges and add them, while also setting up the convex hull algorithm to create new joining edges
-        std::vector<size_t> newPoints;
-        newPoints.reserve(clippedEdges.size());
+        std::vector<size_t>& newPoints = m_clipScratch.m_newPoints;
+        newPoints.clear();
 
-        for(std::unordered_map<size_t, ClippedEdge>::const_iterator clippedEdgeIter = clippedEdges.begin(); clippedEdgeIter != clippedEdges.end(); clippedEdgeIter++) {
-            size_t clippedEdgeIndex = clippedEdgeIter->first;
-            const ClippedEdge& clippedEdge = clippedEdgeIter->second;
+        for(size_t clippedEdgeIndex = 0; clippedEdgeIndex < clippedEdges.size(); clippedEdgeIndex++) {
+            const ClippedEdge& clippedEdge = clippedEdges[clippedEdgeIndex];
             
             //add the new point
             size_t newPointIndex = m_points.size();
@@ -207,13 +222,9 @@ struct MeshEdgeList {
 
             //set the new edge's points
             newEdge.m_point[clippedEdge.m_modifiedPointIndex] = newPointIndex;
-            newEdge.m_point[!clippedEdge.m_modifiedPointIndex] = oldPointRemap[edges[clippedEdgeIndex].m_point[!clippedEdge.m_modifiedPointIndex]];
+            newEdge.m_point[!clippedEdge.m_modifiedPointIndex] = oldPointRemap[edges[clippedEdge.m_edgeIndex].m_point[!clippedEdge.m_modifiedPointIndex]];
         }
 
-        delete[] isEdgeModified;
-        delete[] oldPointRemap;
-        delete[] isPointOffside;
-
         //use the dimension order of the normal to determine how to best perform the convex hull algorithm
         glm::detail::tvec3<uint8_t> normalDimensionOrder = sortDimensions(clipPlane.m_normal);
 
@@ -249,8 +260,8 @@ struct MeshEdgeList {
         
         //now do monotone chain on the points to find the convex polygon forming the clipped portion        
         {
-            std::vector<size_t> newEdgeList;
-            newEdgeList.reserve(newPoints.size());
+            std::vector<size_t>& newEdgeList = m_clipScratch.m_newEdgeList;
+            newEdgeList.clear();
 
             //do one side
             convexHull(newPoints.begin(), newPoints.end(), normalDimensionOrder, newEdgeList);
@@ -281,7 +292,7 @@ private:
     }
 
     template <typename Iter>
-    void convexHull(Iter& iter, Iter& end, const glm::detail::tvec3<uint8_t> dimensionOrder, std::vector<size_t>& destination) const {                  
+    void convexHull(Iter iter, Iter end, const glm::detail::tvec3<uint8_t> dimensionOrder, std::vector<size_t>& destination) const {                  
         if(iter != end) {
             //init some things first
             size_t point = *iter;            
@@ -320,13 +331,47 @@ private:
         }
     }
 
+    struct ClippedEdge {
+        size_t m_edgeIndex;                 //which edge got clipped
+        bool m_modifiedPointIndex;          //which point in the line is clipped off, 0 or 1
+        glm::detail::tvec3<T> m_coords;     //the new coordinates replacing the clipped off point
+    };
+
+    /**
+    The temporary arrays convexClip works in, kept around so clipping every frame stops going to the heap once they've grown.
+    Copying a mesh edge list doesn't copy these, the copy just grows its own.
+    */
+    struct ClipScratch {
+        ClipScratch() {}
+        ClipScratch(const ClipScratch&) {}
+
+        inline ClipScratch& operator=(const ClipScratch&) {
+            return *this;
+        }
+
+        std::vector<glm::detail::tvec3<T> > m_points;
+        std::vector<Edge> m_edges;
+        std::vector<uint8_t> m_isPointOffside;
+        std::vector<uint8_t> m_isEdgeModified;
+        std::vector<size_t> m_oldPointRemap;
+        std::vector<ClippedEdge> m_clippedEdges;
+        std::vector<size_t> m_newPoints;
+        std::vector<size_t> m_newEdgeList;
+    };
+
+    ClipScratch m_clipScratch;
+
 public:
     //TODO: make accessor functions for this
     std::vector<glm::detail::tvec3<T> > m_points;
     std::vector<Edge> m_edges;
 
-    ///Fast point to edge lookup map.
-    PointEdgeMap m_pointEdgeMap;
+    /**
+    Fast point to edge lookup, use getPointEdges().
+    The edges touching point p are m_pointEdges[m_pointEdgeOffsets[p]] up to m_pointEdges[m_pointEdgeOffsets[p + 1]].
+    */
+    std::vector<size_t> m_pointEdgeOffsets;
+    std::vector<size_t> m_pointEdges;
 
     ///The bounding box
     Box<T> m_bounds;
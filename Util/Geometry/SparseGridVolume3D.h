@@ -0,0 +1,68 @@
+#ifndef ILL_SPARSE_GRID_VOLUME_3D_H_
+#define ILL_SPARSE_GRID_VOLUME_3D_H_
+
+#include "Util/Geometry/GridVolume3D.h"
+#include "Util/serial/SparseCellArray.h"
+
+/**
+A 3D uniform grid volume that also stores something in each cell, but only allocates the cells in bricks
+of the grid that actually have something in them.  See SparseCellArray.
+
+All of the cell math and the box, box omit, and convex mesh iterators come straight from GridVolume3D,
+so anything that traverses a GridVolume3D traverses this the same way and gets the same cell array indices.
+
+This lets the world extent be huge with fine cells while the memory only scales with the occupied part of the world.
+
+@param T What gets stored in each cell.
+@param W The precision of the world space
+*/
+template <typename T, typename W = glm::mediump_float>
+class SparseGridVolume3D : public GridVolume3D<W> {
+public:
+    SparseGridVolume3D() {}
+
+    /**
+    Creates the grid volume.  No cells are allocated yet.
+
+    @param cellDimensions The dimensions of each cell, usually they can just be a perfect cube
+    @param cellNumber The number of cells in each dimension, x, y, and z
+    */
+    SparseGridVolume3D(const glm::detail::tvec3<W>& cellDimensions, const glm::uvec3& cellNumber)
+        : GridVolume3D<W>(cellDimensions, cellNumber),
+        m_cells(cellNumber)
+    {}
+
+    /**
+    Returns the contents of a cell for reading.  Cells in bricks that were never written to return a default constructed value.
+    */
+    inline const T& getCell(unsigned int cellArrayIndex) const {
+        return m_cells.get(cellArrayIndex);
+    }
+
+    inline const T& getCell(const glm::uvec3& cell) const {
+        return m_cells.get(cell);
+    }
+
+    /**
+    Returns the contents of a cell for writing, allocating the cell's brick if needed.
+    */
+    inline T& getCellMutable(unsigned int cellArrayIndex) {
+        return m_cells.getMutable(cellArrayIndex);
+    }
+
+    inline T& getCellMutable(const glm::uvec3& cell) {
+        return m_cells.getMutable(cell);
+    }
+
+    /**
+    Returns the underlying storage, which has some stats on how much is allocated.
+    */
+    inline const SparseCellArray<T>& getCells() const {
+        return m_cells;
+    }
+
+private:
+    SparseCellArray<T> m_cells;
+};
+
+#endif
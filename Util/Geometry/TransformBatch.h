@@ -0,0 +1,140 @@
+#ifndef ILL_TRANSFORM_BATCH_H_
+#define ILL_TRANSFORM_BATCH_H_
+
+#include <cassert>
+#include <vector>
+
+#include "Util/Geometry/Transform.h"
+
+/**
+The transform batch arrays are padded to a multiple of this many transforms so the SIMD code can always load a full group.
+8 is enough for AVX.
+*/
+const size_t TRANSFORM_BATCH_GROUP_SIZE = 8;
+
+/**
+A list of Transforms stored as a structure of arrays, one array for each component of the position, rotation, and scale.
+This is the layout the SIMD code in transformBatchMath.h wants, since it can load the same component of 4 or 8 transforms at once.
+
+Unlike BoxBatch it's sized up front with resize() and filled in by index, since it's meant to be scratch space
+for posing skeletons and such where the number of transforms rarely changes.
+
+The padding past the last transform is kept as the identity transform so nothing in the SIMD code ends up dividing by zero.
+Nothing should care what the results for the padding are.
+*/
+class TransformBatch {
+public:
+    typedef Transform<> value_type;
+
+    inline TransformBatch()
+        : m_size(0)
+    {}
+
+    inline size_t size() const {
+        return m_size;
+    }
+
+    inline bool empty() const {
+        return m_size == 0;
+    }
+
+    /**
+    Resizes the batch, new transforms are the identity.
+    */
+    inline void resize(size_t size) {
+        size_t paddedSize = (size + TRANSFORM_BATCH_GROUP_SIZE - 1) / TRANSFORM_BATCH_GROUP_SIZE * TRANSFORM_BATCH_GROUP_SIZE;
+
+        //reset the transforms being cut off so they're identity padding
+        for(size_t index = size; index < m_size; index++) {
+            set(index, Transform<>());
+        }
+
+        m_size = size;
+
+        if(m_positionX.size() < paddedSize) {
+            m_positionX.resize(paddedSize, 0.0f);
+            m_positionY.resize(paddedSize, 0.0f);
+            m_positionZ.resize(paddedSize, 0.0f);
+            m_rotationX.resize(paddedSize, 0.0f);
+            m_rotationY.resize(paddedSize, 0.0f);
+            m_rotationZ.resize(paddedSize, 0.0f);
+            m_rotationW.resize(paddedSize, 1.0f);
+            m_scaleX.resize(paddedSize, 1.0f);
+            m_scaleY.resize(paddedSize, 1.0f);
+            m_scaleZ.resize(paddedSize, 1.0f);
+        }
+    }
+
+    /**
+    How many transforms there are including the padding, always a multiple of TRANSFORM_BATCH_GROUP_SIZE.
+    Batches of the same size always have the same padded size, even if one used to be bigger and has more room.
+    */
+    inline size_t paddedSize() const {
+        return (m_size + TRANSFORM_BATCH_GROUP_SIZE - 1) / TRANSFORM_BATCH_GROUP_SIZE * TRANSFORM_BATCH_GROUP_SIZE;
+    }
+
+    inline void set(size_t index, const Transform<>& transform) {
+        assert(index < paddedSize());
+
+        m_positionX[index] = transform.m_position.x;
+        m_positionY[index] = transform.m_position.y;
+        m_positionZ[index] = transform.m_position.z;
+        m_rotationX[index] = transform.m_rotation.x;
+        m_rotationY[index] = transform.m_rotation.y;
+        m_rotationZ[index] = transform.m_rotation.z;
+        m_rotationW[index] = transform.m_rotation.w;
+        m_scaleX[index] = transform.m_scale.x;
+        m_scaleY[index] = transform.m_scale.y;
+        m_scaleZ[index] = transform.m_scale.z;
+    }
+
+    inline Transform<> get(size_t index) const {
+        assert(index < m_size);
+
+        return Transform<>(glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]),
+            glm::quat(m_rotationW[index], m_rotationX[index], m_rotationY[index], m_rotationZ[index]),
+            glm::vec3(m_scaleX[index], m_scaleY[index], m_scaleZ[index]));
+    }
+
+    inline size_t getMemoryUsage() const {
+        return m_positionX.capacity() * sizeof(float) * 10;
+    }
+
+    inline const float * getPositionX() const { return m_positionX.data(); }
+    inline const float * getPositionY() const { return m_positionY.data(); }
+    inline const float * getPositionZ() const { return m_positionZ.data(); }
+    inline const float * getRotationX() const { return m_rotationX.data(); }
+    inline const float * getRotationY() const { return m_rotationY.data(); }
+    inline const float * getRotationZ() const { return m_rotationZ.data(); }
+    inline const float * getRotationW() const { return m_rotationW.data(); }
+    inline const float * getScaleX() const { return m_scaleX.data(); }
+    inline const float * getScaleY() const { return m_scaleY.data(); }
+    inline const float * getScaleZ() const { return m_scaleZ.data(); }
+
+    inline float * getPositionX() { return m_positionX.data(); }
+    inline float * getPositionY() { return m_positionY.data(); }
+    inline float * getPositionZ() { return m_positionZ.data(); }
+    inline float * getRotationX() { return m_rotationX.data(); }
+    inline float * getRotationY() { return m_rotationY.data(); }
+    inline float * getRotationZ() { return m_rotationZ.data(); }
+    inline float * getRotationW() { return m_rotationW.data(); }
+    inline float * getScaleX() { return m_scaleX.data(); }
+    inline float * getScaleY() { return m_scaleY.data(); }
+    inline float * getScaleZ() { return m_scaleZ.data(); }
+
+private:
+    size_t m_size;
+
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_positionZ;
+    std::vector<float> m_rotationX;
+    std::vector<float> m_rotationY;
+    std::vector<float> m_rotationZ;
+    std::vector<float> m_rotationW;
+    std::vector<float> m_scaleX;
+    std::vector<float> m_scaleY;
+    std::vector<float> m_scaleZ;
+};
+
+#endif
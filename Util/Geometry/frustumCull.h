@@ -0,0 +1,201 @@
+#ifndef ILL_FRUSTUM_CULL_H_
+#define ILL_FRUSTUM_CULL_H_
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Util/simd.h"
+#include "Util/Geometry/Box.h"
+#include "Util/Geometry/BoxBatch.h"
+#include "Util/Geometry/Frustum.h"
+
+const unsigned int FRUSTUM_NUM_PLANES = 6;
+
+/**
+The 6 planes of a Frustum laid out as a structure of arrays for frustumCullBoxBatch.
+*/
+struct FrustumCullPlanes {
+    inline FrustumCullPlanes() {}
+
+    inline FrustumCullPlanes(const Frustum<>& frustum) {
+        set(frustum);
+    }
+
+    inline void set(const Frustum<>& frustum) {
+        const Plane<> * planes[FRUSTUM_NUM_PLANES] = {
+            &frustum.m_left, &frustum.m_right, &frustum.m_top, &frustum.m_bottom, &frustum.m_near, &frustum.m_far
+        };
+
+        for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+            m_normalX[plane] = planes[plane]->m_normal.x;
+            m_normalY[plane] = planes[plane]->m_normal.y;
+            m_normalZ[plane] = planes[plane]->m_normal.z;
+            m_distance[plane] = planes[plane]->m_distance;
+        }
+    }
+
+    float m_normalX[FRUSTUM_NUM_PLANES];
+    float m_normalY[FRUSTUM_NUM_PLANES];
+    float m_normalZ[FRUSTUM_NUM_PLANES];
+    float m_distance[FRUSTUM_NUM_PLANES];
+};
+
+/**
+Tests a single box against the planes of a frustum the plain way.
+The box is outside if its corner furthest along a plane's normal is still behind that plane.
+
+This is conservative, some boxes near the corners of the frustum are said to be visible when they're not,
+but anything really visible is never culled.  frustumCullBoxBatch gives the same results for many boxes at once,
+other than rounding differences for boxes just touching a plane.
+*/
+inline bool frustumBoxVisible(const Frustum<>& frustum, const Box<>& box) {
+    const Plane<> * planes[FRUSTUM_NUM_PLANES] = {
+        &frustum.m_left, &frustum.m_right, &frustum.m_top, &frustum.m_bottom, &frustum.m_near, &frustum.m_far
+    };
+
+    for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+        const glm::vec3& normal = planes[plane]->m_normal;
+
+        glm::vec3 farCorner(normal.x >= 0.0f ? box.m_max.x : box.m_min.x,
+            normal.y >= 0.0f ? box.m_max.y : box.m_min.y,
+            normal.z >= 0.0f ? box.m_max.z : box.m_min.z);
+
+        if(planes[plane]->distance(farCorner) < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline unsigned int boxBatchCountBits(uint32_t bits) {
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+/**
+Tests every box in a batch against the planes of a frustum, 8 at a time with AVX, 4 at a time with SSE2,
+or one at a time otherwise.  See Util/simd.h.
+
+Since the planes are the same for the whole batch, which of the min or max arrays holds the corner furthest along
+each plane's normal is worked out once up front, so the inner loop is just multiplies, adds, and compares.
+
+@param planes The frustum planes.
+@param boxes The boxes.
+@param visibleMask Where to write the results, bit i of word i / 32 is set if box i is at least partially in the frustum.
+    Must have room for (boxes.size() + 31) / 32 words.
+
+@return How many boxes are visible.
+*/
+inline size_t frustumCullBoxBatch(const FrustumCullPlanes& planes, const BoxBatch& boxes, uint32_t * visibleMask) {
+    size_t numBoxes = boxes.size();
+    size_t numWords = (numBoxes + 31) / 32;
+
+    for(size_t word = 0; word < numWords; word++) {
+        visibleMask[word] = 0;
+    }
+
+    const float * farX[FRUSTUM_NUM_PLANES];
+    const float * farY[FRUSTUM_NUM_PLANES];
+    const float * farZ[FRUSTUM_NUM_PLANES];
+
+    for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+        farX[plane] = planes.m_normalX[plane] >= 0.0f ? boxes.getMaxX() : boxes.getMinX();
+        farY[plane] = planes.m_normalY[plane] >= 0.0f ? boxes.getMaxY() : boxes.getMinY();
+        farZ[plane] = planes.m_normalZ[plane] >= 0.0f ? boxes.getMaxZ() : boxes.getMinZ();
+    }
+
+#if defined(ILL_AVX)
+    __m256 normalX[FRUSTUM_NUM_PLANES];
+    __m256 normalY[FRUSTUM_NUM_PLANES];
+    __m256 normalZ[FRUSTUM_NUM_PLANES];
+    __m256 distance[FRUSTUM_NUM_PLANES];
+
+    for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+        normalX[plane] = _mm256_set1_ps(planes.m_normalX[plane]);
+        normalY[plane] = _mm256_set1_ps(planes.m_normalY[plane]);
+        normalZ[plane] = _mm256_set1_ps(planes.m_normalZ[plane]);
+        distance[plane] = _mm256_set1_ps(planes.m_distance[plane]);
+    }
+
+    __m256 zero = _mm256_setzero_ps();
+
+    for(size_t box = 0; box < numBoxes; box += 8) {
+        __m256 outside = zero;
+
+        for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+            __m256 dist = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(normalX[plane], _mm256_loadu_ps(farX[plane] + box)),
+                    _mm256_mul_ps(normalY[plane], _mm256_loadu_ps(farY[plane] + box))),
+                _mm256_add_ps(_mm256_mul_ps(normalZ[plane], _mm256_loadu_ps(farZ[plane] + box)),
+                    distance[plane]));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, zero, _CMP_LT_OQ));
+        }
+
+        visibleMask[box >> 5] |= (uint32_t) (~_mm256_movemask_ps(outside) & 0xFF) << (box & 31);
+    }
+#elif defined(ILL_SSE2)
+    __m128 normalX[FRUSTUM_NUM_PLANES];
+    __m128 normalY[FRUSTUM_NUM_PLANES];
+    __m128 normalZ[FRUSTUM_NUM_PLANES];
+    __m128 distance[FRUSTUM_NUM_PLANES];
+
+    for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+        normalX[plane] = _mm_set1_ps(planes.m_normalX[plane]);
+        normalY[plane] = _mm_set1_ps(planes.m_normalY[plane]);
+        normalZ[plane] = _mm_set1_ps(planes.m_normalZ[plane]);
+        distance[plane] = _mm_set1_ps(planes.m_distance[plane]);
+    }
+
+    __m128 zero = _mm_setzero_ps();
+
+    for(size_t box = 0; box < numBoxes; box += 4) {
+        __m128 outside = zero;
+
+        for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES; plane++) {
+            __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(normalX[plane], _mm_loadu_ps(farX[plane] + box)),
+                    _mm_mul_ps(normalY[plane], _mm_loadu_ps(farY[plane] + box))),
+                _mm_add_ps(_mm_mul_ps(normalZ[plane], _mm_loadu_ps(farZ[plane] + box)),
+                    distance[plane]));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, zero));
+        }
+
+        visibleMask[box >> 5] |= (uint32_t) (~_mm_movemask_ps(outside) & 0xF) << (box & 31);
+    }
+#else
+    for(size_t box = 0; box < numBoxes; box++) {
+        bool outside = false;
+
+        for(unsigned int plane = 0; plane < FRUSTUM_NUM_PLANES && !outside; plane++) {
+            //same order of operations as the SIMD versions so the results match exactly
+            float dist = (planes.m_normalX[plane] * farX[plane][box] + planes.m_normalY[plane] * farY[plane][box])
+                + (planes.m_normalZ[plane] * farZ[plane][box] + planes.m_distance[plane]);
+
+            outside = dist < 0.0f;
+        }
+
+        if(!outside) {
+            visibleMask[box >> 5] |= (uint32_t) 1 << (box & 31);
+        }
+    }
+#endif
+
+    //the SIMD versions also wrote results for the padding
+    if(numBoxes & 31) {
+        visibleMask[numWords - 1] &= ((uint32_t) 1 << (numBoxes & 31)) - 1;
+    }
+
+    size_t numVisible = 0;
+
+    for(size_t word = 0; word < numWords; word++) {
+        numVisible += boxBatchCountBits(visibleMask[word]);
+    }
+
+    return numVisible;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef ILL_QUANTIZATION_H__
+#define ILL_QUANTIZATION_H__
+
+#include <stdint.h>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/**
+Quantizes a value inside some range to 16 bits.  Values outside the range are clamped to it.
+
+@param rangeMin The lowest value in the range.
+@param rangeExtent How far the range goes past rangeMin.  With a 0 extent everything quantizes to 0.
+*/
+inline uint16_t quantizeRange16(float value, float rangeMin, float rangeExtent) {
+    if(rangeExtent <= 0.0f) {
+        return 0;
+    }
+
+    float normalized = (value - rangeMin) / rangeExtent;
+
+    if(normalized <= 0.0f) {
+        return 0;
+    }
+
+    if(normalized >= 1.0f) {
+        return 0xFFFF;
+    }
+
+    return (uint16_t) (normalized * 65535.0f + 0.5f);
+}
+
+/**
+Undoes quantizeRange16.
+
+@param rangeScale The range extent divided by 65535, precomputed since this is called a lot more than quantizing.
+*/
+inline float dequantizeRange16(uint16_t value, float rangeMin, float rangeScale) {
+    return rangeMin + (float) value * rangeScale;
+}
+
+/**
+The smallest three quaternion components are stored as 15 bits each between -1/sqrt(2) and 1/sqrt(2).
+*/
+const float QUAT_SMALLEST_THREE_RANGE = 0.70710678f;
+const float QUAT_SMALLEST_THREE_MAX = 32767.0f;
+
+/**
+Packs a unit quaternion into 48 bits using the smallest three method.
+The largest component is dropped since it can be rebuilt from the other three, and the quaternion is negated if needed so
+the dropped component is positive, which is the same rotation.  The other three can't be bigger than 1/sqrt(2) so they get 15 bits each
+over just that range.  That leaves 2 bits to say which one was dropped and 1 bit unused.
+
+The error on each component is at most about 0.00002, which comes out to at most about 0.00011 radians or under a hundredth of a degree.
+
+@param rotation The quaternion to pack.  It's normalized first.
+@param destination 3 16 bit values to write into.
+*/
+template <typename T>
+inline void packQuatSmallestThree(const glm::detail::tquat<T>& rotation, uint16_t * destination) {
+    glm::detail::tquat<T> normalized = glm::normalize(rotation);
+
+    unsigned int largest = 0;
+
+    for(unsigned int component = 1; component < 4; component++) {
+        if(std::abs(normalized[component]) > std::abs(normalized[largest])) {
+            largest = component;
+        }
+    }
+
+    T sign = normalized[largest] < (T) 0 ? (T) -1 : (T) 1;
+    uint64_t packed = largest;
+
+    for(unsigned int component = 0; component < 4; component++) {
+        if(component == largest) {
+            continue;
+        }
+
+        float value = (float) (normalized[component] * sign) / QUAT_SMALLEST_THREE_RANGE;
+        value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+
+        packed = (packed << 15) | (uint64_t) ((value * 0.5f + 0.5f) * QUAT_SMALLEST_THREE_MAX + 0.5f);
+    }
+
+    destination[0] = (uint16_t) packed;
+    destination[1] = (uint16_t) (packed >> 16);
+    destination[2] = (uint16_t) (packed >> 32);
+}
+
+/**
+Undoes packQuatSmallestThree.
+*/
+inline glm::quat unpackQuatSmallestThree(const uint16_t * source) {
+    uint64_t packed = (uint64_t) source[0] | ((uint64_t) source[1] << 16) | ((uint64_t) source[2] << 32);
+
+    unsigned int largest = (unsigned int) (packed >> 45) & 3;
+
+    glm::quat res;
+    float sumSquares = 0.0f;
+
+    //the components come out in reverse order of how they went in
+    for(int component = 3; component >= 0; component--) {
+        if((unsigned int) component == largest) {
+            continue;
+        }
+
+        float value = ((float) (packed & 0x7FFF) / QUAT_SMALLEST_THREE_MAX * 2.0f - 1.0f) * QUAT_SMALLEST_THREE_RANGE;
+        packed >>= 15;
+
+        res[component] = value;
+        sumSquares += value * value;
+    }
+
+    res[largest] = std::sqrt(sumSquares < 1.0f ? 1.0f - sumSquares : 0.0f);
+
+    return res;
+}
+
+#endif
@@ -0,0 +1,694 @@
+#ifndef ILL_TRANSFORM_BATCH_MATH_H_
+#define ILL_TRANSFORM_BATCH_MATH_H_
+
+#include <cassert>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "Util/simd.h"
+#include "Util/Geometry/TransformBatch.h"
+
+/**
+Adjusts the blend amount for normalized lerping between quaternions so it comes out almost the same as slerping,
+without needing any trig functions.  The curve fit is from Arseny Kapoulkine's "Approximating slerp".
+The results are within about 0.0004 of glm::shortMix for any pair of unit quaternions, and much closer when they're near each other like most animation blends.
+
+@param cosAngle The absolute value of the dot product of the quaternions.
+@param delta The blend amount, which is the same for the whole batch.
+@param deltaTerm delta * (delta - 0.5) * (delta - 1), which only depends on the delta so it's worked out once per batch.
+@param deltaSquared (delta - 0.5) squared, same deal.
+*/
+inline float transformBatchSlerpDelta(float cosAngle, float delta, float deltaTerm, float deltaSquared) {
+    float a = 1.0904f + cosAngle * (-3.2452f + cosAngle * (3.55645f - cosAngle * 1.43519f));
+    float b = 0.848013f + cosAngle * (-1.06021f + cosAngle * 0.215638f);
+
+    return delta + deltaTerm * (a * deltaSquared + b);
+}
+
+#if defined(ILL_AVX)
+/**
+Blends 8 transforms starting at index for blendTransformBatch and blendTransformBatchMasked,
+with the blend amount and the terms for transformBatchSlerpDelta for each of them.
+*/
+inline void blendTransformBatchGroup(const TransformBatch& from, const TransformBatch& to, size_t index,
+        __m256 deltaV, __m256 deltaTermV, __m256 deltaSquaredV, TransformBatch& dest) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    #define ILL_TRANSFORM_BATCH_LERP(getter) \
+        _mm256_storeu_ps(dest.getter() + index, _mm256_add_ps(_mm256_loadu_ps(from.getter() + index), \
+            _mm256_mul_ps(deltaV, _mm256_sub_ps(_mm256_loadu_ps(to.getter() + index), _mm256_loadu_ps(from.getter() + index)))))
+
+    ILL_TRANSFORM_BATCH_LERP(getPositionX);
+    ILL_TRANSFORM_BATCH_LERP(getPositionY);
+    ILL_TRANSFORM_BATCH_LERP(getPositionZ);
+    ILL_TRANSFORM_BATCH_LERP(getScaleX);
+    ILL_TRANSFORM_BATCH_LERP(getScaleY);
+    ILL_TRANSFORM_BATCH_LERP(getScaleZ);
+
+    #undef ILL_TRANSFORM_BATCH_LERP
+
+    __m256 fromX = _mm256_loadu_ps(from.getRotationX() + index);
+    __m256 fromY = _mm256_loadu_ps(from.getRotationY() + index);
+    __m256 fromZ = _mm256_loadu_ps(from.getRotationZ() + index);
+    __m256 fromW = _mm256_loadu_ps(from.getRotationW() + index);
+    __m256 toX = _mm256_loadu_ps(to.getRotationX() + index);
+    __m256 toY = _mm256_loadu_ps(to.getRotationY() + index);
+    __m256 toZ = _mm256_loadu_ps(to.getRotationZ() + index);
+    __m256 toW = _mm256_loadu_ps(to.getRotationW() + index);
+
+    __m256 cosAngle = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fromX, toX), _mm256_mul_ps(fromY, toY)),
+        _mm256_mul_ps(fromZ, toZ)), _mm256_mul_ps(fromW, toW));
+
+    //flip the destination rotation to go the short way, the sign bit of the cosine does it with an xor
+    __m256 flip = _mm256_and_ps(cosAngle, signMask);
+    toX = _mm256_xor_ps(toX, flip);
+    toY = _mm256_xor_ps(toY, flip);
+    toZ = _mm256_xor_ps(toZ, flip);
+    toW = _mm256_xor_ps(toW, flip);
+    cosAngle = _mm256_andnot_ps(signMask, cosAngle);
+
+    __m256 a = _mm256_add_ps(_mm256_set1_ps(1.0904f), _mm256_mul_ps(cosAngle, _mm256_add_ps(_mm256_set1_ps(-3.2452f),
+        _mm256_mul_ps(cosAngle, _mm256_sub_ps(_mm256_set1_ps(3.55645f), _mm256_mul_ps(cosAngle, _mm256_set1_ps(1.43519f)))))));
+    __m256 b = _mm256_add_ps(_mm256_set1_ps(0.848013f), _mm256_mul_ps(cosAngle, _mm256_add_ps(_mm256_set1_ps(-1.06021f),
+        _mm256_mul_ps(cosAngle, _mm256_set1_ps(0.215638f)))));
+    __m256 toWeight = _mm256_add_ps(deltaV, _mm256_mul_ps(deltaTermV, _mm256_add_ps(_mm256_mul_ps(a, deltaSquaredV), b)));
+    __m256 fromWeight = _mm256_sub_ps(one, toWeight);
+
+    __m256 x = _mm256_add_ps(_mm256_mul_ps(fromX, fromWeight), _mm256_mul_ps(toX, toWeight));
+    __m256 y = _mm256_add_ps(_mm256_mul_ps(fromY, fromWeight), _mm256_mul_ps(toY, toWeight));
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(fromZ, fromWeight), _mm256_mul_ps(toZ, toWeight));
+    __m256 w = _mm256_add_ps(_mm256_mul_ps(fromW, fromWeight), _mm256_mul_ps(toW, toWeight));
+
+    __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+        _mm256_mul_ps(z, z)), _mm256_mul_ps(w, w)));
+
+    _mm256_storeu_ps(dest.getRotationX() + index, _mm256_div_ps(x, length));
+    _mm256_storeu_ps(dest.getRotationY() + index, _mm256_div_ps(y, length));
+    _mm256_storeu_ps(dest.getRotationZ() + index, _mm256_div_ps(z, length));
+    _mm256_storeu_ps(dest.getRotationW() + index, _mm256_div_ps(w, length));
+}
+#elif defined(ILL_SSE2)
+/**
+Blends 4 transforms starting at index for blendTransformBatch and blendTransformBatchMasked,
+with the blend amount and the terms for transformBatchSlerpDelta for each of them.
+*/
+inline void blendTransformBatchGroup(const TransformBatch& from, const TransformBatch& to, size_t index,
+        __m128 deltaV, __m128 deltaTermV, __m128 deltaSquaredV, TransformBatch& dest) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    #define ILL_TRANSFORM_BATCH_LERP(getter) \
+        _mm_storeu_ps(dest.getter() + index, _mm_add_ps(_mm_loadu_ps(from.getter() + index), \
+            _mm_mul_ps(deltaV, _mm_sub_ps(_mm_loadu_ps(to.getter() + index), _mm_loadu_ps(from.getter() + index)))))
+
+    ILL_TRANSFORM_BATCH_LERP(getPositionX);
+    ILL_TRANSFORM_BATCH_LERP(getPositionY);
+    ILL_TRANSFORM_BATCH_LERP(getPositionZ);
+    ILL_TRANSFORM_BATCH_LERP(getScaleX);
+    ILL_TRANSFORM_BATCH_LERP(getScaleY);
+    ILL_TRANSFORM_BATCH_LERP(getScaleZ);
+
+    #undef ILL_TRANSFORM_BATCH_LERP
+
+    __m128 fromX = _mm_loadu_ps(from.getRotationX() + index);
+    __m128 fromY = _mm_loadu_ps(from.getRotationY() + index);
+    __m128 fromZ = _mm_loadu_ps(from.getRotationZ() + index);
+    __m128 fromW = _mm_loadu_ps(from.getRotationW() + index);
+    __m128 toX = _mm_loadu_ps(to.getRotationX() + index);
+    __m128 toY = _mm_loadu_ps(to.getRotationY() + index);
+    __m128 toZ = _mm_loadu_ps(to.getRotationZ() + index);
+    __m128 toW = _mm_loadu_ps(to.getRotationW() + index);
+
+    __m128 cosAngle = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(fromX, toX), _mm_mul_ps(fromY, toY)),
+        _mm_mul_ps(fromZ, toZ)), _mm_mul_ps(fromW, toW));
+
+    //flip the destination rotation to go the short way, the sign bit of the cosine does it with an xor
+    __m128 flip = _mm_and_ps(cosAngle, signMask);
+    toX = _mm_xor_ps(toX, flip);
+    toY = _mm_xor_ps(toY, flip);
+    toZ = _mm_xor_ps(toZ, flip);
+    toW = _mm_xor_ps(toW, flip);
+    cosAngle = _mm_andnot_ps(signMask, cosAngle);
+
+    __m128 a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(cosAngle, _mm_add_ps(_mm_set1_ps(-3.2452f),
+        _mm_mul_ps(cosAngle, _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(cosAngle, _mm_set1_ps(1.43519f)))))));
+    __m128 b = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(cosAngle, _mm_add_ps(_mm_set1_ps(-1.06021f),
+        _mm_mul_ps(cosAngle, _mm_set1_ps(0.215638f)))));
+    __m128 toWeight = _mm_add_ps(deltaV, _mm_mul_ps(deltaTermV, _mm_add_ps(_mm_mul_ps(a, deltaSquaredV), b)));
+    __m128 fromWeight = _mm_sub_ps(one, toWeight);
+
+    __m128 x = _mm_add_ps(_mm_mul_ps(fromX, fromWeight), _mm_mul_ps(toX, toWeight));
+    __m128 y = _mm_add_ps(_mm_mul_ps(fromY, fromWeight), _mm_mul_ps(toY, toWeight));
+    __m128 z = _mm_add_ps(_mm_mul_ps(fromZ, fromWeight), _mm_mul_ps(toZ, toWeight));
+    __m128 w = _mm_add_ps(_mm_mul_ps(fromW, fromWeight), _mm_mul_ps(toW, toWeight));
+
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+        _mm_mul_ps(z, z)), _mm_mul_ps(w, w)));
+
+    _mm_storeu_ps(dest.getRotationX() + index, _mm_div_ps(x, length));
+    _mm_storeu_ps(dest.getRotationY() + index, _mm_div_ps(y, length));
+    _mm_storeu_ps(dest.getRotationZ() + index, _mm_div_ps(z, length));
+    _mm_storeu_ps(dest.getRotationW() + index, _mm_div_ps(w, length));
+}
+#else
+/**
+Blends the transform at index for blendTransformBatch and blendTransformBatchMasked,
+with the blend amount and the terms for transformBatchSlerpDelta.
+*/
+inline void blendTransformBatchGroup(const TransformBatch& from, const TransformBatch& to, size_t index,
+        float delta, float deltaTerm, float deltaSquared, TransformBatch& dest) {
+    #define ILL_TRANSFORM_BATCH_LERP(getter) \
+        dest.getter()[index] = from.getter()[index] + delta * (to.getter()[index] - from.getter()[index])
+
+    ILL_TRANSFORM_BATCH_LERP(getPositionX);
+    ILL_TRANSFORM_BATCH_LERP(getPositionY);
+    ILL_TRANSFORM_BATCH_LERP(getPositionZ);
+    ILL_TRANSFORM_BATCH_LERP(getScaleX);
+    ILL_TRANSFORM_BATCH_LERP(getScaleY);
+    ILL_TRANSFORM_BATCH_LERP(getScaleZ);
+
+    #undef ILL_TRANSFORM_BATCH_LERP
+
+    float fromX = from.getRotationX()[index];
+    float fromY = from.getRotationY()[index];
+    float fromZ = from.getRotationZ()[index];
+    float fromW = from.getRotationW()[index];
+    float toX = to.getRotationX()[index];
+    float toY = to.getRotationY()[index];
+    float toZ = to.getRotationZ()[index];
+    float toW = to.getRotationW()[index];
+
+    //same order of operations as the SIMD versions so the results match exactly
+    float cosAngle = ((fromX * toX + fromY * toY) + fromZ * toZ) + fromW * toW;
+
+    if(cosAngle < 0.0f) {
+        toX = -toX;
+        toY = -toY;
+        toZ = -toZ;
+        toW = -toW;
+        cosAngle = -cosAngle;
+    }
+
+    float toWeight = transformBatchSlerpDelta(cosAngle, delta, deltaTerm, deltaSquared);
+    float fromWeight = 1.0f - toWeight;
+
+    float x = fromX * fromWeight + toX * toWeight;
+    float y = fromY * fromWeight + toY * toWeight;
+    float z = fromZ * fromWeight + toZ * toWeight;
+    float w = fromW * fromWeight + toW * toWeight;
+
+    float length = std::sqrt(((x * x + y * y) + z * z) + w * w);
+
+    dest.getRotationX()[index] = x / length;
+    dest.getRotationY()[index] = y / length;
+    dest.getRotationZ()[index] = z / length;
+    dest.getRotationW()[index] = w / length;
+}
+#endif
+
+/**
+Blends between two batches of transforms, the same thing as Transform::interpolate on each one but 8 at a time with AVX,
+4 at a time with SSE2, or one at a time otherwise.  See Util/simd.h.
+
+Positions and scales are lerped.  Rotations go the short way around like glm::shortMix, but are normalized lerps
+with the blend amount adjusted by transformBatchSlerpDelta so they come out almost the same as slerping.
+
+@param from The transforms at delta 0.
+@param to The transforms at delta 1, must be the same size as from.
+@param delta How far to blend.
+@param dest Where to write the results, gets resized to match.  Can be the same batch as from or to.
+*/
+inline void blendTransformBatch(const TransformBatch& from, const TransformBatch& to, float delta, TransformBatch& dest) {
+    assert(from.size() == to.size());
+
+    dest.resize(from.size());
+
+    float deltaTerm = delta * (delta - 0.5f) * (delta - 1.0f);
+    float deltaSquared = (delta - 0.5f) * (delta - 0.5f);
+
+    //the padding is identity transforms so the SIMD versions can go right through it
+    size_t paddedSize = from.paddedSize();
+
+#if defined(ILL_AVX)
+    const __m256 deltaV = _mm256_set1_ps(delta);
+    const __m256 deltaTermV = _mm256_set1_ps(deltaTerm);
+    const __m256 deltaSquaredV = _mm256_set1_ps(deltaSquared);
+
+    for(size_t index = 0; index < paddedSize; index += 8) {
+        blendTransformBatchGroup(from, to, index, deltaV, deltaTermV, deltaSquaredV, dest);
+    }
+#elif defined(ILL_SSE2)
+    const __m128 deltaV = _mm_set1_ps(delta);
+    const __m128 deltaTermV = _mm_set1_ps(deltaTerm);
+    const __m128 deltaSquaredV = _mm_set1_ps(deltaSquared);
+
+    for(size_t index = 0; index < paddedSize; index += 4) {
+        blendTransformBatchGroup(from, to, index, deltaV, deltaTermV, deltaSquaredV, dest);
+    }
+#else
+    for(size_t index = 0; index < paddedSize; index++) {
+        blendTransformBatchGroup(from, to, index, delta, deltaTerm, deltaSquared, dest);
+    }
+#endif
+}
+
+/**
+Blends between two batches of transforms like blendTransformBatch, but by a different amount for each transform,
+like for blending in an animation on only some of the bones.
+
+@param from The transforms at delta 0.
+@param to The transforms at delta 1, must be the same size as from.
+@param delta How far to blend overall.
+@param mask How much of delta to blend each transform by, usually 0 to 1.
+    Must have room for from.paddedSize() values, the ones for the padding can be anything.
+@param dest Where to write the results, gets resized to match.  Can be the same batch as from or to.
+*/
+inline void blendTransformBatchMasked(const TransformBatch& from, const TransformBatch& to, float delta, const float * mask, TransformBatch& dest) {
+    assert(from.size() == to.size());
+
+    dest.resize(from.size());
+
+    size_t paddedSize = from.paddedSize();
+
+#if defined(ILL_AVX)
+    const __m256 overallDelta = _mm256_set1_ps(delta);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for(size_t index = 0; index < paddedSize; index += 8) {
+        __m256 deltaV = _mm256_mul_ps(overallDelta, _mm256_loadu_ps(mask + index));
+        __m256 deltaHalf = _mm256_sub_ps(deltaV, half);
+
+        blendTransformBatchGroup(from, to, index, deltaV,
+            _mm256_mul_ps(_mm256_mul_ps(deltaV, deltaHalf), _mm256_sub_ps(deltaV, one)), _mm256_mul_ps(deltaHalf, deltaHalf), dest);
+    }
+#elif defined(ILL_SSE2)
+    const __m128 overallDelta = _mm_set1_ps(delta);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for(size_t index = 0; index < paddedSize; index += 4) {
+        __m128 deltaV = _mm_mul_ps(overallDelta, _mm_loadu_ps(mask + index));
+        __m128 deltaHalf = _mm_sub_ps(deltaV, half);
+
+        blendTransformBatchGroup(from, to, index, deltaV,
+            _mm_mul_ps(_mm_mul_ps(deltaV, deltaHalf), _mm_sub_ps(deltaV, one)), _mm_mul_ps(deltaHalf, deltaHalf), dest);
+    }
+#else
+    for(size_t index = 0; index < paddedSize; index++) {
+        float transformDelta = delta * mask[index];
+
+        blendTransformBatchGroup(from, to, index, transformDelta,
+            transformDelta * (transformDelta - 0.5f) * (transformDelta - 1.0f), (transformDelta - 0.5f) * (transformDelta - 0.5f), dest);
+    }
+#endif
+}
+
+/**
+Adds the difference between two batches of transforms on top of another, for additive animation layers.
+The additive transforms are relative to the reference transforms, like an animation of nodding relative to the bind pose,
+so the base ends up nodding the same amount on top of whatever it was doing.
+
+Positions are offset by the difference, scales multiplied by the ratio, and rotations multiplied by the rotation from the reference
+to the additive one, all scaled by the weight.  Scaling the rotation is a normalized lerp from the identity without the
+transformBatchSlerpDelta adjustment, since additive rotations are usually small.
+
+@param base The transforms to add on top of.
+@param additive The transforms with the difference in them, must be the same size as base.
+@param reference What the additive transforms are relative to, must be the same size as base.
+@param weight How much of the difference to add.
+@param mask How much of the weight to add for each transform, or NULL for all of it.
+    Must have room for base.paddedSize() values, the ones for the padding can be anything.
+@param dest Where to write the results, gets resized to match.  Can be the same batch as base.
+*/
+inline void addTransformBatch(const TransformBatch& base, const TransformBatch& additive, const TransformBatch& reference,
+        float weight, const float * mask, TransformBatch& dest) {
+    assert(base.size() == additive.size() && base.size() == reference.size());
+
+    dest.resize(base.size());
+
+    size_t paddedSize = base.paddedSize();
+
+#if defined(ILL_AVX)
+    const __m256 overallWeight = _mm256_set1_ps(weight);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    #define ILL_TRANSFORM_BATCH_ADD(getter) \
+        _mm256_storeu_ps(dest.getter() + index, _mm256_add_ps(_mm256_loadu_ps(base.getter() + index), \
+            _mm256_mul_ps(weightV, _mm256_sub_ps(_mm256_loadu_ps(additive.getter() + index), _mm256_loadu_ps(reference.getter() + index)))))
+
+    #define ILL_TRANSFORM_BATCH_SCALE(getter) \
+        _mm256_storeu_ps(dest.getter() + index, _mm256_mul_ps(_mm256_loadu_ps(base.getter() + index), _mm256_add_ps(one, \
+            _mm256_mul_ps(weightV, _mm256_sub_ps(_mm256_div_ps(_mm256_loadu_ps(additive.getter() + index), _mm256_loadu_ps(reference.getter() + index)), one)))))
+
+    for(size_t index = 0; index < paddedSize; index += 8) {
+        __m256 weightV = mask ? _mm256_mul_ps(overallWeight, _mm256_loadu_ps(mask + index)) : overallWeight;
+
+        //the rotations are read before anything is written in case dest is the same batch as base
+        __m256 baseX = _mm256_loadu_ps(base.getRotationX() + index);
+        __m256 baseY = _mm256_loadu_ps(base.getRotationY() + index);
+        __m256 baseZ = _mm256_loadu_ps(base.getRotationZ() + index);
+        __m256 baseW = _mm256_loadu_ps(base.getRotationW() + index);
+        __m256 addX = _mm256_loadu_ps(additive.getRotationX() + index);
+        __m256 addY = _mm256_loadu_ps(additive.getRotationY() + index);
+        __m256 addZ = _mm256_loadu_ps(additive.getRotationZ() + index);
+        __m256 addW = _mm256_loadu_ps(additive.getRotationW() + index);
+        __m256 refX = _mm256_loadu_ps(reference.getRotationX() + index);
+        __m256 refY = _mm256_loadu_ps(reference.getRotationY() + index);
+        __m256 refZ = _mm256_loadu_ps(reference.getRotationZ() + index);
+        __m256 refW = _mm256_loadu_ps(reference.getRotationW() + index);
+
+        ILL_TRANSFORM_BATCH_ADD(getPositionX);
+        ILL_TRANSFORM_BATCH_ADD(getPositionY);
+        ILL_TRANSFORM_BATCH_ADD(getPositionZ);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleX);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleY);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleZ);
+
+        //the difference, the conjugate of the reference times the additive rotation
+        __m256 diffX = _mm256_add_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(refW, addX), _mm256_mul_ps(refX, addW)), _mm256_mul_ps(refY, addZ)), _mm256_mul_ps(refZ, addY));
+        __m256 diffY = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(refW, addY), _mm256_mul_ps(refX, addZ)), _mm256_mul_ps(refY, addW)), _mm256_mul_ps(refZ, addX));
+        __m256 diffZ = _mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(refW, addZ), _mm256_mul_ps(refX, addY)), _mm256_mul_ps(refY, addX)), _mm256_mul_ps(refZ, addW));
+        __m256 diffW = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(refW, addW), _mm256_mul_ps(refX, addX)), _mm256_mul_ps(refY, addY)), _mm256_mul_ps(refZ, addZ));
+
+        //the short way around, then scaled by the weight with a normalized lerp from the identity
+        __m256 flip = _mm256_and_ps(diffW, signMask);
+        diffX = _mm256_mul_ps(weightV, _mm256_xor_ps(diffX, flip));
+        diffY = _mm256_mul_ps(weightV, _mm256_xor_ps(diffY, flip));
+        diffZ = _mm256_mul_ps(weightV, _mm256_xor_ps(diffZ, flip));
+        diffW = _mm256_add_ps(_mm256_sub_ps(one, weightV), _mm256_mul_ps(weightV, _mm256_xor_ps(diffW, flip)));
+
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(diffX, diffX), _mm256_mul_ps(diffY, diffY)),
+            _mm256_mul_ps(diffZ, diffZ)), _mm256_mul_ps(diffW, diffW)));
+
+        diffX = _mm256_div_ps(diffX, length);
+        diffY = _mm256_div_ps(diffY, length);
+        diffZ = _mm256_div_ps(diffZ, length);
+        diffW = _mm256_div_ps(diffW, length);
+
+        //base times the difference
+        _mm256_storeu_ps(dest.getRotationX() + index,
+            _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(baseW, diffX), _mm256_mul_ps(baseX, diffW)), _mm256_mul_ps(baseY, diffZ)), _mm256_mul_ps(baseZ, diffY)));
+        _mm256_storeu_ps(dest.getRotationY() + index,
+            _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(baseW, diffY), _mm256_mul_ps(baseX, diffZ)), _mm256_mul_ps(baseY, diffW)), _mm256_mul_ps(baseZ, diffX)));
+        _mm256_storeu_ps(dest.getRotationZ() + index,
+            _mm256_add_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(baseW, diffZ), _mm256_mul_ps(baseX, diffY)), _mm256_mul_ps(baseY, diffX)), _mm256_mul_ps(baseZ, diffW)));
+        _mm256_storeu_ps(dest.getRotationW() + index,
+            _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(baseW, diffW), _mm256_mul_ps(baseX, diffX)), _mm256_mul_ps(baseY, diffY)), _mm256_mul_ps(baseZ, diffZ)));
+    }
+
+    #undef ILL_TRANSFORM_BATCH_ADD
+    #undef ILL_TRANSFORM_BATCH_SCALE
+#elif defined(ILL_SSE2)
+    const __m128 overallWeight = _mm_set1_ps(weight);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    #define ILL_TRANSFORM_BATCH_ADD(getter) \
+        _mm_storeu_ps(dest.getter() + index, _mm_add_ps(_mm_loadu_ps(base.getter() + index), \
+            _mm_mul_ps(weightV, _mm_sub_ps(_mm_loadu_ps(additive.getter() + index), _mm_loadu_ps(reference.getter() + index)))))
+
+    #define ILL_TRANSFORM_BATCH_SCALE(getter) \
+        _mm_storeu_ps(dest.getter() + index, _mm_mul_ps(_mm_loadu_ps(base.getter() + index), _mm_add_ps(one, \
+            _mm_mul_ps(weightV, _mm_sub_ps(_mm_div_ps(_mm_loadu_ps(additive.getter() + index), _mm_loadu_ps(reference.getter() + index)), one)))))
+
+    for(size_t index = 0; index < paddedSize; index += 4) {
+        __m128 weightV = mask ? _mm_mul_ps(overallWeight, _mm_loadu_ps(mask + index)) : overallWeight;
+
+        //the rotations are read before anything is written in case dest is the same batch as base
+        __m128 baseX = _mm_loadu_ps(base.getRotationX() + index);
+        __m128 baseY = _mm_loadu_ps(base.getRotationY() + index);
+        __m128 baseZ = _mm_loadu_ps(base.getRotationZ() + index);
+        __m128 baseW = _mm_loadu_ps(base.getRotationW() + index);
+        __m128 addX = _mm_loadu_ps(additive.getRotationX() + index);
+        __m128 addY = _mm_loadu_ps(additive.getRotationY() + index);
+        __m128 addZ = _mm_loadu_ps(additive.getRotationZ() + index);
+        __m128 addW = _mm_loadu_ps(additive.getRotationW() + index);
+        __m128 refX = _mm_loadu_ps(reference.getRotationX() + index);
+        __m128 refY = _mm_loadu_ps(reference.getRotationY() + index);
+        __m128 refZ = _mm_loadu_ps(reference.getRotationZ() + index);
+        __m128 refW = _mm_loadu_ps(reference.getRotationW() + index);
+
+        ILL_TRANSFORM_BATCH_ADD(getPositionX);
+        ILL_TRANSFORM_BATCH_ADD(getPositionY);
+        ILL_TRANSFORM_BATCH_ADD(getPositionZ);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleX);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleY);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleZ);
+
+        //the difference, the conjugate of the reference times the additive rotation
+        __m128 diffX = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(refW, addX), _mm_mul_ps(refX, addW)), _mm_mul_ps(refY, addZ)), _mm_mul_ps(refZ, addY));
+        __m128 diffY = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(refW, addY), _mm_mul_ps(refX, addZ)), _mm_mul_ps(refY, addW)), _mm_mul_ps(refZ, addX));
+        __m128 diffZ = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(refW, addZ), _mm_mul_ps(refX, addY)), _mm_mul_ps(refY, addX)), _mm_mul_ps(refZ, addW));
+        __m128 diffW = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(refW, addW), _mm_mul_ps(refX, addX)), _mm_mul_ps(refY, addY)), _mm_mul_ps(refZ, addZ));
+
+        //the short way around, then scaled by the weight with a normalized lerp from the identity
+        __m128 flip = _mm_and_ps(diffW, signMask);
+        diffX = _mm_mul_ps(weightV, _mm_xor_ps(diffX, flip));
+        diffY = _mm_mul_ps(weightV, _mm_xor_ps(diffY, flip));
+        diffZ = _mm_mul_ps(weightV, _mm_xor_ps(diffZ, flip));
+        diffW = _mm_add_ps(_mm_sub_ps(one, weightV), _mm_mul_ps(weightV, _mm_xor_ps(diffW, flip)));
+
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)),
+            _mm_mul_ps(diffZ, diffZ)), _mm_mul_ps(diffW, diffW)));
+
+        diffX = _mm_div_ps(diffX, length);
+        diffY = _mm_div_ps(diffY, length);
+        diffZ = _mm_div_ps(diffZ, length);
+        diffW = _mm_div_ps(diffW, length);
+
+        //base times the difference
+        _mm_storeu_ps(dest.getRotationX() + index,
+            _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(baseW, diffX), _mm_mul_ps(baseX, diffW)), _mm_mul_ps(baseY, diffZ)), _mm_mul_ps(baseZ, diffY)));
+        _mm_storeu_ps(dest.getRotationY() + index,
+            _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(baseW, diffY), _mm_mul_ps(baseX, diffZ)), _mm_mul_ps(baseY, diffW)), _mm_mul_ps(baseZ, diffX)));
+        _mm_storeu_ps(dest.getRotationZ() + index,
+            _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(baseW, diffZ), _mm_mul_ps(baseX, diffY)), _mm_mul_ps(baseY, diffX)), _mm_mul_ps(baseZ, diffW)));
+        _mm_storeu_ps(dest.getRotationW() + index,
+            _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(baseW, diffW), _mm_mul_ps(baseX, diffX)), _mm_mul_ps(baseY, diffY)), _mm_mul_ps(baseZ, diffZ)));
+    }
+
+    #undef ILL_TRANSFORM_BATCH_ADD
+    #undef ILL_TRANSFORM_BATCH_SCALE
+#else
+    #define ILL_TRANSFORM_BATCH_ADD(getter) \
+        dest.getter()[index] = base.getter()[index] + transformWeight * (additive.getter()[index] - reference.getter()[index])
+
+    #define ILL_TRANSFORM_BATCH_SCALE(getter) \
+        dest.getter()[index] = base.getter()[index] * (1.0f + transformWeight * (additive.getter()[index] / reference.getter()[index] - 1.0f))
+
+    for(size_t index = 0; index < paddedSize; index++) {
+        float transformWeight = mask ? weight * mask[index] : weight;
+
+        float baseX = base.getRotationX()[index];
+        float baseY = base.getRotationY()[index];
+        float baseZ = base.getRotationZ()[index];
+        float baseW = base.getRotationW()[index];
+        float addX = additive.getRotationX()[index];
+        float addY = additive.getRotationY()[index];
+        float addZ = additive.getRotationZ()[index];
+        float addW = additive.getRotationW()[index];
+        float refX = reference.getRotationX()[index];
+        float refY = reference.getRotationY()[index];
+        float refZ = reference.getRotationZ()[index];
+        float refW = reference.getRotationW()[index];
+
+        ILL_TRANSFORM_BATCH_ADD(getPositionX);
+        ILL_TRANSFORM_BATCH_ADD(getPositionY);
+        ILL_TRANSFORM_BATCH_ADD(getPositionZ);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleX);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleY);
+        ILL_TRANSFORM_BATCH_SCALE(getScaleZ);
+
+        //same order of operations as the SIMD versions so the results match exactly
+        float diffX = ((refW * addX - refX * addW) - refY * addZ) + refZ * addY;
+        float diffY = ((refW * addY + refX * addZ) - refY * addW) - refZ * addX;
+        float diffZ = ((refW * addZ - refX * addY) + refY * addX) - refZ * addW;
+        float diffW = ((refW * addW + refX * addX) + refY * addY) + refZ * addZ;
+
+        if(diffW < 0.0f) {
+            diffX = -diffX;
+            diffY = -diffY;
+            diffZ = -diffZ;
+            diffW = -diffW;
+        }
+
+        diffX = transformWeight * diffX;
+        diffY = transformWeight * diffY;
+        diffZ = transformWeight * diffZ;
+        diffW = (1.0f - transformWeight) + transformWeight * diffW;
+
+        float length = std::sqrt(((diffX * diffX + diffY * diffY) + diffZ * diffZ) + diffW * diffW);
+
+        diffX = diffX / length;
+        diffY = diffY / length;
+        diffZ = diffZ / length;
+        diffW = diffW / length;
+
+        dest.getRotationX()[index] = ((baseW * diffX + baseX * diffW) + baseY * diffZ) - baseZ * diffY;
+        dest.getRotationY()[index] = ((baseW * diffY - baseX * diffZ) + baseY * diffW) + baseZ * diffX;
+        dest.getRotationZ()[index] = ((baseW * diffZ + baseX * diffY) - baseY * diffX) + baseZ * diffW;
+        dest.getRotationW()[index] = ((baseW * diffW - baseX * diffX) - baseY * diffY) - baseZ * diffZ;
+    }
+
+    #undef ILL_TRANSFORM_BATCH_ADD
+    #undef ILL_TRANSFORM_BATCH_SCALE
+#endif
+}
+
+#if defined(ILL_SSE2)
+/**
+Stores 4 matrices laid out as a structure of arrays as column major matrices.
+columns[col][component] has that component of that column for each of the 4 matrices.
+Only the first count of them are written so the end of an array that isn't a multiple of 4 doesn't get written past.
+*/
+inline void transformBatchStoreMatrices(__m128 columns[4][4], glm::mat4 * dest, size_t count) {
+    //after transposing, columns[col][matrix] is that whole column of that matrix
+    for(unsigned int col = 0; col < 4; col++) {
+        _MM_TRANSPOSE4_PS(columns[col][0], columns[col][1], columns[col][2], columns[col][3]);
+    }
+
+    for(size_t matrix = 0; matrix < count; matrix++) {
+        for(unsigned int col = 0; col < 4; col++) {
+            _mm_storeu_ps(&dest[matrix][col][0], columns[col][matrix]);
+        }
+    }
+}
+#endif
+
+/**
+Turns a batch of transforms into matrices, the same thing as Transform::getMatrix on each one
+but 4 at a time with SSE2 or one at a time otherwise.  See Util/simd.h.
+The rotation, scale, and translation are written straight into the matrix instead of multiplying together 3 matrices.
+
+@param transforms The transforms.
+@param dest Where to write the matrices, must have room for transforms.size() of them.
+*/
+inline void transformBatchMatrices(const TransformBatch& transforms, glm::mat4 * dest) {
+    size_t numTransforms = transforms.size();
+
+#if defined(ILL_SSE2)
+    //AVX doesn't help much here since most of the work is shuffling the results into matrices
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    for(size_t index = 0; index < numTransforms; index += 4) {
+        __m128 x = _mm_loadu_ps(transforms.getRotationX() + index);
+        __m128 y = _mm_loadu_ps(transforms.getRotationY() + index);
+        __m128 z = _mm_loadu_ps(transforms.getRotationZ() + index);
+        __m128 w = _mm_loadu_ps(transforms.getRotationW() + index);
+        __m128 scaleX = _mm_loadu_ps(transforms.getScaleX() + index);
+        __m128 scaleY = _mm_loadu_ps(transforms.getScaleY() + index);
+        __m128 scaleZ = _mm_loadu_ps(transforms.getScaleZ() + index);
+
+        __m128 xx = _mm_mul_ps(x, x);
+        __m128 yy = _mm_mul_ps(y, y);
+        __m128 zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y);
+        __m128 xz = _mm_mul_ps(x, z);
+        __m128 yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x);
+        __m128 wy = _mm_mul_ps(w, y);
+        __m128 wz = _mm_mul_ps(w, z);
+
+        __m128 columns[4][4] = {
+            {
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX),
+                zero
+            },
+            {
+                _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY),
+                zero
+            },
+            {
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ),
+                zero
+            },
+            {
+                _mm_loadu_ps(transforms.getPositionX() + index),
+                _mm_loadu_ps(transforms.getPositionY() + index),
+                _mm_loadu_ps(transforms.getPositionZ() + index),
+                one
+            }
+        };
+
+        transformBatchStoreMatrices(columns, dest + index, numTransforms - index < 4 ? numTransforms - index : 4);
+    }
+#else
+    for(size_t index = 0; index < numTransforms; index++) {
+        float x = transforms.getRotationX()[index];
+        float y = transforms.getRotationY()[index];
+        float z = transforms.getRotationZ()[index];
+        float w = transforms.getRotationW()[index];
+        float scaleX = transforms.getScaleX()[index];
+        float scaleY = transforms.getScaleY()[index];
+        float scaleZ = transforms.getScaleZ()[index];
+
+        glm::mat4& matrix = dest[index];
+
+        //same order of operations as the SIMD version so the results match exactly
+        matrix[0][0] = (1.0f - 2.0f * (y * y + z * z)) * scaleX;
+        matrix[0][1] = (2.0f * (x * y + w * z)) * scaleX;
+        matrix[0][2] = (2.0f * (x * z - w * y)) * scaleX;
+        matrix[0][3] = 0.0f;
+
+        matrix[1][0] = (2.0f * (x * y - w * z)) * scaleY;
+        matrix[1][1] = (1.0f - 2.0f * (x * x + z * z)) * scaleY;
+        matrix[1][2] = (2.0f * (y * z + w * x)) * scaleY;
+        matrix[1][3] = 0.0f;
+
+        matrix[2][0] = (2.0f * (x * z + w * y)) * scaleZ;
+        matrix[2][1] = (2.0f * (y * z - w * x)) * scaleZ;
+        matrix[2][2] = (1.0f - 2.0f * (x * x + y * y)) * scaleZ;
+        matrix[2][3] = 0.0f;
+
+        matrix[3][0] = transforms.getPositionX()[index];
+        matrix[3][1] = transforms.getPositionY()[index];
+        matrix[3][2] = transforms.getPositionZ()[index];
+        matrix[3][3] = 1.0f;
+    }
+#endif
+}
+
+/**
+Multiplies two 4x4 matrices, dest = left * right, with SSE2 or the plain glm way otherwise.
+Adds things up in the same order glm does, so the results are the same as glm's operator*.
+dest can be the same matrix as left or right.
+*/
+inline void multiplyMatrix(const glm::mat4& left, const glm::mat4& right, glm::mat4& dest) {
+#if defined(ILL_SSE2)
+    __m128 left0 = _mm_loadu_ps(&left[0][0]);
+    __m128 left1 = _mm_loadu_ps(&left[1][0]);
+    __m128 left2 = _mm_loadu_ps(&left[2][0]);
+    __m128 left3 = _mm_loadu_ps(&left[3][0]);
+
+    __m128 res[4];
+
+    for(unsigned int col = 0; col < 4; col++) {
+        const float * rightCol = &right[col][0];
+
+        res[col] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(left0, _mm_set1_ps(rightCol[0])),
+            _mm_mul_ps(left1, _mm_set1_ps(rightCol[1]))),
+            _mm_mul_ps(left2, _mm_set1_ps(rightCol[2]))),
+            _mm_mul_ps(left3, _mm_set1_ps(rightCol[3])));
+    }
+
+    for(unsigned int col = 0; col < 4; col++) {
+        _mm_storeu_ps(&dest[col][0], res[col]);
+    }
+#else
+    dest = left * right;
+#endif
+}
+
+#endif
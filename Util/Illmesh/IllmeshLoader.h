@@ -6,25 +6,68 @@
 #include "Util/Geometry/MeshData.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/File.h"
+#include "FileSystem/BufferedFileReader.h"
 
 const uint64_t MESH_MAGIC = 0x494C4C4D45534831;	//ILLMESH1 in big endian 64 bit
+const uint64_t MESH2_MAGIC = 0x494C4C4D45534832;	//ILLMESH2 in big endian 64 bit
+
+/**
+The vertex and index blocks in an ILLMESH2 file start on a multiple of this many bytes.
+*/
+const uint32_t MESH2_BLOCK_ALIGNMENT = 16;
+
+/**
+ILLMESH2 header size in bytes, the primitive groups start right after it.
+*/
+const uint32_t MESH2_HEADER_SIZE = 32;
+
+/**
+ILLMESH2 size in bytes of each primitive group entry.
+*/
+const uint32_t MESH2_GROUP_SIZE = 12;
 
 /**
 Loads the amazing illmesh format.  It's a nice simple format where you don't deal with any BS and just load what you need into the VBO and IBO.
+
+ILLMESH1 stores everything one value at a time so it has to be read one value at a time.
+
+ILLMESH2 stores the interleaved vertex data and the indices as little endian blocks aligned to MESH2_BLOCK_ALIGNMENT,
+so each block is read straight into the MeshData in one go.  The layout is:
+- 8 bytes magic string ILLMESH2
+- 1 byte features mask
+- 1 byte number of primitive groups
+- 1 byte vertex size, must match what MeshData computes from the features
+- 1 byte index size, 2 for 16 bit indices or 4 for 32 bit indices, 0 is treated as 2
+- 32 bit number of vertices
+- 32 bit number of indices
+- 32 bit offset of the primitive groups
+- 32 bit offset of the vertex block
+- 32 bit offset of the index block
+- The primitive groups, each is 1 byte type, 3 bytes padding, 32 bit begin index, 32 bit number of indices
+
+Everything after the magic string is little endian.  Use Tools/illMesh or IllmeshWriter.h to convert old files.
 */
 struct IllmeshLoader {
     IllmeshLoader(const char * fileName)
-        : m_features(0)
+        : m_features(0),
+        m_version(0),
+        m_indexSize(sizeof(uint16_t))
     {
-        m_openFile = illFileSystem::fileSystem->openRead(fileName);
+        m_openFile = illFileSystem::openBufferedRead(fileName);
 		
 		//read magic string
 		{
 			uint64_t magic;
 			m_openFile->readB64(magic);
 
-			if(magic != MESH_MAGIC) {
-				LOG_FATAL_ERROR("Not a valid ILLMESH1 file.");      //TODO: make this not fatal and instead load a crappy little box to indicate that the mesh failed to load
+			if(magic == MESH_MAGIC) {
+                m_version = 1;
+            }
+            else if(magic == MESH2_MAGIC) {
+                m_version = 2;
+            }
+            else {
+				LOG_FATAL_ERROR("Not a valid ILLMESH1 or ILLMESH2 file.");      //TODO: make this not fatal and instead load a crappy little box to indicate that the mesh failed to load
 			}
 		}
 		
@@ -33,8 +76,33 @@ struct IllmeshLoader {
 
         //read the buffer sizes
         m_openFile->read8(m_numGroups);
-		m_openFile->readL32(m_numVert);
-		m_openFile->readL16(m_numInd);        
+
+        if(m_version == 1) {
+		    m_openFile->readL32(m_numVert);
+
+            uint16_t numInd;
+		    m_openFile->readL16(numInd);
+            m_numInd = numInd;
+        }
+        else {
+            m_openFile->read8(m_vertexSize);
+
+            m_openFile->read8(m_indexSize);
+
+            if(m_indexSize == 0) {
+                m_indexSize = sizeof(uint16_t);
+            }
+            else if(m_indexSize != sizeof(uint16_t) && m_indexSize != sizeof(uint32_t)) {
+                LOG_FATAL_ERROR("ILLMESH2 file %s has invalid index size %u.", fileName, (unsigned int) m_indexSize);
+            }
+
+            m_openFile->readL32(m_numVert);
+            m_openFile->readL32(m_numInd);
+
+            m_openFile->readL32(m_groupsOffset);
+            m_openFile->readL32(m_vertexOffset);
+            m_openFile->readL32(m_indexOffset);
+        }
     }
 
     ~IllmeshLoader() {
@@ -42,6 +110,11 @@ struct IllmeshLoader {
     }
 
     void buildMesh(MeshData<>& mesh) const {
+        if(m_version == 2) {
+            buildMesh2(mesh);
+            return;
+        }
+
         //read groups
         for(unsigned int group = 0; group < m_numGroups; group++) {
             MeshData<>::PrimitiveGroup& primitiveGroup = mesh.getPrimitiveGroup(group);
@@ -85,11 +158,104 @@ struct IllmeshLoader {
     }
 
     FeaturesMask m_features;
-    illFileSystem::File * m_openFile;
+    illFileSystem::BufferedFileReader * m_openFile;
+
+    ///1 for ILLMESH1, 2 for ILLMESH2
+    uint8_t m_version;
 
     uint32_t m_numVert;
-    uint16_t m_numInd;
+    uint32_t m_numInd;
     uint8_t m_numGroups;
+
+    ///The size of the indices in bytes, pass it along to MeshData.  Always 2 for ILLMESH1.
+    uint8_t m_indexSize;
+
+private:
+    void buildMesh2(MeshData<>& mesh) const {
+        if(m_indexSize != mesh.getIndexSize()) {
+            LOG_FATAL_ERROR("ILLMESH2 file %s has index size %u but the mesh was created with index size %u.", 
+                m_openFile->getFileName(), (unsigned int) m_indexSize, (unsigned int) mesh.getIndexSize());
+        }
+
+        if((size_t) m_vertexSize != mesh.getVertexSize()) {
+            LOG_FATAL_ERROR("ILLMESH2 file %s has vertex size %u but its features need vertex size %u.", 
+                m_openFile->getFileName(), (unsigned int) m_vertexSize, (unsigned int) mesh.getVertexSize());
+        }
+
+        //make sure every block is inside the file before reading anything into the mesh
+        {
+            uint64_t fileSize = (uint64_t) m_openFile->getSize();
+
+            checkBlock2("primitive group", m_groupsOffset, (uint64_t) m_numGroups * MESH2_GROUP_SIZE, fileSize);
+            checkBlock2("vertex", m_vertexOffset, (uint64_t) m_numVert * mesh.getVertexSize(), fileSize);
+            checkBlock2("index", m_indexOffset, (uint64_t) m_numInd * m_indexSize, fileSize);
+        }
+
+        //read groups
+        m_openFile->seek(m_groupsOffset);
+
+        for(unsigned int group = 0; group < m_numGroups; group++) {
+            MeshData<>::PrimitiveGroup& primitiveGroup = mesh.getPrimitiveGroup(group);
+
+            uint8_t type;
+            m_openFile->read8(type);
+            primitiveGroup.m_type = (MeshData<>::PrimitiveGroup::Type) type;
+
+            m_openFile->seekAhead(3);
+
+            m_openFile->readL32(primitiveGroup.m_beginIndex);
+            m_openFile->readL32(primitiveGroup.m_numIndices);
+        }
+
+        //read the VBO and IBO in one go each, the blocks are already laid out the same as in memory
+        m_openFile->seek(m_vertexOffset);
+        m_openFile->read(mesh.getData(), (size_t) m_numVert * mesh.getVertexSize());
+
+        m_openFile->seek(m_indexOffset);
+        m_openFile->read(mesh.getIndexData(), (size_t) m_numInd * m_indexSize);
+
+#if ILL_BYTEORDER == ILL_BIG_ENDIAN
+        {
+            float * vertexData = reinterpret_cast<float *>(mesh.getData());
+            size_t numElements = (size_t) m_numVert * mesh.getVertexSize() / sizeof(float);
+
+            for(size_t element = 0; element < numElements; element++) {
+                vertexData[element] = littleF(vertexData[element]);
+            }
+
+            if(m_indexSize == sizeof(uint32_t)) {
+                uint32_t * indices = mesh.getIndices32();
+
+                for(uint32_t index = 0; index < m_numInd; index++) {
+                    indices[index] = little32(indices[index]);
+                }
+            }
+            else {
+                uint16_t * indices = mesh.getIndices();
+
+                for(uint32_t index = 0; index < m_numInd; index++) {
+                    indices[index] = little16(indices[index]);
+                }
+            }
+        }
+#endif
+    }
+
+    /**
+    Fails if a block in an ILLMESH2 file goes past the end of the file, which means the file is truncated or the header is garbage.
+    */
+    void checkBlock2(const char * blockName, uint64_t offset, uint64_t size, uint64_t fileSize) const {
+        if(offset > fileSize || size > fileSize - offset) {
+            LOG_FATAL_ERROR("ILLMESH2 file %s has a %s block of %u bytes at offset %u, past the end of the %u byte file.", 
+                m_openFile->getFileName(), blockName, (unsigned int) size, (unsigned int) offset, (unsigned int) fileSize);
+        }
+    }
+
+    //ILLMESH2 only
+    uint8_t m_vertexSize;
+    uint32_t m_groupsOffset;
+    uint32_t m_vertexOffset;
+    uint32_t m_indexOffset;
 };
 
 #endif
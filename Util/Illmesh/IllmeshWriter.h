@@ -0,0 +1,156 @@
+#ifndef ILL_ILLMESHWRITER_H__
+#define ILL_ILLMESHWRITER_H__
+
+#include <cassert>
+#include "Logging/logging.h"
+#include "Util/Illmesh/IllmeshLoader.h"
+
+/**
+Rounds an offset in an ILLMESH2 file up to the next MESH2_BLOCK_ALIGNMENT.
+*/
+inline uint32_t illmesh2AlignOffset(uint32_t offset) {
+    return (offset + MESH2_BLOCK_ALIGNMENT - 1) & ~(MESH2_BLOCK_ALIGNMENT - 1);
+}
+
+/**
+Writes zeroes until the file is at the offset.
+*/
+inline void illmeshPadTo(illFileSystem::File * file, uint32_t offset) {
+    for(size_t position = file->tell(); position < offset; position++) {
+        file->write8(0);
+    }
+}
+
+/**
+Writes a mesh in the old ILLMESH1 format.  Only really useful for testing that old files still load.
+The mesh can't have more than 65535 indices since ILLMESH1 stores the count in 16 bits, and it must use 16 bit indices.
+*/
+inline void writeIllmesh1(const MeshData<>& mesh, illFileSystem::File * file) {
+    if(mesh.getNumInd() > 0xFFFF) {
+        LOG_FATAL_ERROR("Mesh with %u indices doesn't fit in ILLMESH1 file %s.", mesh.getNumInd(), file->getFileName());
+    }
+
+    if(mesh.getIndexSize() != sizeof(uint16_t)) {
+        LOG_FATAL_ERROR("Mesh with 32 bit indices doesn't fit in ILLMESH1 file %s.", file->getFileName());
+    }
+
+    file->writeB64(MESH_MAGIC);
+    file->write8(mesh.getFeatures());
+    file->write8(mesh.getNumPrimitiveGroups());
+    file->writeL32(mesh.getNumVert());
+    file->writeL16((uint16_t) mesh.getNumInd());
+
+    for(uint8_t group = 0; group < mesh.getNumPrimitiveGroups(); group++) {
+        const MeshData<>::PrimitiveGroup& primitiveGroup = mesh.getPrimitiveGroup(group);
+
+        file->write8((uint8_t) primitiveGroup.m_type);
+        file->writeL16((uint16_t) primitiveGroup.m_beginIndex);
+        file->writeL16((uint16_t) primitiveGroup.m_numIndices);
+    }
+
+    const float * vertexData = reinterpret_cast<const float *>(mesh.getData());
+    size_t numElements = (size_t) mesh.getNumVert() * mesh.getVertexSize() / sizeof(float);
+
+    for(size_t element = 0; element < numElements; element++) {
+        file->writeLF(vertexData[element]);
+    }
+
+    for(uint32_t index = 0; index < mesh.getNumInd(); index++) {
+        file->writeL16(mesh.getIndices()[index]);
+    }
+}
+
+/**
+Writes a mesh in the ILLMESH2 format described in IllmeshLoader.h.
+The mesh data needs to be allocated.  The index size is stored in the file so the mesh loads back with the same index size.
+*/
+inline void writeIllmesh2(const MeshData<>& mesh, illFileSystem::File * file) {
+    assert(mesh.getData());
+    assert(mesh.getIndexData());
+
+    uint32_t vertexBlockSize = mesh.getNumVert() * (uint32_t) mesh.getVertexSize();
+
+    uint32_t groupsOffset = MESH2_HEADER_SIZE;
+    uint32_t vertexOffset = illmesh2AlignOffset(groupsOffset + mesh.getNumPrimitiveGroups() * MESH2_GROUP_SIZE);
+    uint32_t indexOffset = illmesh2AlignOffset(vertexOffset + vertexBlockSize);
+
+    //header
+    file->writeB64(MESH2_MAGIC);
+    file->write8(mesh.getFeatures());
+    file->write8(mesh.getNumPrimitiveGroups());
+    file->write8((uint8_t) mesh.getVertexSize());
+    file->write8(mesh.getIndexSize());
+    file->writeL32(mesh.getNumVert());
+    file->writeL32(mesh.getNumInd());
+    file->writeL32(groupsOffset);
+    file->writeL32(vertexOffset);
+    file->writeL32(indexOffset);
+
+    //groups
+    for(uint8_t group = 0; group < mesh.getNumPrimitiveGroups(); group++) {
+        const MeshData<>::PrimitiveGroup& primitiveGroup = mesh.getPrimitiveGroup(group);
+
+        file->write8((uint8_t) primitiveGroup.m_type);
+        file->write8(0);
+        file->write8(0);
+        file->write8(0);
+        file->writeL32(primitiveGroup.m_beginIndex);
+        file->writeL32(primitiveGroup.m_numIndices);
+    }
+
+    //VBO
+    illmeshPadTo(file, vertexOffset);
+
+#if ILL_BYTEORDER == ILL_LIL_ENDIAN
+    file->write(mesh.getData(), vertexBlockSize);
+#else
+    {
+        const float * vertexData = reinterpret_cast<const float *>(mesh.getData());
+
+        for(uint32_t element = 0; element < vertexBlockSize / sizeof(float); element++) {
+            file->writeLF(vertexData[element]);
+        }
+    }
+#endif
+
+    //IBO
+    illmeshPadTo(file, indexOffset);
+
+#if ILL_BYTEORDER == ILL_LIL_ENDIAN
+    file->write(mesh.getIndexData(), mesh.getNumInd() * mesh.getIndexSize());
+#else
+    if(mesh.getIndexSize() == sizeof(uint32_t)) {
+        for(uint32_t index = 0; index < mesh.getNumInd(); index++) {
+            file->writeL32(mesh.getIndices32()[index]);
+        }
+    }
+    else {
+        for(uint32_t index = 0; index < mesh.getNumInd(); index++) {
+            file->writeL16(mesh.getIndices()[index]);
+        }
+    }
+#endif
+}
+
+/**
+Loads a mesh file of any illmesh version and writes it back out as ILLMESH2.
+Both paths go through illFileSystem::fileSystem.
+*/
+inline void convertIllmesh(const char * sourcePath, const char * destinationPath) {
+    MeshData<> * mesh;
+
+    {
+        IllmeshLoader meshLoader(sourcePath);
+
+        mesh = new MeshData<>(meshLoader.m_numInd, meshLoader.m_numVert, meshLoader.m_numGroups, meshLoader.m_features, true, meshLoader.m_indexSize);
+        meshLoader.buildMesh(*mesh);
+    }
+
+    illFileSystem::File * file = illFileSystem::fileSystem->openWrite(destinationPath);
+    writeIllmesh2(*mesh, file);
+
+    delete file;
+    delete mesh;
+}
+
+#endif
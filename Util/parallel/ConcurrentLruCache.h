@@ -0,0 +1,441 @@
+#ifndef ILL_CONCURRENT_LRU_CACHE_H_
+#define ILL_CONCURRENT_LRU_CACHE_H_
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Util/serial/IntrusivePtr.h"
+
+/**
+A version of LruCache that can be used from any number of threads at once, for when resources are requested by loader threads.
+
+The keys are spread across shards by their hash, each with its own lock, so threads asking for different things rarely wait on each other.
+Elements are created outside the lock so a slow load only holds up threads asking for that same key.
+Those threads wait for the first one to finish creating it, so every element is only ever created once.
+
+The differences from LruCache:
+- The cache keeps a reference to every element itself instead of being the elements' RefCountOwner,
+so an element is unreferenced when the cache's reference is the only one left.  That way references can be dropped on any
+thread with no callback into the cache, and the cache never deletes something another thread is in the middle of releasing.
+- Since nothing tells the cache when an element is released, the LRU order is the order the elements were last requested in,
+and elements count as unreferenced from when the cache first notices, which is whenever it looks for things to evict.
+Without a memory budget it only looks at elements that haven't been requested or looked at for the eviction time,
+so an element goes away somewhere between one and two eviction times after it's released.
+Call evict() every so often, like once a frame, for elements to go away when nothing new is being requested.
+- The memory budget is split evenly between the shards.  The memory usage is measured when an element is created and when
+the cache notices it went unreferenced, since nobody else can be changing it then.
+- Evicted elements are deleted after the shard is unlocked, so their destructors can use the cache.
+
+@tparam Key The key to uniquely identify objects in the cache
+@tparam T The object type, a RefCounted with an AtomicRefCount since references get dropped on whatever thread
+*/
+template <typename Key, typename T>
+class ConcurrentLruCache {
+public:
+    /**
+    Counters for tuning the cache size, the same as LruCache's.
+    */
+    struct Stats {
+        Stats()
+            : m_hits(0),
+            m_misses(0),
+            m_evictions(0)
+        {}
+
+        uint64_t m_hits;            ///<getElement() calls that found the element in the cache, including ones that waited for it to be created
+        uint64_t m_misses;          ///<getElement() calls that had to create the element
+        uint64_t m_evictions;       ///<Elements destroyed to make room or for being unreferenced too long
+    };
+
+    /**
+    Constructor for the concurrent LRU cache.
+
+    @param createFunc Takes a Key and returns a new object for the cache.  Gets called on whatever thread asked for the element first.
+    @param numShards How many shards to split the cache into, a power of 2.  More than the number of threads using the cache is plenty.
+    @param evictionSeconds How long elements should be in the cache without any references before they get destroyed.
+    */
+    ConcurrentLruCache(std::function<T* (Key)> createFunc, size_t numShards = 16, std::chrono::steady_clock::duration evictionSeconds = std::chrono::seconds(2))
+        : m_createFunc(createFunc),
+        m_evictionSeconds(evictionSeconds),
+        m_memoryBudget(0),
+        m_shards(new Shard[numShards]),
+        m_shardMask(numShards - 1)
+    {
+        assert(numShards > 0 && (numShards & (numShards - 1)) == 0);
+    }
+
+    ~ConcurrentLruCache() {
+        clear();
+        delete[] m_shards;
+    }
+
+    inline size_t getNumShards() const {
+        return m_shardMask + 1;
+    }
+
+    /**
+    Sets the function that returns how many bytes an element is using.  Set this before any threads are using the cache.
+    */
+    inline void setSizeFunc(std::function<size_t (const T&)> sizeFunc) {
+        m_sizeFunc = sizeFunc;
+    }
+
+    /**
+    Sets the memory budget in bytes and evicts right away if the cache is over it.
+    0 turns off the budget and goes back to evicting elements that have been unreferenced for the eviction time.
+    Set this before any threads are using the cache, or from the thread that calls evict().
+    */
+    inline void setMemoryBudget(size_t memoryBudget) {
+        m_memoryBudget = memoryBudget;
+        evict();
+    }
+
+    inline size_t getMemoryBudget() const {
+        return m_memoryBudget;
+    }
+
+    /**
+    Bytes used by everything in the cache, referenced or not, as last measured with the size function.
+    */
+    size_t getMemoryUsage() const {
+        size_t memoryUsage = 0;
+
+        for(size_t shard = 0; shard <= m_shardMask; shard++) {
+            std::lock_guard<std::mutex> lock(m_shards[shard].m_mutex);
+            memoryUsage += m_shards[shard].m_memoryUsage;
+        }
+
+        return memoryUsage;
+    }
+
+    /**
+    How many elements are in the cache, including ones still being created.
+    */
+    size_t getNumElements() const {
+        size_t numElements = 0;
+
+        for(size_t shard = 0; shard <= m_shardMask; shard++) {
+            std::lock_guard<std::mutex> lock(m_shards[shard].m_mutex);
+            numElements += m_shards[shard].m_elements.size();
+        }
+
+        return numElements;
+    }
+
+    Stats getStats() const {
+        Stats stats;
+
+        for(size_t shard = 0; shard <= m_shardMask; shard++) {
+            std::lock_guard<std::mutex> lock(m_shards[shard].m_mutex);
+
+            stats.m_hits += m_shards[shard].m_stats.m_hits;
+            stats.m_misses += m_shards[shard].m_stats.m_misses;
+            stats.m_evictions += m_shards[shard].m_stats.m_evictions;
+        }
+
+        return stats;
+    }
+
+    void resetStats() {
+        for(size_t shard = 0; shard <= m_shardMask; shard++) {
+            std::lock_guard<std::mutex> lock(m_shards[shard].m_mutex);
+            m_shards[shard].m_stats = Stats();
+        }
+    }
+
+    /**
+    Returns a smart pointer to an element in the cache, creating it if it isn't in there.
+    If another thread is creating the element right now this waits for it.
+    */
+    inline IntrusivePtr<T> getElement(Key key) {
+        return getElement(key, m_createFunc);
+    }
+
+    /**
+    Same as getElement(key) but creates the element with a different function if it's not in the cache.
+    */
+    IntrusivePtr<T> getElement(Key key, const std::function<T* (Key)>& createFunc) {
+        Shard& shard = getShard(key);
+        auto time = std::chrono::steady_clock::now();
+
+        {
+            std::unique_lock<std::mutex> lock(shard.m_mutex);
+
+            while(true) {
+                auto iter = shard.m_elements.find(key);
+
+                if(iter == shard.m_elements.end()) {
+                    break;
+                }
+
+                //someone else is creating it, look it up again after since it could even be evicted by the time this wakes up
+                if(!iter->second.m_element) {
+                    shard.m_created.wait(lock);
+                    continue;
+                }
+
+                ++shard.m_stats.m_hits;
+
+                ElementInfo& elementInfo = iter->second;
+
+                shard.m_lruOrder.splice(shard.m_lruOrder.begin(), shard.m_lruOrder, elementInfo.m_lruIterator);
+                elementInfo.m_lastUsed = time;
+                elementInfo.m_unreferenced = false;
+
+                return IntrusivePtr<T>(elementInfo.m_element);
+            }
+
+            ++shard.m_stats.m_misses;
+
+            //leave a placeholder so other threads asking for this know to wait
+            shard.m_elements[key];
+        }
+
+        //load the element without holding up the rest of the shard
+        T * element = createFunc(key);
+        IntrusivePtr<T> result(element);
+
+        //the cache's own reference
+        element->referenceIncrement();
+
+        std::vector<T *> evicted;
+
+        {
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+            shard.m_lruOrder.push_front(key);
+
+            ElementInfo& elementInfo = shard.m_elements.at(key);
+            elementInfo.m_element = element;
+            elementInfo.m_lruIterator = shard.m_lruOrder.begin();
+            elementInfo.m_lastUsed = time;
+
+            updateMemoryUsage(shard, elementInfo);
+
+            shard.m_created.notify_all();
+
+            evictElements(shard, time, evicted);
+        }
+
+        deleteEvicted(evicted);
+
+        return result;
+    }
+
+    /**
+    Evicts whatever should be evicted right now across all the shards.
+    Call this every so often, like once a frame, so unreferenced elements go away even when nothing new is being requested.
+    */
+    void evict() {
+        auto time = std::chrono::steady_clock::now();
+        std::vector<T *> evicted;
+
+        for(size_t shard = 0; shard <= m_shardMask; shard++) {
+            std::lock_guard<std::mutex> lock(m_shards[shard].m_mutex);
+            evictElements(m_shards[shard], time, evicted);
+        }
+
+        deleteEvicted(evicted);
+    }
+
+    /**
+    Drops the cache's references to everything in it.  Elements still referenced elsewhere stay alive until those references go away.
+    Nothing can be getting created while this is called.
+    */
+    void clear() {
+        std::vector<T *> evicted;
+
+        for(size_t shard = 0; shard <= m_shardMask; shard++) {
+            Shard& currentShard = m_shards[shard];
+            std::lock_guard<std::mutex> lock(currentShard.m_mutex);
+
+            for(auto iter = currentShard.m_elements.begin(); iter != currentShard.m_elements.end(); iter++) {
+                assert(iter->second.m_element);
+                evicted.push_back(iter->second.m_element);
+            }
+
+            currentShard.m_elements.clear();
+            currentShard.m_lruOrder.clear();
+            currentShard.m_memoryUsage = 0;
+        }
+
+        deleteEvicted(evicted);
+    }
+
+private:
+    //not copyable
+    ConcurrentLruCache(const ConcurrentLruCache&);
+    ConcurrentLruCache& operator=(const ConcurrentLruCache&);
+
+    /**
+    Info stored about each element.  The element is null while it's being created.
+    */
+    struct ElementInfo {
+        ElementInfo()
+            : m_element(NULL),
+            m_memoryUsage(0),
+            m_unreferenced(false)
+        {}
+
+        T * m_element;
+        size_t m_memoryUsage;
+        bool m_unreferenced;                                        ///<Whether the last eviction pass saw this with only the cache's reference
+        std::chrono::steady_clock::time_point m_lastUsed;           ///<When this was last requested, or last moved to the front by a time based eviction pass
+        typename std::list<Key>::iterator m_lruIterator;
+    };
+
+    struct Shard {
+        Shard()
+            : m_memoryUsage(0)
+        {}
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_created;                          ///<Notified whenever an element in the shard is done being created
+        std::unordered_map<Key, ElementInfo> m_elements;
+        std::list<Key> m_lruOrder;                                  ///<In order of m_lastUsed, front is the most recent
+        size_t m_memoryUsage;
+        Stats m_stats;
+
+        char m_padding[64];                                         ///<Keeps the shards' locks off each others' cache lines
+    };
+
+    inline Shard& getShard(const Key& key) {
+        size_t hash = std::hash<Key>()(key);
+
+        //integer keys hash to themselves, mix the high bits in so sequential ids spread out the same as anything else
+        return m_shards[(hash ^ (hash >> 7) ^ (hash >> 15)) & m_shardMask];
+    }
+
+    /**
+    Measures an element again and updates the shard's total.
+    */
+    inline void updateMemoryUsage(Shard& shard, ElementInfo& elementInfo) {
+        size_t memoryUsage = m_sizeFunc ? m_sizeFunc(*elementInfo.m_element) : 0;
+
+        shard.m_memoryUsage = shard.m_memoryUsage - elementInfo.m_memoryUsage + memoryUsage;
+        elementInfo.m_memoryUsage = memoryUsage;
+    }
+
+    /**
+    Finds elements in a shard to evict and takes them out of the shard.
+    They're added to the evicted list to be deleted after the shard is unlocked.
+    The shard must be locked.
+    */
+    void evictElements(Shard& shard, std::chrono::steady_clock::time_point time, std::vector<T *>& evicted) {
+        if(m_memoryBudget == 0) {
+            evictExpiredElements(shard, time, evicted);
+            return;
+        }
+
+        size_t shardBudget = m_memoryBudget / (m_shardMask + 1);
+
+        //starting from the least recently requested
+        auto lruIter = shard.m_lruOrder.end();
+
+        while(lruIter != shard.m_lruOrder.begin() && shard.m_memoryUsage > shardBudget) {
+            --lruIter;
+
+            auto elementIter = shard.m_elements.find(*lruIter);
+            ElementInfo& elementInfo = elementIter->second;
+
+            //nobody else can get a new reference to it while the shard is locked, so if the cache's reference is the only one it stays that way
+            if(elementInfo.m_element->getReferences() > 1) {
+                elementInfo.m_unreferenced = false;
+                continue;
+            }
+
+            if(!elementInfo.m_unreferenced) {
+                elementInfo.m_unreferenced = true;
+                updateMemoryUsage(shard, elementInfo);
+            }
+
+            lruIter = evictElement(shard, elementIter, evicted);
+        }
+    }
+
+    /**
+    Evicts elements that have been unreferenced for the eviction time, for when there's no memory budget.
+
+    The LRU list is kept in order of m_lastUsed, so this only looks at the back of it and stops at the first element
+    that was used within the eviction time.  Elements that are still referenced, or were just noticed to be unreferenced,
+    get moved to the front as if they were used now, so each element is looked at about once per eviction time
+    instead of the whole shard being walked on every miss.
+    */
+    void evictExpiredElements(Shard& shard, std::chrono::steady_clock::time_point time, std::vector<T *>& evicted) {
+        //elements moved to the front go to the back of what's left to look at, so with no eviction time this stops after one pass
+        size_t numToCheck = shard.m_lruOrder.size();
+
+        while(numToCheck > 0) {
+            --numToCheck;
+
+            auto lruIter = std::prev(shard.m_lruOrder.end());
+            auto elementIter = shard.m_elements.find(*lruIter);
+            ElementInfo& elementInfo = elementIter->second;
+
+            if(time - elementInfo.m_lastUsed < m_evictionSeconds) {
+                break;
+            }
+
+            //nobody else can get a new reference to it while the shard is locked, so if the cache's reference is the only one it stays that way
+            if(elementInfo.m_element->getReferences() > 1) {
+                elementInfo.m_unreferenced = false;
+            }
+            else if(!elementInfo.m_unreferenced) {
+                elementInfo.m_unreferenced = true;
+                updateMemoryUsage(shard, elementInfo);
+            }
+            else {
+                //unreferenced since it was last moved to the front
+                evictElement(shard, elementIter, evicted);
+                continue;
+            }
+
+            elementInfo.m_lastUsed = time;
+            shard.m_lruOrder.splice(shard.m_lruOrder.begin(), shard.m_lruOrder, lruIter);
+        }
+    }
+
+    /**
+    Takes an element out of the shard and adds it to the evicted list.
+
+    @return The LRU list iterator after the element's.
+    */
+    inline typename std::list<Key>::iterator evictElement(Shard& shard, typename std::unordered_map<Key, ElementInfo>::iterator elementIter, std::vector<T *>& evicted) {
+        evicted.push_back(elementIter->second.m_element);
+
+        shard.m_memoryUsage -= elementIter->second.m_memoryUsage;
+        ++shard.m_stats.m_evictions;
+
+        auto lruIter = shard.m_lruOrder.erase(elementIter->second.m_lruIterator);
+        shard.m_elements.erase(elementIter);
+
+        return lruIter;
+    }
+
+    /**
+    Drops the cache's references to evicted elements, which deletes them unless someone still has a reference.
+    */
+    inline void deleteEvicted(std::vector<T *>& evicted) {
+        for(size_t element = 0; element < evicted.size(); element++) {
+            evicted[element]->referenceDecrement();
+        }
+    }
+
+    std::function<T* (Key)> m_createFunc;
+    std::function<size_t (const T&)> m_sizeFunc;
+    std::chrono::steady_clock::duration m_evictionSeconds;
+    size_t m_memoryBudget;
+
+    Shard * m_shards;
+    size_t m_shardMask;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include <cassert>
+
+#include "TaskQueue.h"
+
+TaskQueue::TaskQueue(size_t numThreads)
+    : m_quit(false)
+{
+    assert(numThreads > 0);
+
+    m_threads.reserve(numThreads);
+
+    for(size_t thread = 0; thread < numThreads; thread++) {
+        m_threads.push_back(std::thread(&TaskQueue::workerLoop, this));
+    }
+}
+
+TaskQueue::~TaskQueue() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_wake.notify_all();
+
+    for(size_t thread = 0; thread < m_threads.size(); thread++) {
+        m_threads[thread].join();
+    }
+}
+
+void TaskQueue::push(std::function<void ()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    m_wake.notify_one();
+}
+
+void TaskQueue::workerLoop() {
+    while(true) {
+        std::function<void ()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while(!m_quit && m_tasks.empty()) {
+                m_wake.wait(lock);
+            }
+
+            //keep going until the queue is drained even when quitting
+            if(m_tasks.empty()) {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef ILL_TASK_QUEUE_H_
+#define ILL_TASK_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+A few worker threads that run tasks in the background in the order they're pushed.
+
+This is for work that can take a while and shouldn't hold up the frame, like loading resources off disk.
+ThreadPool is for splitting work up within a frame and waits for it to finish, so long running stuff like file I/O
+shouldn't go through there or it would stall whatever parallelFor is running.
+
+Tasks run on whichever worker is free, so there's no ordering guarantee once there's more than one worker.
+*/
+class TaskQueue {
+public:
+    /**
+    Starts the worker threads.
+    @param numThreads How many threads to start.  At least 1.
+    */
+    TaskQueue(size_t numThreads = 1);
+
+    /**
+    Finishes all the tasks that were pushed and stops the workers.
+    */
+    ~TaskQueue();
+
+    inline size_t getNumThreads() const {
+        return m_threads.size();
+    }
+
+    /**
+    Queues up a task to run on one of the workers.  Can be called from any thread.
+    */
+    void push(std::function<void ()> task);
+
+private:
+    //not copyable
+    TaskQueue(const TaskQueue&);
+    TaskQueue& operator=(const TaskQueue&);
+
+    void workerLoop();
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void ()> > m_tasks;
+
+    bool m_quit;
+};
+
+#endif
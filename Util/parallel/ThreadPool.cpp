@@ -0,0 +1,159 @@
+#include <cassert>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : m_function(NULL),
+    m_ranges(NULL),
+    m_numBusy(0),
+    m_generation(0),
+    m_quit(false)
+{
+    if(numThreads == (size_t) -1) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    m_ranges = new WorkRange[numThreads + 1];
+
+    for(size_t thread = 0; thread <= numThreads; thread++) {
+        m_ranges[thread].m_range = 0;
+    }
+
+    m_threads.reserve(numThreads);
+
+    for(size_t thread = 0; thread < numThreads; thread++) {
+        m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, thread + 1));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_wake.notify_all();
+
+    for(size_t thread = 0; thread < m_threads.size(); thread++) {
+        m_threads[thread].join();
+    }
+
+    delete[] m_ranges;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void (size_t)>& function) {
+    if(count == 0) {
+        return;
+    }
+
+    //not worth waking anyone up
+    if(count == 1 || m_threads.empty()) {
+        for(size_t index = 0; index < count; index++) {
+            function(index);
+        }
+
+        return;
+    }
+
+    assert(count <= 0xFFFFFFFF);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_function = &function;
+
+        //split the range up evenly, threads that finish early will steal from the rest
+        size_t concurrency = getConcurrency();
+
+        for(size_t thread = 0; thread < concurrency; thread++) {
+            m_ranges[thread].m_range = packRange((uint64_t) count * thread / concurrency, (uint64_t) count * (thread + 1) / concurrency);
+        }
+
+        m_numBusy = m_threads.size();
+        ++m_generation;
+    }
+
+    m_wake.notify_all();
+
+    //the calling thread helps out instead of just waiting
+    runJob(0);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while(m_numBusy > 0) {
+            m_done.wait(lock);
+        }
+
+        m_function = NULL;
+    }
+}
+
+void ThreadPool::workerLoop(size_t thread) {
+    uint64_t lastGeneration = 0;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while(!m_quit && m_generation == lastGeneration) {
+                m_wake.wait(lock);
+            }
+
+            if(m_quit) {
+                return;
+            }
+
+            lastGeneration = m_generation;
+        }
+
+        runJob(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if(--m_numBusy == 0) {
+                m_done.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::runJob(size_t thread) {
+    std::atomic<uint64_t>& ownRange = m_ranges[thread].m_range;
+
+    do {
+        uint64_t range = ownRange.load();
+
+        //claim indices off the front one at a time, other threads might be taking the back half at the same time
+        while(rangeBegin(range) < rangeEnd(range)) {
+            if(ownRange.compare_exchange_weak(range, packRange(rangeBegin(range) + 1, rangeEnd(range)))) {
+                (*m_function)(rangeBegin(range));
+                range = ownRange.load();
+            }
+        }
+    } while(steal(thread));
+}
+
+bool ThreadPool::steal(size_t thread) {
+    size_t concurrency = getConcurrency();
+
+    //start with the next thread over so thieves spread out instead of all going after the calling thread
+    for(size_t victimOffset = 1; victimOffset < concurrency; victimOffset++) {
+        std::atomic<uint64_t>& victimRange = m_ranges[(thread + victimOffset) % concurrency].m_range;
+        uint64_t range = victimRange.load();
+
+        while(rangeBegin(range) < rangeEnd(range)) {
+            uint32_t middle = rangeBegin(range) + (rangeEnd(range) - rangeBegin(range)) / 2;
+
+            if(victimRange.compare_exchange_weak(range, packRange(rangeBegin(range), middle))) {
+                //nobody else touches an empty range so this doesn't need to be a compare and swap
+                m_ranges[thread].m_range = packRange(middle, rangeEnd(range));
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
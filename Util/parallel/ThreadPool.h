@@ -0,0 +1,132 @@
+#ifndef ILL_THREAD_POOL_H_
+#define ILL_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+A fixed set of worker threads for splitting up CPU heavy work within a frame.
+
+Work is handed out with parallelFor, which runs a function for every index in a range
+across the workers and the calling thread, and returns once all of them are done.
+
+The range starts out split evenly between the threads, and each thread goes through its own piece in order.
+A thread that runs out steals the back half of whatever another thread has left, so uneven work still balances out
+without every index going through one shared counter.
+
+Which thread runs which index isn't deterministic, so anything that needs a deterministic result
+should write the result for each index somewhere of its own and combine them afterwards in index order.
+*/
+class ThreadPool {
+public:
+    /**
+    Starts the worker threads.
+    @param numThreads How many threads to start on top of the calling thread.
+        Pass (size_t) -1 to use one less than the number of hardware threads, since the calling thread also does work.
+    */
+    ThreadPool(size_t numThreads = (size_t) -1);
+
+    /**
+    Waits for the workers to finish what they're doing and stops them.
+    */
+    ~ThreadPool();
+
+    /**
+    How many worker threads there are, not counting the calling thread.
+    */
+    inline size_t getNumThreads() const {
+        return m_threads.size();
+    }
+
+    /**
+    How many things can run at once including the calling thread.
+    Useful for deciding how many pieces to split work up into.
+    */
+    inline size_t getConcurrency() const {
+        return m_threads.size() + 1;
+    }
+
+    /**
+    Calls the function for every index from 0 to count - 1, spread out across the worker threads and the calling thread.
+    Returns when every call has finished.  Don't call this again from inside the function.
+    */
+    void parallelFor(size_t count, const std::function<void (size_t)>& function);
+
+private:
+    //not copyable
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void workerLoop(size_t thread);
+
+    /**
+    Keeps claiming indices of the current job and running them until there are none left,
+    first from this thread's own range and then by stealing from the others.
+
+    @param thread Which range is this thread's own, 0 for the calling thread and 1 and up for the workers.
+    */
+    void runJob(size_t thread);
+
+    /**
+    Tries to take the back half of another thread's remaining range and make it this thread's range.
+    @return Whether anything was stolen.
+    */
+    bool steal(size_t thread);
+
+    /**
+    The indices a thread has left to run, packed into one atomic so claiming and stealing are a single compare and swap.
+    The low 32 bits are the next index and the high 32 bits are the end.
+    Padded out to its own cache line so threads going through their own ranges don't fight over the line.
+    */
+    struct WorkRange {
+        std::atomic<uint64_t> m_range;
+        char m_padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    static inline uint64_t packRange(uint64_t begin, uint64_t end) {
+        return begin | (end << 32);
+    }
+
+    static inline uint32_t rangeBegin(uint64_t range) {
+        return (uint32_t) range;
+    }
+
+    static inline uint32_t rangeEnd(uint64_t range) {
+        return (uint32_t) (range >> 32);
+    }
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    /**
+    The job being run, only valid while a parallelFor call is in progress.
+    */
+    const std::function<void (size_t)> * m_function;
+
+    /**
+    One per thread including the calling thread, which is the first one.
+    */
+    WorkRange * m_ranges;
+
+    /**
+    How many workers are still running the current job.
+    */
+    size_t m_numBusy;
+
+    /**
+    Goes up by one for every job so workers know when there's a new one.
+    */
+    uint64_t m_generation;
+
+    bool m_quit;
+};
+
+#endif
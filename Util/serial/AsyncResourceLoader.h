@@ -0,0 +1,211 @@
+#ifndef ILL_ASYNC_RESOURCE_LOADER_H_
+#define ILL_ASYNC_RESOURCE_LOADER_H_
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "Util/serial/IntrusivePtr.h"
+#include "Util/parallel/TaskQueue.h"
+
+/**
+Loads resources in the background for the resource managers.
+
+The resource's reloadCpu() runs on a TaskQueue worker, then reloadFinish() runs on the main thread in pumpCompletions()
+so things like GPU uploads happen where they're allowed to.  Without a task queue reloadCpu() runs right away on the calling thread,
+which is handy for platforms without threads and for testing.
+
+Everything except the worker side is meant to be called from the main thread only.
+The pending requests hold a reference to their resource so they don't get evicted from the cache while loading.
+
+@tparam T The resource type, a ResourceBase.
+@tparam Loader The backend loader for the resource.
+*/
+template <typename T, typename Loader>
+class AsyncResourceLoader {
+public:
+    AsyncResourceLoader()
+        : m_taskQueue(NULL)
+    {}
+
+    /**
+    Whoever owns this needs to call finishAll() before destroying it, since that needs the loader.
+    */
+    ~AsyncResourceLoader() {
+        assert(m_pending.empty());
+    }
+
+    inline TaskQueue * getTaskQueue() const {
+        return m_taskQueue;
+    }
+
+    inline void setTaskQueue(TaskQueue * taskQueue) {
+        m_taskQueue = taskQueue;
+    }
+
+    inline size_t getNumPending() const {
+        return m_pending.size();
+    }
+
+    inline bool isPending(const T * resource) const {
+        return !m_pending.empty() && m_pending.find(resource) != m_pending.end();
+    }
+
+    /**
+    Starts loading a resource that has its load args set, unless it's already loaded or loading.
+    The check and marking the resource as loading happen together under the lock,
+    so asking for a resource again before it's done doesn't queue up a second load.
+
+    @return Whether or not a load was started.
+    */
+    bool request(const IntrusivePtr<T>& resource) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if(resource->isLoaded() || resource->isLoading()) {
+                return false;
+            }
+
+            resource->setLoadingInternal(true);
+        }
+
+        assert(!isPending(resource.get()));
+
+        Request * request = new Request(resource);
+        m_pending[request->m_pointer] = request;
+
+        if(m_taskQueue) {
+            m_taskQueue->push([this, request] () {
+                request->m_pointer->reloadCpu();
+                completed(request);
+            });
+        }
+        else {
+            request->m_pointer->reloadCpu();
+            completed(request);
+        }
+
+        return true;
+    }
+
+    /**
+    Finishes loading resources whose background part is done, in the order they got done.
+    Always finishes at least one if there are any ready so things keep moving even with a tiny budget,
+    then keeps going until the time budget runs out.
+
+    @return How many resources were finished.
+    */
+    size_t pumpCompletions(Loader * loader, std::chrono::steady_clock::duration budget) {
+        auto start = std::chrono::steady_clock::now();
+        size_t numFinished = 0;
+
+        do {
+            Request * request;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                if(m_completed.empty()) {
+                    break;
+                }
+
+                request = m_completed.front();
+                m_completed.pop_front();
+            }
+
+            finishRequest(request, loader);
+            ++numFinished;
+        } while(std::chrono::steady_clock::now() - start < budget);
+
+        return numFinished;
+    }
+
+    /**
+    If the resource is loading, waits for its background part and finishes it right away.
+    For when something needs a resource this frame and can't wait for pumpCompletions().
+    */
+    void finish(const T * resource, Loader * loader) {
+        if(m_pending.empty()) {
+            return;
+        }
+
+        auto pendingIter = m_pending.find(resource);
+
+        if(pendingIter == m_pending.end()) {
+            return;
+        }
+
+        Request * request = pendingIter->second;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while(!request->m_cpuDone) {
+                m_cpuDoneCondition.wait(lock);
+            }
+
+            m_completed.erase(std::find(m_completed.begin(), m_completed.end(), request));
+        }
+
+        finishRequest(request, loader);
+    }
+
+    /**
+    Waits for and finishes everything that's loading.
+    */
+    void finishAll(Loader * loader) {
+        while(!m_pending.empty()) {
+            finish(m_pending.begin()->first, loader);
+        }
+    }
+
+private:
+    struct Request {
+        Request(const IntrusivePtr<T>& resource)
+            : m_resource(resource),
+            m_pointer(resource.get()),
+            m_cpuDone(false)
+        {}
+
+        IntrusivePtr<T> m_resource;      ///<Only touched on the main thread since the cache isn't thread safe
+        T * m_pointer;
+        bool m_cpuDone;                 ///<Guarded by m_mutex
+    };
+
+    /**
+    Called on the worker once reloadCpu() is done.
+    */
+    void completed(Request * request) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        request->m_cpuDone = true;
+        m_completed.push_back(request);
+
+        //notify while still locked, once the main thread sees the request is done it might destroy the loader
+        m_cpuDoneCondition.notify_all();
+    }
+
+    void finishRequest(Request * request, Loader * loader) {
+        m_pending.erase(request->m_pointer);
+
+        request->m_pointer->setLoadingInternal(false);
+        request->m_pointer->reloadFinish(loader);
+
+        //drops the reference, the resource might go into the cache's LRU list now
+        delete request;
+    }
+
+    TaskQueue * m_taskQueue;
+
+    std::unordered_map<const T *, Request *> m_pending;     ///<Main thread only
+
+    std::mutex m_mutex;
+    std::condition_variable m_cpuDoneCondition;
+    std::deque<Request *> m_completed;                      ///<Requests whose reloadCpu() is done, guarded by m_mutex
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef ILL_FRAME_ARENA_H_
+#define ILL_FRAME_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+#include "Logging/logging.h"
+
+/**
+The alignment used for raw allocations from the arena when none is given.
+*/
+const size_t FRAME_ARENA_DEFAULT_ALIGNMENT = 16;
+
+/**
+A linear allocator for memory that only needs to live until the end of a frame.
+Allocating just bumps an offset in a block of memory and freeing does nothing.
+Calling reset() at the start of the next frame makes all of the memory available again at once.
+
+If a frame needs more memory than is in the current block, another block is taken from the heap.
+On the next reset() those blocks are merged into one block big enough for the whole frame,
+so after a few frames of warming up the arena stops calling the heap allocator entirely.
+
+Nothing allocated from the arena gets its destructor called on reset, so only use this for things
+that are either trivially destructible or are guaranteed to be destroyed before the reset.
+*/
+class FrameArena {
+public:
+    /**
+    Creates the arena.  No memory is taken until the first allocation.
+    @param blockSize The minimum size of a block taken from the heap.
+    */
+    inline FrameArena(size_t blockSize = 1 << 16)
+        : m_blockSize(blockSize),
+        m_blocks(NULL),
+        m_numAllocations(0),
+        m_numHeapAllocations(0),
+        m_bytesUsed(0)
+    {}
+
+    inline ~FrameArena() {
+        freeBlocks();
+    }
+
+    /**
+    Returns some memory that stays valid until the next reset().
+    */
+    inline void * allocate(size_t size, size_t alignment = FRAME_ARENA_DEFAULT_ALIGNMENT) {
+        assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+        ++m_numAllocations;
+
+        void * res = m_blocks ? m_blocks->bump(size, alignment) : NULL;
+
+        if(!res) {
+            addBlock(size + alignment);
+            res = m_blocks->bump(size, alignment);
+        }
+
+        m_bytesUsed += size;
+
+        return res;
+    }
+
+    /**
+    Makes all of the memory available again.
+    Anything allocated from the arena before this is no longer valid.
+    */
+    inline void reset() {
+        //merge the blocks into one so next frame fits in a single block
+        if(m_blocks && m_blocks->m_next) {
+            size_t capacity = getCapacity();
+
+            freeBlocks();
+            addBlock(capacity);
+        }
+
+        if(m_blocks) {
+            m_blocks->m_used = 0;
+        }
+
+        m_numAllocations = 0;
+        m_bytesUsed = 0;
+    }
+
+    /**
+    How many allocations were made since the last reset.
+    */
+    inline size_t getNumAllocations() const {
+        return m_numAllocations;
+    }
+
+    /**
+    How many times the arena itself called the heap allocator since it was created.
+    This stops going up once the arena is warmed up.
+    */
+    inline size_t getNumHeapAllocations() const {
+        return m_numHeapAllocations;
+    }
+
+    /**
+    How many bytes were handed out since the last reset, not including alignment padding.
+    */
+    inline size_t getBytesUsed() const {
+        return m_bytesUsed;
+    }
+
+    /**
+    The total size of all blocks held by the arena.
+    */
+    inline size_t getCapacity() const {
+        size_t res = 0;
+
+        for(Block * block = m_blocks; block; block = block->m_next) {
+            res += block->m_size;
+        }
+
+        return res;
+    }
+
+private:
+    //not copyable
+    FrameArena(const FrameArena&);
+    FrameArena& operator=(const FrameArena&);
+
+    /**
+    A block of memory taken from the heap, the memory follows right after this header.
+    */
+    struct Block {
+        inline void * bump(size_t size, size_t alignment) {
+            uintptr_t begin = reinterpret_cast<uintptr_t>(this + 1);
+            uintptr_t aligned = (begin + m_used + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+            if(aligned + size > begin + m_size) {
+                return NULL;
+            }
+
+            m_used = aligned + size - begin;
+
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        Block * m_next;
+        size_t m_size;
+        size_t m_used;
+    };
+
+    inline void addBlock(size_t minSize) {
+        size_t size = minSize > m_blockSize ? minSize : m_blockSize;
+
+        Block * block = (Block *) malloc(sizeof(Block) + size);
+
+        if(!block) {
+            LOG_FATAL_ERROR("Frame arena failed to allocate a block of %u bytes", (unsigned int) size);
+        }
+
+        ++m_numHeapAllocations;
+
+        block->m_next = m_blocks;
+        block->m_size = size;
+        block->m_used = 0;
+
+        m_blocks = block;
+    }
+
+    inline void freeBlocks() {
+        while(m_blocks) {
+            Block * next = m_blocks->m_next;
+            free(m_blocks);
+            m_blocks = next;
+        }
+    }
+
+    size_t m_blockSize;
+
+    /**
+    The blocks, newest first.  Only the newest one is ever bumped.
+    */
+    Block * m_blocks;
+
+    size_t m_numAllocations;
+    size_t m_numHeapAllocations;
+    size_t m_bytesUsed;
+};
+
+/**
+An STL allocator that takes its memory from a FrameArena.
+Deallocating does nothing, the memory comes back when the arena is reset.
+
+If the arena is NULL this falls back on the regular heap, so containers using this
+can still be used outside of a frame without any special handling.
+*/
+template <typename T>
+class FrameArenaAllocator {
+public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind {
+        typedef FrameArenaAllocator<U> other;
+    };
+
+    inline FrameArenaAllocator(FrameArena * arena = NULL)
+        : m_arena(arena)
+    {}
+
+    template <typename U>
+    inline FrameArenaAllocator(const FrameArenaAllocator<U>& other)
+        : m_arena(other.m_arena)
+    {}
+
+    inline T * allocate(size_t num, const void * hint = NULL) {
+        if(m_arena) {
+            return (T *) m_arena->allocate(num * sizeof(T), std::alignment_of<T>::value);
+        }
+        else {
+            return (T *) ::operator new(num * sizeof(T));
+        }
+    }
+
+    inline void deallocate(T * ptr, size_t num) {
+        if(!m_arena) {
+            ::operator delete(ptr);
+        }
+    }
+
+    inline size_t max_size() const {
+        return std::numeric_limits<size_t>::max() / sizeof(T);
+    }
+
+    inline T * address(T& ref) const {
+        return &ref;
+    }
+
+    inline const T * address(const T& ref) const {
+        return &ref;
+    }
+
+    inline void construct(T * ptr, const T& val) {
+        new(ptr) T(val);
+    }
+
+    template <typename U, typename... Args>
+    inline void construct(U * ptr, Args&&... args) {
+        new((void *) ptr) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    inline void destroy(U * ptr) {
+        ptr->~U();
+    }
+
+    FrameArena * m_arena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const FrameArenaAllocator<T>& a, const FrameArenaAllocator<U>& b) {
+    return a.m_arena == b.m_arena;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const FrameArenaAllocator<T>& a, const FrameArenaAllocator<U>& b) {
+    return a.m_arena != b.m_arena;
+}
+
+#endif
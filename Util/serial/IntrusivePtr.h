@@ -0,0 +1,280 @@
+#ifndef ILL_INTRUSIVE_PTR_H__
+#define ILL_INTRUSIVE_PTR_H__
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include "Util/casting.h"
+
+/**
+Reference count policy for objects only ever referenced from one thread at a time.
+*/
+struct SerialRefCount {
+    SerialRefCount()
+        : m_count(0)
+    {}
+
+    /**
+    @return The count after incrementing.
+    */
+    inline unsigned int increment() {
+        return ++m_count;
+    }
+
+    /**
+    @return The count after decrementing.
+    */
+    inline unsigned int decrement() {
+        return --m_count;
+    }
+
+    inline unsigned int get() const {
+        return m_count;
+    }
+
+    unsigned int m_count;
+};
+
+/**
+Reference count policy for objects whose pointers get copied and dropped on several threads at once.
+Incrementing can be relaxed since whoever increments already has a reference keeping the object alive.
+Decrementing needs acquire and release so whoever drops the last reference sees everything the other threads did to the object.
+*/
+struct AtomicRefCount {
+    AtomicRefCount()
+        : m_count(0)
+    {}
+
+    inline unsigned int increment() {
+        return m_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    inline unsigned int decrement() {
+        return m_count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+
+    /**
+    Acquires so that seeing the count drop to 1 also means seeing everything the thread that dropped it did to the object.
+    */
+    inline unsigned int get() const {
+        return m_count.load(std::memory_order_acquire);
+    }
+
+    std::atomic<unsigned int> m_count;
+};
+
+/**
+Something that owns reference counted objects and wants to know when they go between having references and not, like LruCache.
+The owner data is whatever the owner passed to setRefCountOwner() so it doesn't need to look the object up.
+*/
+class RefCountOwner {
+public:
+    virtual ~RefCountOwner() {}
+
+    virtual void onZeroReferences(void * ownerData) = 0;
+    virtual void onNonZeroReferences(void * ownerData) = 0;
+};
+
+/**
+Base class for objects that keep their own reference count for IntrusivePtr.
+
+This is the faster alternative to RefCountPtr, which allocates a RefCountPtrRoot and a PtrHelper separately from every object
+and has to go through the root to get to the object.  Here the count is inside the object so there's nothing extra to allocate
+and a pointer is just a pointer.
+
+Without an owner the object deletes itself once there are no references left.  With an owner the owner gets told instead
+and decides what happens to the object.
+
+@tparam RefCountPolicy SerialRefCount or AtomicRefCount.
+*/
+template <typename RefCountPolicy = SerialRefCount>
+class RefCounted {
+public:
+    inline void referenceIncrement() {
+        //if there were previously no references but there are now
+        if(m_references.increment() == 1 && m_refCountOwner) {
+            m_refCountOwner->onNonZeroReferences(m_refCountOwnerData);
+        }
+    }
+
+    inline void referenceDecrement() {
+        assert(m_references.get() > 0);
+
+        //once all references are gone do something
+        if(m_references.decrement() == 0) {
+            if(m_refCountOwner) {
+                m_refCountOwner->onZeroReferences(m_refCountOwnerData);
+            }
+            else {
+                delete this;
+            }
+        }
+    }
+
+    inline unsigned int getReferences() const {
+        return m_references.get();
+    }
+
+    /**
+    Sets who gets told when the references go to and from zero instead of the object deleting itself.
+    */
+    inline void setRefCountOwner(RefCountOwner * owner, void * ownerData) {
+        m_refCountOwner = owner;
+        m_refCountOwnerData = ownerData;
+    }
+
+protected:
+    inline RefCounted()
+        : m_refCountOwner(NULL),
+        m_refCountOwnerData(NULL)
+    {}
+
+    //copies of an object start out with no references and no owner
+    inline RefCounted(const RefCounted&)
+        : m_refCountOwner(NULL),
+        m_refCountOwnerData(NULL)
+    {}
+
+    inline RefCounted& operator=(const RefCounted&) {
+        return *this;
+    }
+
+    virtual ~RefCounted() {}
+
+private:
+    RefCountPolicy m_references;
+    RefCountOwner * m_refCountOwner;
+    void * m_refCountOwnerData;
+};
+
+/**
+A smart pointer to a RefCounted object.  Works the same as RefCountPtr otherwise.
+Moving one doesn't touch the reference count, so returning these by value is free.
+*/
+template <typename T>
+struct IntrusivePtr {
+    /**
+    Creates an empty null pointer.
+    */
+    inline IntrusivePtr()
+        : m_pointer(NULL)
+    {}
+
+    /**
+    Points to an object and adds a reference to it.
+    Pointing a new one of these at a freshly created object is what takes ownership of it.
+    */
+    inline explicit IntrusivePtr(T * pointer)
+        : m_pointer(pointer)
+    {
+        referenceIncrement();
+    }
+
+    inline IntrusivePtr(const IntrusivePtr& other)
+        : m_pointer(other.m_pointer)
+    {
+        referenceIncrement();
+    }
+
+    inline IntrusivePtr(IntrusivePtr&& other)
+        : m_pointer(other.m_pointer)
+    {
+        other.m_pointer = NULL;
+    }
+
+    inline ~IntrusivePtr() {
+        referenceDecrement();
+    }
+
+    inline IntrusivePtr& operator=(const IntrusivePtr& rhs) {
+        if(m_pointer != rhs.m_pointer) {
+            //increment first in case the decrement deletes something holding the last reference to rhs's object
+            T * oldPointer = m_pointer;
+            m_pointer = rhs.m_pointer;
+            referenceIncrement();
+
+            if(oldPointer) {
+                oldPointer->referenceDecrement();
+            }
+        }
+
+        return *this;
+    }
+
+    inline IntrusivePtr& operator=(IntrusivePtr&& rhs) {
+        if(this != &rhs) {
+            T * oldPointer = m_pointer;
+            m_pointer = rhs.m_pointer;
+            rhs.m_pointer = NULL;
+
+            if(oldPointer) {
+                oldPointer->referenceDecrement();
+            }
+        }
+
+        return *this;
+    }
+
+    inline T * operator->() const {
+        return m_pointer;
+    }
+
+    inline T & operator*() const {
+        return *m_pointer;
+    }
+
+    inline bool operator==(const IntrusivePtr& other) const {
+        return m_pointer == other.m_pointer;
+    }
+
+    inline bool operator!=(const IntrusivePtr& other) const {
+        return !(*this == other);
+    }
+
+    /**
+    Makes the pointer point to nothing and decrements the references to whatever it was referencing
+    */
+    inline void reset() {
+        T * oldPointer = m_pointer;
+        m_pointer = NULL;
+
+        if(oldPointer) {
+            oldPointer->referenceDecrement();
+        }
+    }
+
+    inline bool isNull() const {
+        return !m_pointer;
+    }
+
+    inline T * get() const {
+        return m_pointer;
+    }
+
+    template<typename C>
+    inline bool is() const {
+        return m_pointer ? ::is<C>(m_pointer) : false;
+    }
+
+    template<typename C>
+    inline IntrusivePtr<C> as() const {
+        return IntrusivePtr<C>(static_cast<C *>(m_pointer));
+    }
+
+private:
+    inline void referenceIncrement() {
+        if(m_pointer) {
+            m_pointer->referenceIncrement();
+        }
+    }
+
+    inline void referenceDecrement() {
+        if(m_pointer) {
+            m_pointer->referenceDecrement();
+        }
+    }
+
+    T * m_pointer;
+};
+
+#endif
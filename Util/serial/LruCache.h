@@ -6,8 +6,9 @@
 #include <unordered_map>
 #include <list>
 #include <chrono>
+#include <cstdint>
 
-#include "RefCountPtr.h"
+#include "Util/serial/IntrusivePtr.h"
 
 /**
 http://timday.bitbucket.org/lru.html
@@ -17,58 +18,70 @@ http://www.codeproject.com/Articles/23396/A-High-Performance-Multi-Threaded-LRU-
 /**
 A least recently used cache that returns smart pointers to objects inside.
 Once there are no more references to an object through the smart pointers, the object gets put into the least recently used list.
-Objects that are in the least recently used list for a specified time get evicted when new elements get added.
+
+There are two ways objects in the list get evicted:
+- By default objects that have been in the list for the eviction time get evicted when new elements get added or evict() is called.
+- With a memory budget set, objects stay in the list as long as the whole cache fits in the budget.  Once it doesn't,
+the objects released the longest time ago get evicted until it fits again, or until nothing unreferenced is left.
+This is checked whenever something is added or released so it doesn't wait for new requests.
+
+The memory usage comes from the size function, which gets called when an object is created and again whenever it's released
+since that's when it's done loading and changing.  Objects that are still referenced count towards the usage but never get evicted.
+
+The objects keep their own reference count, and the cache makes itself their RefCountOwner so it hears about them
+going unreferenced instead of them deleting themselves.  Even with an atomic reference count the cache isn't thread safe,
+so the last reference to an object has to be dropped on the thread using the cache.
 
 @tparam Key The key to uniquely identify objects in the cache
-@tparam T The object type
+@tparam T The object type, a RefCounted
 */
 template <typename Key, typename T>
-class LruCache {
-public:
-    typedef RefCountPtrRoot<T> HandleRoot;
-
+class LruCache : private RefCountOwner {
 private:
-    /**
-    Implementation of the PtrHelper so the smart pointers refer to the cache instead of to nothing
-    as is by default.
-    */
-    struct LruPtrHelper : public PtrHelper<T> {
-        inline void onZeroReferences() {
-            m_cache->releaseElement(m_key);
-        }
-
-        inline void onNonZeroReferences() {
-            m_cache->unreleaseElement(m_key);
-        }
-
-        Key m_key;
-        LruCache * m_cache;
-    };
-
     /**
     Info stored about each element.
+    The element points back to this as its ref count owner data, which works since the map never moves its values.
     */
     struct ElementInfo {
         ElementInfo()
-            : m_element(NULL)
+            : m_element(NULL),
+            m_memoryUsage(0)
         {}
 
         ~ElementInfo() {
             delete m_element;
         }
 
-        inline void init(HandleRoot * element, 
+        inline void init(T * element, const Key& key,
                 typename std::list<Key>::iterator freeListIterator) {
             m_element = element;
+            m_key = key;
             m_freeListIterator = freeListIterator; 
         }
 
-        HandleRoot * m_element;
+        T * m_element;
+        Key m_key;
+        size_t m_memoryUsage;
         std::chrono::steady_clock::time_point m_timeFreed;
         typename std::list<Key>::iterator m_freeListIterator;
     };
 
 public:
+    /**
+    Counters for tuning the cache size.
+    */
+    struct Stats {
+        Stats()
+            : m_hits(0),
+            m_misses(0),
+            m_evictions(0)
+        {}
+
+        uint64_t m_hits;            ///<getElement() calls that found the element in the cache
+        uint64_t m_misses;          ///<getElement() calls that had to create the element
+        uint64_t m_evictions;       ///<Elements destroyed to make room or for being unreferenced too long
+    };
+
     /**
     Constructor for the LRU cache.
 
@@ -78,35 +91,109 @@ public:
     @param evictionSeconds How many seconds should elements be in the cache without any references before they get
         destroyed.
     */
-    LruCache(std::function<T* (Key)> createFunc, size_t initialSize = 50, std::chrono::steady_clock::duration evictionSeconds = std::chrono::steady_clock::duration(2))
+    LruCache(std::function<T* (Key)> createFunc, size_t initialSize = 50, std::chrono::steady_clock::duration evictionSeconds = std::chrono::seconds(2))
         : m_createFunc(createFunc),
         m_evictionSeconds(evictionSeconds),
+        m_memoryBudget(0),
+        m_memoryUsage(0),
+        m_evicting(false),
         m_elements(initialSize)
     {}
 
+    /**
+    Sets the function that returns how many bytes an element is using.  Without one every element counts as 0 bytes.
+    Only affects elements created or released after this is called.
+    */
+    inline void setSizeFunc(std::function<size_t (const T&)> sizeFunc) {
+        m_sizeFunc = sizeFunc;
+    }
+
+    /**
+    Sets the memory budget in bytes and evicts right away if the cache is over it.
+    0 turns off the budget and goes back to evicting elements that have been unreferenced for the eviction time.
+    */
+    inline void setMemoryBudget(size_t memoryBudget) {
+        m_memoryBudget = memoryBudget;
+        evictElements();
+    }
+
+    inline size_t getMemoryBudget() const {
+        return m_memoryBudget;
+    }
+
+    /**
+    Bytes used by everything in the cache, referenced or not, as last measured with the size function.
+    */
+    inline size_t getMemoryUsage() const {
+        return m_memoryUsage;
+    }
+
+    inline size_t getNumElements() const {
+        return m_elements.size();
+    }
+
+    /**
+    How many elements have no references and could be evicted.
+    */
+    inline size_t getNumUnreferenced() const {
+        return m_freeOrder.size();
+    }
+
+    inline const Stats& getStats() const {
+        return m_stats;
+    }
+
+    inline void resetStats() {
+        m_stats = Stats();
+    }
+
     /**
     Returns a smart pointer to an element in the cache.
     Whether or not the element is in the cache or needs to be created before being returned is totally abstract.
     */
-    inline RefCountPtr<T> getElement(Key key) {
+    inline IntrusivePtr<T> getElement(Key key) {
+        return getElement(key, m_createFunc);
+    }
+
+    /**
+    Same as getElement(key) but creates the element with a different function if it's not in the cache.
+    */
+    inline IntrusivePtr<T> getElement(Key key, const std::function<T* (Key)>& createFunc) {
         auto iter = m_elements.find(key);
 
         //if element in cache, return it
         if(iter != m_elements.end()) {
-            return RefCountPtr<T>(iter->second.m_element);
+            ++m_stats.m_hits;
+            return IntrusivePtr<T>(iter->second.m_element);
         }
 
+        ++m_stats.m_misses;
+
         //load the element
-        LruPtrHelper * helper = new LruPtrHelper();
-        helper->m_key = key;
-        helper->m_cache = this;
+        T * element = createFunc(key);
+        
+        ElementInfo& elementInfo = m_elements[key];
+        elementInfo.init(element, key, m_freeOrder.end());
 
-        RefCountPtrRoot<T> * element = new RefCountPtrRoot<T>(m_createFunc(key), true, helper);
-        m_elements[key].init(element, m_freeOrder.end());
+        //take the first reference before becoming the owner so it doesn't count as the element coming out of the LRU list
+        IntrusivePtr<T> result(element);
+        element->setRefCountOwner(this, &elementInfo);
+
+        updateMemoryUsage(elementInfo);
 
         evictElements();
 
-        return RefCountPtr<T>(element, false);
+        return result;
+    }
+
+    /**
+    Calls a function with every element in the cache, referenced or not.
+    The function can't add or remove elements, so if it needs to hold on to some it should copy the pointers out.
+    */
+    inline void forEachElement(const std::function<void (T&)>& func) {
+        for(auto iter = m_elements.begin(); iter != m_elements.end(); ++iter) {
+            func(*iter->second.m_element);
+        }
     }
 
     /**
@@ -115,32 +202,52 @@ public:
     inline void clear() {
         m_elements.clear();
         m_freeOrder.clear();
+        m_memoryUsage = 0;
+    }
+
+    /**
+    Evicts whatever should be evicted right now.  Call this every so often, like once a frame,
+    so elements that went unreferenced get evicted after the eviction time even if nothing new is being requested.
+    */
+    inline void evict() {
+        evictElements();
     }
 
 private:
+    virtual void onZeroReferences(void * ownerData) {
+        releaseElement(*static_cast<ElementInfo *>(ownerData));
+    }
+
+    virtual void onNonZeroReferences(void * ownerData) {
+        unreleaseElement(*static_cast<ElementInfo *>(ownerData));
+    }
+
     /**
     Releases an element, placing it into the LRU list.
-    The element isn't deleted just yet in case it ends up being needed again.
+    The element isn't deleted just yet in case it ends up being needed again, unless the cache is over its memory budget.
     */
-    void releaseElement(Key key) {
+    void releaseElement(ElementInfo& elementInfo) {
         auto time = std::chrono::steady_clock::now();
 
-        m_freeOrder.push_front(key);
-
-        ElementInfo& elementInfo = m_elements.at(key);
+        m_freeOrder.push_front(elementInfo.m_key);
 
         assert(elementInfo.m_freeListIterator == m_freeOrder.end());
         
         elementInfo.m_timeFreed = time;
         elementInfo.m_freeListIterator = m_freeOrder.begin();
+
+        updateMemoryUsage(elementInfo);
+
+        //this can evict the element itself so nothing can touch elementInfo after
+        if(m_memoryBudget > 0) {
+            evictElements();
+        }
     }
 
     /**
     Unreleases an element, removing it from the LRU list.
     */
-    void unreleaseElement(Key key) {
-        ElementInfo& elementInfo = m_elements.at(key);
-
+    void unreleaseElement(ElementInfo& elementInfo) {
         assert(elementInfo.m_freeListIterator != m_freeOrder.end());
 
         m_freeOrder.erase(elementInfo.m_freeListIterator);
@@ -149,29 +256,65 @@ private:
     }
 
     /**
-    Evicts all elements in the cache who have been in for at least the number of
-    eviction seconds.
+    Measures an element again and updates the total.
+    */
+    inline void updateMemoryUsage(ElementInfo& elementInfo) {
+        size_t memoryUsage = m_sizeFunc ? m_sizeFunc(*elementInfo.m_element) : 0;
+
+        m_memoryUsage = m_memoryUsage - elementInfo.m_memoryUsage + memoryUsage;
+        elementInfo.m_memoryUsage = memoryUsage;
+    }
+
+    /**
+    Evicts unreferenced elements starting from the one released the longest time ago.
+    With a memory budget this keeps going until the cache fits in the budget,
+    otherwise until it gets to an element that hasn't been unreferenced for the eviction time.
     */
     void evictElements() {
+        //destroying an element can release elements it was holding on to, which would come back in here
+        if(m_evicting) {
+            return;
+        }
+
+        m_evicting = true;
+
         auto time = std::chrono::steady_clock::now();
-        auto freeIter = m_freeOrder.begin();
 
-        for(; freeIter != m_freeOrder.end(); freeIter++) {
-            auto elementIter = m_elements.find(*freeIter);
+        //the front of the list is the most recently released
+        while(!m_freeOrder.empty()) {
+            auto elementIter = m_elements.find(m_freeOrder.back());
 
-            if(time - elementIter->second.m_timeFreed < m_evictionSeconds) {
-                break;
+            if(m_memoryBudget > 0) {
+                if(m_memoryUsage <= m_memoryBudget) {
+                    break;
+                }
             }
-            else {
-                m_elements.erase(elementIter);
+            else if(time - elementIter->second.m_timeFreed < m_evictionSeconds) {
+                break;
             }
+
+            m_freeOrder.pop_back();
+            m_memoryUsage -= elementIter->second.m_memoryUsage;
+            ++m_stats.m_evictions;
+
+            //delete the element after it's out of the map since its destructor might release other elements in here
+            T * element = elementIter->second.m_element;
+            elementIter->second.m_element = NULL;
+            m_elements.erase(elementIter);
+
+            delete element;
         }
 
-        m_freeOrder.erase(m_freeOrder.begin(), freeIter);
+        m_evicting = false;
     }
 
     std::function<T* (Key)> m_createFunc;
+    std::function<size_t (const T&)> m_sizeFunc;
     std::chrono::steady_clock::duration m_evictionSeconds;
+    size_t m_memoryBudget;
+    size_t m_memoryUsage;
+    bool m_evicting;
+    Stats m_stats;
     std::unordered_map<Key, ElementInfo> m_elements;
     std::list<Key> m_freeOrder;      //one of the few places in my code where I use a list
 };
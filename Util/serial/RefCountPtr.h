@@ -121,6 +121,16 @@ struct RefCountPtr {
         referenceIncrement();
     }
 
+    /**
+    Move constructor.
+    This takes over the other pointer's reference so the count doesn't change.
+    */
+    inline RefCountPtr(RefCountPtr &&other)
+        : m_root(other.m_root)
+    {
+        other.m_root = NULL;
+    }
+
     /**
     Creates a new smart pointer that points to a raw C pointer.
     */
@@ -175,6 +185,17 @@ struct RefCountPtr {
         return *this;
     }
 
+    inline RefCountPtr & operator=(RefCountPtr && rhs) {
+        if(this != &rhs) {
+            referenceDecrement();
+
+            m_root = rhs.m_root;
+            rhs.m_root = NULL;
+        }
+
+        return *this;
+    }
+
     inline T * operator->() const {
         //this doesn't need to be safe and check if root is null
         //if you're trying to dereference a null pointer you're already screwed on the calling end anyway
@@ -4,13 +4,17 @@
 #include <cstdlib>
 #include <cstdint>
 
+#include "Util/serial/IntrusivePtr.h"
+
 /**
 Base class for a Resource like a texture or sound.
+Resources keep their own reference count for IntrusivePtr, which is atomic so worker threads can hold on to resources too.
+
 @tparam LoadArgs The type of struct that holds the loading arguments for the resource when passed into the load function.
 @tparam Loader The backend loader object that is used for loading this resource type. (TODO: make a version that doesn't take a loader)
 */
 template <typename LoadArgs, typename Loader>
-class ResourceBase 
+class ResourceBase : public RefCounted<AtomicRefCount>
 {
 public:
    /**
@@ -29,6 +33,14 @@ public:
       reload(loader);
    }
 
+   /**
+   Sets a resource's loading args without loading it.
+   Used when the loading happens later like with AsyncResourceLoader.
+   */
+   inline void setLoadArgs(const LoadArgs& loadArgs) {
+      m_loadArgs = loadArgs;
+   }
+
    /**
    Returns a resource's loading args.
    */
@@ -36,12 +48,71 @@ public:
       return m_loadArgs;
    }
 
+   /**
+   Whether or not the resource is loaded and ready for use.
+   Resources that are loading in the background with AsyncResourceLoader aren't loaded until they're finished in pumpCompletions().
+   */
+   inline bool isLoaded() const {
+      return m_state == RES_LOADED;
+   }
+
+   /**
+   Whether or not the resource is in the middle of loading, like in the background with AsyncResourceLoader.
+   */
+   inline bool isLoading() const {
+      return m_state == RES_LOADING;
+   }
+
+   /**
+   Marks the resource as loading while its reloadCpu() runs in the background, and back to unloaded once that's done
+   so reloadFinish() can take it the rest of the way like a normal load would.
+   Only AsyncResourceLoader should call this.
+   */
+   inline void setLoadingInternal(bool loading) {
+      m_state = loading ? RES_LOADING : RES_UNLOADED;
+   }
+
+   /**
+   Roughly how many bytes of main memory the resource is using.
+   Resource managers use this to keep their caches within a memory budget.
+   */
+   virtual size_t getCpuMemoryUsage() const {
+      return 0;
+   }
+
+   /**
+   Roughly how many bytes of GPU memory the resource is using, like vertex buffers and textures.
+   */
+   virtual size_t getGpuMemoryUsage() const {
+      return 0;
+   }
+
+   inline size_t getMemoryUsage() const {
+      return getCpuMemoryUsage() + getGpuMemoryUsage();
+   }
+
    /**
    Reloads a resource based on its loading args.
    This is called either when the resource is loaded for the first time or after a subsystem this resource depends on is reinitialized.
    */
    virtual void reload(Loader * loader) = 0;
 
+   /**
+   The part of loading that can happen on a worker thread, like reading and parsing files.
+   This is called on an unloaded resource whose loadArgs are set, and reloadFinish() is called afterwards on the main thread.
+   It can't touch the loader, anything else shared between threads, or the resource state.
+   By default does nothing and everything happens in reloadFinish().
+   */
+   virtual void reloadCpu() {}
+
+   /**
+   The part of loading that has to happen on the main thread after reloadCpu(), like uploading to the GPU.
+   By default does the whole reload() since resources that don't split up their loading do everything here.
+   */
+   virtual void reloadFinish(Loader * loader) {
+      reload(loader);
+   }
+
    /**
    Frees the resource.
    This might be called to temporarily unload a resource while a subsystem restarts, or when the resource is no longer needed.
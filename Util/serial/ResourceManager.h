@@ -2,18 +2,20 @@
 #define ILL_RESOURCEMANAGER_H__
 
 #include "Logging/logging.h"
+#include <functional>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "Util/serial/LruCache.h"
 #include "Util/serial/Pool.h"
+#include "Util/serial/AsyncResourceLoader.h"
 
 template<typename Key, typename T, typename Loader>
 class ResourceManager {
-private:
+public:
     typedef LruCache<Key, T> LruCacheType;
 
-public:
     ResourceManager(Loader * loader)
         : m_loader(loader),
 
@@ -23,9 +25,15 @@ public:
 
             return resource;
         })
-    {}
+    {
+        m_resourceCache.setSizeFunc([] (const T& resource) {
+            return resource.getMemoryUsage();
+        });
+    }
 
-    ~ResourceManager() {}
+    ~ResourceManager() {
+        m_asyncLoader.finishAll(m_loader);
+    }
 
     inline Loader * getLoader() const {
         return m_loader;
@@ -35,23 +43,121 @@ public:
         m_loader = loader;
     }
 
-    inline RefCountPtr<T> getResource(Key key) {
-        return m_resourceCache.getElement(key);
+    /**
+    Sets the task queue requestResource() loads resources on.  With no task queue the background part of the loading happens right in requestResource().
+    */
+    inline void setTaskQueue(TaskQueue * taskQueue) {
+        m_asyncLoader.setTaskQueue(taskQueue);
+    }
+
+    /**
+    Gets a loaded resource.  If it's still loading from requestResource() this waits for it to finish.
+    */
+    inline IntrusivePtr<T> getResource(Key key) {
+        IntrusivePtr<T> resource = m_resourceCache.getElement(key);
+        m_asyncLoader.finish(resource.get(), m_loader);
+
+        return resource;
+    }
+
+    /**
+    Returns a resource right away and loads it in the background if it isn't loaded or loading already.
+    Check isLoaded() on the resource to see when it's ready.  Call pumpCompletions() every frame to finish loading.
+    */
+    inline IntrusivePtr<T> requestResource(Key key) {
+        IntrusivePtr<T> resource = m_resourceCache.getElement(key, [] (Key key) {
+            T * resource = new T();
+            resource->setLoadArgs(key);
+
+            return resource;
+        });
+
+        m_asyncLoader.request(resource);
+
+        return resource;
+    }
+
+    /**
+    Finishes loading resources from requestResource() whose background part is done, spending about as much time as the budget.
+    Call it on the main thread once a frame.
+    */
+    inline size_t pumpCompletions(std::chrono::steady_clock::duration budget) {
+        return m_asyncLoader.pumpCompletions(m_loader, budget);
+    }
+
+    inline size_t getNumPendingLoads() const {
+        return m_asyncLoader.getNumPending();
+    }
+
+    /**
+    Keeps unused resources around as long as the CPU and GPU memory of all resources in here fits in the budget.
+    0 turns off the budget, then unused resources get freed after a couple seconds.
+    */
+    inline void setMemoryBudget(size_t memoryBudget) {
+        m_resourceCache.setMemoryBudget(memoryBudget);
+    }
+
+    inline size_t getMemoryBudget() const {
+        return m_resourceCache.getMemoryBudget();
+    }
+
+    /**
+    The CPU and GPU memory of all resources in here, including ones still in use.
+    */
+    inline size_t getMemoryUsage() const {
+        return m_resourceCache.getMemoryUsage();
+    }
+
+    inline const typename LruCacheType::Stats& getCacheStats() const {
+        return m_resourceCache.getStats();
+    }
+
+    inline void resetCacheStats() {
+        m_resourceCache.resetStats();
+    }
+
+    /**
+    Frees resources that have been unused for too long.  Call this once in a while when there's no memory budget,
+    otherwise unused resources only get freed when new ones are loaded.
+    */
+    inline void evictUnused() {
+        m_resourceCache.evict();
+    }
+
+    /**
+    Gets the resources in the cache that match, for reloading them when their files change.
+    Resources that aren't in the cache don't need reloading since they'll load whatever's on disk when they're requested.
+    */
+    inline void findCachedResources(const std::function<bool (const T&)>& matches, std::vector<IntrusivePtr<T> >& dest) {
+        m_resourceCache.forEachElement([&matches, &dest] (T& resource) {
+            if(matches(resource)) {
+                dest.push_back(IntrusivePtr<T>(&resource));
+            }
+        });
+    }
+
+    /**
+    Reloads a resource from this manager in place so everything holding on to it gets the new version.
+    If it's still loading from requestResource() it gets finished first.
+    */
+    inline void reloadResource(T * resource) {
+        m_asyncLoader.finish(resource, m_loader);
+        resource->reload(m_loader);
     }
 
 private:
     Loader * m_loader;
     LruCacheType m_resourceCache;
+    AsyncResourceLoader<T, Loader> m_asyncLoader;
 };
 
 /**
 */
 template<typename Id, typename T, typename LoadArgs, typename Loader>
 class ConfigurableResourceManager {
-private:
+public:
     typedef LruCache<Id, T> LruCacheType;
 
-public:
     ConfigurableResourceManager(Loader * loader)      
         : m_loader(loader),
         m_nameMap(NULL),
@@ -63,9 +169,15 @@ public:
 
             return resource;
         })
-    {}
+    {
+        m_resourceCache.setSizeFunc([] (const T& resource) {
+            return resource.getMemoryUsage();
+        });
+    }
 
     ~ConfigurableResourceManager() {
+        m_asyncLoader.finishAll(m_loader);
+
         delete m_nameMap;
         delete[] m_loadArgs;
     }
@@ -79,6 +191,8 @@ public:
     }
 
     inline void initialize(LoadArgs * loadArgs, std::map<std::string, Id>* nameMap) {
+        m_asyncLoader.finishAll(m_loader);
+
         delete m_nameMap;
         delete[] m_loadArgs;
         m_resourceCache.clear();
@@ -97,8 +211,106 @@ public:
         return (*idIter).second;
     }
 
-    inline RefCountPtr<T> getResource(Id resourceId) {
-        return m_resourceCache.getElement(resourceId);
+    /**
+    Sets the task queue requestResource() loads resources on.  With no task queue the background part of the loading happens right in requestResource().
+    */
+    inline void setTaskQueue(TaskQueue * taskQueue) {
+        m_asyncLoader.setTaskQueue(taskQueue);
+    }
+
+    /**
+    Gets a loaded resource.  If it's still loading from requestResource() this waits for it to finish.
+    */
+    inline IntrusivePtr<T> getResource(Id resourceId) {
+        IntrusivePtr<T> resource = m_resourceCache.getElement(resourceId);
+        m_asyncLoader.finish(resource.get(), m_loader);
+
+        return resource;
+    }
+
+    /**
+    Returns a resource right away and loads it in the background if it isn't loaded or loading already.
+    Check isLoaded() on the resource to see when it's ready.  Call pumpCompletions() every frame to finish loading.
+    */
+    inline IntrusivePtr<T> requestResource(Id resourceId) {
+        IntrusivePtr<T> resource = m_resourceCache.getElement(resourceId, [this] (Id id) {
+            T * resource = new T();
+            resource->setLoadArgs(this->m_loadArgs[id]);
+
+            return resource;
+        });
+
+        m_asyncLoader.request(resource);
+
+        return resource;
+    }
+
+    /**
+    Finishes loading resources from requestResource() whose background part is done, spending about as much time as the budget.
+    Call it on the main thread once a frame.
+    */
+    inline size_t pumpCompletions(std::chrono::steady_clock::duration budget) {
+        return m_asyncLoader.pumpCompletions(m_loader, budget);
+    }
+
+    inline size_t getNumPendingLoads() const {
+        return m_asyncLoader.getNumPending();
+    }
+
+    /**
+    Keeps unused resources around as long as the CPU and GPU memory of all resources in here fits in the budget.
+    0 turns off the budget, then unused resources get freed after a couple seconds.
+    */
+    inline void setMemoryBudget(size_t memoryBudget) {
+        m_resourceCache.setMemoryBudget(memoryBudget);
+    }
+
+    inline size_t getMemoryBudget() const {
+        return m_resourceCache.getMemoryBudget();
+    }
+
+    /**
+    The CPU and GPU memory of all resources in here, including ones still in use.
+    */
+    inline size_t getMemoryUsage() const {
+        return m_resourceCache.getMemoryUsage();
+    }
+
+    inline const typename LruCacheType::Stats& getCacheStats() const {
+        return m_resourceCache.getStats();
+    }
+
+    inline void resetCacheStats() {
+        m_resourceCache.resetStats();
+    }
+
+    /**
+    Frees resources that have been unused for too long.  Call this once in a while when there's no memory budget,
+    otherwise unused resources only get freed when new ones are loaded.
+    */
+    inline void evictUnused() {
+        m_resourceCache.evict();
+    }
+
+    /**
+    Gets the resources in the cache that match, for reloading them when their files change.
+    Resources that aren't in the cache don't need reloading since they'll load whatever's on disk when they're requested.
+    */
+    inline void findCachedResources(const std::function<bool (const T&)>& matches, std::vector<IntrusivePtr<T> >& dest) {
+        m_resourceCache.forEachElement([&matches, &dest] (T& resource) {
+            if(matches(resource)) {
+                dest.push_back(IntrusivePtr<T>(&resource));
+            }
+        });
+    }
+
+    /**
+    Reloads a resource from this manager in place so everything holding on to it gets the new version.
+    If it's still loading from requestResource() it gets finished first.
+    */
+    inline void reloadResource(T * resource) {
+        m_asyncLoader.finish(resource, m_loader);
+        resource->reload(m_loader);
     }
 
 private:
@@ -106,6 +318,7 @@ private:
     LruCacheType m_resourceCache;
     std::map<std::string, Id> * m_nameMap;   
     LoadArgs * m_loadArgs;
+    AsyncResourceLoader<T, Loader> m_asyncLoader;
 };
 
 #endif
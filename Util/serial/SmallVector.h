@@ -0,0 +1,115 @@
+#ifndef ILL_SMALL_VECTOR_H_
+#define ILL_SMALL_VECTOR_H_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/**
+A vector that keeps up to N elements inside itself before going to the heap.
+Handy for lots of little lists that are usually short, like the lights affecting each object,
+where a std::vector per list would mean a heap allocation per list.
+
+Once it goes past N elements everything moves into a std::vector, and stays there until it's cleared.
+Clearing keeps the heap capacity around so a list that grows and shrinks every frame doesn't keep reallocating.
+
+Meant for simple types like pointers, elements are copied around freely.
+*/
+template <typename T, unsigned int N>
+class SmallVector {
+public:
+    typedef T * iterator;
+    typedef const T * const_iterator;
+
+    inline SmallVector()
+        : m_size(0)
+    {}
+
+    inline size_t size() const {
+        return m_size;
+    }
+
+    inline bool empty() const {
+        return m_size == 0;
+    }
+
+    inline T * data() {
+        return m_heap.empty() ? m_inline : m_heap.data();
+    }
+
+    inline const T * data() const {
+        return m_heap.empty() ? m_inline : m_heap.data();
+    }
+
+    inline iterator begin() {
+        return data();
+    }
+
+    inline iterator end() {
+        return data() + m_size;
+    }
+
+    inline const_iterator begin() const {
+        return data();
+    }
+
+    inline const_iterator end() const {
+        return data() + m_size;
+    }
+
+    inline T& operator[](size_t index) {
+        assert(index < m_size);
+        return data()[index];
+    }
+
+    inline const T& operator[](size_t index) const {
+        assert(index < m_size);
+        return data()[index];
+    }
+
+    inline void push_back(const T& element) {
+        if(!m_heap.empty()) {
+            m_heap.push_back(element);
+        }
+        else if(m_size < N) {
+            m_inline[m_size] = element;
+        }
+        else {
+            m_heap.reserve(N * 2);
+            m_heap.assign(m_inline, m_inline + N);
+            m_heap.push_back(element);
+        }
+
+        ++m_size;
+    }
+
+    /**
+    Drops everything past the first few elements.  Can't be used to grow the vector.
+    */
+    inline void shrink(size_t size) {
+        assert(size <= m_size);
+
+        if(!m_heap.empty()) {
+            m_heap.resize(size);
+
+            //keep the heap's elements on the heap even if they'd fit inline, unless there's nothing left
+            if(size == 0) {
+                m_heap.clear();
+            }
+        }
+
+        m_size = size;
+    }
+
+    inline void clear() {
+        m_heap.clear();
+        m_size = 0;
+    }
+
+private:
+    size_t m_size;
+    T m_inline[N];
+    std::vector<T> m_heap;
+};
+
+#endif
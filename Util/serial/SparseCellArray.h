@@ -0,0 +1,177 @@
+#ifndef ILL_SPARSE_CELL_ARRAY_H_
+#define ILL_SPARSE_CELL_ARRAY_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+The number of bits of each cell coordinate that pick a cell within a brick, so bricks are 8x8x8 cells.
+*/
+const unsigned int SPARSE_CELL_ARRAY_BRICK_BITS = 3;
+const unsigned int SPARSE_CELL_ARRAY_BRICK_DIMENSION = 1 << SPARSE_CELL_ARRAY_BRICK_BITS;
+const unsigned int SPARSE_CELL_ARRAY_BRICK_CELLS = SPARSE_CELL_ARRAY_BRICK_DIMENSION * SPARSE_CELL_ARRAY_BRICK_DIMENSION * SPARSE_CELL_ARRAY_BRICK_DIMENSION;
+
+/**
+Per cell data for a 3D grid that only allocates memory for parts of the grid that were written to.
+
+The grid is split into bricks of 8x8x8 cells.  There's a pointer per brick for the whole grid,
+but the cells in a brick are only allocated the first time one of them is accessed with getMutable.
+Reading a cell in a brick that was never allocated returns a default constructed value.
+
+So an 8 byte pointer covers 512 cells, and the rest of the memory scales with the occupied space rather than the size of the world.
+
+Cells are addressed with the same array index the grid volumes use, x + cellNumber.x * (y + cellNumber.y * z),
+or with the cell grid position directly which is a bit cheaper.
+
+@tparam T The per cell data.  Must be default constructible.
+*/
+template <typename T>
+class SparseCellArray {
+public:
+    inline SparseCellArray()
+        : m_numBricksAllocated(0)
+    {}
+
+    /**
+    Creates the array.  No bricks are allocated yet.
+
+    @param cellNumber The number of cells in each dimension, x, y, and z.
+    */
+    inline SparseCellArray(const glm::uvec3& cellNumber)
+        : m_numBricksAllocated(0)
+    {
+        setCellNumber(cellNumber);
+    }
+
+    inline ~SparseCellArray() {
+        clear();
+    }
+
+    /**
+    Sets the number of cells in each dimension.  Anything in the array is lost.
+    */
+    inline void setCellNumber(const glm::uvec3& cellNumber) {
+        clear();
+
+        m_cellNumber = cellNumber;
+        m_brickNumber = (cellNumber + glm::uvec3(SPARSE_CELL_ARRAY_BRICK_DIMENSION - 1)) / glm::uvec3(SPARSE_CELL_ARRAY_BRICK_DIMENSION);
+
+        m_bricks.assign(m_brickNumber.x * m_brickNumber.y * m_brickNumber.z, (T *) NULL);
+    }
+
+    inline const glm::uvec3& getCellNumber() const {
+        return m_cellNumber;
+    }
+
+    /**
+    Frees all of the bricks.
+    */
+    inline void clear() {
+        for(size_t brick = 0; brick < m_bricks.size(); brick++) {
+            delete[] m_bricks[brick];
+            m_bricks[brick] = NULL;
+        }
+
+        m_numBricksAllocated = 0;
+    }
+
+    /**
+    Reads a cell without allocating anything.
+    */
+    inline const T& get(const glm::uvec3& cell) const {
+        const T * brick = m_bricks[brickIndex(cell)];
+
+        if(!brick) {
+            return s_default;
+        }
+
+        return brick[cellInBrickIndex(cell)];
+    }
+
+    inline const T& get(unsigned int cellArrayIndex) const {
+        return get(cellForIndex(cellArrayIndex));
+    }
+
+    /**
+    Returns a cell for writing, allocating its brick if needed.
+    */
+    inline T& getMutable(const glm::uvec3& cell) {
+        T *& brick = m_bricks[brickIndex(cell)];
+
+        if(!brick) {
+            brick = new T[SPARSE_CELL_ARRAY_BRICK_CELLS]();
+            ++m_numBricksAllocated;
+        }
+
+        return brick[cellInBrickIndex(cell)];
+    }
+
+    inline T& getMutable(unsigned int cellArrayIndex) {
+        return getMutable(cellForIndex(cellArrayIndex));
+    }
+
+    /**
+    Whether or not the brick containing a cell was ever written to.
+    Traversals can use this to skip over a whole brick of untouched cells.
+    */
+    inline bool isBrickAllocated(const glm::uvec3& cell) const {
+        return m_bricks[brickIndex(cell)] != NULL;
+    }
+
+    inline size_t getNumBricksAllocated() const {
+        return m_numBricksAllocated;
+    }
+
+    /**
+    How much memory the brick pointers and allocated bricks take, not counting anything the cells themselves point to.
+    */
+    inline size_t getMemoryUsage() const {
+        return m_bricks.capacity() * sizeof(T *) + m_numBricksAllocated * SPARSE_CELL_ARRAY_BRICK_CELLS * sizeof(T);
+    }
+
+private:
+    //not copyable
+    SparseCellArray(const SparseCellArray&);
+    SparseCellArray& operator=(const SparseCellArray&);
+
+    inline glm::uvec3 cellForIndex(unsigned int cellArrayIndex) const {
+        return glm::uvec3(cellArrayIndex % m_cellNumber.x,
+            (cellArrayIndex / m_cellNumber.x) % m_cellNumber.y,
+            cellArrayIndex / (m_cellNumber.x * m_cellNumber.y));
+    }
+
+    inline size_t brickIndex(const glm::uvec3& cell) const {
+        assert(cell.x < m_cellNumber.x && cell.y < m_cellNumber.y && cell.z < m_cellNumber.z);
+
+        return (cell.x >> SPARSE_CELL_ARRAY_BRICK_BITS)
+            + m_brickNumber.x * ((cell.y >> SPARSE_CELL_ARRAY_BRICK_BITS)
+            + m_brickNumber.y * (cell.z >> SPARSE_CELL_ARRAY_BRICK_BITS));
+    }
+
+    inline static size_t cellInBrickIndex(const glm::uvec3& cell) {
+        const unsigned int mask = SPARSE_CELL_ARRAY_BRICK_DIMENSION - 1;
+
+        return (cell.x & mask)
+            + ((cell.y & mask) << SPARSE_CELL_ARRAY_BRICK_BITS)
+            + ((cell.z & mask) << (SPARSE_CELL_ARRAY_BRICK_BITS << 1));
+    }
+
+    glm::uvec3 m_cellNumber;
+    glm::uvec3 m_brickNumber;
+
+    /**
+    A pointer per brick, NULL for bricks that were never written to.
+    */
+    std::vector<T *> m_bricks;
+    size_t m_numBricksAllocated;
+
+    static const T s_default;
+};
+
+template <typename T>
+const T SparseCellArray<T>::s_default = T();
+
+#endif
@@ -0,0 +1,433 @@
+#ifndef ILL_SPARSE_CELL_STORAGE_H_
+#define ILL_SPARSE_CELL_STORAGE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+Where an item lives inside a SparseCellStorage.
+Whoever adds items keeps a list of these per item so the item can be found and removed again without searching the cells.
+*/
+struct SparseCellLocation {
+    /**
+    The cell array index, the same thing the grid volume returns from indexForCell.
+    */
+    uint32_t m_cell;
+
+    /**
+    The slot the cell's contents are stored in.  This stays the same for as long as the cell isn't empty.
+    */
+    uint32_t m_slot;
+
+    /**
+    The index of the item within the cell's contents.
+    */
+    uint32_t m_index;
+};
+
+typedef std::vector<SparseCellLocation> SparseCellLocationList;
+
+/**
+The default attachment for a SparseCellStorage, which stores nothing.
+
+An attachment is some extra per item data kept in its own container in each cell, in the same order as the items.
+It needs a value_type and push_back, set, and swapRemove methods, where swapRemove moves the last value into the removed one's place.
+BoxBatch is one, which lets the bounds of the items in a cell be culled all at once.
+*/
+struct SparseCellNoAttachment {
+    typedef char value_type;
+
+    inline void push_back(const value_type&) {}
+    inline void set(size_t, const value_type&) {}
+    inline void swapRemove(size_t) {}
+
+    inline size_t getMemoryUsage() const {
+        return 0;
+    }
+};
+
+/**
+Stores a collection of items for each cell in a grid, but only for the cells that actually have something in them.
+
+Empty cells take a single bit, which is checked before anything else so skipping empty cells is very quick.
+Non empty cells are found through an open addressed hash table going from cell array index to a slot,
+and each slot stores its items contiguously so iterating a cell is just walking an array.
+
+Each item added also adds an entry to a location list the caller owns, usually one per object in the scene.
+Each item in a cell points back at its entry in that list, so removing is a swap with the last item followed by
+fixing up the one index that moved, no searching involved.
+
+Slots and their memory get reused when cells become empty and then get filled again, so after things settle down
+moving objects around doesn't hit the heap allocator.
+
+References returned by getCell are only good until the next add.
+
+@tparam T The item type, usually a pointer to some node.
+@tparam Attachment Extra per item data stored alongside the items in each cell, see SparseCellNoAttachment.
+*/
+template <typename T, typename Attachment = SparseCellNoAttachment>
+class SparseCellStorage {
+public:
+    /**
+    The contents of one cell.  Works like a read only container.
+    */
+    class Cell {
+    public:
+        typedef typename std::vector<T>::const_iterator const_iterator;
+        typedef const_iterator iterator;
+
+        inline Cell() {}
+
+        inline const_iterator begin() const {
+            return m_items.begin();
+        }
+
+        inline const_iterator end() const {
+            return m_items.end();
+        }
+
+        inline const_iterator cbegin() const {
+            return m_items.begin();
+        }
+
+        inline const_iterator cend() const {
+            return m_items.end();
+        }
+
+        inline bool empty() const {
+            return m_items.empty();
+        }
+
+        inline size_t size() const {
+            return m_items.size();
+        }
+
+        inline const T& operator[](size_t index) const {
+            assert(index < m_items.size());
+            return m_items[index];
+        }
+
+        /**
+        The attached data of the items, in the same order as the items.
+        */
+        inline const Attachment& getAttachment() const {
+            return m_attachment;
+        }
+
+    private:
+        /**
+        Which location list entry belongs to an item, so it can be updated when the item moves within the cell.
+        */
+        struct BackReference {
+            SparseCellLocationList * m_locations;
+            uint32_t m_location;
+        };
+
+        std::vector<T> m_items;
+        std::vector<BackReference> m_backReferences;
+        Attachment m_attachment;
+
+        friend class SparseCellStorage;
+    };
+
+    inline SparseCellStorage()
+        : m_numMapEntries(0),
+        m_mapShift(32)
+    {}
+
+    /**
+    Returns whether or not a cell has anything in it.  This never touches the hash table.
+    */
+    inline bool isOccupied(uint32_t cell) const {
+        size_t word = cell >> 6;
+        return word < m_occupied.size() && (m_occupied[word] & ((uint64_t) 1 << (cell & 63))) != 0;
+    }
+
+    /**
+    Returns the contents of a cell.  Cells that have nothing in them return a shared empty cell.
+    */
+    inline const Cell& getCell(uint32_t cell) const {
+        if(!isOccupied(cell)) {
+            return s_emptyCell;
+        }
+
+        return m_slots[findSlot(cell)];
+    }
+
+    /**
+    Adds an item to a cell.  The item shouldn't already be in that cell.
+
+    @param cell The cell array index.
+    @param item The item.
+    @param locations The item's location list.  This gets an entry added to it and must stay at the same address while the item is stored.
+    @param attachment The item's attached data.
+    */
+    inline void add(uint32_t cell, const T& item, SparseCellLocationList * locations,
+            const typename Attachment::value_type& attachment = typename Attachment::value_type()) {
+        uint32_t slot = findOrCreateSlot(cell);
+        Cell& cellContents = m_slots[slot];
+
+        SparseCellLocation location;
+        location.m_cell = cell;
+        location.m_slot = slot;
+        location.m_index = (uint32_t) cellContents.m_items.size();
+
+        typename Cell::BackReference backReference;
+        backReference.m_locations = locations;
+        backReference.m_location = (uint32_t) locations->size();
+
+        cellContents.m_items.push_back(item);
+        cellContents.m_backReferences.push_back(backReference);
+        cellContents.m_attachment.push_back(attachment);
+        locations->push_back(location);
+    }
+
+    /**
+    Changes the attached data of the item stored at some entry of its location list.
+    */
+    inline void setAttachment(const SparseCellLocationList * locations, size_t locationIndex, const typename Attachment::value_type& attachment) {
+        assert(locationIndex < locations->size());
+
+        const SparseCellLocation& location = (*locations)[locationIndex];
+        m_slots[location.m_slot].m_attachment.set(location.m_index, attachment);
+    }
+
+    /**
+    Removes the item stored at some entry of its location list.  The list loses that entry.
+    The last entry in the list is moved into its place, so when removing several entries go from the back.
+    */
+    inline void remove(SparseCellLocationList * locations, size_t locationIndex) {
+        assert(locationIndex < locations->size());
+
+        SparseCellLocation location = (*locations)[locationIndex];
+        Cell& cellContents = m_slots[location.m_slot];
+
+        assert(location.m_index < cellContents.m_items.size());
+        assert(cellContents.m_backReferences[location.m_index].m_locations == locations);
+
+        //swap remove from the cell and fix the location of whatever item was moved into the hole
+        uint32_t lastItem = (uint32_t) cellContents.m_items.size() - 1;
+
+        if(location.m_index != lastItem) {
+            cellContents.m_items[location.m_index] = cellContents.m_items[lastItem];
+            cellContents.m_backReferences[location.m_index] = cellContents.m_backReferences[lastItem];
+
+            const typename Cell::BackReference& moved = cellContents.m_backReferences[location.m_index];
+            (*moved.m_locations)[moved.m_location].m_index = location.m_index;
+        }
+
+        cellContents.m_items.pop_back();
+        cellContents.m_backReferences.pop_back();
+        cellContents.m_attachment.swapRemove(location.m_index);
+
+        if(cellContents.m_items.empty()) {
+            eraseSlot(location.m_cell);
+            m_freeSlots.push_back(location.m_slot);
+        }
+
+        //swap remove from the location list and fix the back reference of whatever location was moved into the hole
+        size_t lastLocation = locations->size() - 1;
+
+        if(locationIndex != lastLocation) {
+            (*locations)[locationIndex] = (*locations)[lastLocation];
+
+            const SparseCellLocation& moved = (*locations)[locationIndex];
+            m_slots[moved.m_slot].m_backReferences[moved.m_index].m_location = (uint32_t) locationIndex;
+        }
+
+        locations->pop_back();
+    }
+
+    /**
+    Removes an item from every cell it's in.  The location list ends up empty.
+    */
+    inline void removeAll(SparseCellLocationList * locations) {
+        while(!locations->empty()) {
+            remove(locations, locations->size() - 1);
+        }
+    }
+
+    /**
+    How many cells currently have something in them.
+    */
+    inline size_t getNumOccupiedCells() const {
+        return m_numMapEntries;
+    }
+
+    /**
+    Roughly how much memory is held, counting the hash table, the slots, and the capacity of the per slot arrays.
+    */
+    inline size_t getMemoryUsage() const {
+        size_t res = m_mapCells.capacity() * sizeof(uint32_t)
+            + m_mapSlots.capacity() * sizeof(uint32_t)
+            + m_slots.capacity() * sizeof(Cell)
+            + m_freeSlots.capacity() * sizeof(uint32_t)
+            + m_occupied.capacity() * sizeof(uint64_t);
+
+        for(size_t slot = 0; slot < m_slots.size(); slot++) {
+            res += m_slots[slot].m_items.capacity() * sizeof(T)
+                + m_slots[slot].m_backReferences.capacity() * sizeof(typename Cell::BackReference)
+                + m_slots[slot].m_attachment.getMemoryUsage();
+        }
+
+        return res;
+    }
+
+private:
+    static const uint32_t EMPTY = 0xFFFFFFFF;
+
+    /**
+    Fibonacci hashing, cell indices are very regular so this takes the well mixed top bits of the product.
+    */
+    inline uint32_t hash(uint32_t cell) const {
+        return (uint32_t) ((cell * 2654435769u) >> m_mapShift);
+    }
+
+    /**
+    Finds the slot for a cell that's known to be occupied.
+    */
+    inline uint32_t findSlot(uint32_t cell) const {
+        uint32_t mask = (uint32_t) m_mapCells.size() - 1;
+        uint32_t pos = hash(cell);
+
+        while(m_mapCells[pos] != cell) {
+            assert(m_mapCells[pos] != EMPTY);
+            pos = (pos + 1) & mask;
+        }
+
+        return m_mapSlots[pos];
+    }
+
+    inline uint32_t findOrCreateSlot(uint32_t cell) {
+        //keep the table at most half full so probes stay short
+        if((m_numMapEntries + 1) * 2 > m_mapCells.size()) {
+            rehash(m_mapCells.empty() ? 64 : m_mapCells.size() * 2);
+        }
+
+        uint32_t mask = (uint32_t) m_mapCells.size() - 1;
+        uint32_t pos = hash(cell);
+
+        for(; m_mapCells[pos] != EMPTY; pos = (pos + 1) & mask) {
+            if(m_mapCells[pos] == cell) {
+                return m_mapSlots[pos];
+            }
+        }
+
+        uint32_t slot;
+
+        if(m_freeSlots.empty()) {
+            slot = (uint32_t) m_slots.size();
+            m_slots.push_back(Cell());
+        }
+        else {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+
+        m_mapCells[pos] = cell;
+        m_mapSlots[pos] = slot;
+        ++m_numMapEntries;
+
+        size_t word = cell >> 6;
+
+        if(word >= m_occupied.size()) {
+            m_occupied.resize(word + 1, 0);
+        }
+
+        m_occupied[word] |= (uint64_t) 1 << (cell & 63);
+
+        return slot;
+    }
+
+    /**
+    Removes a cell from the hash table by shifting back the entries after it, so no tombstones are ever left behind.
+    */
+    inline void eraseSlot(uint32_t cell) {
+        m_occupied[cell >> 6] &= ~((uint64_t) 1 << (cell & 63));
+
+        uint32_t mask = (uint32_t) m_mapCells.size() - 1;
+        uint32_t hole = hash(cell);
+
+        while(m_mapCells[hole] != cell) {
+            assert(m_mapCells[hole] != EMPTY);
+            hole = (hole + 1) & mask;
+        }
+
+        for(uint32_t pos = (hole + 1) & mask; m_mapCells[pos] != EMPTY; pos = (pos + 1) & mask) {
+            uint32_t ideal = hash(m_mapCells[pos]);
+
+            //the entry can move back into the hole if that's not before where it would ideally be
+            if(((pos - ideal) & mask) >= ((pos - hole) & mask)) {
+                m_mapCells[hole] = m_mapCells[pos];
+                m_mapSlots[hole] = m_mapSlots[pos];
+                hole = pos;
+            }
+        }
+
+        m_mapCells[hole] = EMPTY;
+        --m_numMapEntries;
+    }
+
+    inline void rehash(size_t capacity) {
+        std::vector<uint32_t> oldCells(capacity, EMPTY);
+        std::vector<uint32_t> oldSlots(capacity, EMPTY);
+
+        oldCells.swap(m_mapCells);
+        oldSlots.swap(m_mapSlots);
+
+        uint32_t mask = (uint32_t) capacity - 1;
+
+        m_mapShift = 32;
+
+        while(((size_t) 1 << (32 - m_mapShift)) < capacity) {
+            --m_mapShift;
+        }
+
+        for(size_t oldPos = 0; oldPos < oldCells.size(); oldPos++) {
+            if(oldCells[oldPos] == EMPTY) {
+                continue;
+            }
+
+            uint32_t pos = hash(oldCells[oldPos]);
+
+            while(m_mapCells[pos] != EMPTY) {
+                pos = (pos + 1) & mask;
+            }
+
+            m_mapCells[pos] = oldCells[oldPos];
+            m_mapSlots[pos] = oldSlots[oldPos];
+        }
+    }
+
+    /**
+    The hash table, cell array index to slot, with a power of 2 size.
+    */
+    std::vector<uint32_t> m_mapCells;
+    std::vector<uint32_t> m_mapSlots;
+    size_t m_numMapEntries;
+
+    /**
+    How far to shift the hashed cell index down to get a position in the hash table.
+    */
+    unsigned int m_mapShift;
+
+    /**
+    A bit for every cell up to the highest one ever used, set if the cell has anything in it.
+    */
+    std::vector<uint64_t> m_occupied;
+
+    std::vector<Cell> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+
+    static const Cell s_emptyCell;
+};
+
+template <typename T, typename Attachment>
+const uint32_t SparseCellStorage<T, Attachment>::EMPTY;
+
+template <typename T, typename Attachment>
+const typename SparseCellStorage<T, Attachment>::Cell SparseCellStorage<T, Attachment>::s_emptyCell;
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef ILL_SIMD_H_
+#define ILL_SIMD_H_
+
+/**
+Figures out which SIMD instruction sets can be used when compiling for the current platform.
+
+If ILL_SSE2 ends up defined the SSE2 intrinsics are included and can be used.
+If ILL_AVX ends up defined the AVX intrinsics are included too.  That only happens when the compiler is told it can use AVX,
+with /arch:AVX or -mavx, since the engine doesn't check the CPU at runtime.
+Code using them should always have a plain C++ version in the #else for platforms without them, like ARM devices.
+Define ILL_NO_SIMD to force the plain versions, which is handy for checking the SIMD versions give the same results.
+*/
+
+#if !defined(ILL_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ILL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(ILL_SSE2) && defined(__AVX__)
+#define ILL_AVX
+#include <immintrin.h>
+#endif
+
+#endif